@@ -3,27 +3,51 @@
  * @brief Header file containing constant values for a matrix processing program.
  *
  * This file defines constant values used in a matrix processing program.
- * These constants include the number of rows and columns in matrices,
- * the maximum length of user input, and the initial size of a line buffer.
+ * These constants include the number of rows and columns in the predefined matrices,
+ * the largest dimension of a named matrix, the alignment of the elements of a matrix, the maximum length of user input,
+ * and the initial size of a line buffer.
  */
 
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
 /**
- * @brief Number of rows in matrices.
+ * @brief Number of rows in the predefined matrices.
  *
- * This constant defines the number of rows in matrices used in the program.
+ * This constant defines the number of rows the predefined matrices are created with.
  */
 #define NUM_OF_ROWS 4
 
 /**
- * @brief Number of columns in matrices.
+ * @brief Number of columns in the predefined matrices.
  *
- * This constant defines the number of columns in matrices used in the program.
+ * This constant defines the number of columns the predefined matrices are created with.
  */
 #define NUM_OF_COLUMNS 4
 
+/**
+ * @brief Largest number of rows or columns of a matrix created with 'new_mat'.
+ *
+ * This constant matches the largest matrices of our workloads, 4096x4096, and bounds the block
+ * of a matrix to 128 MB, so a mistyped dimension is reported instead of exhausting the memory.
+ */
+#define MAX_MAT_DIMENSION 4096
+
+/**
+ * @brief Alignment of the block of the elements of a matrix, in bytes.
+ *
+ * The block starts on a cache line, so no row of a matrix shares a line with another block.
+ */
+#define MAT_ALIGNMENT 64
+
+/**
+ * @brief Multiple the stride of the rows of a matrix is rounded up to, in elements.
+ *
+ * Four doubles are 32 bytes, so every row is aligned for vector loads, and the 16 elements
+ * of a 4x4 matrix are contiguous.
+ */
+#define MAT_STRIDE_ALIGNMENT 4
+
 /**
  * @brief Maximum length of user input.
  *
@@ -38,4 +62,12 @@
  */
 #define INIT_LINE_SIZE 100
 
+/**
+ * @brief Initial number of values in the buffer of a 'read_mat' command.
+ *
+ * The buffer is doubled as values are parsed, so it holds the values of the command rather than
+ * one per element of the matrix.
+ */
+#define INIT_VALUES_SIZE 16
+
 #endif /**< CONSTANTS_H */
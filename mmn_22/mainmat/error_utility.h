@@ -30,6 +30,11 @@
  * - [Macro] MISSING_ARG_ERR - Error message for missing argument in a command.
  * - [Macro] MISSING_SCALAR_ERR - Error message for missing scalar argument in a command.
  * - [Macro] ARG_IS_NOT_DOUBLE - Error message for an argument that is not a real number in a command.
+ * - [Macro] SHAPE_MISMATCH_ERR - Error message for matrices whose shapes do not fit the operation.
+ * - [Macro] INVALID_MAT_NAME_ERR - Error message for a new matrix name that is not a valid name.
+ * - [Macro] MAT_EXISTS_ERR - Error message for a new matrix name that is already defined.
+ * - [Macro] INVALID_DIMENSION_ERR - Error message for a matrix dimension that is not a valid size.
+ * - [Macro] INVALID_THREADS_ERR - Error message for a number of threads that is not a valid number.
  * - [Macro] ILLEGAL_COMMA(ch) - Macro to check for an illegal comma at the given character pointer.
  * - [Macro] EXTRANEOUS_TEXT(ch) - Macro to check for extraneous text at the given character pointer.
  * - [Macro] MISSING_ARGUMENT(ch) - Macro to check for a missing argument at the given character pointer.
@@ -106,6 +111,31 @@
  */
 #define ARG_IS_NOT_DOUBLE "Argument is not a real number"
 
+/**
+ * @brief Error message for matrices whose shapes do not fit the operation.
+ */
+#define SHAPE_MISMATCH_ERR "Matrix dimensions do not match"
+
+/**
+ * @brief Error message for a new matrix name that is not a valid name.
+ */
+#define INVALID_MAT_NAME_ERR "Invalid matrix name"
+
+/**
+ * @brief Error message for a new matrix name that is already defined.
+ */
+#define MAT_EXISTS_ERR "Matrix name already defined"
+
+/**
+ * @brief Error message for a matrix dimension that is not a valid size.
+ */
+#define INVALID_DIMENSION_ERR "Matrix dimension is not a positive integer in range"
+
+/**
+ * @brief Error message for a number of threads that is not a valid number.
+ */
+#define INVALID_THREADS_ERR "Number of threads is not a positive integer in range"
+
 /**
  * @brief Checks for an illegal comma at the given character pointer.
  *
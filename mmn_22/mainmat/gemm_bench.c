@@ -0,0 +1,356 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * @file gemm_bench.c
+ * @brief Benchmark of the blocked multiplication of gemm_utility.h against the dot product loop.
+ *
+ * For square and rectangular shapes, the product of two random matrices is timed with the dot product
+ * per element mul_mat used before, and with gemm, and the rate of each is reported in GFLOP/s, counting
+ * 2 * m * n * k operations per product. The dot product loop is only run up to BENCH_NAIVE_VOLUME
+ * multiplications; the larger products of gemm are checked on sampled elements instead.
+ *
+ * gemm is timed on one thread, and when the pool of parallel_utility.h has more threads, on all of them
+ * too, with the scaling of the rate from one thread to all of them.
+ *
+ * The Strassen-Winograd multiplication of strassen_utility.h is then timed against gemm on large square
+ * matrices, for cutoffs of one and two levels, its rate reported as 2 * n^3 operations per second as
+ * gemm's is. The error of both is measured on sampled elements against a dot product in long double.
+ *
+ * Usage: gemm_bench [scale], where scale divides the dimensions of the shapes (1 by default). The number
+ * of threads is set by MAINMAT_THREADS, as for mainmat.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#include <time.h>
+
+#include "gemm_utility.h"
+#include "simd_utility.h"
+#include "parallel_utility.h"
+#include "strassen_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Largest number of multiplications of a product timed with the dot product loop.
+ */
+#define BENCH_NAIVE_VOLUME (512.0 * 512.0 * 512.0)
+
+/**
+ * @brief Smallest time a shape is measured for, in seconds, over repetitions.
+ */
+#define BENCH_MIN_TIME 0.3
+
+/**
+ * @brief Number of elements of a product checked against a dot product, when the loop is not run.
+ */
+#define BENCH_SAMPLES 256
+
+/**
+ * @brief Largest difference from the dot product accepted for an element, per multiplication summed.
+ */
+#define BENCH_TOLERANCE 1e-14
+
+/**
+ * @brief Structure to represent a shape of the benchmark, C (m x n) = A (m x k) * B (k x n).
+ */
+typedef struct {
+    int m; /**< The number of rows of A and C. */
+    int n; /**< The number of columns of B and C. */
+    int k; /**< The inner dimension. */
+} BenchShape;
+
+/**
+ * @brief The shapes, square and then rectangular, including shapes that are not multiples of the blocks.
+ */
+static const BenchShape benchShapes[] = {
+    {64, 64, 64}, {128, 128, 128}, {256, 256, 256}, {512, 512, 512}, {1024, 1024, 1024}, {2048, 2048, 2048},
+    {1000, 1000, 100}, {100, 1000, 1000}, {1000, 100, 1000}, {4000, 200, 300}, {37, 1501, 703}, {2000, 2000, 8}
+};
+
+/**
+ * @brief Structure to represent a product of square matrices timed with the Strassen-Winograd recursion.
+ */
+typedef struct {
+    int n;      /**< The dimension of the matrices. */
+    int cutoff; /**< The cutoff of the recursion. */
+} StrassenShape;
+
+/**
+ * @brief The products of the Strassen-Winograd recursion, with one or two levels, and an odd dimension.
+ */
+static const StrassenShape strassenShapes[] = {
+    {1024, 1024}, {2048, 2048}, {2048, 1024}, {3001, 2048}, {4096, 4096}, {4096, 2048}, {4096, 1024}
+};
+
+/**
+ * @brief State of the pseudo-random generator (xorshift), fixed so runs are comparable.
+ */
+static unsigned long randomState = 2463534242UL;
+
+/* Returns the next pseudo-random number */
+static unsigned long next_random(void) {
+
+    randomState ^= (randomState << 13) & 0xFFFFFFFFUL;
+    randomState ^= randomState >> 17;
+    randomState ^= (randomState << 5) & 0xFFFFFFFFUL;
+    return randomState;
+}
+
+/* Fills a matrix with pseudo-random numbers in [-1, 1] */
+static void fill_random(mat *matrix) {
+
+    int row, col;
+
+    FOR_RANGE(row, matrix->rows) {
+        FOR_RANGE(col, matrix->cols) {
+            MAT_ELEMENT(matrix, row, col) = (double) next_random() / 2147483647.5 - 1.0;
+        }
+    }
+}
+
+/* Returns the current time in seconds */
+static double now_seconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/* Multiplies two matrices with a dot product per element, as mul_mat did before gemm */
+static void mul_naive(const mat *a, const mat *b, mat *c) {
+
+    double sum;
+    int row, col, p;
+
+    FOR_RANGE(row, a->rows) {
+        FOR_RANGE(col, b->cols) {
+            sum = 0;
+            FOR_RANGE(p, a->cols) {
+                sum += MAT_ELEMENT(a, row, p) * MAT_ELEMENT(b, p, col);
+            }
+            MAT_ELEMENT(c, row, col) = sum;
+        }
+    }
+}
+
+/* Runs gemm on two matrices */
+static void mul_gemm(const mat *a, const mat *b, mat *c) {
+
+    gemm(a->rows, b->cols, a->cols, a->data, a->stride, b->data, b->stride, c->data, c->stride);
+}
+
+/* Runs the Strassen-Winograd multiplication on two matrices */
+static void mul_strassen(const mat *a, const mat *b, mat *c) {
+
+    strassen_gemm(a->rows, b->cols, a->cols, a->data, a->stride, b->data, b->stride, c->data, c->stride);
+}
+
+/* Times a multiplication, repeated for at least BENCH_MIN_TIME seconds, and returns its rate in GFLOP/s */
+static double time_product(void (*multiply)(const mat *, const mat *, mat *), const mat *a, const mat *b, mat *c) {
+
+    double start = now_seconds(), elapsed;
+    long repetitions = 0;
+
+    do {
+        multiply(a, b, c);
+        repetitions++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < BENCH_MIN_TIME);
+
+    return 2.0 * a->rows * b->cols * a->cols * (double) repetitions / elapsed * 1e-9;
+}
+
+/* Returns whether a product agrees with a dot product on sampled elements */
+static bool check_samples(const mat *a, const mat *b, const mat *c) {
+
+    double sum;
+    int i, row, col, p;
+
+    FOR_RANGE(i, BENCH_SAMPLES) {
+        row = (int) (next_random() % (unsigned long) a->rows);
+        col = (int) (next_random() % (unsigned long) b->cols);
+        sum = 0;
+        FOR_RANGE(p, a->cols) {
+            sum += MAT_ELEMENT(a, row, p) * MAT_ELEMENT(b, p, col);
+        }
+        if (fabs(sum - MAT_ELEMENT(c, row, col)) > BENCH_TOLERANCE * a->cols) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Returns the largest error of a product on sampled elements, against a dot product in long double */
+static double sample_error(const mat *a, const mat *b, const mat *c) {
+
+    long double sum;
+    double error, largest = 0;
+    int i, row, col, p;
+
+    FOR_RANGE(i, BENCH_SAMPLES) {
+        row = (int) (next_random() % (unsigned long) a->rows);
+        col = (int) (next_random() % (unsigned long) b->cols);
+        sum = 0;
+        FOR_RANGE(p, a->cols) {
+            sum += (long double) MAT_ELEMENT(a, row, p) * (long double) MAT_ELEMENT(b, p, col);
+        }
+        error = fabs((double) (sum - (long double) MAT_ELEMENT(c, row, col)));
+        if (error > largest) {
+            largest = error;
+        }
+    }
+    return largest;
+}
+
+/* Returns whether two products agree on all their elements */
+static bool check_all(const mat *expected, const mat *c, int k) {
+
+    int row, col;
+
+    FOR_RANGE(row, c->rows) {
+        FOR_RANGE(col, c->cols) {
+            if (fabs(MAT_ELEMENT(expected, row, col) - MAT_ELEMENT(c, row, col)) > BENCH_TOLERANCE * k) {
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/* Runs one shape and prints the rate of both multiplications, and of gemm on all the threads */
+static void run_shape(const BenchShape *shape, int scale, int threads) {
+
+    int m = shape->m / scale > 0 ? shape->m / scale : 1;
+    int n = shape->n / scale > 0 ? shape->n / scale : 1;
+    int k = shape->k / scale > 0 ? shape->k / scale : 1;
+    double naiveRate = 0, gemmRate, threadsRate;
+    bool correct;
+    mat a, b, c, expected;
+
+    init_mat(&a, m, k);
+    init_mat(&b, k, n);
+    init_mat(&c, m, n);
+    init_mat(&expected, m, n);
+    fill_random(&a);
+    fill_random(&b);
+
+    printf("%5d x %5d x %5d", m, n, k);
+
+    if ((double) m * n * k <= BENCH_NAIVE_VOLUME) {
+        naiveRate = time_product(mul_naive, &a, &b, &expected);
+        printf(" %10.2f", naiveRate);
+    }
+    else {
+        printf(" %10s", "-");
+    }
+
+    parallel_set_threads(1);
+    gemmRate = time_product(mul_gemm, &a, &b, &c);
+    correct = naiveRate > 0 ? check_all(&expected, &c, k) : check_samples(&a, &b, &c);
+    if (!correct) {
+        printf(" %10s\n", "MISMATCH");
+    }
+    else if (naiveRate > 0) {
+        printf(" %10.2f %8.1fx", gemmRate, gemmRate / naiveRate);
+    }
+    else {
+        printf(" %10.2f %9s", gemmRate, "-");
+    }
+
+    /* The product on all the threads is checked as the product on one thread is */
+    parallel_set_threads(threads);
+    if (correct && threads > 1) {
+        memset(c.data, 0, sizeof(double) * (size_t) c.rows * (size_t) c.stride);
+        threadsRate = time_product(mul_gemm, &a, &b, &c);
+        correct = naiveRate > 0 ? check_all(&expected, &c, k) : check_samples(&a, &b, &c);
+        if (correct) {
+            printf(" %10.2f %8.2fx", threadsRate, threadsRate / gemmRate);
+        }
+        else {
+            printf(" %10s", "MISMATCH");
+        }
+    }
+    printf("\n");
+
+    free_mat(&a);
+    free_mat(&b);
+    free_mat(&c);
+    free_mat(&expected);
+}
+
+/* Runs one product with gemm and with the Strassen-Winograd recursion, and prints their rates and errors */
+static void run_strassen(const StrassenShape *shape, int scale) {
+
+    int n = shape->n / scale > 0 ? shape->n / scale : 1;
+    int cutoff = shape->cutoff / scale > STRASSEN_MIN_CUTOFF ? shape->cutoff / scale : STRASSEN_MIN_CUTOFF;
+    int levels = 0, size;
+    unsigned long samples;
+    double gemmRate, fastRate, gemmError, fastError;
+    mat a, b, c;
+
+    for (size = n ; size >= cutoff ; size /= 2) {
+        levels++;
+    }
+
+    init_mat(&a, n, n);
+    init_mat(&b, n, n);
+    init_mat(&c, n, n);
+    fill_random(&a);
+    fill_random(&b);
+
+    /* Both products are checked on the same elements */
+    samples = randomState;
+    strassen_set_cutoff(0);
+    gemmRate = time_product(mul_gemm, &a, &b, &c);
+    gemmError = sample_error(&a, &b, &c);
+
+    randomState = samples;
+    strassen_set_cutoff(cutoff);
+    fastRate = time_product(mul_strassen, &a, &b, &c);
+    fastError = sample_error(&a, &b, &c);
+
+    printf("%5d %7d %7d %10.2f %10.2f %8.2fx %11.1e %11.1e\n", n, cutoff, levels, gemmRate, fastRate,
+           fastRate / gemmRate, gemmError, fastError);
+
+    free_mat(&a);
+    free_mat(&b);
+    free_mat(&c);
+}
+
+int main(int argc, char *argv[]) {
+
+    int scale = argc > 1 ? atoi(argv[1]) : 1;
+    int threads = parallel_threads();
+    size_t i;
+
+    if (scale <= 0) {
+        scale = 1;
+    }
+
+    printf("Matrix multiplication, GFLOP/s (micro-kernel: %s, threads: %d)\n", mat4_kernel_name(mat4_best_kernel()),
+           threads);
+    printf("%-21s %10s %10s %9s", "m x n x k", "loop", "gemm", "speedup");
+    if (threads > 1) {
+        printf(" %10s %9s", "threads", "scaling");
+    }
+    printf("\n");
+
+    FOR_RANGE(i, sizeof(benchShapes) / sizeof(benchShapes[0])) {
+        run_shape(&benchShapes[i], scale, threads);
+    }
+
+    printf("\nStrassen-Winograd against gemm, GFLOP/s as 2 * n^3 operations, largest error of sampled elements\n");
+    printf("%5s %7s %7s %10s %10s %9s %11s %11s\n", "n", "cutoff", "levels", "gemm", "strassen", "speedup",
+           "gemm err", "strassen err");
+    FOR_RANGE(i, sizeof(strassenShapes) / sizeof(strassenShapes[0])) {
+        run_strassen(&strassenShapes[i], scale);
+    }
+
+    strassen_free();
+    gemm_free();
+    parallel_free();
+    return EXIT_SUCCESS;
+}
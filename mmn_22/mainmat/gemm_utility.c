@@ -0,0 +1,433 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "gemm_utility.h"
+#include "simd_utility.h"
+#include "parallel_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define GEMM_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief A micro-kernel, which sets a GEMM_MR x GEMM_NR tile of C to the product of a sliver of A and a sliver
+ * of B, added to the tile if accumulate is TRUE.
+ */
+typedef void (*MicroKernel)(int kc, const double *a, const double *b, double *c, int ldc, bool accumulate);
+
+/**
+ * @brief Structure to represent a product split into tiles of C, each a task of the pool of parallel_utility.h.
+ */
+typedef struct {
+    int m, n, k;        /**< The shape of the product. */
+    const double *a;    /**< The elements of A. */
+    int lda;            /**< The stride of the rows of A. */
+    const double *b;    /**< The elements of B. */
+    int ldb;            /**< The stride of the rows of B. */
+    double *c;          /**< The elements of C. */
+    int ldc;            /**< The stride of the rows of C. */
+    int tileRows;       /**< The number of rows of a tile, a multiple of GEMM_MR. */
+    int tileCols;       /**< The number of columns of a tile, a multiple of GEMM_NR. */
+    int colTiles;       /**< The number of tiles across C. */
+    MicroKernel kernel; /**< The micro-kernel of the chosen set. */
+} GemmJob;
+
+/**
+ * @brief Structure to represent the buffers a thread packs its blocks of A and B into, kept between products.
+ */
+typedef struct {
+    double *packA;  /**< The buffer of a block of A. */
+    size_t sizeA;   /**< The number of doubles of the buffer of A. */
+    double *packB;  /**< The buffer of a panel of B. */
+    size_t sizeB;   /**< The number of doubles of the buffer of B. */
+} PackBuffers;
+
+/**
+ * @brief The key of the buffers of every thread, created by the first product computed in blocks.
+ */
+static pthread_key_t packKey;
+static pthread_once_t packKeyOnce = PTHREAD_ONCE_INIT;
+
+/* Frees the buffers of a thread, also run when a worker of the pool exits */
+static void free_pack_buffers(void *context) {
+
+    PackBuffers *buffers = (PackBuffers *) context;
+
+    aligned_memory_free(buffers->packA);
+    aligned_memory_free(buffers->packB);
+    free(buffers);
+}
+
+/* Creates the key of the buffers of every thread, run once */
+static void create_pack_key(void) {
+
+    pthread_key_create(&packKey, free_pack_buffers);
+}
+
+/* Returns the buffers of the calling thread, grown to hold at least the given numbers of doubles */
+static PackBuffers *pack_buffers(size_t sizeA, size_t sizeB) {
+
+    PackBuffers *buffers;
+
+    pthread_once(&packKeyOnce, create_pack_key);
+    buffers = (PackBuffers *) pthread_getspecific(packKey);
+    if (buffers == NULL) {
+        buffers = (PackBuffers *) validated_memory_allocation(sizeof(PackBuffers));
+        buffers->packA = NULL;
+        buffers->sizeA = 0;
+        buffers->packB = NULL;
+        buffers->sizeB = 0;
+        pthread_setspecific(packKey, buffers);
+    }
+
+    /* A buffer only grows, so the products of a run allocate it a few times at most */
+    if (buffers->sizeA < sizeA) {
+        aligned_memory_free(buffers->packA);
+        buffers->packA = (double *) validated_aligned_allocation(sizeof(double) * sizeA, MAT_ALIGNMENT);
+        buffers->sizeA = sizeA;
+    }
+    if (buffers->sizeB < sizeB) {
+        aligned_memory_free(buffers->packB);
+        buffers->packB = (double *) validated_aligned_allocation(sizeof(double) * sizeB, MAT_ALIGNMENT);
+        buffers->sizeB = sizeB;
+    }
+    return buffers;
+}
+
+/* Returns the smaller of two numbers */
+static int min_int(int x, int y) {
+
+    return x < y ? x : y;
+}
+
+/* Rounds a number up to a multiple of another */
+static int round_up(int x, int multiple) {
+
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+/* Multiplies two small matrices with a dot product per element */
+static void gemm_small(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc) {
+
+    double sum;
+    int row, col, p;
+
+    FOR_RANGE(row, m) {
+        FOR_RANGE(col, n) {
+            sum = 0;
+            FOR_RANGE(p, k) {
+                sum += a[row * lda + p] * b[p * ldb + col];
+            }
+            c[row * ldc + col] = sum;
+        }
+    }
+}
+
+/* Multiplies a sliver of A by a sliver of B into a tile of C with scalar loops */
+static void kernel_scalar(int kc, const double *a, const double *b, double *c, int ldc, bool accumulate) {
+
+    double tile[GEMM_MR * GEMM_NR];
+    int p, i, j;
+
+    FOR_RANGE(i, GEMM_MR * GEMM_NR) {
+        tile[i] = 0;
+    }
+
+    /* Every element of the inner dimension adds the outer product of a column of A and a row of B */
+    FOR_RANGE(p, kc) {
+        FOR_RANGE(i, GEMM_MR) {
+            FOR_RANGE(j, GEMM_NR) {
+                tile[i * GEMM_NR + j] += a[i] * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    FOR_RANGE(i, GEMM_MR) {
+        FOR_RANGE(j, GEMM_NR) {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + tile[i * GEMM_NR + j] : tile[i * GEMM_NR + j];
+        }
+    }
+}
+
+#ifdef GEMM_SIMD
+/* Multiplies a sliver of A by a sliver of B into a tile of C, each half of 4 columns held in 12 SSE2 registers */
+static void kernel_sse2(int kc, const double *a, const double *b, double *c, int ldc, bool accumulate) {
+
+    __m128d sum[GEMM_MR][2], b0, b1, factor;
+    const double *aSliver, *bSliver;
+    int half, p, i;
+
+    /* The 16 SSE2 registers hold a 6x4 tile, so the sliver of A is read once per half of the tile */
+    FOR_RANGE(half, GEMM_NR / 4) {
+        FOR_RANGE(i, GEMM_MR) {
+            sum[i][0] = _mm_setzero_pd();
+            sum[i][1] = _mm_setzero_pd();
+        }
+
+        aSliver = a;
+        bSliver = b + 4 * half;
+        FOR_RANGE(p, kc) {
+            b0 = _mm_load_pd(bSliver);
+            b1 = _mm_load_pd(bSliver + 2);
+            FOR_RANGE(i, GEMM_MR) {
+                factor = _mm_set1_pd(aSliver[i]);
+                sum[i][0] = _mm_add_pd(sum[i][0], _mm_mul_pd(factor, b0));
+                sum[i][1] = _mm_add_pd(sum[i][1], _mm_mul_pd(factor, b1));
+            }
+            aSliver += GEMM_MR;
+            bSliver += GEMM_NR;
+        }
+
+        FOR_RANGE(i, GEMM_MR) {
+            if (accumulate) {
+                sum[i][0] = _mm_add_pd(sum[i][0], _mm_loadu_pd(c + i * ldc + 4 * half));
+                sum[i][1] = _mm_add_pd(sum[i][1], _mm_loadu_pd(c + i * ldc + 4 * half + 2));
+            }
+            _mm_storeu_pd(c + i * ldc + 4 * half, sum[i][0]);
+            _mm_storeu_pd(c + i * ldc + 4 * half + 2, sum[i][1]);
+        }
+    }
+}
+
+/* Multiplies a sliver of A by a sliver of B into a tile of C, the tile held in 12 AVX registers */
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(int kc, const double *a, const double *b, double *c, int ldc, bool accumulate) {
+
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    __m256d b0, b1, factor;
+    int p;
+
+    /* A row of the sliver of B is two vectors, each element of the column of A is broadcast over them */
+    FOR_RANGE(p, kc) {
+        b0 = _mm256_load_pd(b);
+        b1 = _mm256_load_pd(b + 4);
+
+        factor = _mm256_broadcast_sd(a);
+        c00 = _mm256_fmadd_pd(factor, b0, c00);
+        c01 = _mm256_fmadd_pd(factor, b1, c01);
+        factor = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(factor, b0, c10);
+        c11 = _mm256_fmadd_pd(factor, b1, c11);
+        factor = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(factor, b0, c20);
+        c21 = _mm256_fmadd_pd(factor, b1, c21);
+        factor = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(factor, b0, c30);
+        c31 = _mm256_fmadd_pd(factor, b1, c31);
+        factor = _mm256_broadcast_sd(a + 4);
+        c40 = _mm256_fmadd_pd(factor, b0, c40);
+        c41 = _mm256_fmadd_pd(factor, b1, c41);
+        factor = _mm256_broadcast_sd(a + 5);
+        c50 = _mm256_fmadd_pd(factor, b0, c50);
+        c51 = _mm256_fmadd_pd(factor, b1, c51);
+
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if (accumulate) {
+        c00 = _mm256_add_pd(c00, _mm256_loadu_pd(c));
+        c01 = _mm256_add_pd(c01, _mm256_loadu_pd(c + 4));
+        c10 = _mm256_add_pd(c10, _mm256_loadu_pd(c + ldc));
+        c11 = _mm256_add_pd(c11, _mm256_loadu_pd(c + ldc + 4));
+        c20 = _mm256_add_pd(c20, _mm256_loadu_pd(c + 2 * ldc));
+        c21 = _mm256_add_pd(c21, _mm256_loadu_pd(c + 2 * ldc + 4));
+        c30 = _mm256_add_pd(c30, _mm256_loadu_pd(c + 3 * ldc));
+        c31 = _mm256_add_pd(c31, _mm256_loadu_pd(c + 3 * ldc + 4));
+        c40 = _mm256_add_pd(c40, _mm256_loadu_pd(c + 4 * ldc));
+        c41 = _mm256_add_pd(c41, _mm256_loadu_pd(c + 4 * ldc + 4));
+        c50 = _mm256_add_pd(c50, _mm256_loadu_pd(c + 5 * ldc));
+        c51 = _mm256_add_pd(c51, _mm256_loadu_pd(c + 5 * ldc + 4));
+    }
+
+    _mm256_storeu_pd(c, c00);
+    _mm256_storeu_pd(c + 4, c01);
+    _mm256_storeu_pd(c + ldc, c10);
+    _mm256_storeu_pd(c + ldc + 4, c11);
+    _mm256_storeu_pd(c + 2 * ldc, c20);
+    _mm256_storeu_pd(c + 2 * ldc + 4, c21);
+    _mm256_storeu_pd(c + 3 * ldc, c30);
+    _mm256_storeu_pd(c + 3 * ldc + 4, c31);
+    _mm256_storeu_pd(c + 4 * ldc, c40);
+    _mm256_storeu_pd(c + 4 * ldc + 4, c41);
+    _mm256_storeu_pd(c + 5 * ldc, c50);
+    _mm256_storeu_pd(c + 5 * ldc + 4, c51);
+}
+#endif
+
+/* Packs a block of A into slivers of GEMM_MR rows, column by column, the rows past the block zero */
+static void pack_a(int mc, int kc, const double *a, int lda, double *packA) {
+
+    int ir, p, i;
+
+    for (ir = 0 ; ir < mc ; ir += GEMM_MR) {
+        FOR_RANGE(p, kc) {
+            FOR_RANGE(i, GEMM_MR) {
+                *packA++ = ir + i < mc ? a[(ir + i) * lda + p] : 0;
+            }
+        }
+    }
+}
+
+/* Packs a panel of B into slivers of GEMM_NR columns, row by row, the columns past the panel zero */
+static void pack_b(int kc, int nc, const double *b, int ldb, double *packB) {
+
+    int jr, p, j;
+
+    for (jr = 0 ; jr < nc ; jr += GEMM_NR) {
+        FOR_RANGE(p, kc) {
+            FOR_RANGE(j, GEMM_NR) {
+                *packB++ = jr + j < nc ? b[p * ldb + jr + j] : 0;
+            }
+        }
+    }
+}
+
+/* Multiplies a packed block of A by a packed panel of B, a tile of C per micro-kernel call */
+static void macro_kernel(int mc, int nc, int kc, const double *packA, const double *packB, double *c, int ldc,
+                         bool accumulate, MicroKernel kernel) {
+
+    double edge[GEMM_MR * GEMM_NR];
+    int ir, jr, mr, nr, i, j;
+
+    for (jr = 0 ; jr < nc ; jr += GEMM_NR) {
+        nr = min_int(GEMM_NR, nc - jr);
+        for (ir = 0 ; ir < mc ; ir += GEMM_MR) {
+            mr = min_int(GEMM_MR, mc - ir);
+
+            if (mr == GEMM_MR && nr == GEMM_NR) {
+                kernel(kc, packA + ir * kc, packB + jr * kc, c + ir * ldc + jr, ldc, accumulate);
+                continue;
+            }
+
+            /* A tile on the edge of C is computed beside it, and only its part inside C is copied */
+            FOR_RANGE(i, GEMM_MR) {
+                FOR_RANGE(j, GEMM_NR) {
+                    edge[i * GEMM_NR + j] = accumulate && i < mr && j < nr ? c[(ir + i) * ldc + jr + j] : 0;
+                }
+            }
+            kernel(kc, packA + ir * kc, packB + jr * kc, edge, GEMM_NR, accumulate);
+            FOR_RANGE(i, mr) {
+                FOR_RANGE(j, nr) {
+                    c[(ir + i) * ldc + jr + j] = edge[i * GEMM_NR + j];
+                }
+            }
+        }
+    }
+}
+
+/* Multiplies two matrices in blocks with a micro-kernel, on the calling thread */
+static void gemm_blocked(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc,
+                         MicroKernel kernel) {
+
+    PackBuffers *buffers;
+    double *packA, *packB;
+    int jc, pc, ic, nc, kc, mc;
+
+    /* The buffers of the thread are grown to the blocks of this product, and kept for the next one */
+    buffers = pack_buffers((size_t) min_int(GEMM_MC, round_up(m, GEMM_MR)) * (size_t) min_int(GEMM_KC, k),
+                           (size_t) min_int(GEMM_NC, round_up(n, GEMM_NR)) * (size_t) min_int(GEMM_KC, k));
+    packA = buffers->packA;
+    packB = buffers->packB;
+
+    for (jc = 0 ; jc < n ; jc += GEMM_NC) {
+        nc = min_int(GEMM_NC, n - jc);
+        for (pc = 0 ; pc < k ; pc += GEMM_KC) {
+            kc = min_int(GEMM_KC, k - pc);
+            pack_b(kc, nc, b + pc * ldb + jc, ldb, packB);
+
+            /* The first block of the inner dimension sets C, the others add to it */
+            for (ic = 0 ; ic < m ; ic += GEMM_MC) {
+                mc = min_int(GEMM_MC, m - ic);
+                pack_a(mc, kc, a + ic * lda + pc, lda, packA);
+                macro_kernel(mc, nc, kc, packA, packB, c + ic * ldc + jc, ldc, pc > 0 ? TRUE : FALSE, kernel);
+            }
+        }
+    }
+}
+
+/* Multiplies the rows and columns of A and B of a tile of C, a task of the pool */
+static void gemm_tile(void *context, int task) {
+
+    GemmJob *job = (GemmJob *) context;
+    int row = task / job->colTiles * job->tileRows;
+    int col = task % job->colTiles * job->tileCols;
+
+    gemm_blocked(min_int(job->tileRows, job->m - row), min_int(job->tileCols, job->n - col), job->k,
+                 job->a + row * job->lda, job->lda, job->b + col, job->ldb, job->c + row * job->ldc + col, job->ldc,
+                 job->kernel);
+}
+
+/* Multiplies two matrices */
+void gemm(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc) {
+
+    MicroKernel kernel = kernel_scalar;
+    GemmJob job;
+    int tasks, rowTiles, colTiles;
+
+    if ((double) m * (double) n * (double) k < (double) GEMM_MIN_VOLUME) {
+        gemm_small(m, n, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+
+#ifdef GEMM_SIMD
+    switch (mat4_best_kernel()) {
+        case MAT4_SSE2:kernel = kernel_sse2;
+            break;
+        case MAT4_AVX2:kernel = kernel_avx2;
+            break;
+        default:break;
+    }
+#endif
+
+    tasks = parallel_split((double) m * (double) n * (double) k, (double) GEMM_PARALLEL_VOLUME);
+    if (tasks == 1) {
+        gemm_blocked(m, n, k, a, lda, b, ldb, c, ldc, kernel);
+        return;
+    }
+
+    /* C is split by rows, and by columns as well when it has too few rows for the tasks */
+    rowTiles = min_int(tasks, (m + GEMM_MR - 1) / GEMM_MR);
+    colTiles = min_int((tasks + rowTiles - 1) / rowTiles, (n + GEMM_NR - 1) / GEMM_NR);
+
+    job.m = m;
+    job.n = n;
+    job.k = k;
+    job.a = a;
+    job.lda = lda;
+    job.b = b;
+    job.ldb = ldb;
+    job.c = c;
+    job.ldc = ldc;
+    job.tileRows = round_up((m + rowTiles - 1) / rowTiles, GEMM_MR);
+    job.tileCols = round_up((n + colTiles - 1) / colTiles, GEMM_NR);
+    job.colTiles = (n + job.tileCols - 1) / job.tileCols;
+    job.kernel = kernel;
+
+    parallel_for((m + job.tileRows - 1) / job.tileRows * job.colTiles, gemm_tile, &job);
+}
+
+/* Frees the buffers of the calling thread */
+void gemm_free(void) {
+
+    PackBuffers *buffers;
+
+    pthread_once(&packKeyOnce, create_pack_key);
+    buffers = (PackBuffers *) pthread_getspecific(packKey);
+    if (buffers != NULL) {
+        free_pack_buffers(buffers);
+        pthread_setspecific(packKey, NULL);
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * @file gemm_utility.h
+ * @brief Header file containing the general matrix multiplication of large matrices.
+ *
+ * This header file defines the multiplication mul_mat runs on matrices of any shape other than 4x4.
+ * The product is computed in blocks that fit the levels of the cache, as in the GotoBLAS and BLIS
+ * libraries:
+ * - The columns of B are taken GEMM_NC at a time, and the inner dimension GEMM_KC at a time. The
+ *   GEMM_KC x GEMM_NC panel of B is packed into slivers of GEMM_NR columns, and is kept in the L3 cache.
+ * - The rows of A are taken GEMM_MC at a time. The GEMM_MC x GEMM_KC block of A is packed into slivers
+ *   of GEMM_MR rows, and is kept in the L2 cache.
+ * - A micro-kernel multiplies a sliver of A by a sliver of B, the GEMM_MR x GEMM_NR tile of C held in
+ *   registers and the sliver of B kept in the L1 cache. Every element loaded feeds GEMM_MR or GEMM_NR
+ *   multiplications, and the packed slivers are read in order.
+ *
+ * @remark
+ * The micro-kernel follows the set of kernels chosen in simd_utility.h. The AVX2 micro-kernel holds a 6x8
+ * tile of C in 12 vector registers, and updates it with 12 FMA instructions per element of the inner
+ * dimension. The SSE2 micro-kernel holds half of the tile, 6x4, in 12 registers and computes the tile in
+ * two passes over the sliver of A. The scalar micro-kernel accumulates the tile in a local array.
+ *
+ * @remark
+ * A product of at least two tasks of GEMM_PARALLEL_VOLUME multiplications is split into tiles of C, which
+ * run on the pool of parallel_utility.h. C is split by rows, and by columns too when it has too few rows
+ * for the tiles. Every thread packs its blocks into buffers of its own, so the threads share nothing but
+ * A and B, which they only read.
+ *
+ * @remark
+ * The packing buffers of a thread are allocated by its first product computed in blocks and kept for its
+ * next products, growing when a product has larger blocks, so the products of the leaves of the
+ * recursion of strassen_utility.h allocate nothing. The buffers of a worker of the pool are freed when
+ * the worker stops, and those of the calling thread by gemm_free.
+ *
+ * @note
+ * - The matrices are stored row by row, each with its own stride (see MAT_ELEMENT).
+ * - C should not share elements with A or B.
+ * - Products smaller than GEMM_MIN_VOLUME multiplications are computed with a dot product per element,
+ *   as packing them would cost more than it saves.
+ *
+ * @overview
+ * - [Macro] GEMM_MR, GEMM_NR - The shape of the tile of the micro-kernel.
+ * - [Macro] GEMM_MC, GEMM_KC, GEMM_NC - The shape of the blocks of A and B.
+ * - [Macro] GEMM_MIN_VOLUME - The smallest product computed in blocks.
+ * - [Macro] GEMM_PARALLEL_VOLUME - The smallest tile of a product split across threads.
+ * - [Function] gemm(...) - Multiplies two matrices.
+ * - [Function] gemm_free(void) - Frees the packing buffers of the calling thread.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#ifndef GEMM_UTILITY_H
+#define GEMM_UTILITY_H
+
+/**
+ * @brief Number of rows of the tile of C of the micro-kernel.
+ */
+#define GEMM_MR 6
+
+/**
+ * @brief Number of columns of the tile of C of the micro-kernel, two vectors of 4 doubles.
+ */
+#define GEMM_NR 8
+
+/**
+ * @brief Number of rows of a block of A, a multiple of GEMM_MR. A packed block takes 144 KB, in the L2 cache.
+ */
+#define GEMM_MC 72
+
+/**
+ * @brief Length of the inner dimension of a block. A sliver of B takes 16 KB, in the L1 cache.
+ */
+#define GEMM_KC 256
+
+/**
+ * @brief Number of columns of a panel of B, a multiple of GEMM_NR. A packed panel takes 8 MB, in the L3 cache.
+ */
+#define GEMM_NC 4096
+
+/**
+ * @brief Smallest number of multiplications of a product computed in blocks.
+ */
+#define GEMM_MIN_VOLUME (32L * 32L * 32L)
+
+/**
+ * @brief Smallest number of multiplications of a tile of a product split across threads.
+ */
+#define GEMM_PARALLEL_VOLUME (96L * 96L * 96L)
+
+/**
+ * @brief Multiplies two matrices, C = A * B.
+ *
+ * @param[in] m - The number of rows of A and C.
+ * @param[in] n - The number of columns of B and C.
+ * @param[in] k - The number of columns of A and rows of B.
+ * @param[in] a - The elements of A.
+ * @param[in] lda - The stride of the rows of A.
+ * @param[in] b - The elements of B.
+ * @param[in] ldb - The stride of the rows of B.
+ * @param[out] c - The elements of C, which should not share elements with A or B.
+ * @param[in] ldc - The stride of the rows of C.
+ *
+ * @return void
+ *
+ * @complexity
+ * Time Complexity: O(m * n * k), divided among the threads of the pool for a large product.
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   gemm(matrixA->rows, matrixB->cols, matrixA->cols, matrixA->data, matrixA->stride,
+ *        matrixB->data, matrixB->stride, matrixC->data, matrixC->stride);
+ * \endcode
+ */
+void gemm(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc);
+
+/**
+ * @brief Frees the packing buffers of the calling thread.
+ *
+ * The next product computed in blocks on the thread allocates them again.
+ *
+ * @return void
+ */
+void gemm_free(void);
+
+
+#endif /**< GEMM_UTILITY_H */
@@ -2,9 +2,9 @@
  * @file globals.h
  * @brief Header file containing global constants, enums, and declarations.
  *
- * This header file defines global constants such as maximum matrix name length,
- * the number of supported functions, and the number of matrices.
- * It also includes enumerations for boolean values, command types, and matrices.
+ * This header file defines global constants such as the number of supported functions
+ * and the number of predefined matrices.
+ * It also includes enumerations for boolean values and command types.
  *
  * @remark
  * This header file centralizes global constants and enumerations used throughout the program,
@@ -13,25 +13,21 @@
  * @note
  * - The boolean enumeration provides TRUE and FALSE values.
  * - The CommandType enumeration lists supported command types.
- * - The Matrix enumeration lists predefined matrices.
+ * - The matrices are named at run time, and are kept in the registry of registry_utility.h.
  *
  * @see
- * - MAX_MAT_NAME
  * - FUNC_COUNT
  * - NUM_OF_MATRICES
  * - bool enumeration
  * - CommandType enumeration
- * - Matrix enumeration
  */
 
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
-#define MAX_MAT_NAME 5 /**< Maximum length of matrix names. */
+#define FUNC_COUNT 11 /**< Number of supported functions. */
 
-#define FUNC_COUNT 8 /**< Number of supported functions. */
-
-#define NUM_OF_MATRICES 6 /**< Number of predefined matrices. */
+#define NUM_OF_MATRICES 6 /**< Number of predefined matrices, registered when the program starts. */
 
 
 
@@ -89,6 +85,15 @@ typedef enum {
  * @var CommandType::TRANS_MAT
  * Represents the command type for transposing a matrix.
 
+ * @var CommandType::NEW_MAT
+ * Represents the command type for creating a named matrix.
+
+ * @var CommandType::FREE_MAT
+ * Represents the command type for freeing a named matrix.
+
+ * @var CommandType::THREADS
+ * Represents the command type for setting the number of threads of the matrix operations.
+
  * @var CommandType::STOP
  * Represents the command type for stopping the program.
 
@@ -110,57 +115,16 @@ typedef enum {
     MUL_MAT,
     MUL_SCALAR,
     TRANS_MAT,
+    NEW_MAT,
+    FREE_MAT,
+    THREADS,
     STOP,
     NONE_FUNC = -1 /**< Represents the absence of a specific register */
 } CommandType;
 
-/**
- * @enum Matrix
- * @brief Enumeration for predefined matrices.
- *
- * The Matrix enumeration lists the predefined matrices used in the program.
- *
- * @var Matrix::MATRIX_A
- * Represents the matrix with the name "MAT_A".
-
- * @var Matrix::MATRIX_B
- * Represents the matrix with the name "MAT_B".
-
- * @var Matrix::MATRIX_C
- * Represents the matrix with the name "MAT_C".
-
- * @var Matrix::MATRIX_D
- * Represents the matrix with the name "MAT_D".
-
- * @var Matrix::MATRIX_E
- * Represents the matrix with the name "MAT_E".
-
- * @var Matrix::MATRIX_F
- * Represents the matrix with the name "MAT_F".
-
- * @var Matrix::NONE_MATRIX
- * Represents the absence of a specific matrix register.
- *
- * @example
- * \code
- * Matrix currentMatrix = MATRIX_A;
- * \endcode
- * // The `currentMatrix` variable is assigned the value `MATRIX_A` to represent the "MAT_A" matrix.
- * \endcode
- */
-typedef enum {
-    MATRIX_A,
-    MATRIX_B,
-    MATRIX_C,
-    MATRIX_D,
-    MATRIX_E,
-    MATRIX_F,
-    NONE_MATRIX = -1
-} Matrix;
-
 /* List of function names */
 extern const char *funcNames[]; /**< List of function names. */
 
-extern const char *matrices[]; /**< List of matrix names. */
+extern const char *matrices[]; /**< List of the names of the predefined matrices. */
 
 #endif /**< GLOBALS_H */
\ No newline at end of file
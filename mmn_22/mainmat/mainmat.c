@@ -1,11 +1,11 @@
 #include "mainmat.h"
 #include "utility.h"
 #include "process_input.h"
+#include "constants.h"
 #include "message_utility.h"
+#include "registry_utility.h"
 
 
-mat MAT_A, MAT_B, MAT_C, MAT_D, MAT_E, MAT_F;
-
 int main() {
 
     matrices_initialization();
@@ -35,14 +35,12 @@ void program_process() {
 /* Initialize all matrices to 0 in all cells */
 void matrices_initialization() {
 
-    double zero[] = {0};
-    int size = sizeof(zero) / sizeof(zero[0]);
+    int i;
+
+    registry_init();
 
-    read_mat(&MAT_A, zero, size);
-    read_mat(&MAT_B, zero, size);
-    read_mat(&MAT_C, zero, size);
-    read_mat(&MAT_D, zero, size);
-    read_mat(&MAT_E, zero, size);
-    read_mat(&MAT_F, zero, size);
+    FOR_RANGE(i, NUM_OF_MATRICES) {
+        registry_add(matrices[i], strlen(matrices[i]), NUM_OF_ROWS, NUM_OF_COLUMNS);
+    }
 }
 
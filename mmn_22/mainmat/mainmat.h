@@ -31,24 +31,24 @@
 /**
  * @brief Initialize all matrices to zero in all cells.
  *
- * This function initializes all predefined matrices (MAT_A to MAT_F) to zero in all cells.
+ * This function creates the registry of the named matrices, and registers all predefined matrices
+ * (MAT_A to MAT_F) as NUM_OF_ROWS x NUM_OF_COLUMNS matrices with zero in all cells.
  *
  * @return void
  *
- * @var MAT_A to MAT_F - Predefined matrices.
- * @var zero - Array containing a single zero element.
+ * @var matrices - The names of the predefined matrices.
  *
  * @overview
- * This function initializes all predefined matrices to zero in all cells by calling the read_mat function.
+ * This function creates the registry and adds each predefined matrix to it by calling the registry_add function.
  *
  * @algorithm
  * The function follows these steps:
- * 1. Create an array 'zero' containing a single zero element.
- * 2. Determine the size of the 'zero' array.
- * 3. Initialize each predefined matrix to zero by calling the read_mat function with the 'zero' array.
+ * 1. Create an empty registry by calling the registry_init function.
+ * 2. Add each predefined matrix with the default shape by calling the registry_add function.
  *
  * @note
- * - The matrices are initialized using the read_mat function.
+ * - The matrices are created by the registry, which zeroes their elements.
+ * - More matrices are added and removed while the program runs by the 'new_mat' and 'free_mat' commands.
  *
  * @example
  * \code
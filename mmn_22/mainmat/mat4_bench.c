@@ -0,0 +1,176 @@
+/**
+ * @file mat4_bench.c
+ * @brief Benchmark of the vector kernels of simd_utility.h against the scalar loops.
+ *
+ * Every operation is run by every set of kernels the CPU supports over an array of 4x4 matrices,
+ * each operation taking a matrix and the next one, as the commands of the program take the
+ * predefined matrices. The results of every set are checked against the results of the scalar
+ * loops, the products within a rounding error as the FMA instructions round once.
+ *
+ * Usage: mat4_bench [scale], where scale divides the number of operations (1 by default).
+ *
+ * @author Yehonatan Keypur
+ */
+
+#include <time.h>
+
+#include "simd_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Number of 4x4 matrices the operations take, 32 KB of elements.
+ */
+#define BENCH_MATRICES 256
+
+/**
+ * @brief Number of operations per measurement.
+ */
+#define BENCH_OPERATIONS 20000000UL
+
+/**
+ * @brief Largest difference from the scalar loops accepted for a product.
+ */
+#define BENCH_TOLERANCE 1e-12
+
+/**
+ * @enum BenchOperation
+ * @brief Enumeration for the operations of the benchmark.
+ */
+typedef enum {
+    BENCH_ADD,
+    BENCH_SUB,
+    BENCH_MUL,
+    BENCH_MUL_SCALAR,
+    BENCH_TRANS,
+    BENCH_OPERATION_COUNT
+} BenchOperation;
+
+/**
+ * @brief Names of the operations, in the order of BenchOperation.
+ */
+static const char *const operationNames[BENCH_OPERATION_COUNT] = {"add_mat", "sub_mat", "mul_mat", "mul_scalar", "trans_mat"};
+
+/**
+ * @brief State of the pseudo-random generator (xorshift), fixed so runs are comparable.
+ */
+static unsigned long randomState = 2463534242UL;
+
+/* Returns the next pseudo-random number in [-1, 1] */
+static double next_random(void) {
+
+    randomState ^= (randomState << 13) & 0xFFFFFFFFUL;
+    randomState ^= randomState >> 17;
+    randomState ^= (randomState << 5) & 0xFFFFFFFFUL;
+    return (double) randomState / 2147483647.5 - 1.0;
+}
+
+/* Runs an operation of a set over all the matrices */
+static void run_operation(const Mat4Ops *ops, BenchOperation operation, const double *in, double *out) {
+
+    int i;
+    const double *a, *b;
+
+    FOR_RANGE(i, BENCH_MATRICES) {
+        a = in + 16 * i;
+        b = in + 16 * ((i + 1) % BENCH_MATRICES);
+        switch (operation) {
+            case BENCH_ADD:ops->add(a, b, out + 16 * i);
+                break;
+            case BENCH_SUB:ops->sub(a, b, out + 16 * i);
+                break;
+            case BENCH_MUL:ops->mul(a, b, out + 16 * i);
+                break;
+            case BENCH_MUL_SCALAR:ops->mul_scalar(a, 1.5, out + 16 * i);
+                break;
+            case BENCH_TRANS:ops->trans(a, out + 16 * i);
+                break;
+            default:break;
+        }
+    }
+}
+
+/* Returns the largest difference between two arrays of matrices */
+static double max_difference(const double *x, const double *y) {
+
+    double largest = 0;
+    int i;
+
+    FOR_RANGE(i, 16 * BENCH_MATRICES) {
+        if (fabs(x[i] - y[i]) > largest) {
+            largest = fabs(x[i] - y[i]);
+        }
+    }
+    return largest;
+}
+
+/* Runs an operation by every set and prints the time of every set */
+static void run_case(BenchOperation operation, const double *in, double *expected, double *out, int scale) {
+
+    unsigned long repetitions = BENCH_OPERATIONS / (unsigned long) scale / BENCH_MATRICES + 1, r;
+    double elapsed, scalarTime = 0;
+    double tolerance = operation == BENCH_MUL ? BENCH_TOLERANCE : 0;
+    clock_t start;
+    int kernel;
+
+    printf("%-12s", operationNames[operation]);
+    run_operation(mat4_ops(MAT4_SCALAR), operation, in, expected);
+
+    FOR_RANGE(kernel, MAT4_KERNELS) {
+        if (!mat4_kernel_supported((Mat4Kernel) kernel)) {
+            printf(" %16s", "-");
+            continue;
+        }
+
+        start = clock();
+        for (r = 0 ; r < repetitions ; r++) {
+            run_operation(mat4_ops((Mat4Kernel) kernel), operation, in, out);
+        }
+        elapsed = (double) (clock() - start) / CLOCKS_PER_SEC / (double) (repetitions * BENCH_MATRICES);
+        if (kernel == MAT4_SCALAR) {
+            scalarTime = elapsed;
+        }
+
+        /* Every set must compute what the scalar loops compute */
+        if (max_difference(out, expected) > tolerance) {
+            printf(" %16s", "MISMATCH");
+            continue;
+        }
+        printf(" %7.2f (%5.2fx)", elapsed * 1e9, scalarTime / elapsed);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+
+    int scale = argc > 1 ? atoi(argv[1]) : 1;
+    size_t size = sizeof(double) * 16 * BENCH_MATRICES;
+    double *in = (double *) validated_aligned_allocation(size, MAT_ALIGNMENT);
+    double *expected = (double *) validated_aligned_allocation(size, MAT_ALIGNMENT);
+    double *out = (double *) validated_aligned_allocation(size, MAT_ALIGNMENT);
+    int i, kernel;
+
+    if (scale <= 0) {
+        scale = 1;
+    }
+    FOR_RANGE(i, 16 * BENCH_MATRICES) {
+        in[i] = next_random();
+    }
+
+    printf("4x4 operations, nanoseconds per operation (speedup over the scalar loops)\n");
+    printf("%-12s", "operation");
+    FOR_RANGE(kernel, MAT4_KERNELS) {
+        printf(" %16s", mat4_kernel_name((Mat4Kernel) kernel));
+    }
+    printf("\n");
+
+    FOR_RANGE(i, BENCH_OPERATION_COUNT) {
+        run_case((BenchOperation) i, in, expected, out, scale);
+    }
+
+    aligned_memory_free(in);
+    aligned_memory_free(expected);
+    aligned_memory_free(out);
+    return EXIT_SUCCESS;
+}
@@ -1,31 +1,139 @@
 #include "utility.h"
 #include "constants.h"
 #include "message_utility.h"
+#include "simd_utility.h"
+#include "gemm_utility.h"
+#include "strassen_utility.h"
+#include "parallel_utility.h"
 
 
+/**
+ * @brief Structure to represent an element-wise operation split into ranges of rows, each a task of the pool.
+ */
+typedef struct {
+    const mat *matrixA; /**< The first operand. */
+    const mat *matrixB; /**< The second operand, NULL for the multiplication by a scalar. */
+    double scalar;      /**< The scalar of the multiplication by a scalar. */
+    mat *matrixC;       /**< The result, which may be an operand. */
+    int rowsPerTask;    /**< The number of rows of a task. */
+} RowsJob;
+
+/* Rounds a number of columns up to the stride of the rows */
+static int row_stride(int cols) {
+
+    return (cols + MAT_STRIDE_ALIGNMENT - 1) / MAT_STRIDE_ALIGNMENT * MAT_STRIDE_ALIGNMENT;
+}
+
+/* Gives a matrix the shape of a result, keeping its block if the shape is unchanged */
+static void shape_mat(mat *matrix, int rows, int cols) {
+
+    if (matrix->rows != rows || matrix->cols != cols) {
+        free_mat(matrix);
+        init_mat(matrix, rows, cols);
+    }
+}
+
+/* Replaces a matrix with a result computed beside it */
+static void replace_mat(mat *matrix, mat *result) {
+
+    free_mat(matrix);
+    *matrix = *result;
+}
+
+/* Adds the rows of a task */
+static void add_rows(void *context, int task) {
+
+    RowsJob *job = (RowsJob *) context;
+    int first = task * job->rowsPerTask;
+    int row, col;
+
+    for (row = first ; row < job->matrixA->rows && row < first + job->rowsPerTask ; row++) {
+        FOR_RANGE(col, job->matrixA->cols) {
+            MAT_ELEMENT(job->matrixC, row, col) = MAT_ELEMENT(job->matrixA, row, col) +
+                                                  MAT_ELEMENT(job->matrixB, row, col);
+        }
+    }
+}
+
+/* Subtracts the rows of a task */
+static void sub_rows(void *context, int task) {
+
+    RowsJob *job = (RowsJob *) context;
+    int first = task * job->rowsPerTask;
+    int row, col;
+
+    for (row = first ; row < job->matrixA->rows && row < first + job->rowsPerTask ; row++) {
+        FOR_RANGE(col, job->matrixA->cols) {
+            MAT_ELEMENT(job->matrixC, row, col) = MAT_ELEMENT(job->matrixA, row, col) -
+                                                  MAT_ELEMENT(job->matrixB, row, col);
+        }
+    }
+}
+
+/* Multiplies the rows of a task by the scalar */
+static void scale_rows(void *context, int task) {
+
+    RowsJob *job = (RowsJob *) context;
+    int first = task * job->rowsPerTask;
+    int row, col;
+
+    for (row = first ; row < job->matrixA->rows && row < first + job->rowsPerTask ; row++) {
+        FOR_RANGE(col, job->matrixA->cols) {
+            MAT_ELEMENT(job->matrixC, row, col) = MAT_ELEMENT(job->matrixA, row, col) * job->scalar;
+        }
+    }
+}
+
+/* Runs an element-wise operation on the pool, a range of rows per task, or on this thread if it is small */
+static void run_by_rows(ParallelTask work, const mat *matrixA, const mat *matrixB, double scalar, mat *matrixC) {
+
+    RowsJob job;
+    int tasks = parallel_split((double) matrixA->rows * (double) matrixA->cols, PARALLEL_MIN_ELEMENTS);
+
+    job.matrixA = matrixA;
+    job.matrixB = matrixB;
+    job.scalar = scalar;
+    job.matrixC = matrixC;
+    job.rowsPerTask = (matrixA->rows + tasks - 1) / tasks;
+
+    parallel_for((matrixA->rows + job.rowsPerTask - 1) / job.rowsPerTask, work, &job);
+}
+
+/* Creates a matrix of a shape, with all its elements zero */
+void init_mat(mat *matrix, int rows, int cols) {
+
+    size_t size;
+
+    matrix->rows = rows;
+    matrix->cols = cols;
+    matrix->stride = row_stride(cols);
+
+    size = (size_t) rows * (size_t) matrix->stride * sizeof(double);
+    matrix->data = (double *) validated_aligned_allocation(size, MAT_ALIGNMENT);
+    memset(matrix->data, 0, size);
+}
+
+/* Frees the elements of a matrix */
+void free_mat(mat *matrix) {
+
+    aligned_memory_free(matrix->data);
+    matrix->data = NULL;
+    matrix->rows = 0;
+    matrix->cols = 0;
+    matrix->stride = 0;
+}
+
 /* Reads values into a matrix */
 void read_mat(mat *matrix, const double *val, size_t size) {
 
-    int i = 0;
+    size_t i = 0;
     int row, col;
 
-    /* If there are more than 16 values, the function will ignore the excess values */
-    size = size > 16 ? 16 : size;
-
-    /* Insert values */
-    FOR_RANGE(row, size) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            if (i < size) {
-                matrix->data[row][col] = val[i];
-                i++;
-            }
-            else if (i < 16) {
-                matrix->data[row][col] = 0;
-                i++;
-            }
-            else {
-                break;
-            }
+    /* Insert values row by row, the values past the elements of the matrix are ignored */
+    FOR_RANGE(row, matrix->rows) {
+        FOR_RANGE(col, matrix->cols) {
+            MAT_ELEMENT(matrix, row, col) = i < size ? val[i] : 0;
+            i++;
         }
     }
 }
@@ -37,9 +145,9 @@ void print_mat(mat *matrix) {
     bool useScientific = FALSE; /**< Flag to determine if scientific notation is needed */
 
     /* Check if scientific notation is needed */
-    FOR_RANGE(row, NUM_OF_ROWS) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            if (fabs(matrix->data[row][col]) > 1000.0) {
+    FOR_RANGE(row, matrix->rows) {
+        FOR_RANGE(col, matrix->cols) {
+            if (fabs(MAT_ELEMENT(matrix, row, col)) > 1000.0) {
                 useScientific = TRUE;
                 break;
             }
@@ -49,14 +157,14 @@ void print_mat(mat *matrix) {
         }
     }
 
-    FOR_RANGE(row, NUM_OF_ROWS) {
+    FOR_RANGE(row, matrix->rows) {
         printf("\n");
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
+        FOR_RANGE(col, matrix->cols) {
             if (useScientific) {
-                printf("%10.2e\t", matrix->data[row][col]);
+                printf("%10.2e\t", MAT_ELEMENT(matrix, row, col));
             }
             else {
-                printf("%7.2f\t", matrix->data[row][col]);
+                printf("%7.2f\t", MAT_ELEMENT(matrix, row, col));
             }
         }
     }
@@ -64,76 +172,117 @@ void print_mat(mat *matrix) {
 }
 
 /* Add two matrices */
-void add_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
+bool add_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
 
-    int row, col;
-
-    FOR_RANGE(row, NUM_OF_ROWS) {
+    if (matrixA->rows != matrixB->rows || matrixA->cols != matrixB->cols) {
+        return FALSE;
+    }
+    shape_mat(matrixC, matrixA->rows, matrixA->cols);
 
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            matrixC->data[row][col] = matrixA->data[row][col] + matrixB->data[row][col];
-        }
+    if (IS_MAT4(matrixA)) {
+        mat4_best_ops()->add(matrixA->data, matrixB->data, matrixC->data);
+        return TRUE;
     }
+
+    run_by_rows(add_rows, matrixA, matrixB, 0, matrixC);
+    return TRUE;
 }
 
 /* Subtracts one matrix from another */
-void sub_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
+bool sub_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
 
-    int row, col;
+    if (matrixA->rows != matrixB->rows || matrixA->cols != matrixB->cols) {
+        return FALSE;
+    }
+    shape_mat(matrixC, matrixA->rows, matrixA->cols);
 
-    FOR_RANGE(row, NUM_OF_ROWS) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            matrixC->data[row][col] = matrixA->data[row][col] - matrixB->data[row][col];
-        }
+    if (IS_MAT4(matrixA)) {
+        mat4_best_ops()->sub(matrixA->data, matrixB->data, matrixC->data);
+        return TRUE;
     }
+
+    run_by_rows(sub_rows, matrixA, matrixB, 0, matrixC);
+    return TRUE;
 }
 
 /* Multiplies two matrices */
-void mul_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
+bool mul_mat(mat *matrixA, mat *matrixB, mat *matrixC) {
 
-    mat temp_mat = {0};
-    int row, col, k;
+    mat result;
+    mat *target = matrixC;
 
-    FOR_RANGE(row, NUM_OF_ROWS) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
+    if (matrixA->cols != matrixB->rows) {
+        return FALSE;
+    }
 
-            /* Initialize matrixC[row][col] to 0 before accumulating the result */
-            temp_mat.data[row][col] = 0;
+    if (IS_MAT4(matrixA) && IS_MAT4(matrixB)) {
+        shape_mat(matrixC, 4, 4);
+        mat4_best_ops()->mul(matrixA->data, matrixB->data, matrixC->data);
+        return TRUE;
+    }
+
+    /* A destination that is an operand is written only once the product is complete */
+    if (matrixC == matrixA || matrixC == matrixB) {
+        init_mat(&result, matrixA->rows, matrixB->cols);
+        target = &result;
+    }
+    else {
+        shape_mat(matrixC, matrixA->rows, matrixB->cols);
+    }
 
-            /* Calculates the dot product of the row from matrixA and the column from matrixB */
-            FOR_RANGE(k, 4) {
+    strassen_gemm(matrixA->rows, matrixB->cols, matrixA->cols, matrixA->data, matrixA->stride,
+                  matrixB->data, matrixB->stride, target->data, target->stride);
 
-                temp_mat.data[row][col] += matrixA->data[row][k] * matrixB->data[k][col];
-            }
-        }
+    if (target != matrixC) {
+        replace_mat(matrixC, target);
     }
-    copy_mat(&temp_mat, matrixC);
+    return TRUE;
 }
 
 /* Multiplies a matrix by a scalar */
 void mul_scalar(mat *matrixA, double scalar, mat *matrixB) {
 
-    int row, col;
+    shape_mat(matrixB, matrixA->rows, matrixA->cols);
 
-    FOR_RANGE(row, NUM_OF_ROWS) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            matrixB->data[row][col] = matrixA->data[row][col] * scalar;
-        }
+    if (IS_MAT4(matrixA)) {
+        mat4_best_ops()->mul_scalar(matrixA->data, scalar, matrixB->data);
+        return;
     }
+
+    run_by_rows(scale_rows, matrixA, NULL, scalar, matrixB);
 }
 
 /* Transposes a matrix */
 void trans_mat(mat *matrixA, mat *matrixB) {
 
+    mat result;
+    mat *target = matrixB;
     int row, col;
-    mat temp_mat = {0};
 
-    FOR_RANGE(row, NUM_OF_ROWS) {
-        FOR_RANGE(col, NUM_OF_COLUMNS) {
-            temp_mat.data[row][col] = matrixA->data[col][row];
+    if (IS_MAT4(matrixA)) {
+        shape_mat(matrixB, 4, 4);
+        mat4_best_ops()->trans(matrixA->data, matrixB->data);
+        return;
+    }
+
+    /* A matrix transposed into itself is written only once the transpose is complete */
+    if (matrixB == matrixA) {
+        init_mat(&result, matrixA->cols, matrixA->rows);
+        target = &result;
+    }
+    else {
+        shape_mat(matrixB, matrixA->cols, matrixA->rows);
+    }
+
+    FOR_RANGE(row, matrixA->rows) {
+        FOR_RANGE(col, matrixA->cols) {
+            MAT_ELEMENT(target, col, row) = MAT_ELEMENT(matrixA, row, col);
         }
     }
-    copy_mat(&temp_mat, matrixB);
+
+    if (target != matrixB) {
+        replace_mat(matrixB, target);
+    }
 }
 
 /* Stops the program */
@@ -142,4 +291,3 @@ void stop() {
     printf(EXIT_MESSAGE);
     exit(0);
 }
-
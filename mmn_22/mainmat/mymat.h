@@ -2,21 +2,28 @@
  * @file mymat.h
  * @brief Header file containing structures and functions for matrix operations.
  *
- * This header file defines a 4x4 matrix structure and various functions for matrix operations,
- * including reading values into a matrix, printing the contents of a matrix, matrix addition,
+ * This header file defines a dense matrix structure of any shape and various functions for matrix operations,
+ * including creating and freeing a matrix, reading values into a matrix, printing the contents of a matrix, matrix addition,
  * matrix subtraction, matrix multiplication, scalar multiplication, matrix transposition, and program termination.
  *
  * @remark
- * This file encapsulates matrix operations, providing a structured representation of a 4x4 matrix
+ * This file encapsulates matrix operations, providing a structured representation of a matrix
  * and functions to perform common operations such as reading, printing, addition, subtraction, multiplication,
  * scalar multiplication, transposition, and program termination.
  *
  * @note
- * - The matrix structure uses a 2D array ('data') to store its elements.
+ * - The matrix structure stores its elements row by row in one heap block aligned to MAT_ALIGNMENT bytes,
+ *   every row starting `stride` elements after the previous one.
+ * - The operations check the shapes of their operands, and give the destination the shape of the result.
+ * - The 4x4 matrices, the shape of the predefined matrices, take the vector kernels of simd_utility.h.
+ * - The addition, subtraction, multiplication and multiplication by a scalar of large matrices are split
+ *   across the pool of threads of parallel_utility.h; small matrices are computed on the calling thread.
  * - The provided functions ensure proper handling of matrices and enhance the functionality of a matrix processing program.
  *
  * @see
  * - mat structure
+ * - init_mat
+ * - free_mat
  * - read_mat
  * - print_mat
  * - add_mat
@@ -36,38 +43,94 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "globals.h"
 
 /**
- * @brief Structure representing a 4x4 matrix.
+ * @brief Structure representing a dense matrix of any shape.
  *
- * This structure contains a 2D array 'data' to store the elements of a 4x4 matrix.
+ * This structure holds the shape of a matrix and its elements, stored row by row in a single
+ * heap block. The block is aligned to MAT_ALIGNMENT bytes (a cache line), and every row starts
+ * `stride` elements after the previous one, the number of columns rounded up to a multiple of
+ * MAT_STRIDE_ALIGNMENT, so every row is aligned for vector loads.
  *
- * @var data - 2D array to store the elements of the matrix.
+ * @var rows - The number of rows.
+ * @var cols - The number of columns.
+ * @var stride - The number of elements between the starts of two consecutive rows.
+ * @var data - The elements of the matrix, `rows * stride` of them, the padding of every row zero.
  *
  * @overview
- * This structure defines a 4x4 matrix using a 2D array to store its elements.
- *
- * @note
- * - The elements of the matrix are stored in the 'data' array.
+ * This structure defines a matrix of any shape, created by init_mat and released by free_mat.
+ * The element in row `row` and column `col` is `data[row * stride + col]`, read with MAT_ELEMENT.
  *
  * @example
  * \code
  *   // Usage Example:
  *   mat myMatrix;
+ *   init_mat(&myMatrix, 3, 5);
  *   // Accessing an element of the matrix:
- *   myMatrix.data[0][0] = 1.0;
+ *   MAT_ELEMENT(&myMatrix, 0, 0) = 1.0;
+ *   free_mat(&myMatrix);
  * \endcode
  */
 typedef struct {
-    double data[4][4];
+    int rows;     /**< The number of rows. */
+    int cols;     /**< The number of columns. */
+    int stride;   /**< The number of elements between the starts of two consecutive rows. */
+    double *data; /**< The elements, row by row, aligned to MAT_ALIGNMENT bytes. */
 } mat;
 
+/**
+ * @brief Accesses the element of a matrix in a row and a column.
+ *
+ * @param matrix - Pointer to the matrix.
+ * @param row - The row of the element.
+ * @param col - The column of the element.
+ */
+#define MAT_ELEMENT(matrix, row, col) ((matrix)->data[(size_t) (row) * (size_t) (matrix)->stride + (size_t) (col)])
+
+/**
+ * @brief Checks whether a matrix is 4x4, the shape of the specialized path of the operations.
+ *
+ * @param matrix - Pointer to the matrix.
+ */
+#define IS_MAT4(matrix) ((matrix)->rows == 4 && (matrix)->cols == 4)
+
+/**
+ * @brief Creates a matrix of a shape, with all its elements zero.
+ *
+ * This function allocates the aligned block of the elements of a matrix and zeroes it.
+ * The program exits with an error message if the memory cannot be allocated.
+ *
+ * @param[out] matrix - The matrix to create.
+ * @param[in] rows - The number of rows, at least 1.
+ * @param[in] cols - The number of columns, at least 1.
+ *
+ * @return void
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   mat myMatrix;
+ *   init_mat(&myMatrix, 4, 4);
+ * \endcode
+ */
+void init_mat(mat *matrix, int rows, int cols);
+
+/**
+ * @brief Frees the elements of a matrix.
+ *
+ * @param[in,out] matrix - The matrix to free, left with no elements and a 0x0 shape.
+ *
+ * @return void
+ */
+void free_mat(mat *matrix);
+
 
 /**
  * @brief Reads values into a matrix.
  *
  * This function reads values from the input array `val` and inserts them into the matrix `matrix`.
- * If there are more than 16 values, the function will ignore the excess values.
+ * If there are more values than elements in the matrix, the function will ignore the excess values.
  *
  * @param[in,out] matrix - The matrix to store the values.
  * @param[in] val - The array of values to read.
@@ -76,17 +139,18 @@ typedef struct {
  * @return void
  *
  * @overview
- * This function populates the matrix with values from the input array, ensuring a maximum of 16 values are considered.
- * It fills the matrix row by row, column by column, and pads with zeros if the array has fewer than 16 values.
+ * This function populates the matrix with values from the input array, considering at most rows * cols values.
+ * It fills the matrix row by row, column by column, and pads with zeros if the array has fewer values.
  *
  * @note
- * - If the input array `val` has more than 16 values, the excess values are ignored.
+ * - If the input array `val` has more values than the matrix has elements, the excess values are ignored.
  *
  * @example
  * \code
  *   // Usage Example:
  *   double values[10] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0};
  *   mat myMatrix;
+ *   init_mat(&myMatrix, 4, 4);
  *   read_mat(&myMatrix, values, 10);
  * \endcode
  */
@@ -102,8 +166,6 @@ void read_mat(mat *matrix, const double *val, size_t size);
  *
  * @return void
  *
- * @var NUM_OF_ROWS - The total number of rows in the matrix.
- * @var NUM_OF_COLUMNS - The total number of columns in the matrix.
  * @var FOR_RANGE - Macro for iterating over a range.
  * @var fabs - Function to get the absolute value of a floating-point number.
  *
@@ -125,8 +187,6 @@ void read_mat(mat *matrix, const double *val, size_t size);
  * - The matrix parameter is a pointer to the matrix to be printed.
  *
  * @see
- * - NUM_OF_ROWS
- * - NUM_OF_COLUMNS
  * - FOR_RANGE
  * - fabs
  *
@@ -143,16 +203,14 @@ void print_mat(mat *matrix);
  * @brief Add two matrices and store the result in a third matrix.
  *
  * This function adds two matrices (matrixA and matrixB) element-wise and stores the
- * result in another matrix (matrixC).
+ * result in another matrix (matrixC), which takes their shape.
  *
  * @param[in] matrixA - Pointer to the first matrix.
- * @param[in] matrixB - Pointer to the second matrix.
- * @param[out] matrixC - Pointer to the matrix to store the result.
+ * @param[in] matrixB - Pointer to the second matrix, of the shape of the first.
+ * @param[out] matrixC - Pointer to the matrix to store the result, which may be one of the operands.
  *
- * @return void
+ * @return TRUE if the matrices were added, FALSE if their shapes differ (matrixC is left unchanged).
  *
- * @var NUM_OF_ROWS - The total number of rows in the matrices.
- * @var NUM_OF_COLUMNS - The total number of columns in the matrices.
  * @var FOR_RANGE - Macro for iterating over a range.
  *
  * @overview
@@ -170,8 +228,6 @@ void print_mat(mat *matrix);
  * - The matrixC parameter is a pointer to the matrix to store the result.
  *
  * @see
- * - NUM_OF_ROWS
- * - NUM_OF_COLUMNS
  * - FOR_RANGE
  *
  * @example
@@ -181,7 +237,7 @@ void print_mat(mat *matrix);
  *   add_mat(&matrixA, &matrixB, &matrixC);
  * \endcode
  */
-void add_mat(mat *matrixA, mat *matrixB, mat *matrixC);
+bool add_mat(mat *matrixA, mat *matrixB, mat *matrixC);
 
 /**
  * @brief Subtracts one matrix from another.
@@ -189,10 +245,10 @@ void add_mat(mat *matrixA, mat *matrixB, mat *matrixC);
  * This function subtracts the matrix `matrixB` from `matrixA`, storing the result in the matrix `matrixC`.
  *
  * @param[in] matrixA - The matrix to subtract from.
- * @param[in] matrixB - The matrix to subtract.
- * @param[out] matrixC - The resulting matrix after subtraction.
+ * @param[in] matrixB - The matrix to subtract, of the shape of matrixA.
+ * @param[out] matrixC - The resulting matrix after subtraction, which may be one of the operands.
  *
- * @return void
+ * @return TRUE if the matrices were subtracted, FALSE if their shapes differ (matrixC is left unchanged).
  *
  * @overview
  * This function performs element-wise subtraction of the values in matrixA and matrixB, storing the result in matrixC.
@@ -205,21 +261,26 @@ void add_mat(mat *matrixA, mat *matrixB, mat *matrixC);
  *   sub_mat(&matrixA, &matrixB, &resultMatrix);
  * \endcode
  */
-void sub_mat(mat *matrixA, mat *matrixB, mat *matrixC);
+bool sub_mat(mat *matrixA, mat *matrixB, mat *matrixC);
 
 /**
  * @brief Multiplies two matrices.
  *
  * This function multiplies the matrices `matrixA` and `matrixB`, storing the result in the matrix `matrixC`.
  *
- * @param[in] matrixA - The first matrix.
- * @param[in] matrixB - The second matrix.
- * @param[out] matrixC - The resulting matrix after multiplication.
+ * @param[in] matrixA - The first matrix, of shape m x k.
+ * @param[in] matrixB - The second matrix, of shape k x n.
+ * @param[out] matrixC - The resulting m x n matrix after multiplication, which may be one of the operands.
  *
- * @return void
+ * @return TRUE if the matrices were multiplied, FALSE if the columns of matrixA are not the rows of
+ *         matrixB (matrixC is left unchanged).
  *
  * @overview
  * This function performs matrix multiplication of matrixA and matrixB, storing the result in matrixC.
+ * When matrixC is one of the operands, the product is computed into a new block that then replaces its elements.
+ * The product of 4x4 matrices runs on the kernels of simd_utility.h, and the product of other shapes on the
+ * blocked multiplication of gemm_utility.h, through the Strassen-Winograd recursion of strassen_utility.h
+ * when all its dimensions are at least the cutoff.
  *
  * @example
  * \code
@@ -229,7 +290,7 @@ void sub_mat(mat *matrixA, mat *matrixB, mat *matrixC);
  *   mul_mat(&matrixA, &matrixB, &resultMatrix);
  * \endcode
  */
-void mul_mat(mat *matrixA, mat *matrixB, mat *matrixC);
+bool mul_mat(mat *matrixA, mat *matrixB, mat *matrixC);
 
 /**
  * @brief Multiplies a matrix by a scalar.
@@ -238,7 +299,7 @@ void mul_mat(mat *matrixA, mat *matrixB, mat *matrixC);
  *
  * @param[in] matrixA - The matrix to be multiplied.
  * @param[in] scalar - The scalar value for multiplication.
- * @param[out] matrixB - The resulting matrix after scalar multiplication.
+ * @param[out] matrixB - The resulting matrix after scalar multiplication, of the shape of matrixA, which may be matrixA.
  *
  * @return void
  *
@@ -262,7 +323,7 @@ void mul_scalar(mat *matrixA, double scalar, mat *matrixB);
  * This function transposes the matrix `matrixA` and stores the result in the matrix `matrixB`.
  *
  * @param[in] matrixA - The matrix to be transposed.
- * @param[out] matrixB - The resulting transposed matrix.
+ * @param[out] matrixB - The resulting transposed matrix, of the transposed shape, which may be matrixA.
  *
  * @return void
  *
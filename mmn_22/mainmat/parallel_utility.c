@@ -0,0 +1,223 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "parallel_utility.h"
+#include "utility.h"
+
+
+/**
+ * @brief The number of threads of the pool, counting the calling thread, set once before it is first needed.
+ */
+static int numThreads = 1;
+static pthread_once_t numThreadsOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief The workers of the pool, and the number of them running.
+ */
+static pthread_t workers[MAX_THREADS];
+static int numWorkers = 0;
+
+/**
+ * @brief Protects the operation of the pool, and the counters of its tasks.
+ */
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Signaled when an operation is posted or the workers should stop, and when the last task is done.
+ */
+static pthread_cond_t workPosted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t workDone = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief The operation running on the pool.
+ */
+static ParallelTask jobWork = NULL;
+static void *jobContext = NULL;
+static int jobTasks = 0;      /**< The number of tasks of the operation. */
+static int nextTask = 0;      /**< The next task to hand out. */
+static int finishedTasks = 0; /**< The number of tasks done. */
+static bool jobRunning = FALSE;
+static bool stopping = FALSE;
+
+/* Returns the number of threads set by the environment, or else the number of online cores */
+static int default_threads(void) {
+
+    const char *value = getenv(THREADS_ENV);
+    char *end;
+    long threads;
+
+    if (value != NULL) {
+        threads = strtol(value, &end, 10);
+        if (end != value && *end == '\0' && threads >= 1 && threads <= MAX_THREADS) {
+            return (int) threads;
+        }
+    }
+
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) {
+        return 1;
+    }
+    return threads > MAX_THREADS ? MAX_THREADS : (int) threads;
+}
+
+/* Sets the number of threads from the environment or the cores, run once */
+static void init_threads(void) {
+
+    numThreads = default_threads();
+}
+
+/* Runs tasks of the operation until none is left, called and returning with the lock held */
+static void run_tasks(void) {
+
+    ParallelTask work = jobWork;
+    void *context = jobContext;
+    int task;
+
+    while (nextTask < jobTasks) {
+        task = nextTask++;
+        pthread_mutex_unlock(&poolLock);
+        work(context, task);
+        pthread_mutex_lock(&poolLock);
+
+        if (++finishedTasks == jobTasks) {
+            pthread_cond_signal(&workDone);
+        }
+    }
+}
+
+/* Waits for operations and runs their tasks, the work of a worker */
+static void *worker_loop(void *arg) {
+
+    (void) arg;
+
+    pthread_mutex_lock(&poolLock);
+    while (TRUE) {
+        while (!stopping && nextTask >= jobTasks) {
+            pthread_cond_wait(&workPosted, &poolLock);
+        }
+        if (stopping) {
+            break;
+        }
+        run_tasks();
+    }
+    pthread_mutex_unlock(&poolLock);
+    return NULL;
+}
+
+/* Starts the workers of the pool, one less than its threads as the calling thread works too, with the lock held */
+static void start_workers(void) {
+
+    while (numWorkers < numThreads - 1) {
+        if (pthread_create(&workers[numWorkers], NULL, worker_loop, NULL) != 0) {
+            break; /**< The pool goes on with the workers it has */
+        }
+        numWorkers++;
+    }
+}
+
+/* Stops and joins the workers of the pool */
+static void stop_workers(void) {
+
+    int i;
+
+    pthread_mutex_lock(&poolLock);
+    stopping = TRUE;
+    pthread_cond_broadcast(&workPosted);
+    pthread_mutex_unlock(&poolLock);
+
+    FOR_RANGE(i, numWorkers) {
+        pthread_join(workers[i], NULL);
+    }
+    numWorkers = 0;
+    stopping = FALSE;
+}
+
+/* Runs the tasks of an operation one after another on the calling thread */
+static void run_here(int numTasks, ParallelTask work, void *context) {
+
+    int task;
+
+    FOR_RANGE(task, numTasks) {
+        work(context, task);
+    }
+}
+
+/* Returns the number of threads of the pool */
+int parallel_threads(void) {
+
+    pthread_once(&numThreadsOnce, init_threads);
+    return numThreads;
+}
+
+/* Sets the number of threads of the pool */
+bool parallel_set_threads(int threads) {
+
+    if (threads < 1 || threads > MAX_THREADS) {
+        return FALSE;
+    }
+
+    /* The workers of the new number are started by the next operation that is split */
+    pthread_once(&numThreadsOnce, init_threads);
+    stop_workers();
+    numThreads = threads;
+    return TRUE;
+}
+
+/* Returns the number of tasks to split an operation into */
+int parallel_split(double work, double minWork) {
+
+    double tasks;
+
+    /* A small operation does not ask for the number of threads, which would read the environment */
+    if (work < 2 * minWork) {
+        return 1;
+    }
+
+    tasks = work / minWork;
+    if (tasks > (double) parallel_threads() * TASKS_PER_THREAD) {
+        tasks = (double) parallel_threads() * TASKS_PER_THREAD;
+    }
+    return parallel_threads() == 1 ? 1 : (int) tasks;
+}
+
+/* Runs the tasks of an operation on the threads of the pool */
+void parallel_for(int numTasks, ParallelTask work, void *context) {
+
+    /* A single task, a pool of one thread or a call from a task runs here alone */
+    if (numTasks <= 1 || parallel_threads() == 1) {
+        run_here(numTasks, work, context);
+        return;
+    }
+
+    /* A task runs while jobRunning is set, which only the lock makes safe to read */
+    pthread_mutex_lock(&poolLock);
+    if (jobRunning) {
+        pthread_mutex_unlock(&poolLock);
+        run_here(numTasks, work, context);
+        return;
+    }
+
+    start_workers();
+    jobRunning = TRUE;
+    jobWork = work;
+    jobContext = context;
+    jobTasks = numTasks;
+    nextTask = 0;
+    finishedTasks = 0;
+    pthread_cond_broadcast(&workPosted);
+
+    run_tasks();
+    while (finishedTasks < jobTasks) {
+        pthread_cond_wait(&workDone, &poolLock);
+    }
+    jobRunning = FALSE;
+    pthread_mutex_unlock(&poolLock);
+}
+
+/* Stops and joins the workers of the pool */
+void parallel_free(void) {
+
+    stop_workers();
+}
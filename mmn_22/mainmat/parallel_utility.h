@@ -0,0 +1,142 @@
+/**
+ * @file parallel_utility.h
+ * @brief Header file containing the pool of worker threads the large matrix operations run on.
+ *
+ * This header file defines a persistent pool of threads. An operation is split into tasks, numbered from
+ * zero, and parallel_for hands them out one at a time to the workers of the pool and to the calling
+ * thread, returning once all of them are done. The workers are started once and wait for the next
+ * operation between calls, so an operation does not pay for creating and joining threads.
+ *
+ * The multiplication of gemm_utility.h is split into tiles of the product, and the addition, subtraction
+ * and multiplication by a scalar of mymat.h into ranges of rows. The tasks of an operation write disjoint
+ * parts of its result, so they take no lock. An operation smaller than a few tasks of work runs on the
+ * calling thread alone, without waking the pool, so the 4x4 operations keep their latency.
+ *
+ * @remark
+ * The pool has as many threads as the CPU has online cores, counting the calling thread, unless the
+ * environment variable MAINMAT_THREADS sets another number. The 'threads N' command changes the number
+ * while the program runs.
+ *
+ * @note
+ * - The workers are started on the first operation large enough to be split.
+ * - A parallel_for called from a task runs its own tasks on the calling thread.
+ * - If a worker cannot be created, the pool goes on with the threads it has.
+ *
+ * @overview
+ * - [Macro] THREADS_ENV - The environment variable that sets the number of threads.
+ * - [Macro] MAX_THREADS - The largest number of threads.
+ * - [Macro] TASKS_PER_THREAD - The number of tasks per thread an operation is split into.
+ * - [Macro] PARALLEL_MIN_ELEMENTS - The smallest task of an element-wise operation.
+ * - [Typedef] ParallelTask - A task of an operation.
+ * - [Function] parallel_threads(void) - Returns the number of threads of the pool.
+ * - [Function] parallel_set_threads(int threads) - Sets the number of threads of the pool.
+ * - [Function] parallel_split(double work, double minWork) - Returns the number of tasks to split an operation into.
+ * - [Function] parallel_for(int numTasks, ParallelTask work, void *context) - Runs the tasks of an operation.
+ * - [Function] parallel_free(void) - Stops the workers of the pool.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#ifndef PARALLEL_UTILITY_H
+#define PARALLEL_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Name of the environment variable that sets the number of threads.
+ */
+#define THREADS_ENV "MAINMAT_THREADS"
+
+/**
+ * @brief Largest number of threads of the pool, counting the calling thread.
+ */
+#define MAX_THREADS 256
+
+/**
+ * @brief Number of tasks per thread an operation is split into, so threads that finish early take the rest.
+ */
+#define TASKS_PER_THREAD 4
+
+/**
+ * @brief Smallest number of elements of a task of the element-wise operations.
+ */
+#define PARALLEL_MIN_ELEMENTS 65536.0
+
+/**
+ * @brief A task of an operation.
+ *
+ * @param[in,out] context - The operation, shared by its tasks.
+ * @param[in] task - The number of the task, from zero.
+ */
+typedef void (*ParallelTask)(void *context, int task);
+
+/**
+ * @brief Returns the number of threads of the pool.
+ *
+ * On the first call, the number is taken from MAINMAT_THREADS, or else from the number of online cores.
+ *
+ * @return int - The number of threads, counting the calling thread.
+ */
+int parallel_threads(void);
+
+/**
+ * @brief Sets the number of threads of the pool.
+ *
+ * The workers of the pool are stopped, and the new number of workers is started.
+ *
+ * @param[in] threads - The number of threads, counting the calling thread.
+ *
+ * @return bool - TRUE if the number was set, FALSE if it is not between 1 and MAX_THREADS.
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   parallel_set_threads(4);
+ * \endcode
+ */
+bool parallel_set_threads(int threads);
+
+/**
+ * @brief Returns the number of tasks to split an operation into.
+ *
+ * An operation is split into up to TASKS_PER_THREAD tasks per thread, each of at least minWork.
+ * An operation of less than two tasks of minWork, or a pool of one thread, gives one task.
+ *
+ * @param[in] work - The amount of work of the operation, such as its number of elements.
+ * @param[in] minWork - The smallest amount of work of a task.
+ *
+ * @return int - The number of tasks, at least 1.
+ */
+int parallel_split(double work, double minWork);
+
+/**
+ * @brief Runs the tasks of an operation on the threads of the pool, and waits for all of them.
+ *
+ * The calling thread runs tasks as well. With one task, or a pool of one thread, the tasks run on the
+ * calling thread alone.
+ *
+ * @param[in] numTasks - The number of tasks.
+ * @param[in] work - The function run for every task.
+ * @param[in,out] context - The operation, given to every task.
+ *
+ * @return void
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   parallel_for(parallel_split((double) rows * cols, PARALLEL_MIN_ELEMENTS), add_rows, &job);
+ * \endcode
+ */
+void parallel_for(int numTasks, ParallelTask work, void *context);
+
+/**
+ * @brief Stops and joins the workers of the pool.
+ *
+ * The next operation large enough to be split starts the pool again.
+ *
+ * @return void
+ */
+void parallel_free(void);
+
+
+#endif /**< PARALLEL_UTILITY_H */
@@ -2,11 +2,12 @@
 #include "constants.h"
 #include "error_utility.h"
 #include "message_utility.h"
+#include "registry_utility.h"
+#include "parallel_utility.h"
+#include "strassen_utility.h"
+#include "gemm_utility.h"
 
 
-/* Extern the matrices */
-extern mat MAT_A, MAT_B, MAT_C, MAT_D, MAT_E, MAT_F;
-
 /* Get user input */
 void get_input(char userInput[]) {
 
@@ -29,7 +30,7 @@ bool line_process(char **userInput) {
     *userInput = (char *) validated_memory_allocation(sizeof(char *) * (size_t) INIT_LINE_SIZE);
 
     /* Check if successfully read a line using get_line function */
-    if (get_line(*userInput)) {
+    if (get_line(userInput)) {
 
         /* Check if the line is only with spaces */
         if (IS_END_OF_COMMAND(*userInput)) {
@@ -49,7 +50,7 @@ bool line_process(char **userInput) {
 }
 
 /* Reads a line from standard input */
-bool get_line(char *line) {
+bool get_line(char **line) {
 
     int ch, i;                                   /**< Character and index variables  */
     char *tempLine;                              /**< Temporary variable for memory allocation */
@@ -62,32 +63,35 @@ bool get_line(char *line) {
         /* Handle EOF error */
         if (ch == EOF) {
             error_handling(EOF_ERR);
-            free(line); /**< Deallocate the memory pointed to by the pointer */
+            free(*line); /**< Deallocate the memory pointed to by the pointer */
             exit(0);
         }
 
-        line[i] = (char) ch;
+        (*line)[i] = (char) ch;
 
         /* Double the line length if the current index is at the end */
         if (i == lineLength - 1) {
 
             lineLength *= 2;
-            tempLine = (char *) realloc(line, (lineLength + 1) * sizeof(char));
+            tempLine = (char *) realloc(*line, (lineLength + 1) * sizeof(char));
 
             /* Check for memory allocation failure */
             if (tempLine == NULL) {
                 handle_memory_allocation_failure();
             }
             else {
-                /* Update the line pointer and reset the temporary pointer */
-                line = tempLine;
+                /* Update the line pointer of the caller and reset the temporary pointer */
+                *line = tempLine;
                 tempLine = NULL;
             }
         }
     }
 
+    /* Terminate the line, the parsing of the arguments stops at the null terminator */
+    (*line)[i] = '\0';
+
     /* Return TRUE if the last character is the null terminator, FALSE otherwise */
-    return line[i] == '\0' ? TRUE : FALSE;
+    return (*line)[i] == '\0' ? TRUE : FALSE;
 }
 
 /* Analyzes and processes user input for matrix operations */
@@ -122,11 +126,26 @@ void analyze_input(char *userInput) {
     /* Check for stop command */
     if (cmdType == STOP) {
         handle_stop(userInput);
+        return; /**< Reach here only if there was an error */
     }
 
     /* Check for missing argument */
     MISSING_ARGUMENT(userInput)
 
+    /* The first argument of these commands is a name, which is not a defined matrix for 'new_mat' */
+    if (cmdType == NEW_MAT) {
+        handle_new_mat(userInput);
+        return;
+    }
+    if (cmdType == FREE_MAT) {
+        handle_free_mat(userInput);
+        return;
+    }
+    if (cmdType == THREADS) {
+        handle_threads(userInput);
+        return;
+    }
+
     /* Get the first matrix */
     firstMat = whichMatrix(userInput);
 
@@ -172,11 +191,14 @@ void analyze_input(char *userInput) {
 /* Handle 'stop' command in user input */
 void handle_stop(char *userInput) {
 
-    /* Errors check */
-    userInput++; /**< Move the pointer to the next position (after the 'stop' command) */
+    /* Errors check, the pointer is already after the 'stop' command and its spaces */
     EXTRANEOUS_TEXT(userInput) /**< Check for extraneous text after the end of the command */
 
-    stop(); /**< Stop the program */
+    registry_free(); /**< Free all the matrices */
+    strassen_free(); /**< Free the temporaries of the fast multiplication */
+    gemm_free();     /**< Free the packing buffers of the multiplication */
+    parallel_free(); /**< Stop the worker threads */
+    stop();          /**< Stop the program */
 }
 
 /* Handle 'print_mat' command in user input */
@@ -283,8 +305,9 @@ void handle_mul_scalar(char *userInput, mat *firstMat) {
 /* Handle matrix addition, subtraction, or multiplication command in user input */
 void handle_add_sub_mul(char *userInput, mat *firstMat, CommandType cmdType) {
 
-    mat *secondMatrix; /* The second matrix argument */
-    mat *thirdMatrix;  /* The third matrix argument */
+    mat *secondMatrix;       /* The second matrix argument */
+    mat *thirdMatrix;        /* The third matrix argument */
+    bool shapesMatch = TRUE; /* Whether the shapes of the matrices fit the operation */
 
     /* Error checking */
     MISSING_COMMA(userInput)
@@ -334,24 +357,31 @@ void handle_add_sub_mul(char *userInput, mat *firstMat, CommandType cmdType) {
 
     /* The input is valid, therefore, activate the corresponding function */
     switch (cmdType) {
-        case ADD_MAT:add_mat(firstMat, secondMatrix, thirdMatrix);
+        case ADD_MAT:shapesMatch = add_mat(firstMat, secondMatrix, thirdMatrix);
             break;
-        case SUB_MAT:sub_mat(firstMat, secondMatrix, thirdMatrix);
+        case SUB_MAT:shapesMatch = sub_mat(firstMat, secondMatrix, thirdMatrix);
             break;
-        case MUL_MAT:mul_mat(firstMat, secondMatrix, thirdMatrix);
+        case MUL_MAT:shapesMatch = mul_mat(firstMat, secondMatrix, thirdMatrix);
             break;
         default:break; /**< Intentionally ignored, as they are handled elsewhere */
     }
+
+    /* The shapes of the matrices are only known to the operation */
+    if (!shapesMatch) {
+        error_handling(SHAPE_MISMATCH_ERR);
+    }
 }
 
 /* Handle 'read_mat' command in user input */
 void handle_read_mat(char *userInput, mat *firstMat) {
 
-    int i = 0;                 /** Counter for the loop */
-    double values[16] = {0};   /**< Array to store the input values */
+    size_t i = 0;              /** Counter for the loop */
+    double *values = NULL;     /**< Array to store the input values, grown as they are parsed */
+    double *tempValues;        /**< Temporary pointer for reallocating the values */
+    size_t capacity = 0;       /**< The number of values the array can hold */
     char *endPtr;              /**< A pointer for 'strtod' function */
     char tempChar;             /** Temporary variable for error checking */
-    size_t numOfVal;           /** The number of input values */
+    size_t numOfVal;           /** The number of elements of the matrix */
 
     /* Error checking */
     MISSING_ARGUMENT(userInput)
@@ -365,11 +395,27 @@ void handle_read_mat(char *userInput, mat *firstMat) {
     MULTIPLE_CONSECUTIVE_COMMAS(userInput)
     MISSING_ARGUMENT(userInput)
 
+    /* The values past the elements of the matrix are parsed but not kept */
+    numOfVal = (size_t) firstMat->rows * (size_t) firstMat->cols;
+
     endPtr = userInput;
     /* Loop to extract numbers */
     while (IS_NOT_END_OF_COMMAND(userInput)) {
 
-        if (i < 16) {
+        if (i < numOfVal) {
+
+            /* Double the array when it is full, up to one value per element of the matrix */
+            if (i == capacity) {
+                capacity = (capacity == 0) ? INIT_VALUES_SIZE : capacity * 2;
+                if (capacity > numOfVal) {
+                    capacity = numOfVal;
+                }
+                tempValues = (double *) realloc(values, capacity * sizeof(double));
+                if (tempValues == NULL) {
+                    handle_memory_allocation_failure();
+                }
+                values = tempValues;
+            }
             values[i] = strtod(userInput, &endPtr);
             i++;
         }
@@ -380,6 +426,7 @@ void handle_read_mat(char *userInput, mat *firstMat) {
         /* Check if conversion was successful */
         if (userInput == endPtr) {
             error_handling(ARG_IS_NOT_DOUBLE);
+            free(values);
             return;
         }
 
@@ -407,31 +454,141 @@ void handle_read_mat(char *userInput, mat *firstMat) {
 
                 /* Reach here if there is an extraneous text after an end of command */
                 error_handling(EXT_TXT_ERR);
+                free(values);
                 return;
             }
             else if (tempChar != ',') { /**< True if didn't reach end of command */
 
                 /* Reach here if there is a missing comma */
                 error_handling(NO_COMMA_ERR);
+                free(values);
                 return;
             }
             else if (*userInput && *userInput == ',') { /**< True if didn't reach end of command */
 
                 /* Reach here if there are too many commas */
                 error_handling(UNNECESSARY_COMMA_ERR);
+                free(values);
                 return;
             }
         }
     }
 
     /* Error checking */
-    if (IS_NOT_END_OF_COMMAND(userInput)) {
-        MISSING_COMMA(userInput)
+    if (IS_NOT_END_OF_COMMAND(userInput) && *userInput != ',') {
+        error_handling(NO_COMMA_ERR);
+        free(values);
+        return;
+    }
+
+    /* If reach here, the input is valid, and the elements without a value are zero */
+    read_mat(firstMat, values, i);
+    free(values);
+}
+
+/* Handle 'new_mat' command in user input */
+void handle_new_mat(char *userInput) {
+
+    char *name = userInput;                     /**< The name of the new matrix */
+    size_t length = mat_name_length(userInput); /**< The length of the name */
+    int rows, cols;                             /**< The shape of the new matrix */
+
+    /* The name should be a valid name, which no matrix has */
+    if (length == 0) {
+        error_handling(INVALID_MAT_NAME_ERR);
+        return;
+    }
+    if (registry_find(name, length) != NULL) {
+        error_handling(MAT_EXISTS_ERR);
+        return;
     }
 
-    /* Get the number of values */
-    numOfVal = sizeof(values) / sizeof(values[0]);
+    /* Move the pointer after the name */
+    MOVE_AFTER_MAT(userInput)
+    MOVE_TO_NON_WHITE(userInput)
 
-    /* If reach here, the input is valid */
-    read_mat(firstMat, values, numOfVal);
-}
\ No newline at end of file
+    /* Error checking */
+    MISSING_COMMA(userInput)
+    userInput++;
+    MOVE_TO_NON_WHITE(userInput)
+    MULTIPLE_CONSECUTIVE_COMMAS(userInput)
+    MISSING_ARGUMENT(userInput)
+
+    /* Get the number of rows */
+    if (!getDimension(&userInput, &rows)) {
+        error_handling(INVALID_DIMENSION_ERR);
+        return;
+    }
+
+    /* Error checking */
+    MOVE_TO_NON_WHITE(userInput)
+    MISSING_COMMA(userInput)
+    userInput++;
+    MOVE_TO_NON_WHITE(userInput)
+    MULTIPLE_CONSECUTIVE_COMMAS(userInput)
+    MISSING_ARGUMENT(userInput)
+
+    /* Get the number of columns */
+    if (!getDimension(&userInput, &cols)) {
+        error_handling(INVALID_DIMENSION_ERR);
+        return;
+    }
+
+    /* Error checking */
+    MOVE_TO_NON_WHITE(userInput)
+    EXTRANEOUS_TEXT(userInput)
+
+    /* The input is valid, therefore, create the matrix */
+    registry_add(name, length, rows, cols);
+}
+
+/* Handle 'free_mat' command in user input */
+void handle_free_mat(char *userInput) {
+
+    char *name = userInput;                     /**< The name of the matrix */
+    size_t length = mat_name_length(userInput); /**< The length of the name */
+
+    /* There should be a matrix in this point */
+    if (length == 0 || registry_find(name, length) == NULL) {
+        error_handling(UNDEFINED_MAT_ERR);
+        return;
+    }
+
+    /* Move the pointer after the matrix */
+    MOVE_AFTER_MAT(userInput)
+    MOVE_TO_NON_WHITE(userInput)
+
+    /* Error checking */
+    EXTRANEOUS_TEXT(userInput)
+
+    /* The input is valid, therefore, free the matrix */
+    registry_remove(name, length);
+}
+
+/* Handle 'threads' command in user input */
+void handle_threads(char *userInput) {
+
+    char *endPtr;    /**< The end of the number */
+    long threads;    /**< The number of threads */
+
+    /* The number should be a positive integer, followed by the end of the command */
+    if (!isdigit((unsigned char) *userInput)) {
+        error_handling(INVALID_THREADS_ERR);
+        return;
+    }
+    threads = strtol(userInput, &endPtr, 10);
+    if (*endPtr && !isspace((unsigned char) *endPtr) && *endPtr != ',') {
+        error_handling(INVALID_THREADS_ERR);
+        return;
+    }
+    userInput = endPtr;
+
+    /* Error checking */
+    MOVE_TO_NON_WHITE(userInput)
+    EXTRANEOUS_TEXT(userInput)
+
+    /* The input is valid, therefore, set the number of threads */
+    if (threads > MAX_THREADS || !parallel_set_threads((int) threads)) {
+        error_handling(INVALID_THREADS_ERR);
+    }
+}
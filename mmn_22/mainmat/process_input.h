@@ -127,9 +127,9 @@ bool line_process(char **userInput);
 /**
  * @brief Reads a line from standard input.
  *
- * This function reads a line from the standard input and stores it in the provided character array `line`.
+ * This function reads a line from the standard input and stores it in the character array pointed to by `line`.
  *
- * @param[out] line - The character array to store the read line.
+ * @param[in,out] line - Pointer to the character array to store the read line, updated when the array is reallocated.
  *
  * @return Boolean value indicating the success of reading the line.
  * - Returns TRUE if the line is successfully read.
@@ -144,6 +144,7 @@ bool line_process(char **userInput);
  * - If an EOF is encountered, the function performs error handling using the `error_handling` function and exits with status 0.
  * - Memory for the input line is dynamically allocated and resized as needed.
  * - If memory reallocation fails, the function calls `handle_memory_allocation_failure`.
+ * - The array may move when it grows, so the caller reads the line through `*line` after the call.
  *
  * @see
  * - error_handling
@@ -152,15 +153,15 @@ bool line_process(char **userInput);
  * @example
  * \code
  *   // Usage Example:
- *   char *inputLine = NULL;
- *   if (get_line(inputLine)) {
+ *   char *inputLine = (char *) validated_memory_allocation(INIT_LINE_SIZE + 1);
+ *   if (get_line(&inputLine)) {
  *       // Successfully read the line, process it accordingly.
  *   } else {
  *       // Error occurred or EOF encountered.
  *   }
  * \endcode
  */
-bool get_line(char *line);
+bool get_line(char **line);
 
 /**
  * @brief Analyzes and processes user input for matrix operations.
@@ -180,6 +181,8 @@ bool get_line(char *line);
  * @note
  * - The function utilizes various macros (e.g., `MOVE_TO_NON_WHITE`, `MOVE_TO_NEXT_WORD`, `ILLEGAL_COMMA`, `MISSING_ARGUMENT`) for pointer movement and error checking.
  * - Matrix operations are handled by specific functions (e.g., `handle_print_mat`, `handle_trans_mat`, `handle_mul_scalar`, `handle_add_sub_mul`, `handle_read_mat`).
+ * - The 'new_mat' and 'free_mat' commands take a matrix name rather than a defined matrix, and are handled by `handle_new_mat` and `handle_free_mat`.
+ * - The 'threads' command takes a number rather than a matrix, and is handled by `handle_threads`.
  *
  * @see
  * - first_Word_analysis
@@ -208,7 +211,7 @@ void analyze_input(char *userInput);
  * text, and ultimately stops the program.
  *
  * @param[in,out] userInput - User input containing the 'stop' command.
- * @note The userInput pointer should point to the 'stop' command in the input.
+ * @note The userInput pointer should point after the 'stop' command in the input.
  *
  * @return void
  *
@@ -216,18 +219,20 @@ void analyze_input(char *userInput);
  *
  * @overview
  * This function is responsible for handling the 'stop' command in the user input.
- * It moves the userInput pointer to the next position (after the 'stop' command),
+ * The userInput pointer is already past the 'stop' command and the spaces after it, so it
  * checks for extraneous text using the EXTRANEOUS_TEXT macro, and finally stops
  * the program by calling the stop function.
  *
  * @algorithm
  * The function follows these steps:
- * 1. Move the userInput pointer to the next position (after the 'stop' command).
- * 2. Check for extraneous text using the EXTRANEOUS_TEXT macro.
- * 3. Stop the program by calling the stop function.
+ * 1. Check for extraneous text using the EXTRANEOUS_TEXT macro.
+ * 2. Free the registry of the named matrices by calling the registry_free function.
+ * 3. Free the arena of the Strassen-Winograd multiplication by calling the strassen_free function.
+ * 4. Stop the worker threads of the matrix operations by calling the parallel_free function.
+ * 5. Stop the program by calling the stop function.
  *
  * @note
- * - The userInput pointer should point to the 'stop' command in the input.
+ * - The userInput pointer should point after the 'stop' command in the input.
  *
  * @see
  * - EXTRANEOUS_TEXT
@@ -536,5 +541,100 @@ void handle_add_sub_mul(char *userInput, mat *firstMat, CommandType cmdType);
  */
 void handle_read_mat(char *userInput, mat *firstMat);
 
+/**
+ * @brief Handle 'new_mat' command in user input.
+ *
+ * This function processes the 'new_mat' command in the user input, validates for errors,
+ * and creates a named matrix of the given shape with zero in all cells.
+ *
+ * @param[in] userInput - User input pointing at the name of the new matrix, followed by its
+ *                        number of rows and of columns: "NAME, rows, cols".
+ *
+ * @return void
+ *
+ * @var MISSING_COMMA - Macro to check for a missing comma in the user input.
+ * @var MULTIPLE_CONSECUTIVE_COMMAS - Macro to check for multiple consecutive commas in the user input.
+ * @var MISSING_ARGUMENT - Macro to check for a missing argument in the user input.
+ * @var EXTRANEOUS_TEXT - Macro to check for extraneous text after the end of the command.
+ *
+ * @algorithm
+ * The function follows these steps:
+ * 1. Measure the name using the mat_name_length function; if it is not a name, call error_handling and return.
+ * 2. Check that no matrix has the name using the registry_find function; if one has, call error_handling and return.
+ * 3. Extract the number of rows and of columns using the getDimension function, checking the commas between the arguments.
+ * 4. Check for extraneous text using the EXTRANEOUS_TEXT macro.
+ * 5. Create the matrix using the registry_add function.
+ *
+ * @note
+ * - The dimensions are positive integers of at most MAX_MAT_DIMENSION.
+ *
+ * @see
+ * - mat_name_length()
+ * - getDimension()
+ * - registry_find()
+ * - registry_add()
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   char userInput[] = "MAT_G, 3, 5";
+ *   handle_new_mat(userInput);
+ *   // MAT_G is now a 3x5 matrix with zero in all cells.
+ * \endcode
+ */
+void handle_new_mat(char *userInput);
+
+/**
+ * @brief Handle 'free_mat' command in user input.
+ *
+ * This function processes the 'free_mat' command in the user input, validates for errors,
+ * and removes the named matrix, freeing its memory. The name may be defined again with 'new_mat'.
+ *
+ * @param[in] userInput - User input pointing at the name of the matrix.
+ *
+ * @return void
+ *
+ * @var EXTRANEOUS_TEXT - Macro to check for extraneous text after the end of the command.
+ *
+ * @see
+ * - registry_find()
+ * - registry_remove()
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   char userInput[] = "MAT_G";
+ *   handle_free_mat(userInput);
+ * \endcode
+ */
+void handle_free_mat(char *userInput);
+
+/**
+ * @brief Handle 'threads' command in user input.
+ *
+ * This function processes the 'threads' command in the user input, validates for errors,
+ * and sets the number of threads the large matrix operations run on, counting the main thread.
+ *
+ * @param[in] userInput - User input pointing at the number of threads.
+ *
+ * @return void
+ *
+ * @var EXTRANEOUS_TEXT - Macro to check for extraneous text after the end of the command.
+ *
+ * @note
+ * - The number should be between 1 and MAX_THREADS; 'threads 1' runs every operation on the main thread.
+ *
+ * @see
+ * - parallel_set_threads()
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   char userInput[] = "4";
+ *   handle_threads(userInput);
+ * \endcode
+ */
+void handle_threads(char *userInput);
+
 
 #endif /**< PROCESS_INPUT_H */
@@ -0,0 +1,152 @@
+#include "registry_utility.h"
+#include "utility.h"
+
+
+/* The buckets of the registry, with the number of buckets and of entries */
+static MatEntry **buckets = NULL;
+static size_t capacity = 0;
+static size_t count = 0;
+
+/* Hashes a name with the 32 bit FNV-1a hash */
+static unsigned long hash_name(const char *name, size_t length) {
+
+    unsigned long hash = 2166136261UL;
+    size_t i;
+
+    FOR_RANGE(i, length) {
+        hash ^= (unsigned char) name[i];
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+/* Returns the link that points at the entry of a name, or at the end of its bucket */
+static MatEntry **find_link(const char *name, size_t length, unsigned long hash) {
+
+    MatEntry **link = &buckets[hash & (capacity - 1)];
+
+    while (*link != NULL) {
+        if ((*link)->hash == hash && (*link)->length == length && memcmp((*link)->name, name, length) == 0) {
+            break;
+        }
+        link = &(*link)->next;
+    }
+    return link;
+}
+
+/* Doubles the buckets of the registry, moving every entry to its new bucket */
+static void grow_registry(void) {
+
+    size_t newCapacity = capacity * 2;
+    MatEntry **newBuckets;
+    MatEntry *entry, *next;
+    size_t i;
+
+    newBuckets = (MatEntry **) validated_memory_allocation(sizeof(MatEntry *) * newCapacity);
+    FOR_RANGE(i, newCapacity) {
+        newBuckets[i] = NULL;
+    }
+
+    FOR_RANGE(i, capacity) {
+        for (entry = buckets[i] ; entry != NULL ; entry = next) {
+            next = entry->next;
+            entry->next = newBuckets[entry->hash & (newCapacity - 1)];
+            newBuckets[entry->hash & (newCapacity - 1)] = entry;
+        }
+    }
+
+    free(buckets);
+    buckets = newBuckets;
+    capacity = newCapacity;
+}
+
+/* Creates an empty registry */
+void registry_init(void) {
+
+    size_t i;
+
+    capacity = REGISTRY_INIT_CAPACITY;
+    count = 0;
+    buckets = (MatEntry **) validated_memory_allocation(sizeof(MatEntry *) * capacity);
+    FOR_RANGE(i, capacity) {
+        buckets[i] = NULL;
+    }
+}
+
+/* Returns the matrix with a name */
+mat *registry_find(const char *name, size_t length) {
+
+    MatEntry *entry = *find_link(name, length, hash_name(name, length));
+
+    return entry != NULL ? &entry->matrix : NULL;
+}
+
+/* Adds a matrix with a name */
+mat *registry_add(const char *name, size_t length, int rows, int cols) {
+
+    unsigned long hash = hash_name(name, length);
+    MatEntry **link = find_link(name, length, hash);
+    MatEntry *entry;
+
+    if (*link != NULL) {
+        return NULL;
+    }
+
+    entry = (MatEntry *) validated_memory_allocation(sizeof(MatEntry));
+    entry->name = (char *) validated_memory_allocation(length + 1);
+    memcpy(entry->name, name, length);
+    entry->name[length] = '\0';
+    entry->length = length;
+    entry->hash = hash;
+    init_mat(&entry->matrix, rows, cols);
+
+    /* New entries are added at the head of their bucket */
+    entry->next = buckets[hash & (capacity - 1)];
+    buckets[hash & (capacity - 1)] = entry;
+    count++;
+
+    if (count * 4 > capacity * 3) {
+        grow_registry();
+    }
+    return &entry->matrix;
+}
+
+/* Removes the matrix with a name */
+bool registry_remove(const char *name, size_t length) {
+
+    MatEntry **link = find_link(name, length, hash_name(name, length));
+    MatEntry *entry = *link;
+
+    if (entry == NULL) {
+        return FALSE;
+    }
+
+    *link = entry->next;
+    free_mat(&entry->matrix);
+    free(entry->name);
+    free(entry);
+    count--;
+
+    return TRUE;
+}
+
+/* Frees the registry and all its matrices */
+void registry_free(void) {
+
+    MatEntry *entry, *next;
+    size_t i;
+
+    FOR_RANGE(i, capacity) {
+        for (entry = buckets[i] ; entry != NULL ; entry = next) {
+            next = entry->next;
+            free_mat(&entry->matrix);
+            free(entry->name);
+            free(entry);
+        }
+    }
+
+    free(buckets);
+    buckets = NULL;
+    capacity = 0;
+    count = 0;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file registry_utility.h
+ * @brief Header file containing the registry of the named matrices of a matrix processing program.
+ *
+ * This header file defines the registry that maps the name of every matrix of the program to the matrix.
+ * The predefined matrices are registered when the program starts, and the 'new_mat' and 'free_mat'
+ * commands add and remove matrices while it runs.
+ *
+ * @remark
+ * The registry is a hash table with separate chaining. A name is hashed once with the FNV-1a hash,
+ * and only the entries of its bucket are compared with it, so a matrix argument is resolved in
+ * constant expected time however many matrices are registered.
+ *
+ * @note
+ * - The table doubles its buckets once it holds more than 3/4 of an entry per bucket.
+ * - Every entry is allocated on its own, so the matrix of an entry keeps its address while the
+ *   table grows, until the matrix is removed.
+ * - The names are the names read from the input, so they are given by a pointer and a length
+ *   and need not be terminated.
+ *
+ * @overview
+ * - [Struct] MatEntry - A named matrix of the registry.
+ * - [Function] registry_init(void) - Creates an empty registry.
+ * - [Function] registry_find(const char *name, size_t length) - Returns the matrix with a name.
+ * - [Function] registry_add(const char *name, size_t length, int rows, int cols) - Adds a matrix with a name.
+ * - [Function] registry_remove(const char *name, size_t length) - Removes the matrix with a name.
+ * - [Function] registry_free(void) - Frees the registry and all its matrices.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#ifndef REGISTRY_UTILITY_H
+#define REGISTRY_UTILITY_H
+
+#include <stddef.h>
+
+#include "globals.h"
+#include "mymat.h"
+
+/**
+ * @brief Initial number of buckets of the registry, a power of two.
+ */
+#define REGISTRY_INIT_CAPACITY 16
+
+/**
+ * @struct MatEntry
+ * @brief A named matrix of the registry.
+ *
+ * @var MatEntry::name
+ * The name of the matrix, terminated by a null character.
+ *
+ * @var MatEntry::length
+ * The length of the name.
+ *
+ * @var MatEntry::hash
+ * The hash of the name, compared before the name and kept to move the entry when the table grows.
+ *
+ * @var MatEntry::matrix
+ * The matrix.
+ *
+ * @var MatEntry::next
+ * The next entry of the bucket.
+ */
+typedef struct MatEntry {
+    char *name;
+    size_t length;
+    unsigned long hash;
+    mat matrix;
+    struct MatEntry *next;
+} MatEntry;
+
+/**
+ * @brief Creates an empty registry.
+ *
+ * @return void
+ *
+ * @note
+ * - The registry should be created before any of the other functions is called.
+ */
+void registry_init(void);
+
+/**
+ * @brief Returns the matrix with a name.
+ *
+ * @param[in] name - Pointer to the name.
+ * @param[in] length - The length of the name.
+ *
+ * @return mat* - Pointer to the matrix if a matrix has the name, NULL otherwise.
+ *
+ * @complexity
+ * Time Complexity: O(length) expected.
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   mat *matrix = registry_find("MAT_A", 5);
+ *   if (matrix != NULL) {
+ *       // The matrix is defined.
+ *   }
+ * \endcode
+ */
+mat *registry_find(const char *name, size_t length);
+
+/**
+ * @brief Adds a matrix with a name, with zero in all cells.
+ *
+ * @param[in] name - Pointer to the name.
+ * @param[in] length - The length of the name.
+ * @param[in] rows - The number of rows of the matrix.
+ * @param[in] cols - The number of columns of the matrix.
+ *
+ * @return mat* - Pointer to the new matrix, or NULL if a matrix already has the name.
+ *
+ * @complexity
+ * Time Complexity: O(length + rows * cols) amortized.
+ */
+mat *registry_add(const char *name, size_t length, int rows, int cols);
+
+/**
+ * @brief Removes the matrix with a name and frees it.
+ *
+ * @param[in] name - Pointer to the name.
+ * @param[in] length - The length of the name.
+ *
+ * @return bool - TRUE if the matrix was removed, FALSE if no matrix has the name.
+ *
+ * @complexity
+ * Time Complexity: O(length) expected.
+ */
+bool registry_remove(const char *name, size_t length);
+
+/**
+ * @brief Frees the registry and all its matrices.
+ *
+ * @return void
+ */
+void registry_free(void);
+
+
+#endif /**< REGISTRY_UTILITY_H */
@@ -0,0 +1,323 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "simd_utility.h"
+#include "utility.h"
+
+/**
+ * @brief Defined when the vector kernels are compiled in, on x86-64 with GCC or Clang.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define MAT4_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief Names of the sets of kernels, in the order of Mat4Kernel.
+ */
+static const char *const kernelNames[MAT4_KERNELS] = {"scalar", "sse2", "avx2"};
+
+/**
+ * @brief The set chosen for this CPU, chosen once by the first call of mat4_best_kernel on any thread.
+ */
+static Mat4Kernel bestKernel = MAT4_SCALAR;
+static pthread_once_t bestKernelOnce = PTHREAD_ONCE_INIT;
+
+/* Adds two 4x4 matrices with scalar loops */
+static void add_scalar(const double *a, const double *b, double *c) {
+
+    int i;
+
+    FOR_RANGE(i, 16) {
+        c[i] = a[i] + b[i];
+    }
+}
+
+/* Subtracts one 4x4 matrix from another with scalar loops */
+static void sub_scalar(const double *a, const double *b, double *c) {
+
+    int i;
+
+    FOR_RANGE(i, 16) {
+        c[i] = a[i] - b[i];
+    }
+}
+
+/* Multiplies two 4x4 matrices with scalar loops, through a local result so the destination may be an operand */
+static void mul_scalar_loops(const double *a, const double *b, double *c) {
+
+    double result[16];
+    int row, col, k;
+
+    FOR_RANGE(row, 4) {
+        FOR_RANGE(col, 4) {
+            result[row * 4 + col] = 0;
+            FOR_RANGE(k, 4) {
+                result[row * 4 + col] += a[row * 4 + k] * b[k * 4 + col];
+            }
+        }
+    }
+    memcpy(c, result, sizeof(result));
+}
+
+/* Multiplies a 4x4 matrix by a scalar with scalar loops */
+static void scale_scalar(const double *a, double scalar, double *b) {
+
+    int i;
+
+    FOR_RANGE(i, 16) {
+        b[i] = a[i] * scalar;
+    }
+}
+
+/* Transposes a 4x4 matrix with scalar loops, through a local result so the destination may be the operand */
+static void trans_scalar(const double *a, double *b) {
+
+    double result[16];
+    int row, col;
+
+    FOR_RANGE(row, 4) {
+        FOR_RANGE(col, 4) {
+            result[row * 4 + col] = a[col * 4 + row];
+        }
+    }
+    memcpy(b, result, sizeof(result));
+}
+
+#ifdef MAT4_SIMD
+/* Adds two 4x4 matrices, a pair of elements per SSE2 instruction */
+static void add_sse2(const double *a, const double *b, double *c) {
+
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 2) {
+        _mm_store_pd(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+    }
+}
+
+/* Subtracts one 4x4 matrix from another, a pair of elements per SSE2 instruction */
+static void sub_sse2(const double *a, const double *b, double *c) {
+
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 2) {
+        _mm_store_pd(c + i, _mm_sub_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+    }
+}
+
+/* Multiplies two 4x4 matrices with SSE2, every row of c a sum of the rows of b scaled by the row of a */
+static void mul_sse2(const double *a, const double *b, double *c) {
+
+    __m128d bLow[4], bHigh[4], low[4], high[4], factor;
+    int row, k;
+
+    FOR_RANGE(k, 4) {
+        bLow[k] = _mm_load_pd(b + 4 * k);
+        bHigh[k] = _mm_load_pd(b + 4 * k + 2);
+    }
+
+    /* The rows are stored once all are computed, as c may be a */
+    FOR_RANGE(row, 4) {
+        factor = _mm_set1_pd(a[4 * row]);
+        low[row] = _mm_mul_pd(factor, bLow[0]);
+        high[row] = _mm_mul_pd(factor, bHigh[0]);
+        for (k = 1 ; k < 4 ; k++) {
+            factor = _mm_set1_pd(a[4 * row + k]);
+            low[row] = _mm_add_pd(low[row], _mm_mul_pd(factor, bLow[k]));
+            high[row] = _mm_add_pd(high[row], _mm_mul_pd(factor, bHigh[k]));
+        }
+    }
+    FOR_RANGE(row, 4) {
+        _mm_store_pd(c + 4 * row, low[row]);
+        _mm_store_pd(c + 4 * row + 2, high[row]);
+    }
+}
+
+/* Multiplies a 4x4 matrix by a scalar, a pair of elements per SSE2 instruction */
+static void scale_sse2(const double *a, double scalar, double *b) {
+
+    __m128d factor = _mm_set1_pd(scalar);
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 2) {
+        _mm_store_pd(b + i, _mm_mul_pd(_mm_load_pd(a + i), factor));
+    }
+}
+
+/* Transposes a 4x4 matrix as four 2x2 blocks, each transposed by unpacking two rows */
+static void trans_sse2(const double *a, double *b) {
+
+    __m128d low[4], high[4];
+    int row;
+
+    FOR_RANGE(row, 4) {
+        low[row] = _mm_load_pd(a + 4 * row);
+        high[row] = _mm_load_pd(a + 4 * row + 2);
+    }
+
+    /* Row i of b is column i of a, taken from the lanes i % 2 of the halves of the rows of a */
+    _mm_store_pd(b, _mm_unpacklo_pd(low[0], low[1]));
+    _mm_store_pd(b + 2, _mm_unpacklo_pd(low[2], low[3]));
+    _mm_store_pd(b + 4, _mm_unpackhi_pd(low[0], low[1]));
+    _mm_store_pd(b + 6, _mm_unpackhi_pd(low[2], low[3]));
+    _mm_store_pd(b + 8, _mm_unpacklo_pd(high[0], high[1]));
+    _mm_store_pd(b + 10, _mm_unpacklo_pd(high[2], high[3]));
+    _mm_store_pd(b + 12, _mm_unpackhi_pd(high[0], high[1]));
+    _mm_store_pd(b + 14, _mm_unpackhi_pd(high[2], high[3]));
+}
+
+/* Adds two 4x4 matrices, a row per AVX instruction */
+__attribute__((target("avx2,fma")))
+static void add_avx2(const double *a, const double *b, double *c) {
+
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 4) {
+        _mm256_store_pd(c + i, _mm256_add_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+    }
+}
+
+/* Subtracts one 4x4 matrix from another, a row per AVX instruction */
+__attribute__((target("avx2,fma")))
+static void sub_avx2(const double *a, const double *b, double *c) {
+
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 4) {
+        _mm256_store_pd(c + i, _mm256_sub_pd(_mm256_load_pd(a + i), _mm256_load_pd(b + i)));
+    }
+}
+
+/* Multiplies two 4x4 matrices, every row of c accumulated from broadcasts of the row of a with FMAs */
+__attribute__((target("avx2,fma")))
+static void mul_avx2(const double *a, const double *b, double *c) {
+
+    __m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b + 4);
+    __m256d b2 = _mm256_load_pd(b + 8), b3 = _mm256_load_pd(b + 12);
+    __m256d result[4];
+    int row;
+
+    /* The rows are stored once all are computed, as c may be a */
+    FOR_RANGE(row, 4) {
+        result[row] = _mm256_mul_pd(_mm256_broadcast_sd(a + 4 * row), b0);
+        result[row] = _mm256_fmadd_pd(_mm256_broadcast_sd(a + 4 * row + 1), b1, result[row]);
+        result[row] = _mm256_fmadd_pd(_mm256_broadcast_sd(a + 4 * row + 2), b2, result[row]);
+        result[row] = _mm256_fmadd_pd(_mm256_broadcast_sd(a + 4 * row + 3), b3, result[row]);
+    }
+    FOR_RANGE(row, 4) {
+        _mm256_store_pd(c + 4 * row, result[row]);
+    }
+}
+
+/* Multiplies a 4x4 matrix by a scalar, a row per AVX instruction */
+__attribute__((target("avx2,fma")))
+static void scale_avx2(const double *a, double scalar, double *b) {
+
+    __m256d factor = _mm256_set1_pd(scalar);
+    int i;
+
+    for (i = 0 ; i < 16 ; i += 4) {
+        _mm256_store_pd(b + i, _mm256_mul_pd(_mm256_load_pd(a + i), factor));
+    }
+}
+
+/* Transposes a 4x4 matrix by unpacking pairs of rows and exchanging the 128-bit halves of the pairs */
+__attribute__((target("avx2,fma")))
+static void trans_avx2(const double *a, double *b) {
+
+    __m256d r0 = _mm256_load_pd(a), r1 = _mm256_load_pd(a + 4);
+    __m256d r2 = _mm256_load_pd(a + 8), r3 = _mm256_load_pd(a + 12);
+    __m256d t0, t1, t2, t3;
+
+    /* t0 = (a00 a10 a02 a12), t1 = (a01 a11 a03 a13), t2 = (a20 a30 a22 a32), t3 = (a21 a31 a23 a33) */
+    t0 = _mm256_unpacklo_pd(r0, r1);
+    t1 = _mm256_unpackhi_pd(r0, r1);
+    t2 = _mm256_unpacklo_pd(r2, r3);
+    t3 = _mm256_unpackhi_pd(r2, r3);
+
+    _mm256_store_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_store_pd(b + 4, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_store_pd(b + 8, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_store_pd(b + 12, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+#endif
+
+/**
+ * @brief The kernels of every set, in the order of Mat4Kernel. The sets that are not compiled in are scalar.
+ */
+static const Mat4Ops kernelOps[MAT4_KERNELS] = {
+        {add_scalar, sub_scalar, mul_scalar_loops, scale_scalar, trans_scalar},
+#ifdef MAT4_SIMD
+        {add_sse2, sub_sse2, mul_sse2, scale_sse2, trans_sse2},
+        {add_avx2, sub_avx2, mul_avx2, scale_avx2, trans_avx2}
+#else
+        {add_scalar, sub_scalar, mul_scalar_loops, scale_scalar, trans_scalar},
+        {add_scalar, sub_scalar, mul_scalar_loops, scale_scalar, trans_scalar}
+#endif
+};
+
+/* Checks whether a set of kernels can run on this CPU */
+bool mat4_kernel_supported(Mat4Kernel kernel) {
+
+    switch (kernel) {
+        case MAT4_SCALAR:return TRUE;
+#ifdef MAT4_SIMD
+        case MAT4_SSE2:return TRUE; /**< SSE2 is part of x86-64 */
+        case MAT4_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? TRUE : FALSE;
+#endif
+        default:return FALSE;
+    }
+}
+
+/* Returns the name of a set of kernels */
+const char *mat4_kernel_name(Mat4Kernel kernel) {
+
+    return (kernel >= 0 && kernel < MAT4_KERNELS) ? kernelNames[kernel] : "unknown";
+}
+
+/* Returns the kernels of a set */
+const Mat4Ops *mat4_ops(Mat4Kernel kernel) {
+
+    return &kernelOps[kernel];
+}
+
+/* Chooses the set of kernels for this CPU, run once */
+static void choose_best_kernel(void) {
+
+    const char *forced;
+    int kernel;
+
+    /* The widest supported set, or the set named by the environment */
+    FOR_RANGE(kernel, MAT4_KERNELS) {
+        if (mat4_kernel_supported((Mat4Kernel) kernel)) {
+            bestKernel = (Mat4Kernel) kernel;
+        }
+    }
+
+    forced = getenv(SIMD_ENV);
+    if (forced != NULL) {
+        FOR_RANGE(kernel, MAT4_KERNELS) {
+            if (strcmp(forced, kernelNames[kernel]) == 0 && mat4_kernel_supported((Mat4Kernel) kernel)) {
+                bestKernel = (Mat4Kernel) kernel;
+            }
+        }
+    }
+}
+
+/* Returns the set of kernels chosen for this CPU */
+Mat4Kernel mat4_best_kernel(void) {
+
+    /* The tasks of the pool may be the first to ask */
+    pthread_once(&bestKernelOnce, choose_best_kernel);
+    return bestKernel;
+}
+
+/* Returns the kernels of the set chosen for this CPU */
+const Mat4Ops *mat4_best_ops(void) {
+
+    return &kernelOps[mat4_best_kernel()];
+}
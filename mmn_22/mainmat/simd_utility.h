@@ -0,0 +1,138 @@
+/**
+ * @file simd_utility.h
+ * @brief Header file containing the vector kernels of the 4x4 matrix operations.
+ *
+ * This header file defines the kernels the operations of mymat.h run on 4x4 matrices, the shape of the
+ * predefined matrices. Every kernel works on the 16 contiguous elements of the block of a 4x4 matrix.
+ * A scalar set of kernels runs on any CPU, and on x86-64 an SSE2 set works on pairs of elements and an
+ * AVX2 set works on whole rows, multiplying with FMA instructions.
+ *
+ * @remark
+ * The vector kernels are compiled for their instruction set with the target attribute, so the program is
+ * built for any x86-64 CPU and the set the CPU supports is chosen when the program runs, from the CPUID
+ * feature flags. The environment variable MAINMAT_SIMD ("scalar", "sse2" or "avx2") forces a set, when
+ * the CPU supports it.
+ *
+ * @note
+ * - The multiplication and the transpose read all their operands before writing the result, so the
+ *   result may be one of the operands.
+ * - The elements should be aligned to 32 bytes, as the block of a matrix is (see MAT_ALIGNMENT).
+ * - The FMA instructions round a product and a sum once, so the products of the AVX2 set may differ
+ *   from the scalar ones in the last bit.
+ *
+ * @overview
+ * - [Enum] Mat4Kernel - The sets of kernels.
+ * - [Struct] Mat4Ops - The kernels of the operations of a set.
+ * - [Function] mat4_kernel_supported(Mat4Kernel kernel) - Checks whether a set can run on this CPU.
+ * - [Function] mat4_kernel_name(Mat4Kernel kernel) - Returns the name of a set.
+ * - [Function] mat4_ops(Mat4Kernel kernel) - Returns the kernels of a set.
+ * - [Function] mat4_best_kernel(void) - Returns the set chosen for this CPU.
+ * - [Function] mat4_best_ops(void) - Returns the kernels of the set chosen for this CPU.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#ifndef SIMD_UTILITY_H
+#define SIMD_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Name of the environment variable that forces a set of kernels.
+ */
+#define SIMD_ENV "MAINMAT_SIMD"
+
+/**
+ * @enum Mat4Kernel
+ * @brief Enumeration for the sets of kernels of the 4x4 operations.
+ */
+typedef enum {
+    MAT4_SCALAR,  /**< Scalar loops, on any CPU. */
+    MAT4_SSE2,    /**< Pairs of elements, with SSE2. */
+    MAT4_AVX2,    /**< Rows of 4 elements, with AVX2 and FMA. */
+    MAT4_KERNELS  /**< The number of sets. */
+} Mat4Kernel;
+
+/**
+ * @struct Mat4Ops
+ * @brief The kernels of the operations of a set, on the 16 elements of 4x4 matrices.
+ *
+ * @var Mat4Ops::add
+ * Adds a and b into c.
+ *
+ * @var Mat4Ops::sub
+ * Subtracts b from a into c.
+ *
+ * @var Mat4Ops::mul
+ * Multiplies a by b into c.
+ *
+ * @var Mat4Ops::mul_scalar
+ * Multiplies a by a scalar into b.
+ *
+ * @var Mat4Ops::trans
+ * Transposes a into b.
+ */
+typedef struct {
+    void (*add)(const double *a, const double *b, double *c);
+    void (*sub)(const double *a, const double *b, double *c);
+    void (*mul)(const double *a, const double *b, double *c);
+    void (*mul_scalar)(const double *a, double scalar, double *b);
+    void (*trans)(const double *a, double *b);
+} Mat4Ops;
+
+/**
+ * @brief Checks whether a set of kernels can run on this CPU.
+ *
+ * @param[in] kernel - The set of kernels.
+ *
+ * @return bool - TRUE if the set is compiled in and the CPU has its instructions, FALSE otherwise.
+ */
+bool mat4_kernel_supported(Mat4Kernel kernel);
+
+/**
+ * @brief Returns the name of a set of kernels.
+ *
+ * @param[in] kernel - The set of kernels.
+ *
+ * @return const char* - The name of the set, as MAINMAT_SIMD takes it.
+ */
+const char *mat4_kernel_name(Mat4Kernel kernel);
+
+/**
+ * @brief Returns the kernels of a set.
+ *
+ * @param[in] kernel - The set of kernels, which should be supported.
+ *
+ * @return const Mat4Ops* - The kernels of the set.
+ */
+const Mat4Ops *mat4_ops(Mat4Kernel kernel);
+
+/**
+ * @brief Returns the set of kernels chosen for this CPU.
+ *
+ * The widest supported set is chosen on the first call, unless MAINMAT_SIMD names another supported set.
+ * The choice is made once even when several threads make the first call together.
+ * The kernels of the other operations on vectors, such as the micro-kernel of gemm_utility.h, follow
+ * the same choice.
+ *
+ * @return Mat4Kernel - The chosen set.
+ */
+Mat4Kernel mat4_best_kernel(void);
+
+/**
+ * @brief Returns the kernels of the set chosen for this CPU.
+ *
+ * The set is the set of mat4_best_kernel.
+ *
+ * @return const Mat4Ops* - The kernels of the chosen set.
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   mat4_best_ops()->mul(matrixA->data, matrixB->data, matrixC->data);
+ * \endcode
+ */
+const Mat4Ops *mat4_best_ops(void);
+
+
+#endif /**< SIMD_UTILITY_H */
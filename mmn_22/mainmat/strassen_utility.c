@@ -0,0 +1,260 @@
+#include "strassen_utility.h"
+#include "gemm_utility.h"
+#include "parallel_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Number of doubles every temporary block is rounded up to, so the blocks keep MAT_ALIGNMENT.
+ */
+#define ARENA_ALIGNMENT (MAT_ALIGNMENT / sizeof(double))
+
+/**
+ * @brief Structure to represent a sum of two blocks, C = A + sign * B, split into ranges of rows.
+ */
+typedef struct {
+    int rows;          /**< The number of rows of the blocks. */
+    int cols;          /**< The number of columns of the blocks. */
+    const double *a;   /**< The elements of A. */
+    int lda;           /**< The stride of the rows of A. */
+    const double *b;   /**< The elements of B. */
+    int ldb;           /**< The stride of the rows of B. */
+    double sign;       /**< 1 to add B, -1 to subtract it. */
+    double *c;         /**< The elements of C, which may be A or B. */
+    int ldc;           /**< The stride of the rows of C. */
+    int rowsPerTask;   /**< The number of rows of a task. */
+} SumJob;
+
+/**
+ * @brief The cutoff, -1 until the first call of strassen_cutoff.
+ */
+static int cutoff = -1;
+
+/**
+ * @brief The arena of the temporaries: its elements, its size and the number of elements taken.
+ */
+static double *arena = NULL;
+static size_t arenaSize = 0;
+static size_t arenaUsed = 0;
+
+/* Returns the larger of two numbers */
+static int max_int(int x, int y) {
+
+    return x > y ? x : y;
+}
+
+/* Rounds a number of columns up to the stride of the rows of a temporary */
+static int block_stride(int cols) {
+
+    return (cols + MAT_STRIDE_ALIGNMENT - 1) / MAT_STRIDE_ALIGNMENT * MAT_STRIDE_ALIGNMENT;
+}
+
+/* Returns the number of doubles of a temporary block, rounded up to keep the next block aligned */
+static size_t block_size(int rows, int cols) {
+
+    size_t size = (size_t) rows * (size_t) block_stride(cols);
+
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+/* Returns whether a product is split into quadrants */
+static bool is_split(int m, int n, int k) {
+
+    return cutoff > 0 && m >= cutoff && n >= cutoff && k >= cutoff ? TRUE : FALSE;
+}
+
+/* Returns the number of doubles of the temporaries of the recursion of a product */
+static size_t workspace(int m, int n, int k) {
+
+    if (!is_split(m, n, k)) {
+        return 0;
+    }
+    return block_size(m / 2, max_int(k / 2, n / 2)) + block_size(k / 2, n / 2) + workspace(m / 2, n / 2, k / 2);
+}
+
+/* Takes a temporary block from the arena */
+static double *arena_take(int rows, int cols) {
+
+    double *block = arena + arenaUsed;
+
+    arenaUsed += block_size(rows, cols);
+    return block;
+}
+
+/* Sums the rows of a task */
+static void sum_rows(void *context, int task) {
+
+    SumJob *job = (SumJob *) context;
+    int first = task * job->rowsPerTask;
+    int row, col;
+
+    for (row = first ; row < job->rows && row < first + job->rowsPerTask ; row++) {
+        FOR_RANGE(col, job->cols) {
+            job->c[row * job->ldc + col] = job->a[row * job->lda + col] + job->sign * job->b[row * job->ldb + col];
+        }
+    }
+}
+
+/* Sums two blocks, C = A + sign * B, on the pool */
+static void sum_blocks(int rows, int cols, const double *a, int lda, const double *b, int ldb, double sign,
+                       double *c, int ldc) {
+
+    SumJob job;
+    int tasks = parallel_split((double) rows * (double) cols, PARALLEL_MIN_ELEMENTS);
+
+    job.rows = rows;
+    job.cols = cols;
+    job.a = a;
+    job.lda = lda;
+    job.b = b;
+    job.ldb = ldb;
+    job.sign = sign;
+    job.c = c;
+    job.ldc = ldc;
+    job.rowsPerTask = (rows + tasks - 1) / tasks;
+
+    parallel_for((rows + job.rowsPerTask - 1) / job.rowsPerTask, sum_rows, &job);
+}
+
+/* Multiplies two matrices, split into quadrants while all the dimensions are at least the cutoff */
+static void strassen_recurse(int m, int n, int k, const double *a, int lda, const double *b, int ldb,
+                             double *c, int ldc) {
+
+    const double *a11, *a12, *a21, *a22, *b11, *b12, *b21, *b22;
+    double *c11, *c12, *c21, *c22, *x, *y;
+    int mh = m / 2, nh = n / 2, kh = k / 2;
+    int ldx, ldy, row, col;
+    size_t mark = arenaUsed;
+
+    if (!is_split(m, n, k)) {
+        gemm(m, n, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+
+    /* X holds a quadrant of A and then the product P1, Y a quadrant of B */
+    ldx = block_stride(max_int(kh, nh));
+    ldy = block_stride(nh);
+    x = arena_take(mh, max_int(kh, nh));
+    y = arena_take(kh, nh);
+
+    a11 = a;
+    a12 = a + kh;
+    a21 = a + mh * lda;
+    a22 = a21 + kh;
+    b11 = b;
+    b12 = b + nh;
+    b21 = b + kh * ldb;
+    b22 = b21 + nh;
+    c11 = c;
+    c12 = c + nh;
+    c21 = c + mh * ldc;
+    c22 = c21 + nh;
+
+    /* The 7 products, each written where the sums of the quadrants of C need it */
+    sum_blocks(mh, kh, a11, lda, a21, lda, -1, x, ldx);          /**< S3 = A11 - A21 */
+    sum_blocks(kh, nh, b22, ldb, b12, ldb, -1, y, ldy);          /**< T3 = B22 - B12 */
+    strassen_recurse(mh, nh, kh, x, ldx, y, ldy, c21, ldc);      /**< P7 = S3 * T3 */
+    sum_blocks(mh, kh, a21, lda, a22, lda, 1, x, ldx);           /**< S1 = A21 + A22 */
+    sum_blocks(kh, nh, b12, ldb, b11, ldb, -1, y, ldy);          /**< T1 = B12 - B11 */
+    strassen_recurse(mh, nh, kh, x, ldx, y, ldy, c22, ldc);      /**< P5 = S1 * T1 */
+    sum_blocks(mh, kh, x, ldx, a11, lda, -1, x, ldx);            /**< S2 = S1 - A11 */
+    sum_blocks(kh, nh, b22, ldb, y, ldy, -1, y, ldy);            /**< T2 = B22 - T1 */
+    strassen_recurse(mh, nh, kh, x, ldx, y, ldy, c12, ldc);      /**< P6 = S2 * T2 */
+    sum_blocks(mh, kh, a12, lda, x, ldx, -1, x, ldx);            /**< S4 = A12 - S2 */
+    strassen_recurse(mh, nh, kh, x, ldx, b22, ldb, c11, ldc);    /**< P3 = S4 * B22 */
+    strassen_recurse(mh, nh, kh, a11, lda, b11, ldb, x, ldx);    /**< P1 = A11 * B11 */
+    sum_blocks(mh, nh, x, ldx, c12, ldc, 1, c12, ldc);           /**< U2 = P1 + P6 */
+    sum_blocks(mh, nh, c12, ldc, c21, ldc, 1, c21, ldc);         /**< U3 = U2 + P7 */
+    sum_blocks(mh, nh, c12, ldc, c22, ldc, 1, c12, ldc);         /**< U4 = U2 + P5 */
+    sum_blocks(mh, nh, c21, ldc, c22, ldc, 1, c22, ldc);         /**< C22 = U3 + P5 */
+    sum_blocks(mh, nh, c12, ldc, c11, ldc, 1, c12, ldc);         /**< C12 = U4 + P3 */
+    sum_blocks(kh, nh, y, ldy, b21, ldb, -1, y, ldy);            /**< T4 = T2 - B21 */
+    strassen_recurse(mh, nh, kh, a22, lda, y, ldy, c11, ldc);    /**< P4 = A22 * T4 */
+    sum_blocks(mh, nh, c21, ldc, c11, ldc, -1, c21, ldc);        /**< C21 = U3 - P4 */
+    strassen_recurse(mh, nh, kh, a12, lda, b21, ldb, c11, ldc);  /**< P2 = A12 * B21 */
+    sum_blocks(mh, nh, x, ldx, c11, ldc, 1, c11, ldc);           /**< C11 = P1 + P2 */
+
+    arenaUsed = mark;
+
+    /* The last column of A and row of B of an odd inner dimension add their outer product */
+    if (k % 2 != 0) {
+        FOR_RANGE(row, 2 * mh) {
+            FOR_RANGE(col, 2 * nh) {
+                c[row * ldc + col] += a[row * lda + k - 1] * b[(k - 1) * ldb + col];
+            }
+        }
+    }
+
+    /* The last column and row of C of odd dimensions are products of their own */
+    if (n % 2 != 0) {
+        gemm(2 * mh, 1, k, a, lda, b + n - 1, ldb, c + n - 1, ldc);
+    }
+    if (m % 2 != 0) {
+        gemm(1, n, k, a + (m - 1) * lda, lda, b, ldb, c + (m - 1) * ldc, ldc);
+    }
+}
+
+/* Returns the cutoff */
+int strassen_cutoff(void) {
+
+    const char *value;
+    char *end;
+    long number;
+
+    if (cutoff >= 0) {
+        return cutoff;
+    }
+
+    cutoff = STRASSEN_DEFAULT_CUTOFF;
+    value = getenv(STRASSEN_ENV);
+    if (value != NULL) {
+        number = strtol(value, &end, 10);
+        if (end != value && *end == '\0' && number >= 0 && number <= MAX_MAT_DIMENSION) {
+            strassen_set_cutoff((int) number);
+        }
+    }
+    return cutoff;
+}
+
+/* Sets the cutoff */
+bool strassen_set_cutoff(int newCutoff) {
+
+    if (newCutoff != 0 && newCutoff < STRASSEN_MIN_CUTOFF) {
+        return FALSE;
+    }
+    cutoff = newCutoff;
+    return TRUE;
+}
+
+/* Multiplies two matrices */
+void strassen_gemm(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc) {
+
+    size_t size;
+
+    strassen_cutoff();
+    if (!is_split(m, n, k)) {
+        gemm(m, n, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+
+    /* The arena grows to the temporaries of the whole recursion before it starts */
+    size = workspace(m, n, k);
+    if (size > arenaSize) {
+        strassen_free();
+        arena = (double *) validated_aligned_allocation(sizeof(double) * size, MAT_ALIGNMENT);
+        arenaSize = size;
+    }
+
+    arenaUsed = 0;
+    strassen_recurse(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+/* Frees the arena of the temporaries */
+void strassen_free(void) {
+
+    aligned_memory_free(arena);
+    arena = NULL;
+    arenaSize = 0;
+    arenaUsed = 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file strassen_utility.h
+ * @brief Header file containing the Strassen-Winograd multiplication of very large matrices.
+ *
+ * This header file defines the multiplication mul_mat runs on matrices of other shapes than 4x4. A product
+ * whose three dimensions are all at least the cutoff is split into quadrants, and computed from 7 products
+ * of quadrants and 15 additions, in the variant of Strassen's algorithm by Winograd. The 7 products recurse
+ * until a dimension falls below the cutoff, and are then computed by the blocked multiplication of
+ * gemm_utility.h. Every level saves an eighth of the multiplications, so a product of n x n matrices takes
+ * O(n^2.81) operations instead of O(n^3).
+ *
+ * @remark
+ * The quadrant products and sums are scheduled as in "Memory efficient scheduling of Strassen-Winograd's
+ * matrix multiplication algorithm" (Boyer, Dumas, Pernet and Zhou, 2009): the quadrants of C hold the
+ * intermediate products, and every level needs only two temporary blocks, one of the shape of a quadrant
+ * of A and one of the shape of a quadrant of B. The temporaries of all the levels are taken from an arena,
+ * allocated once as large as the recursion of the product needs and kept for the next products, so the
+ * recursion allocates nothing. A dimension of odd length is split at its even part, and its last row or
+ * column is added by gemm afterwards.
+ *
+ * @note
+ * - The cutoff is STRASSEN_DEFAULT_CUTOFF, unless the environment variable MAINMAT_STRASSEN sets another
+ *   cutoff, or 0 to multiply every product with gemm alone.
+ * - The sums of the quadrants lose some accuracy: the largest error of an element grows with the norms
+ *   of A and B rather than with the element, by a factor of a few units per level. gemm_bench reports it.
+ * - The products of the recursion and the sums of the quadrants run on the pool of parallel_utility.h.
+ * - C should not share elements with A or B.
+ *
+ * @overview
+ * - [Macro] STRASSEN_ENV - The environment variable that sets the cutoff.
+ * - [Macro] STRASSEN_DEFAULT_CUTOFF - The cutoff when the environment does not set one.
+ * - [Macro] STRASSEN_MIN_CUTOFF - The smallest cutoff other than 0.
+ * - [Function] strassen_cutoff(void) - Returns the cutoff.
+ * - [Function] strassen_set_cutoff(int cutoff) - Sets the cutoff.
+ * - [Function] strassen_gemm(...) - Multiplies two matrices.
+ * - [Function] strassen_free(void) - Frees the arena of the temporaries.
+ *
+ * @author Yehonatan Keypur
+ */
+
+#ifndef STRASSEN_UTILITY_H
+#define STRASSEN_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Name of the environment variable that sets the cutoff.
+ */
+#define STRASSEN_ENV "MAINMAT_STRASSEN"
+
+/**
+ * @brief Smallest dimension of a product split into quadrants, when MAINMAT_STRASSEN does not set it.
+ */
+#define STRASSEN_DEFAULT_CUTOFF 2048
+
+/**
+ * @brief Smallest cutoff other than 0, below which the sums of the quadrants cost more than they save.
+ */
+#define STRASSEN_MIN_CUTOFF 64
+
+/**
+ * @brief Returns the cutoff.
+ *
+ * On the first call, the cutoff is taken from MAINMAT_STRASSEN, or else is STRASSEN_DEFAULT_CUTOFF.
+ *
+ * @return int - The smallest dimension of a product split into quadrants, 0 if no product is.
+ */
+int strassen_cutoff(void);
+
+/**
+ * @brief Sets the cutoff.
+ *
+ * @param[in] cutoff - The smallest dimension of a product split into quadrants, 0 to split none.
+ *
+ * @return bool - TRUE if the cutoff was set, FALSE if it is neither 0 nor at least STRASSEN_MIN_CUTOFF.
+ */
+bool strassen_set_cutoff(int cutoff);
+
+/**
+ * @brief Multiplies two matrices, C = A * B, with the Strassen-Winograd recursion above the cutoff.
+ *
+ * @param[in] m - The number of rows of A and C.
+ * @param[in] n - The number of columns of B and C.
+ * @param[in] k - The number of columns of A and rows of B.
+ * @param[in] a - The elements of A.
+ * @param[in] lda - The stride of the rows of A.
+ * @param[in] b - The elements of B.
+ * @param[in] ldb - The stride of the rows of B.
+ * @param[out] c - The elements of C, which should not share elements with A or B.
+ * @param[in] ldc - The stride of the rows of C.
+ *
+ * @return void
+ *
+ * @complexity
+ * Time Complexity: O(m * n * k * (7/8)^L), where L is the number of levels, the number of times the
+ * smallest dimension can be halved without falling below the cutoff.
+ *
+ * @example
+ * \code
+ *   // Usage Example:
+ *   strassen_gemm(matrixA->rows, matrixB->cols, matrixA->cols, matrixA->data, matrixA->stride,
+ *                 matrixB->data, matrixB->stride, matrixC->data, matrixC->stride);
+ * \endcode
+ */
+void strassen_gemm(int m, int n, int k, const double *a, int lda, const double *b, int ldb, double *c, int ldc);
+
+/**
+ * @brief Frees the arena of the temporaries.
+ *
+ * The next product split into quadrants allocates it again.
+ *
+ * @return void
+ */
+void strassen_free(void);
+
+
+#endif /**< STRASSEN_UTILITY_H */
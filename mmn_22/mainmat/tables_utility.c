@@ -1,10 +1,11 @@
 /**
  * @file function_matrices.c
- * @brief source file containing arrays of function and matrix names for a matrix processing program.
+ * @brief source file containing the array of function names for a matrix processing program.
  *
- * This source file defines arrays containing function names and matrix names used in a matrix processing program.
- * The function names array includes names for functions like reading matrices, printing matrices, arithmetic operations,
- * and program termination. The matrices array includes names for different matrices (e.g., MAT_A, MAT_B).
+ * This source file defines arrays containing function names and the names of the predefined matrices used in a matrix
+ * processing program. The function names array includes names for functions like reading matrices, printing matrices,
+ * arithmetic operations, creating and freeing named matrices, setting the number of threads, and program termination. The matrices array includes the
+ * names the registry of registry_utility.h is filled with when the program starts (e.g., MAT_A, MAT_B).
  */
 
 /* List of the function names */
@@ -16,10 +17,13 @@ const char *funcNames[] =
          "mul_mat",
          "mul_scalar",
          "trans_mat",
+         "new_mat",
+         "free_mat",
+         "threads",
          "stop"
         };
 
-/* List of the matrix names */
+/* List of the names of the predefined matrices */
 const char *matrices[] =
         {"MAT_A",
          "MAT_B",
@@ -27,4 +31,4 @@ const char *matrices[] =
          "MAT_D",
          "MAT_E",
          "MAT_F"
-        };
\ No newline at end of file
+        };
@@ -1,9 +1,9 @@
 #include "utility.h"
+#include "constants.h"
 #include "error_utility.h"
+#include "registry_utility.h"
 
 
-extern mat MAT_A, MAT_B, MAT_C, MAT_D, MAT_E, MAT_F;
-
 /* Analyze the first word of a string to determine the command type */
 CommandType first_Word_analysis(char *strPtr) {
 
@@ -28,32 +28,56 @@ CommandType first_Word_analysis(char *strPtr) {
 /* Get a pointer to the matrix based on the provided string */
 mat *whichMatrix(char *ptr) {
 
-    Matrix result = getMatrix(ptr);
+    size_t length = mat_name_length(ptr);
 
-    switch (result) {
-        case MATRIX_A:return &MAT_A;
-        case MATRIX_B:return &MAT_B;
-        case MATRIX_C:return &MAT_C;
-        case MATRIX_D:return &MAT_D;
-        case MATRIX_E:return &MAT_E;
-        case MATRIX_F:return &MAT_F;
-        case NONE_MATRIX:return NULL;
+    if (length == 0) {
+        return NULL;
     }
 
-    return NULL;
+    return registry_find(ptr, length);
 }
 
-/* Retrieve the matrix identifier based on the provided string */
-Matrix getMatrix(char *ptr) {
+/* Measure the matrix name at the start of a string */
+size_t mat_name_length(const char *ptr) {
+
+    size_t length = 0;
 
-    int i;
+    if (!isalpha((unsigned char) *ptr) && *ptr != '_') {
+        return 0;
+    }
 
-    FOR_RANGE(i, NUM_OF_MATRICES) {
-        if (strncmp(ptr, GET_MATRIX(i), MAX_MAT_NAME) == 0)
-            return (Matrix) i;
+    while (isalnum((unsigned char) ptr[length]) || ptr[length] == '_') {
+        length++;
     }
 
-    return NONE_MATRIX;
+    return length;
+}
+
+/* Parse a string for a matrix dimension and move the pointer after it */
+bool getDimension(char **strPtr, int *returnVal) {
+
+    char *endPtr;
+    long dimension;
+
+    /* strtol accepts a sign, which a dimension does not have */
+    if (!isdigit((unsigned char) **strPtr)) {
+        return FALSE;
+    }
+
+    dimension = strtol(*strPtr, &endPtr, 10);
+
+    /* The dimension should be followed by a separator, not by a fraction or other text */
+    if (*endPtr && !isspace((unsigned char) *endPtr) && *endPtr != ',') {
+        return FALSE;
+    }
+    if (dimension < 1 || dimension > MAX_MAT_DIMENSION) {
+        return FALSE;
+    }
+
+    *returnVal = (int) dimension;
+    *strPtr = endPtr;
+
+    return TRUE;
 }
 
 /* Get the number that the pointer points to. Return 0 if there isn't such a number */
@@ -128,11 +152,16 @@ bool getScalar(const char *strPtr, double *returnVal) {
 /* Copy the contents of one matrix to another */
 void copy_mat(mat *srcMatrix, mat *destMatrix) {
 
-    int row, col;
-    for(row = 0 ; row < 4 ; row++) {
-        for(col = 0 ; col < 4 ; col++) {
-            destMatrix->data[row][col] = srcMatrix->data[row][col];
-        }
+    int row;
+
+    /* The destination takes the shape of the source */
+    if (destMatrix->rows != srcMatrix->rows || destMatrix->cols != srcMatrix->cols) {
+        free_mat(destMatrix);
+        init_mat(destMatrix, srcMatrix->rows, srcMatrix->cols);
+    }
+
+    FOR_RANGE(row, srcMatrix->rows) {
+        memcpy(&MAT_ELEMENT(destMatrix, row, 0), &MAT_ELEMENT(srcMatrix, row, 0), sizeof(double) * srcMatrix->cols);
     }
 }
 
@@ -154,6 +183,28 @@ void *validated_memory_allocation(size_t size) {
     return ptr;
 }
 
+/* Allocates memory aligned to a power of two with error checking */
+void *validated_aligned_allocation(size_t size, size_t alignment) {
+
+    char *block = (char *) validated_memory_allocation(size + alignment + sizeof(void *));
+    char *aligned;
+
+    /* The block is kept just before the aligned address, to be freed from it */
+    aligned = block + sizeof(void *);
+    aligned += (alignment - (size_t) ((unsigned long) aligned % alignment)) % alignment;
+    ((void **) aligned)[-1] = block;
+
+    return aligned;
+}
+
+/* Frees memory allocated by validated_aligned_allocation */
+void aligned_memory_free(void *ptr) {
+
+    if (ptr != NULL) {
+        free(((void **) ptr)[-1]);
+    }
+}
+
 /* Handles end-of-file conditions */
 void handle_eof(void) {
 
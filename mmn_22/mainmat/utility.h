@@ -16,12 +16,11 @@
  * @remark Key Features
  * - Macros for moving pointers to non-white characters and the next word in a string.
  * - Macros for checking the end of a command, non-end of a command, and index not at the end of a line.
- * - Macros for obtaining matrix pointers and handling memory allocation errors.
- * - Functions for analyzing the first word of a command, retrieving matrix pointers, and getting scalar values.
+ * - Macros for moving past matrix names and handling memory allocation errors.
+ * - Functions for analyzing the first word of a command, retrieving matrix pointers, and getting scalar values and dimensions.
  * - Functions for copying matrices, handling memory allocation failures, and printing input details.
  *
  * @overview
- * - [Macro] GET_MATRIX(index) - Retrieves a matrix pointer based on the provided index.
  * - [Macro] IS_END_OF_COMMAND(ptr) - Checks if the pointer has reached the end of a command.
  * - [Macro] IS_NOT_END_OF_COMMAND(ptr) - Checks if the pointer has not reached the end of a command.
  * - [Macro] INDEX_NOT_AT_END_OF_LINE(ptr, index) - Checks if the indexed position is not at the end of a line.
@@ -31,7 +30,11 @@
  * - [Macro] MOVE_AFTER_MAT(ptr) - Moves the pointer to the position after a matrix name in a command.
  * - [Function] first_Word_analysis(char *strPtr) - Analyzes the first word of a command and returns the corresponding command type.
  * - [Function] whichMatrix(char *ptr) - Returns a pointer to the matrix with the given name.
+ * - [Function] mat_name_length(const char *ptr) - Returns the length of the matrix name at the start of a string.
+ * - [Function] getDimension(char **strPtr, int *returnVal) - Parses a matrix dimension.
  * - [Function] validated_memory_allocation(size_t size) - Allocates memory with error checking.
+ * - [Function] validated_aligned_allocation(size_t size, size_t alignment) - Allocates aligned memory with error checking.
+ * - [Function] aligned_memory_free(void *ptr) - Frees memory allocated by validated_aligned_allocation.
  * - [Function] handle_memory_allocation_failure(void) - Prints the error message for memory allocation failures and exits.
  * - [Function] handle_eof(void) - Handles end-of-file conditions during input processing.
  * - [Function] print_input(const char *userInput) - Prints the details of the user input.
@@ -53,17 +56,6 @@
 #include "mymat.h"
 
 
-/**
- * @brief Retrieves a matrix from an array of matrices based on the given index.
- *
- * This macro takes an index and returns the corresponding matrix from the array
- * of matrices. It assumes that the array of matrices is named 'matrices'.
- *
- * @param index The index of the matrix to retrieve.
- * @return The matrix at the specified index.
- */
-#define GET_MATRIX(index) (matrices[index])
-
 /**
  * @brief Checks if the character pointer points to the end of a command (null terminator or newline character).
  *
@@ -165,14 +157,14 @@
 /**
  * @brief Macro to move the character pointer to the position after a matrix name.
  *
- * This macro advances the character pointer 'ptr' by a fixed distance, where 'MAX_MAT_NAME'
- * represents the maximum length of a matrix name. It is designed to be used after parsing
- * or processing a matrix name, allowing the pointer to move to the position after the name.
+ * This macro advances the character pointer 'ptr' by the length of the matrix name it points at,
+ * as measured by mat_name_length. It is designed to be used after parsing or processing a matrix
+ * name, allowing the pointer to move to the position after the name.
  *
  * @param ptr The character pointer to be moved.
  */
 #define MOVE_AFTER_MAT(ptr) \
-    ((ptr) += MAX_MAT_NAME);
+    ((ptr) += mat_name_length(ptr));
 
 /**
  * @brief Analyze the first word of a string to determine the command type.
@@ -232,50 +224,38 @@ CommandType first_Word_analysis(char *strPtr);
 /**
  * @brief Get a pointer to the matrix based on the provided string.
  *
- * This function determines the matrix identifier using the getMatrix function,
- * and returns a pointer to the corresponding matrix. If no matching matrix is found,
- * NULL is returned.
+ * This function reads the matrix name at the start of the string and looks it up in the
+ * registry of the named matrices. If no matrix has the name, NULL is returned.
  *
  * @param[in] ptr - Pointer to the string representing the matrix.
  *
  * @return mat* - Pointer to the matrix if a match is found, NULL otherwise.
  *
- * @var Matrix - Enum type representing matrix identifiers.
- * @var getMatrix - Function to retrieve the matrix identifier based on the provided string.
- * @var MATRIX_A - Enum value representing Matrix A.
- * @var MATRIX_B - Enum value representing Matrix B.
- * @var MATRIX_C - Enum value representing Matrix C.
- * @var MATRIX_D - Enum value representing Matrix D.
- * @var MATRIX_E - Enum value representing Matrix E.
- * @var MATRIX_F - Enum value representing Matrix F.
- * @var NONE_MATRIX - Enum value representing no matching matrix.
- * @var MAT_A - Pointer to Matrix A.
- * @var MAT_B - Pointer to Matrix B.
- * @var MAT_C - Pointer to Matrix C.
- * @var MAT_D - Pointer to Matrix D.
- * @var MAT_E - Pointer to Matrix E.
- * @var MAT_F - Pointer to Matrix F.
+ * @var mat_name_length - Function to measure the matrix name at the start of the string.
+ * @var registry_find - Function to look up a matrix by its name.
  *
  * @overview
- * This function uses the getMatrix function to determine the matrix identifier
- * based on the provided string. It then returns a pointer to the corresponding matrix
- * or NULL if no matching matrix is found.
+ * This function measures the matrix name at the start of the provided string and resolves it
+ * with a single lookup in the hash table of the registry, whatever the number of matrices.
  *
  * @algorithm
  * The function follows these steps:
- * 1. Use the getMatrix function to obtain the matrix identifier.
- * 2. Use a switch statement to return a pointer to the corresponding matrix based on the identifier.
- * 3. If no matching matrix is found, return NULL.
+ * 1. Measure the matrix name using the mat_name_length function.
+ * 2. If the string does not start with a name, return NULL.
+ * 3. Return the matrix of the name from the registry_find function, NULL if it is not defined.
  *
  * @note
  * - The ptr parameter is a pointer to the string representing the matrix.
- * - The matrix identifiers and corresponding matrix pointers are defined in the Matrix enum type
- *   and mat structures, respectively.
+ * - The name ends at the first character that cannot be part of a name, such as a comma or a space.
+ *
+ * @see
+ * - mat_name_length
+ * - registry_find
  *
  * @example
  * \code
  *   // Usage Example:
- *   char *matrixString = "Matrix_A";
+ *   char *matrixString = "MAT_A, MAT_B";
  *   mat *resultMatrix = whichMatrix(matrixString);
  *   if (resultMatrix != NULL) {
  *       // Valid matrix pointer found.
@@ -287,61 +267,47 @@ CommandType first_Word_analysis(char *strPtr);
 mat *whichMatrix(char *ptr);
 
 /**
- * @brief Retrieve the matrix identifier based on the provided string.
+ * @brief Measure the matrix name at the start of a string.
  *
- * This function searches for a matrix identifier in the list of predefined matrices,
- * comparing it with the provided string. If a match is found, the corresponding matrix
- * identifier is returned; otherwise, NONE_MATRIX is returned.
+ * A matrix name starts with a letter or an underscore, followed by letters, digits and underscores.
  *
- * @param[in] ptr - Pointer to the string representing the matrix.
+ * @param[in] ptr - Pointer to the string.
  *
- * @return Matrix - Matrix identifier if a match is found, NONE_MATRIX otherwise.
+ * @return size_t - The length of the name, 0 if the string does not start with a name.
  *
- * @var FOR_RANGE - Macro for iterating over a range.
- * @var NUM_OF_MATRICES - The total number of predefined matrices.
- * @var GET_MATRIX - Macro to get the string representation of a matrix by index.
- * @var MAX_MAT_NAME - Maximum length of the matrix name.
- * @var Matrix - Enum type representing matrix identifiers.
- * @var NONE_MATRIX - Enum value representing no matching matrix.
+ * @example
+ * \code
+ *   // Usage Example:
+ *   size_t length = mat_name_length("MAT_A, MAT_B"); // length is 5
+ * \endcode
+ */
+size_t mat_name_length(const char *ptr);
+
+/**
+ * @brief Parse a string for a matrix dimension and move the pointer after it.
  *
- * @overview
- * This function iterates through the range of predefined matrices and compares the
- * provided string with the string representations of each matrix. If a match is found,
- * the corresponding matrix identifier is returned; otherwise, NONE_MATRIX is returned.
+ * This function parses a positive integer of at most MAX_MAT_DIMENSION at the start of the string.
+ * The integer should be followed by a space, a comma or the end of the command.
  *
- * @algorithm
- * The function follows these steps:
- * 1. Iterate through the range of predefined matrices using the FOR_RANGE macro.
- * 2. Compare the provided string with the string representation of each matrix
- *    using the strncmp function.
- * 3. If a match is found, return the corresponding matrix identifier.
- * 4. If no match is found, return NONE_MATRIX.
+ * @param[in,out] strPtr - Pointer to the pointer into the input string, moved after the dimension if it is valid.
+ * @param[out] returnVal - Pointer to store the extracted dimension.
  *
- * @note
- * - The ptr parameter is a pointer to the string representing the matrix.
- * - The matrix identifiers are defined in the Matrix enum type.
+ * @return bool - TRUE if parsing is successful, FALSE otherwise.
  *
  * @see
- * - FOR_RANGE
- * - NUM_OF_MATRICES
- * - GET_MATRIX
- * - MAX_MAT_NAME
- * - Matrix
- * - NONE_MATRIX
+ * - MAX_MAT_DIMENSION
  *
  * @example
  * \code
  *   // Usage Example:
- *   char *matrixString = "Matrix_A";
- *   Matrix result = getMatrix(matrixString);
- *   if (result != NONE_MATRIX) {
- *       // Valid matrix identifier found.
- *   } else {
- *       // No matching matrix found.
+ *   char *inputString = "3, 4";
+ *   int rows;
+ *   if (getDimension(&inputString, &rows)) {
+ *       // rows is 3 and inputString points at ", 4".
  *   }
  * \endcode
  */
-Matrix getMatrix(char *ptr);
+bool getDimension(char **strPtr, int *returnVal);
 
 /**
  * @brief Parse a string for a scalar value and return the result.
@@ -399,7 +365,8 @@ bool getScalar(const char *strPtr, double *returnVal);
 /**
  * @brief Copy the contents of one matrix to another.
  *
- * This function copies the contents of the source matrix to the destination matrix.
+ * This function copies the contents of the source matrix to the destination matrix,
+ * which takes the shape of the source.
  *
  * @param[in] srcMatrix - Pointer to the source matrix.
  * @param[out] destMatrix - Pointer to the destination matrix.
@@ -407,14 +374,14 @@ bool getScalar(const char *strPtr, double *returnVal);
  * @return void
  *
  * @overview
- * This function iterates through each element of the source matrix and copies it to
- * the corresponding element in the destination matrix. It provides a simple and direct
- * way to duplicate the contents of one matrix into another.
+ * This function copies every row of the source matrix to the corresponding row of the
+ * destination matrix. It provides a simple and direct way to duplicate the contents of
+ * one matrix into another.
  *
  * @algorithm
  * The function follows these steps:
- * 1. Use nested loops to iterate through each element of the source matrix.
- * 2. Copy the value of each element to the corresponding position in the destination matrix.
+ * 1. Recreate the destination matrix if its shape differs from the shape of the source.
+ * 2. Copy the elements of each row of the source to the corresponding row of the destination.
  *
  * @note
  * - The srcMatrix parameter is a pointer to the source matrix.
@@ -469,6 +436,30 @@ void handle_memory_allocation_failure(void);
  */
 void *validated_memory_allocation(size_t size);
 
+/**
+ * @brief Allocates memory aligned to a power of two with error checking.
+ *
+ * This function over-allocates with validated_memory_allocation, so it exits the program on failure,
+ * and returns the first address of the block that is a multiple of the alignment. The address of the
+ * block is stored just before the returned address.
+ *
+ * @param size The size of the memory block to allocate.
+ * @param alignment The alignment of the returned address in bytes, a power of two.
+ * @return A pointer to the aligned memory block.
+ *
+ * @note Memory Management:
+ * The caller is responsible for freeing the memory allocated by this function
+ * using the aligned_memory_free function, not free.
+ */
+void *validated_aligned_allocation(size_t size, size_t alignment);
+
+/**
+ * @brief Frees memory allocated by validated_aligned_allocation.
+ *
+ * @param ptr The aligned memory block, or NULL.
+ */
+void aligned_memory_free(void *ptr);
+
 /**
  * @brief Handles end-of-file conditions during input processing.
  *
@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bloom_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+
+
+/* Initializes an empty filter sized for a number of words and a false-positive rate */
+void bloom_init(BloomFilter *bloom, int num_words, double false_positive_rate) {
+
+    double bits_per_word = -log(false_positive_rate) / (log(2.0) * log(2.0));
+    double total_bits;
+    void *bits;
+
+    bloom->num_hashes = (int) (bits_per_word * log(2.0) + 0.5);
+    if (bloom->num_hashes < 1) {
+        bloom->num_hashes = 1;
+    }
+
+    /* Confining each word to a single block costs accuracy, more so at low rates */
+    total_bits = (bits_per_word * BLOOM_BLOCK_PENALTY + 1.0) * (double) (num_words > 0 ? num_words : 1);
+    bloom->num_blocks = (unsigned long) (total_bits / BLOOM_BLOCK_BITS) + 1;
+
+    /* Align the blocks to cache lines so a lookup never straddles two lines */
+    if (posix_memalign(&bits, BLOOM_BLOCK_BYTES, bloom->num_blocks * BLOOM_BLOCK_BYTES) != 0) {
+        handle_memory_allocation_failure();
+    }
+    bloom->bits = (unsigned int *) bits;
+    memset(bloom->bits, 0, bloom->num_blocks * BLOOM_BLOCK_BYTES);
+}
+
+/* Computes the block of a word and the step between its bit positions */
+static unsigned int *bloom_block(const BloomFilter *bloom, const char *word, unsigned int *first, unsigned int *step) {
+
+    /* Mix the bits of the first hash, the low bits of hash() are weak */
+    unsigned int h1 = mix_hash(hash(word));
+    unsigned int h2 = secondary_hash(word);
+
+    *first = h1;
+    *step = (h1 >> 9) | 1U;
+    return bloom->bits + (h2 % bloom->num_blocks) * BLOOM_BLOCK_WORDS;
+}
+
+/* Adds a word to the filter */
+void bloom_add(BloomFilter *bloom, const char *word) {
+
+    unsigned int first, step, bit;
+    unsigned int *block = bloom_block(bloom, word, &first, &step);
+    int i;
+
+    FOR_RANGE(i, bloom->num_hashes) {
+        bit = (first + (unsigned int) i * step) & (BLOOM_BLOCK_BITS - 1);
+        block[bit >> 5] |= 1U << (bit & 31);
+    }
+}
+
+/* Checks whether a word may be in the filter */
+bool bloom_may_contain(const BloomFilter *bloom, const char *word) {
+
+    unsigned int first, step, bit;
+    const unsigned int *block = bloom_block(bloom, word, &first, &step);
+    int i;
+
+    FOR_RANGE(i, bloom->num_hashes) {
+        bit = (first + (unsigned int) i * step) & (BLOOM_BLOCK_BITS - 1);
+        if (!(block[bit >> 5] & (1U << (bit & 31)))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Frees the memory allocated for the filter */
+void bloom_free(BloomFilter *bloom) {
+
+    free(bloom->bits);
+    bloom->bits = NULL;
+    bloom->num_blocks = 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file bloom_utility.h
+ * @brief Header file containing the blocked Bloom filter in front of the word index.
+ *
+ * This header file defines a cache-line-blocked Bloom filter. Every word sets all of its
+ * bits inside a single 64-byte block, so a lookup touches one cache line. A negative answer
+ * means the word is definitely absent from the index, and the hash table and the postings
+ * are not touched at all.
+ *
+ * The filter is a header followed by one contiguous, aligned array of blocks, so it can be
+ * written to and mapped from a persisted index as is.
+ */
+
+#ifndef BLOOM_UTILITY_H
+#define BLOOM_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Size of a block of the filter in bytes (one cache line).
+ */
+#define BLOOM_BLOCK_BYTES 64
+
+/**
+ * @brief Number of 32-bit words in a block of the filter.
+ */
+#define BLOOM_BLOCK_WORDS (BLOOM_BLOCK_BYTES / 4)
+
+/**
+ * @brief Number of bits in a block of the filter.
+ */
+#define BLOOM_BLOCK_BITS (BLOOM_BLOCK_BYTES * 8)
+
+/**
+ * @brief Factor applied to the bits per word of a standard Bloom filter.
+ *
+ * Confining the bits of a word to one block makes the bits unevenly loaded, which raises
+ * the false-positive rate. The penalty grows as the target rate falls, so the filter is
+ * given proportionally more bits.
+ */
+#define BLOOM_BLOCK_PENALTY 1.15
+
+/**
+ * @brief Structure to represent a blocked Bloom filter.
+ */
+typedef struct BloomFilter {
+    unsigned int *bits;        /**< The blocks of the filter, BLOOM_BLOCK_WORDS words each, 64-byte aligned. */
+    unsigned long num_blocks;  /**< The number of blocks. */
+    int num_hashes;            /**< The number of bits set per word. */
+} BloomFilter;
+
+/**
+ * @brief Initializes an empty filter sized for a number of words and a false-positive rate.
+ *
+ * The number of bits per word and the number of hash functions are derived from the
+ * requested rate with the standard formulas (m/n = -ln(p) / ln(2)^2, k = m/n * ln(2)).
+ * Confining the bits of a word to one block raises the actual rate, so the filter is
+ * enlarged by BLOOM_BLOCK_PENALTY plus one bit per word to compensate.
+ *
+ * @param[out] bloom - The filter to initialize.
+ * @param[in] num_words - The number of words that will be added.
+ * @param[in] false_positive_rate - The target false-positive rate, between 0 and 1.
+ */
+void bloom_init(BloomFilter *bloom, int num_words, double false_positive_rate);
+
+/**
+ * @brief Adds a word to the filter.
+ *
+ * @param[in,out] bloom - The filter.
+ * @param[in] word - The word to add.
+ *
+ * @complexity
+ * Time Complexity: O(length of the word + number of hashes), touching a single cache line.
+ */
+void bloom_add(BloomFilter *bloom, const char *word);
+
+/**
+ * @brief Checks whether a word may be in the filter.
+ *
+ * @param[in] bloom - The filter.
+ * @param[in] word - The word to check.
+ *
+ * @return FALSE if the word is definitely absent, TRUE if it may be present.
+ *
+ * @complexity
+ * Time Complexity: O(length of the word + number of hashes), touching a single cache line.
+ */
+bool bloom_may_contain(const BloomFilter *bloom, const char *word);
+
+/**
+ * @brief Frees the memory allocated for the filter.
+ *
+ * @param[in,out] bloom - The filter to free.
+ */
+void bloom_free(BloomFilter *bloom);
+
+
+#endif /**< BLOOM_UTILITY_H */
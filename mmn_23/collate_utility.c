@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "collate_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief A word and the prefix of its key, sorted by the radix sort.
+ */
+typedef struct {
+    unsigned long prefix; /**< The first COLLATE_PREFIX_BYTES bytes of the key, the first byte highest. */
+    unsigned int id;      /**< The index of the word. */
+} CollateItem;
+
+/**
+ * @brief A word whose key shares its prefix with another key, sorted by comparing strings.
+ */
+typedef struct {
+    const char *key;  /**< The key of the word. */
+    const char *word; /**< The word. */
+    unsigned int id;  /**< The index of the word. */
+} CollateTie;
+
+/* Checks whether a byte is an ASCII digit */
+static bool is_digit(unsigned char c) {
+
+    return (c >= '0' && c <= '9') ? TRUE : FALSE;
+}
+
+/* Packs the first bytes of a key into an integer, padded with null bytes */
+static unsigned long key_prefix(const char *key) {
+
+    const unsigned char *next = (const unsigned char *) key;
+    unsigned long prefix = 0;
+    int i;
+
+    FOR_RANGE(i, COLLATE_PREFIX_BYTES) {
+        prefix <<= 8;
+        if (*next != '\0') {
+            prefix |= *next++;
+        }
+    }
+    return prefix;
+}
+
+/* Compares two tied words for use in qsort */
+static int compare_ties(const void *a, const void *b) {
+
+    const CollateTie *tie_a = (const CollateTie *) a;
+    const CollateTie *tie_b = (const CollateTie *) b;
+
+    return collate_compare(tie_a->key, tie_a->word, tie_b->key, tie_b->word);
+}
+
+/* Sorts items by their prefixes, one byte at a time from the lowest, returns the sorted array */
+static CollateItem *radix_sort(CollateItem *items, CollateItem *buffer, unsigned int count) {
+
+    size_t counts[COLLATE_PREFIX_BYTES][256];
+    size_t offset, bucket_count;
+    CollateItem *source = items, *target = buffer, *swap;
+    unsigned int i;
+    int byte, shift, bucket;
+
+    /* One pass counts the values of every byte of the prefixes */
+    memset(counts, 0, sizeof(counts));
+    FOR_RANGE(i, count) {
+        FOR_RANGE(byte, COLLATE_PREFIX_BYTES) {
+            counts[byte][(items[i].prefix >> (8 * byte)) & 0xFF]++;
+        }
+    }
+
+    FOR_RANGE(byte, COLLATE_PREFIX_BYTES) {
+        shift = 8 * byte;
+
+        /* A byte all the prefixes share does not reorder them */
+        if (count == 0 || counts[byte][(source[0].prefix >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        offset = 0;
+        FOR_RANGE(bucket, 256) {
+            bucket_count = counts[byte][bucket];
+            counts[byte][bucket] = offset;
+            offset += bucket_count;
+        }
+        FOR_RANGE(i, count) {
+            target[counts[byte][(source[i].prefix >> shift) & 0xFF]++] = source[i];
+        }
+        swap = source;
+        source = target;
+        target = swap;
+    }
+    return source;
+}
+
+/* Parses the name of a sort order */
+bool collate_parse(const char *name, CollateOrder *order) {
+
+    if (strcmp(name, SORT_BYTES) == 0) {
+        *order = COLLATE_BYTES;
+    }
+    else if (strcmp(name, SORT_NOCASE) == 0) {
+        *order = COLLATE_NOCASE;
+    }
+    else if (strcmp(name, SORT_NATURAL) == 0) {
+        *order = COLLATE_NATURAL;
+    }
+    else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Computes the collation key of a word */
+size_t collate_key(const char *word, CollateOrder order, char *key) {
+
+    const unsigned char *next = (const unsigned char *) word;
+    const unsigned char *digits;
+    unsigned char *out = (unsigned char *) key;
+    size_t length = 0, num_digits;
+    unsigned char c;
+
+    /* The byte orders copy the word, lowering the ASCII letters without case */
+    if (order != COLLATE_NATURAL) {
+        while ((c = *next++) != '\0') {
+            out[length++] = (order == COLLATE_NOCASE && c >= 'A' && c <= 'Z') ? (unsigned char) (c - 'A' + 'a') : c;
+        }
+        out[length] = '\0';
+        return length;
+    }
+
+    while (*next != '\0') {
+        if (is_digit(*next)) {
+            /* A number is its count of significant digits and the digits, so a longer number comes later */
+            while (*next == '0' && is_digit(next[1])) {
+                next++;
+            }
+            digits = next;
+            while (is_digit(*next)) {
+                next++;
+            }
+            num_digits = (size_t) (next - digits);
+            out[length] = '0';
+            out[length + 1] = (unsigned char) (num_digits > COLLATE_MAX_DIGITS ? COLLATE_MAX_DIGITS : num_digits);
+            memcpy(out + length + 2, digits, num_digits);
+            length += 2 + num_digits;
+        }
+        else {
+            out[length++] = *next++;
+        }
+    }
+    out[length] = '\0';
+    return length;
+}
+
+/* Compares two words by their collation keys, and then by their bytes */
+int collate_compare(const char *key_a, const char *word_a, const char *key_b, const char *word_b) {
+
+    int order = strcmp(key_a, key_b);
+
+    return order != 0 ? order : strcmp(word_a, word_b);
+}
+
+/* Sorts words in an order */
+unsigned int *collate_sort(char *const *words, unsigned int count, CollateOrder order) {
+
+    CollateItem *items = (CollateItem *) validated_memory_allocation(sizeof(CollateItem) * (count + 1));
+    CollateItem *buffer = (CollateItem *) validated_memory_allocation(sizeof(CollateItem) * (count + 1));
+    unsigned int *ids = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (count + 1));
+    const char **keys = (const char **) validated_memory_allocation(sizeof(char *) * (count + 1));
+    size_t *key_offsets = NULL;
+    CollateTie *ties = NULL;
+    CollateItem *sorted;
+    char *pool = NULL;
+    size_t pool_length = 0, pool_capacity = 0, tie_capacity = 0, needed;
+    unsigned int i, j, k;
+
+    /* The keys of the byte order are the words, the others are computed once into a pool */
+    if (order == COLLATE_BYTES) {
+        FOR_RANGE(i, count) {
+            keys[i] = words[i];
+            items[i].prefix = key_prefix(keys[i]);
+            items[i].id = i;
+        }
+    }
+    else {
+        key_offsets = (size_t *) validated_memory_allocation(sizeof(size_t) * (count + 1));
+        FOR_RANGE(i, count) {
+            needed = pool_length + COLLATE_KEY_EXPANSION * strlen(words[i]) + 1;
+            if (needed > pool_capacity) {
+                while (needed > pool_capacity) {
+                    pool_capacity = pool_capacity == 0 ? 4096 : 2 * pool_capacity;
+                }
+                pool = (char *) validated_memory_reallocation(pool, pool_capacity);
+            }
+            key_offsets[i] = pool_length;
+            pool_length += collate_key(words[i], order, pool + pool_length) + 1;
+
+            /* The prefix is packed while the key is still in the cache */
+            items[i].prefix = key_prefix(pool + key_offsets[i]);
+            items[i].id = i;
+        }
+
+        /* The pool no longer moves once every key is in it */
+        FOR_RANGE(i, count) {
+            keys[i] = pool + key_offsets[i];
+        }
+        free(key_offsets);
+    }
+    sorted = radix_sort(items, buffer, count);
+
+    /* Only the words whose keys share the whole prefix are compared as strings */
+    for (i = 0 ; i < count ; i = j) {
+        j = i + 1;
+        while (j < count && sorted[j].prefix == sorted[i].prefix) {
+            j++;
+        }
+        if (j - i == 1) {
+            ids[i] = sorted[i].id;
+            continue;
+        }
+
+        if (j - i > tie_capacity) {
+            tie_capacity = j - i;
+            ties = (CollateTie *) validated_memory_reallocation(ties, sizeof(CollateTie) * tie_capacity);
+        }
+        FOR_RANGE(k, j - i) {
+            ties[k].key = keys[sorted[i + k].id];
+            ties[k].word = words[sorted[i + k].id];
+            ties[k].id = sorted[i + k].id;
+        }
+        qsort(ties, j - i, sizeof(CollateTie), compare_ties);
+        FOR_RANGE(k, j - i) {
+            ids[i + k] = ties[k].id;
+        }
+    }
+
+    free(items);
+    free(buffer);
+    free(keys);
+    free(ties);
+    free(pool);
+    return ids;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file collate_utility.h
+ * @brief Header file containing the sort orders of the words and their collation keys.
+ *
+ * This header file defines the orders the index can be printed in (--sort). Every order is
+ * defined by a collation key, a string derived from the word whose byte order is the order
+ * of the words, so no order needs a comparator of its own:
+ * - COLLATE_BYTES: the key is the word itself, the order of strcmp.
+ * - COLLATE_NOCASE: the ASCII letters of the key are lowercase. The folding does not depend
+ *   on the locale, other bytes are kept (Unicode words are folded by --fold-case).
+ * - COLLATE_NATURAL: every run of digits is replaced by a digit marker, the number of its
+ *   significant digits and those digits, so numbers compare by value ("w2" before "w10").
+ *
+ * Words with the same key ("Hill" and "hill" without case, "7" and "007" naturally) are
+ * ordered by their bytes, so every order is total and the output is deterministic.
+ *
+ * The words are sorted by the first bytes of their keys, packed most significant byte first
+ * into an unsigned long, with an LSD radix sort that skips the bytes all the keys share.
+ * Only the words whose keys share the whole prefix are then compared as strings.
+ */
+
+#ifndef COLLATE_UTILITY_H
+#define COLLATE_UTILITY_H
+
+#include "globals.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Number of bytes of the keys packed into the integer the radix sort sorts by.
+ */
+#define COLLATE_PREFIX_BYTES ((int) sizeof(unsigned long))
+
+/**
+ * @brief Maximum ratio between the length of a key and the length of its word.
+ *
+ * A natural key replaces a single digit by a marker, a count and the digit.
+ */
+#define COLLATE_KEY_EXPANSION 3
+
+/**
+ * @brief Largest number of significant digits a natural key orders by value.
+ *
+ * Longer numbers are ordered after all the shorter ones, and by their digits among themselves.
+ */
+#define COLLATE_MAX_DIGITS 255
+
+/**
+ * @brief Parses the name of a sort order, as given to --sort.
+ *
+ * @param[in] name - The name of the order (SORT_BYTES, SORT_NOCASE or SORT_NATURAL).
+ * @param[out] order - The order.
+ *
+ * @return TRUE if the name is the name of an order, FALSE otherwise.
+ */
+bool collate_parse(const char *name, CollateOrder *order);
+
+/**
+ * @brief Computes the collation key of a word.
+ *
+ * @param[in] word - The word.
+ * @param[in] order - The sort order.
+ * @param[out] key - The null-terminated key, which contains no other null byte. It must have
+ *                   room for COLLATE_KEY_EXPANSION * strlen(word) + 1 bytes.
+ *
+ * @return The length of the key.
+ *
+ * @complexity
+ * Time Complexity: O(m), where m is the length of the word.
+ */
+size_t collate_key(const char *word, CollateOrder order, char *key);
+
+/**
+ * @brief Compares two words by their collation keys, and then by their bytes.
+ *
+ * @param[in] key_a - The key of the first word.
+ * @param[in] word_a - The first word.
+ * @param[in] key_b - The key of the second word.
+ * @param[in] word_b - The second word.
+ *
+ * @return A negative value, zero or a positive value as the first word comes before, is equal
+ *         to or comes after the second one.
+ */
+int collate_compare(const char *key_a, const char *word_a, const char *key_b, const char *word_b);
+
+/**
+ * @brief Sorts words in an order.
+ *
+ * @param[in] words - The words.
+ * @param[in] count - The number of words.
+ * @param[in] order - The sort order.
+ *
+ * @return A newly allocated array of the count indexes of the words, in the order of the words.
+ *         The caller is responsible for freeing it.
+ *
+ * @complexity
+ * Time Complexity: O(n * p + t * log t), where n is the number of words, p the number of prefix
+ * bytes that differ between words, and t the number of words sharing their whole prefix with another.
+ */
+unsigned int *collate_sort(char *const *words, unsigned int count, CollateOrder order);
+
+
+#endif /**< COLLATE_UTILITY_H */
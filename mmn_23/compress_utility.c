@@ -0,0 +1,401 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "compress_utility.h"
+#include "parallel_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Size of the header of a BGZF block, up to its extra field.
+ */
+#define BGZF_HEADER_SIZE 18
+
+/**
+ * @brief Size of the trailer of a gzip member (CRC-32 and uncompressed size).
+ */
+#define GZIP_TRAILER_SIZE 8
+
+/**
+ * @brief Maximum uncompressed size of a BGZF block.
+ */
+#define BGZF_MAX_BLOCK_SIZE 65536
+
+/**
+ * @brief Initial size of the buffer receiving the decompressed contents of a file.
+ */
+#define INPUT_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief Structure to represent a block of a BGZF file and its place in the output.
+ */
+typedef struct {
+    const unsigned char *in; /**< The compressed block, a complete gzip member. */
+    size_t in_length;        /**< The size of the compressed block. */
+    unsigned char *out;      /**< The place of the uncompressed block in the output. */
+    size_t out_length;       /**< The size of the uncompressed block. */
+} GzipBlock;
+
+/**
+ * @brief Structure to represent the blocks inflated by one thread.
+ */
+typedef struct {
+    const GzipBlock *blocks; /**< The blocks of the file. */
+    int first;               /**< The first block of the thread. */
+    int last;                /**< The block after the last block of the thread. */
+    bool ok;                 /**< Set to FALSE if a block is corrupt. */
+} InflateTask;
+
+/* Reads a 16-bit little-endian value */
+static size_t read_le16(const unsigned char *p) {
+
+    return (size_t) p[0] | (size_t) p[1] << 8;
+}
+
+/* Reads a 32-bit little-endian value */
+static size_t read_le32(const unsigned char *p) {
+
+    return (size_t) p[0] | (size_t) p[1] << 8 | (size_t) p[2] << 16 | (size_t) p[3] << 24;
+}
+
+/* Detects the compression format of a file from its first bytes */
+Compression detect_compression(const unsigned char *data, size_t length) {
+
+    if (length >= 3 && data[0] == 0x1F && data[1] == 0x8B && data[2] == 8) {
+        return COMPRESSION_GZIP;
+    }
+    if (length >= 4 && data[0] == 0x28 && data[1] == 0xB5 && data[2] == 0x2F && data[3] == 0xFD) {
+        return COMPRESSION_ZSTD;
+    }
+    return COMPRESSION_NONE;
+}
+
+/* Starts the zstd process decompressing the input into a pipe */
+static bool start_decompressor(InputStream *input) {
+
+    int fds[2];
+
+    if (pipe(fds) < 0) {
+        return FALSE;
+    }
+
+    input->child = fork();
+    if (input->child < 0) {
+        input->child = 0;
+        close(fds[0]);
+        close(fds[1]);
+        return FALSE;
+    }
+
+    if (input->child == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execlp(ZSTD_COMMAND, ZSTD_COMMAND, "-dcq", "--", input->file_name, (char *) NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    input->file = fdopen(fds[0], "r");
+    if (input->file == NULL) {
+        close(fds[0]);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Makes the decompressed input ready to be read, returns FALSE if it cannot be */
+static bool input_ready(InputStream *input) {
+
+    if (input->compression != COMPRESSION_ZSTD || input->file != NULL) {
+        return TRUE;
+    }
+
+    /* The zstd process is started on the first read, so an input that is never read costs nothing */
+    if (input->failed || input->child != 0 || !start_decompressor(input)) {
+        input->failed = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Opens an input file for reading line by line */
+bool input_open(InputStream *input, const char *file_name) {
+
+    unsigned char header[4];
+    size_t length;
+
+    input->file_name = file_name;
+    input->gz = NULL;
+    input->child = 0;
+    input->failed = FALSE;
+
+    input->file = fopen(file_name, "r");
+    if (input->file == NULL) {
+        return FALSE;
+    }
+
+    length = fread(header, 1, sizeof(header), input->file);
+    input->compression = detect_compression(header, length);
+    if (input->compression == COMPRESSION_NONE) {
+        rewind(input->file);
+        return TRUE;
+    }
+
+    fclose(input->file);
+    input->file = NULL;
+
+    if (input->compression == COMPRESSION_GZIP) {
+        input->gz = gzopen(file_name, "rb");
+        if (input->gz == NULL) {
+            return FALSE;
+        }
+        gzbuffer(input->gz, INPUT_BUFFER_SIZE / 8);
+    }
+    return TRUE;
+}
+
+/* Reads the next line of the decompressed input */
+char *input_gets(InputStream *input, char *line, int size) {
+
+    if (input->compression == COMPRESSION_GZIP) {
+        return gzgets(input->gz, line, size);
+    }
+    if (!input_ready(input)) {
+        return NULL;
+    }
+    return fgets(line, size, input->file);
+}
+
+/* Reads the next bytes of the decompressed input */
+size_t input_read(InputStream *input, char *buffer, size_t size) {
+
+    int length;
+
+    if (input->compression == COMPRESSION_GZIP) {
+        /* gzread takes an unsigned int and returns an int */
+        length = gzread(input->gz, buffer, (unsigned int) (size < (1U << 30) ? size : (1U << 30)));
+        return length > 0 ? (size_t) length : 0;
+    }
+    if (!input_ready(input)) {
+        return 0;
+    }
+    return fread(buffer, 1, size, input->file);
+}
+
+/* Closes an input stream */
+bool input_close(InputStream *input) {
+
+    bool ok = input->failed ? FALSE : TRUE;
+    int status;
+    int error;
+
+    if (input->gz != NULL) {
+        gzerror(input->gz, &error);
+        if (error != Z_OK) {
+            ok = FALSE;
+        }
+        gzclose(input->gz);
+        input->gz = NULL;
+    }
+
+    if (input->file != NULL) {
+        if (ferror(input->file)) {
+            ok = FALSE;
+        }
+        fclose(input->file);
+        input->file = NULL;
+    }
+
+    if (input->child > 0) {
+        if (waitpid(input->child, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ok = FALSE;
+        }
+        input->child = 0;
+    }
+    return ok;
+}
+
+/* Finds the size of the BGZF block at the start of the data, 0 if there is no BGZF block there */
+static size_t bgzf_block_size(const unsigned char *data, size_t available) {
+
+    size_t extra_end, i;
+
+    if (available < BGZF_HEADER_SIZE || detect_compression(data, available) != COMPRESSION_GZIP ||
+        !(data[3] & 4)) {
+        return 0;
+    }
+
+    /* The block size is in the BC subfield of the extra field */
+    extra_end = 12 + read_le16(data + 10);
+    for (i = 12; i + 4 <= extra_end && i + 4 <= available; i += 4 + read_le16(data + i + 2)) {
+        if (data[i] == 'B' && data[i + 1] == 'C' && read_le16(data + i + 2) == 2 && i + 6 <= available) {
+            return read_le16(data + i + 4) + 1;
+        }
+    }
+    return 0;
+}
+
+/* Inflates the blocks of one thread, each straight to its place in the output */
+static void *inflate_blocks(void *arg) {
+
+    InflateTask *task = (InflateTask *) arg;
+    const GzipBlock *block;
+    z_stream stream;
+    int i;
+
+    task->ok = TRUE;
+    for (i = task->first; i < task->last && task->ok; i++) {
+        block = &task->blocks[i];
+
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+            task->ok = FALSE;
+            break;
+        }
+
+        /* Every block is a complete gzip member, so its checksum and size are verified too */
+        stream.next_in = (Bytef *) block->in;
+        stream.avail_in = (uInt) block->in_length;
+        stream.next_out = block->out;
+        stream.avail_out = (uInt) block->out_length;
+        if (inflate(&stream, Z_FINISH) != Z_STREAM_END || stream.avail_out != 0) {
+            task->ok = FALSE;
+        }
+        inflateEnd(&stream);
+    }
+    return NULL;
+}
+
+/* Decompresses a BGZF file on several threads, returns FALSE if it is not a valid BGZF file */
+static bool inflate_bgzf(const MappedFile *compressed, MappedFile *mapped, int threads) {
+
+    const unsigned char *data = (const unsigned char *) compressed->data;
+    GzipBlock *blocks = NULL;
+    InflateTask *tasks;
+    unsigned char *out;
+    size_t offset = 0, total = 0, block_size;
+    int num_blocks = 0, capacity = 0;
+    bool ok = TRUE;
+    int i;
+
+    /* Find the blocks, and the place of every block in the output from its uncompressed size */
+    while (offset < compressed->size) {
+        block_size = bgzf_block_size(data + offset, compressed->size - offset);
+        if (block_size < BGZF_HEADER_SIZE + GZIP_TRAILER_SIZE || block_size > compressed->size - offset ||
+            read_le32(data + offset + block_size - 4) > BGZF_MAX_BLOCK_SIZE) {
+            free(blocks);
+            return FALSE;
+        }
+
+        if (num_blocks == capacity) {
+            capacity = capacity == 0 ? 64 : 2 * capacity;
+            blocks = (GzipBlock *) validated_memory_reallocation(blocks, sizeof(GzipBlock) * (size_t) capacity);
+        }
+        blocks[num_blocks].in = data + offset;
+        blocks[num_blocks].in_length = block_size;
+        blocks[num_blocks].out_length = read_le32(data + offset + block_size - 4);
+        total += blocks[num_blocks].out_length;
+        num_blocks++;
+        offset += block_size;
+    }
+
+    out = (unsigned char *) validated_memory_allocation(total + 1);
+    total = 0;
+    FOR_RANGE(i, num_blocks) {
+        blocks[i].out = out + total;
+        total += blocks[i].out_length;
+    }
+
+    /* Every thread inflates a run of consecutive blocks */
+    if (threads > num_blocks) {
+        threads = num_blocks > 0 ? num_blocks : 1;
+    }
+    tasks = (InflateTask *) validated_memory_allocation(sizeof(InflateTask) * (size_t) threads);
+    FOR_RANGE(i, threads) {
+        tasks[i].blocks = blocks;
+        tasks[i].first = (int) ((long) num_blocks * i / threads);
+        tasks[i].last = (int) ((long) num_blocks * (i + 1) / threads);
+    }
+    run_on_threads(tasks, sizeof(InflateTask), threads, inflate_blocks);
+
+    FOR_RANGE(i, threads) {
+        if (!tasks[i].ok) {
+            ok = FALSE;
+        }
+    }
+    free(tasks);
+    free(blocks);
+
+    if (!ok) {
+        free(out);
+        return FALSE;
+    }
+    mapped->data = (const char *) out;
+    mapped->size = total;
+    mapped->owned = TRUE;
+    return TRUE;
+}
+
+/* Reads the whole decompressed input into memory */
+static bool read_input(const char *file_name, MappedFile *mapped) {
+
+    InputStream input;
+    size_t capacity = INPUT_BUFFER_SIZE;
+    size_t size = 0;
+    size_t length;
+    char *data;
+
+    if (!input_open(&input, file_name)) {
+        return FALSE;
+    }
+
+    data = (char *) validated_memory_allocation(capacity);
+    while ((length = input_read(&input, data + size, capacity - size)) > 0) {
+        size += length;
+        if (size == capacity) {
+            capacity *= 2;
+            data = (char *) validated_memory_reallocation(data, capacity);
+        }
+    }
+
+    if (!input_close(&input)) {
+        free(data);
+        return FALSE;
+    }
+    mapped->data = data;
+    mapped->size = size;
+    mapped->owned = TRUE;
+    return TRUE;
+}
+
+/* Maps an input file into memory for reading, decompressing it if it is compressed */
+bool map_input(const char *file_name, MappedFile *mapped, int threads) {
+
+    MappedFile compressed;
+    Compression compression;
+
+    if (!map_file(file_name, &compressed)) {
+        return FALSE;
+    }
+
+    compression = detect_compression((const unsigned char *) compressed.data, compressed.size);
+    if (compression == COMPRESSION_NONE) {
+        *mapped = compressed;
+        return TRUE;
+    }
+
+    /* A BGZF file is inflated block by block in parallel, any other one is streamed */
+    if (compression == COMPRESSION_GZIP && inflate_bgzf(&compressed, mapped, threads)) {
+        unmap_file(&compressed);
+        return TRUE;
+    }
+    unmap_file(&compressed);
+    return read_input(file_name, mapped);
+}
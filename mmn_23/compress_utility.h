@@ -0,0 +1,128 @@
+/**
+ * @file compress_utility.h
+ * @brief Header file containing the reading of compressed input files.
+ *
+ * This header file defines the input of the indexer, which may be a plain text file or a file
+ * compressed with gzip or zstd. The format is detected from the first bytes of the file, so a
+ * compressed file is indexed without being decompressed to a temporary file first.
+ *
+ * The sequential pass reads the file through an input stream, which decompresses it as the
+ * lines are read: gzip (including files of several members) through zlib, and zstd through a
+ * zstd process whose output is read from a pipe. The passes that map the file (the parallel
+ * indexer, the searches and the snippets) get its decompressed contents in memory instead.
+ *
+ * A gzip file in the BGZF format (blocks of at most 64 KiB, each a gzip member recording its
+ * compressed size, as written by bgzip) is decompressed on several threads. The uncompressed
+ * size of every block is read from its trailer first, so every block is inflated directly to
+ * its place in the output, and lines that cross block boundaries come out whole.
+ */
+
+#ifndef COMPRESS_UTILITY_H
+#define COMPRESS_UTILITY_H
+
+#include "globals.h"
+#include "utility.h"
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+/**
+ * @brief Command run to decompress zstd files, found on the PATH.
+ */
+#define ZSTD_COMMAND "zstd"
+
+/**
+ * @brief The compression formats of an input file.
+ */
+typedef enum {
+    COMPRESSION_NONE, /**< A plain text file. */
+    COMPRESSION_GZIP, /**< A gzip file, of one or several members. */
+    COMPRESSION_ZSTD  /**< A zstd file. */
+} Compression;
+
+/**
+ * @brief Structure to represent an input file read line by line, decompressed as it is read.
+ */
+typedef struct {
+    Compression compression; /**< The format of the file. */
+    const char *file_name;   /**< The name of the file. */
+    FILE *file;              /**< The plain file, or the pipe from the zstd process once started. */
+    gzFile gz;               /**< The gzip file, NULL unless the file is gzip-compressed. */
+    pid_t child;             /**< The zstd process, 0 if it was not started. */
+    bool failed;             /**< TRUE if the zstd process could not be started. */
+} InputStream;
+
+/**
+ * @brief Detects the compression format of a file from its first bytes.
+ *
+ * @param[in] data - The first bytes of the file.
+ * @param[in] length - The number of bytes available.
+ *
+ * @return The compression format, COMPRESSION_NONE if the bytes start no known format.
+ */
+Compression detect_compression(const unsigned char *data, size_t length);
+
+/**
+ * @brief Opens an input file for reading line by line.
+ *
+ * A zstd process is only started when the first line is read.
+ *
+ * @param[out] input - The input stream.
+ * @param[in] file_name - The name of the file. It must remain valid while the stream is open.
+ *
+ * @return TRUE if the file was opened, FALSE otherwise.
+ */
+bool input_open(InputStream *input, const char *file_name);
+
+/**
+ * @brief Reads the next line of the decompressed input, with the semantics of fgets.
+ *
+ * @param[in,out] input - The input stream.
+ * @param[out] line - The buffer receiving the line, null-terminated.
+ * @param[in] size - The size of the buffer. At most size - 1 bytes are read.
+ *
+ * @return The buffer, or NULL at the end of the input or on an error.
+ */
+char *input_gets(InputStream *input, char *line, int size);
+
+/**
+ * @brief Reads the next bytes of the decompressed input.
+ *
+ * @param[in,out] input - The input stream.
+ * @param[out] buffer - The buffer receiving the bytes.
+ * @param[in] size - The size of the buffer.
+ *
+ * @return The number of bytes read, 0 at the end of the input or on an error.
+ */
+size_t input_read(InputStream *input, char *buffer, size_t size);
+
+/**
+ * @brief Closes an input stream.
+ *
+ * @param[in,out] input - The input stream.
+ *
+ * @return TRUE if the whole input was read without errors, FALSE if the compressed data was
+ *         corrupt or truncated, or the zstd process failed.
+ */
+bool input_close(InputStream *input);
+
+/**
+ * @brief Maps an input file into memory for reading, decompressing it if it is compressed.
+ *
+ * A plain file is mapped with map_file. The contents of a compressed file are decompressed into
+ * memory, on up to threads threads for a BGZF file. The result is released with unmap_file.
+ *
+ * @param[in] file_name - The name of the file.
+ * @param[out] mapped - The mapping, or the decompressed contents, of the file.
+ * @param[in] threads - The number of threads that may decompress the file.
+ *
+ * @return TRUE if the file was mapped, FALSE if it could not be opened, mapped or decompressed.
+ *
+ * @complexity
+ * Time Complexity: O(n / t) for a BGZF file of n bytes decompressed on t threads, O(n) otherwise.
+ */
+bool map_input(const char *file_name, MappedFile *mapped, int threads);
+
+
+#endif /**< COMPRESS_UTILITY_H */
@@ -3,7 +3,7 @@
  * @brief Header file containing constants used throughout the program.
  *
  * This header file defines various constants used in the program,
- * such as maximum line length, hash table size, valid argument count,
+ * such as maximum line length, hash table size, command-line options,
  * and whitespace characters.
  */
 
@@ -19,30 +19,262 @@
 #define MAX_LINE_LENGTH 1024
 
 /**
- * @brief Size of the hash table.
+ * @brief Initial size of the hash table.
  *
- * This constant defines the size of the hash table used for indexing words.
- * It determines the number of buckets in the hash table, impacting the
- * distribution of hash values across the table.
+ * This constant defines the initial number of slots in the table of the symbol
+ * table used for interning words. The table doubles its size whenever it becomes
+ * more than half full, so the value must be a power of two.
  */
-#define HASH_SIZE 100
+#define HASH_SIZE 128
 
 /**
- * @brief Expected count of command-line arguments.
+ * @brief Number of line list nodes allocated together in a block.
  *
- * This constant defines the expected count of command-line arguments
- * when running the program. It is used for input validation.
+ * Every occurrence of a word appends a node to its line list. The nodes are taken
+ * from blocks of this size, so indexing does not call malloc for every occurrence
+ * and freeing the index does not walk the lists.
  */
-#define VALID_ARG_COUNT 2
+#define NODE_BLOCK_SIZE 4096
 
 /**
- * @brief String containing whitespace characters.
+ * @brief Initial number of bytes allocated for the compressed postings of a word.
  *
- * This constant defines a string containing whitespace characters, including
- * space (' '), tab ('\t'), and newline ('\n'). It is used for tokenizing input.
+ * It must be at least MAX_VARINT_BYTES, so doubling it once always makes room for a delta.
  */
-#define SPACES " \t\n"
+#define POSTINGS_INITIAL_CAPACITY 16
 
+/**
+ * @brief Command-line option for a substring search over the indexed file.
+ *
+ * The option takes the substring as its value. The search is narrowed to
+ * candidate lines with the trigram index.
+ */
+#define GREP_OPTION "--grep"
+
+/**
+ * @brief Command-line option for a regular expression search over the indexed file.
+ *
+ * The option takes a POSIX extended regular expression as its value. The search is
+ * narrowed to candidate lines with the trigram index.
+ */
+#define REGEX_OPTION "--regex"
+
+/**
+ * @brief Command-line option for printing only the most frequent words.
+ *
+ * The option takes the number of words K as its value. The K most frequent words
+ * are selected with a bounded heap, without sorting the whole index.
+ */
+#define TOP_OPTION "--top"
+
+/**
+ * @brief Command-line option for printing the number of occurrences of each word.
+ */
+#define COUNTS_OPTION "--counts"
+
+/**
+ * @brief Command-line option for approximate top-K counting.
+ *
+ * With this option the words are counted in a Count-Min sketch instead of the
+ * exact index, so memory stays bounded for streams too large to index.
+ */
+#define APPROX_OPTION "--approx"
+
+/**
+ * @brief Command-line option for the daemon mode.
+ *
+ * The option takes the path of a Unix domain socket as its value. The index is built
+ * once and lookups are then served on the socket until SIGINT or SIGTERM.
+ */
+#define SERVE_OPTION "--serve"
+
+/**
+ * @brief Command-line option for the number of worker threads of the server.
+ */
+#define WORKERS_OPTION "--workers"
+
+/**
+ * @brief Default number of worker threads of the server.
+ */
+#define DEFAULT_WORKERS 4
+
+/**
+ * @brief Command-line option for the false-positive rate of the Bloom filter.
+ *
+ * The Bloom filter is built in front of the served index so that lookups of absent
+ * words are answered without probing the table. The option takes a rate between 0 and 1.
+ */
+#define BLOOM_FPR_OPTION "--bloom-fpr"
+
+/**
+ * @brief Default false-positive rate of the Bloom filter.
+ */
+#define DEFAULT_BLOOM_FPR 0.01
+
+/**
+ * @brief Command-line option for printing the position of every occurrence.
+ *
+ * With this option the line, column and byte offset of every occurrence of a word
+ * are recorded in its postings, and the index is printed with the positions.
+ */
+#define POSITIONS_OPTION "--positions"
+
+/**
+ * @brief Command-line option for printing every occurrence with the text around it.
+ *
+ * The option takes the number of bytes of context to print on each side of the word.
+ * The positions are recorded, and the snippets are read from a mapping of the file.
+ */
+#define CONTEXT_OPTION "--context"
+
+/**
+ * @brief Command-line option for printing the lines every word appears in under the word.
+ *
+ * The offset of every line is recorded in a line table while the file is indexed, and every
+ * line is read from a mapping of the file at its offset (see line_table_utility.h).
+ */
+#define SHOW_LINES_OPTION "--show-lines"
+
+/**
+ * @brief Command-line option for printing the number of occurrences of a word on every line.
+ *
+ * A line is listed once per word however often the word appears on it, and the number of
+ * occurrences is kept with the line (see encode_posting), printed as "line:count".
+ */
+#define LINE_COUNTS_OPTION "--line-counts"
+
+/**
+ * @brief Command-line option for splitting words at punctuation.
+ *
+ * By default words are separated by whitespace only. With this option they are also
+ * separated by Unicode punctuation and symbols, so "hill," and "hill" are the same word.
+ */
+#define WORDS_OPTION "--words"
+
+/**
+ * @brief Command-line option for case-insensitive indexing.
+ *
+ * With this option every word is case-folded before it is indexed, and the words
+ * looked up on the server are folded the same way.
+ */
+#define FOLD_CASE_OPTION "--fold-case"
+
+/**
+ * @brief Command-line option for the word n-gram mode.
+ *
+ * The option takes the number of words of an n-gram (2 for pairs, 3 for triples).
+ * The n-grams of consecutive words on each line are indexed and printed instead of
+ * the words, or only the most frequent ones with --top.
+ */
+#define NGRAMS_OPTION "--ngrams"
+
+/**
+ * @brief Command-line option for the number of threads indexing the file.
+ *
+ * The file is split into one chunk per thread, and the postings of the chunks are merged
+ * in the order of the file, so the output is the same as with a single thread.
+ */
+#define THREADS_OPTION "--threads"
+
+/**
+ * @brief Maximum number of threads indexing the file.
+ */
+#define MAX_THREADS 256
+
+/**
+ * @brief Command-line option for the memory budget of the index.
+ *
+ * The option takes a number of bytes, optionally followed by K, M or G. When the index
+ * approaches the budget, its line lists are compressed, and then the index is spilled to
+ * temporary files in sorted runs, which are merged when the output is printed.
+ */
+#define MAX_MEMORY_OPTION "--max-memory"
+
+/**
+ * @brief Smallest memory budget accepted by --max-memory, in bytes.
+ */
+#define MIN_MAX_MEMORY 65536
+
+/**
+ * @brief Command-line option to save a snapshot of the index to a file after indexing.
+ *
+ * The index is written in the layout the server reads it in (see snapshot_utility.h), and
+ * is served right away with --serve. Without --serve, nothing is printed.
+ */
+#define SAVE_SNAPSHOT_OPTION "--save-snapshot"
+
+/**
+ * @brief Command-line option to serve a snapshot saved by --save-snapshot, instead of indexing a file.
+ *
+ * The snapshot is mapped rather than read, so the server starts without rebuilding the index.
+ * The words are looked up with the tokenizer options the snapshot was indexed with.
+ */
+#define LOAD_SNAPSHOT_OPTION "--load-snapshot"
+
+/**
+ * @brief Command-line option for the order the words are printed in.
+ *
+ * The option takes SORT_BYTES (the default), SORT_NOCASE or SORT_NATURAL, and applies to the
+ * printed index, --counts and the n-grams. Ties of --top are broken by the byte order.
+ */
+#define SORT_OPTION "--sort"
+
+/**
+ * @brief Value of --sort for the byte order of the words.
+ */
+#define SORT_BYTES "bytes"
+
+/**
+ * @brief Value of --sort for the byte order with ASCII letters compared without case.
+ */
+#define SORT_NOCASE "nocase"
+
+/**
+ * @brief Value of --sort for the byte order with numbers compared by value.
+ */
+#define SORT_NATURAL "natural"
+
+/**
+ * @brief Command-line option for the directory whose tree is indexed instead of a file.
+ *
+ * The tree is crawled on --threads threads, and its regular files are indexed as one input,
+ * in the order of their paths. The occurrences are printed as the files and their lines.
+ */
+#define RECURSIVE_OPTION "-r"
+
+/**
+ * @brief Command-line option for the glob the names of the crawled files must match.
+ */
+#define INCLUDE_OPTION "--include"
+
+/**
+ * @brief Command-line option for the largest size of the crawled files.
+ *
+ * The option takes a number of bytes, optionally followed by K, M or G, as --max-memory.
+ */
+#define MAX_FILE_SIZE_OPTION "--max-file-size"
+
+/**
+ * @brief Command-line option for the file the stacks sampled during the run are written to.
+ *
+ * The stacks are written as collapsed stacks, ready for flame graph tools (see profile_utility.h).
+ */
+#define PROFILE_OPTION "--profile"
+
+/**
+ * @brief Number of rows (hash functions) of the Count-Min sketch.
+ *
+ * The probability that an estimate exceeds its error bound is e^(-depth).
+ */
+#define SKETCH_DEPTH 4
+
+/**
+ * @brief Number of counters in each row of the Count-Min sketch.
+ *
+ * The overestimation of a count is at most e / width of the total number of words,
+ * with high probability. The value must be a power of two.
+ */
+#define SKETCH_WIDTH 65536
 /**
  * @brief Macro for representing the newline character.
  *
@@ -0,0 +1,374 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "crawl_utility.h"
+#include "parallel_utility.h"
+#include "collate_utility.h"
+#include "error_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Structure to represent the directories a thread of the crawl has still to read.
+ *
+ * The deque is a ring of paths. Its owner pushes and pops at the back, other threads steal
+ * from the front.
+ */
+typedef struct {
+    pthread_mutex_t lock; /**< Protects the deque. */
+    char **paths;         /**< The ring of the paths of the directories. */
+    size_t head;          /**< The slot of the front of the deque. */
+    size_t count;         /**< The number of directories in the deque. */
+    size_t capacity;      /**< The number of slots of the ring. */
+} DirectoryDeque;
+
+struct Crawler;
+
+/**
+ * @brief Structure to represent a thread of the crawl.
+ */
+typedef struct {
+    struct Crawler *crawler; /**< The crawl the thread takes part in. */
+    int id;                  /**< The number of the thread. */
+    DirectoryDeque dirs;     /**< The directories the thread has still to read. */
+    FileList files;          /**< The files found by the thread. */
+} CrawlWorker;
+
+/**
+ * @brief Structure to represent a crawl, shared by its threads.
+ */
+typedef struct Crawler {
+    const char *include;     /**< Glob the names of the files must match, NULL for every file. */
+    unsigned long max_size;  /**< Largest size of the files kept, 0 for every size. */
+    CrawlWorker *workers;    /**< The threads of the crawl. */
+    int num_workers;         /**< The number of threads. */
+    pthread_mutex_t lock;    /**< Protects the counters below. */
+    pthread_cond_t wake;     /**< Signaled when directories are queued or the crawl ends. */
+    long queued;             /**< The number of directories in the deques. */
+    long pending;            /**< The number of directories queued or being read. */
+} Crawler;
+
+/* Initializes an empty file list */
+void file_list_init(FileList *files) {
+
+    files->paths = NULL;
+    files->sizes = NULL;
+    files->first_lines = NULL;
+    files->count = 0;
+    files->capacity = 0;
+}
+
+/* Adds a file to a file list, which takes ownership of its path */
+static void file_list_add(FileList *files, char *path, unsigned long size) {
+
+    if (files->count == files->capacity) {
+        files->capacity = files->capacity == 0 ? CRAWL_DEQUE_SIZE : 2 * files->capacity;
+        files->paths = (char **) validated_memory_reallocation(files->paths, sizeof(char *) * files->capacity);
+        files->sizes = (unsigned long *) validated_memory_reallocation(files->sizes,
+                                                                       sizeof(unsigned long) * files->capacity);
+    }
+    files->paths[files->count] = path;
+    files->sizes[files->count] = size;
+    files->count++;
+}
+
+/* Pushes a directory at the back of a deque */
+static void deque_push(DirectoryDeque *deque, char *path) {
+
+    char **paths;
+    size_t i;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        /* The ring is unrolled into an array twice as large */
+        paths = (char **) validated_memory_allocation(sizeof(char *) * 2 * deque->capacity);
+        FOR_RANGE(i, deque->count) {
+            paths[i] = deque->paths[(deque->head + i) % deque->capacity];
+        }
+        free(deque->paths);
+        deque->paths = paths;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+    deque->paths[(deque->head + deque->count) % deque->capacity] = path;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/* Pops the directory at the back of a deque, NULL if it is empty */
+static char *deque_pop(DirectoryDeque *deque) {
+
+    char *path = NULL;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        deque->count--;
+        path = deque->paths[(deque->head + deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return path;
+}
+
+/* Steals the directory at the front of a deque, NULL if it is empty */
+static char *deque_steal(DirectoryDeque *deque) {
+
+    char *path = NULL;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        path = deque->paths[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return path;
+}
+
+/* Joins a directory and the name of one of its entries into a new path */
+static char *join_path(const char *directory, size_t directory_length, const char *name) {
+
+    size_t name_length = strlen(name);
+    bool separator = (directory_length > 0 && directory[directory_length - 1] == '/') ? FALSE : TRUE;
+    char *path = (char *) validated_memory_allocation(directory_length + separator + name_length + 1);
+
+    memcpy(path, directory, directory_length);
+    if (separator) {
+        path[directory_length] = '/';
+    }
+    memcpy(path + directory_length + separator, name, name_length + 1);
+    return path;
+}
+
+/* Reads a directory, queuing its subdirectories and keeping its files, returns the number of subdirectories */
+static long read_directory(CrawlWorker *worker, const char *path) {
+
+    const Crawler *crawler = worker->crawler;
+    size_t path_length = strlen(path);
+    struct dirent *dir_entry;
+    struct stat info;
+    const char *name;
+    DIR *dir;
+    long subdirectories = 0;
+    bool known;
+    int fd, type;
+
+    fd = open(path, O_RDONLY | O_DIRECTORY);
+    dir = fd >= 0 ? fdopendir(fd) : NULL;
+    if (dir == NULL) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        error_handling(OPEN_DIR_ERR, path);
+        return 0;
+    }
+
+    while ((dir_entry = readdir(dir)) != NULL) {
+        name = dir_entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        /* Only the file systems that do not report the type of an entry need a stat to tell a directory */
+        type = dir_entry->d_type;
+        known = FALSE;
+        if (type == DT_UNKNOWN) {
+            if (fstatat(dirfd(dir), name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_UNKNOWN;
+            known = TRUE;
+        }
+
+        if (type == DT_DIR) {
+            deque_push(&worker->dirs, join_path(path, path_length, name));
+            subdirectories++;
+        }
+        else if (type == DT_REG) {
+            /* The glob is matched before the file is examined for its size */
+            if (crawler->include != NULL && fnmatch(crawler->include, name, 0) != 0) {
+                continue;
+            }
+            if (!known && fstatat(dirfd(dir), name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            if (crawler->max_size > 0 && (unsigned long) info.st_size > crawler->max_size) {
+                continue;
+            }
+            file_list_add(&worker->files, join_path(path, path_length, name), (unsigned long) info.st_size);
+        }
+    }
+    closedir(dir);
+    return subdirectories;
+}
+
+/* Reads directories until no directory is queued or being read, the work of one thread */
+static void *crawl_worker(void *arg) {
+
+    CrawlWorker *worker = (CrawlWorker *) arg;
+    Crawler *crawler = worker->crawler;
+    char *path;
+    long subdirectories;
+    bool done;
+    int i;
+
+    while (TRUE) {
+        /* Take the last directory of the deque of the thread, or steal the first of another deque */
+        path = deque_pop(&worker->dirs);
+        for (i = 1 ; path == NULL && i < crawler->num_workers ; i++) {
+            path = deque_steal(&crawler->workers[(worker->id + i) % crawler->num_workers].dirs);
+        }
+
+        if (path == NULL) {
+            /* Sleep until another thread queues directories, or the last directory is read */
+            pthread_mutex_lock(&crawler->lock);
+            while (crawler->queued <= 0 && crawler->pending > 0) {
+                pthread_cond_wait(&crawler->wake, &crawler->lock);
+            }
+            done = (crawler->pending == 0) ? TRUE : FALSE;
+            pthread_mutex_unlock(&crawler->lock);
+            if (done) {
+                break;
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&crawler->lock);
+        crawler->queued--;
+        pthread_mutex_unlock(&crawler->lock);
+
+        subdirectories = read_directory(worker, path);
+        free(path);
+
+        /* The subdirectories are announced together, the directory read is no longer pending */
+        pthread_mutex_lock(&crawler->lock);
+        crawler->queued += subdirectories;
+        crawler->pending += subdirectories - 1;
+        if (subdirectories > 0 || crawler->pending == 0) {
+            pthread_cond_broadcast(&crawler->wake);
+        }
+        pthread_mutex_unlock(&crawler->lock);
+    }
+    return NULL;
+}
+
+/* Crawls a directory tree on several threads into the list of its regular files */
+bool crawl_directory(FileList *files, const char *root, const char *include, unsigned long max_size, int threads) {
+
+    Crawler crawler;
+    FileList found;
+    unsigned int *order;
+    struct stat info;
+    size_t i;
+    int t;
+
+    if (stat(root, &info) != 0 || !S_ISDIR(info.st_mode)) {
+        return FALSE;
+    }
+
+    crawler.include = include;
+    crawler.max_size = max_size;
+    crawler.num_workers = threads;
+    crawler.workers = (CrawlWorker *) validated_memory_allocation(sizeof(CrawlWorker) * (size_t) threads);
+    pthread_mutex_init(&crawler.lock, NULL);
+    pthread_cond_init(&crawler.wake, NULL);
+    FOR_RANGE(t, threads) {
+        crawler.workers[t].crawler = &crawler;
+        crawler.workers[t].id = t;
+        pthread_mutex_init(&crawler.workers[t].dirs.lock, NULL);
+        crawler.workers[t].dirs.capacity = CRAWL_DEQUE_SIZE;
+        crawler.workers[t].dirs.paths = (char **) validated_memory_allocation(sizeof(char *) * CRAWL_DEQUE_SIZE);
+        crawler.workers[t].dirs.head = 0;
+        crawler.workers[t].dirs.count = 0;
+        file_list_init(&crawler.workers[t].files);
+    }
+
+    /* The root is the only directory queued at the start */
+    deque_push(&crawler.workers[0].dirs, duplicate_string(root));
+    crawler.queued = 1;
+    crawler.pending = 1;
+
+    run_on_threads(crawler.workers, sizeof(CrawlWorker), threads, crawl_worker);
+
+    /* Gather the files found by every thread */
+    file_list_init(&found);
+    FOR_RANGE(t, threads) {
+        FOR_RANGE(i, crawler.workers[t].files.count) {
+            file_list_add(&found, crawler.workers[t].files.paths[i], crawler.workers[t].files.sizes[i]);
+        }
+        free(crawler.workers[t].files.paths);
+        free(crawler.workers[t].files.sizes);
+        free(crawler.workers[t].dirs.paths);
+        pthread_mutex_destroy(&crawler.workers[t].dirs.lock);
+    }
+    pthread_cond_destroy(&crawler.wake);
+    pthread_mutex_destroy(&crawler.lock);
+    free(crawler.workers);
+
+    /* Sort the files by path, so the files and their lines are numbered the same on every run */
+    order = collate_sort(found.paths, (unsigned int) found.count, COLLATE_BYTES);
+    file_list_init(files);
+    FOR_RANGE(i, found.count) {
+        file_list_add(files, found.paths[order[i]], found.sizes[order[i]]);
+    }
+    files->first_lines = (int *) validated_memory_allocation(sizeof(int) * (files->count + 1));
+    memset(files->first_lines, 0, sizeof(int) * (files->count + 1));
+
+    free(order);
+    free(found.paths);
+    free(found.sizes);
+    return TRUE;
+}
+
+/* Prints the occurrences of a word as the files and the lines of the files they are in */
+void print_word_files(FILE *out, const WordEntry *entry, const FileList *files, bool line_counts) {
+
+    ListNode *curr = entry->lines;
+    size_t file = 0, low, high, middle;
+
+    fprintf(out, "%s - appears in", entry->word);
+    while (curr != NULL) {
+        /* The lines are increasing, so the file of a line is searched from the file of the previous one */
+        low = file;
+        high = files->count;
+        while (high - low > 1) {
+            middle = low + (high - low) / 2;
+            if (files->first_lines[middle] < curr->line_number) {
+                low = middle;
+            }
+            else {
+                high = middle;
+            }
+        }
+        file = low;
+        fprintf(out, " %s:%d", files->paths[file], curr->line_number - files->first_lines[file]);
+        if (line_counts) {
+            fprintf(out, ":%d", curr->count);
+        }
+        curr = curr->next;
+    }
+    fprintf(out, NEW_LINE);
+}
+
+/* Frees the memory allocated for the file list */
+void file_list_free(FileList *files) {
+
+    size_t i;
+
+    FOR_RANGE(i, files->count) {
+        free(files->paths[i]);
+    }
+    free(files->paths);
+    free(files->sizes);
+    free(files->first_lines);
+    file_list_init(files);
+}
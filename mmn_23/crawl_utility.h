@@ -0,0 +1,107 @@
+/**
+ * @file crawl_utility.h
+ * @brief Header file containing the crawl of a directory tree into the list of files to index.
+ *
+ * This header file defines the recursive crawl of -r. The tree is walked on several threads,
+ * every thread reading whole directories: the entries of a directory are read in batches by
+ * readdir from a descriptor opened with open(O_DIRECTORY), and the files are examined with
+ * fstatat relative to that descriptor, so no path is resolved again from the root. The type
+ * reported by readdir spares the stat of the subdirectories. Symbolic links are not followed.
+ *
+ * Every thread keeps the directories it has still to read in a deque of its own. It pushes the
+ * subdirectories it finds and pops the last one, so it walks its part of the tree depth first.
+ * A thread whose deque is empty steals the oldest directory of another thread, the root of the
+ * largest part of the tree left, and sleeps only once no deque holds a directory. The crawl
+ * ends when no directory is queued or being read.
+ *
+ * The files are filtered by the glob of their name (--include) and their size (--max-file-size),
+ * and the list is sorted by path once the crawl ends, so the output does not depend on the order
+ * the threads found the files in.
+ */
+
+#ifndef CRAWL_UTILITY_H
+#define CRAWL_UTILITY_H
+
+#include "globals.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * @brief Initial number of directories a deque of the crawl can hold.
+ */
+#define CRAWL_DEQUE_SIZE 64
+
+/**
+ * @brief Size from which a crawled file is mapped to be indexed, in bytes.
+ *
+ * Smaller files are read into a buffer of the indexing thread, reused from file to file, which
+ * spares the mapping, the page faults and the unmapping of every file.
+ */
+#define CRAWL_MAP_SIZE (1 << 20)
+
+/**
+ * @brief Structure to represent the files found by a crawl, indexed as one input.
+ *
+ * The lines of the files are numbered one after another, in the order of the list, so a line
+ * of the index is found in its file by the number of lines before every file.
+ */
+typedef struct {
+    char **paths;              /**< The paths of the files, sorted by their bytes. */
+    unsigned long *sizes;      /**< The size of every file in bytes, when it was found. */
+    int *first_lines;          /**< The number of lines before every file, known once the files are indexed. */
+    size_t count;              /**< The number of files. */
+    size_t capacity;           /**< The number of paths allocated. */
+} FileList;
+
+/**
+ * @brief Initializes an empty file list.
+ *
+ * @param[out] files - The file list.
+ */
+void file_list_init(FileList *files);
+
+/**
+ * @brief Crawls a directory tree on several threads into the list of its regular files.
+ *
+ * A subdirectory that cannot be read is reported and skipped.
+ *
+ * @param[out] files - The empty file list, sorted by path once the crawl ends.
+ * @param[in] root - The directory to crawl.
+ * @param[in] include - Glob the names of the files must match (fnmatch), NULL to keep every file.
+ * @param[in] max_size - Largest size of the files kept in bytes, 0 to keep every file.
+ * @param[in] threads - The number of threads crawling the tree.
+ *
+ * @return TRUE if the tree was crawled, FALSE if the root is not a directory that can be read.
+ *
+ * @complexity
+ * Time Complexity: O(e / t + f * log f), where e is the number of entries of the tree, t the number
+ * of threads and f the number of files kept, sorted by a radix sort of their paths (see collate_utility.h).
+ */
+bool crawl_directory(FileList *files, const char *root, const char *include, unsigned long max_size, int threads);
+
+/**
+ * @brief Prints the occurrences of a word as the files and the lines of the files they are in.
+ *
+ * The word is printed as "word - appears in path:line path:line ...", every line once, or as
+ * "path:line:count" with the number of occurrences on the line.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] entry - The entry of the word, its line numbers counted across the files of the list.
+ * @param[in] files - The indexed file list.
+ * @param[in] line_counts - TRUE to print the number of occurrences on every line.
+ *
+ * @complexity
+ * Time Complexity: O(l * log f), where l is the number of distinct lines of the word and f the number of files.
+ */
+void print_word_files(FILE *out, const WordEntry *entry, const FileList *files, bool line_counts);
+
+/**
+ * @brief Frees the memory allocated for the file list and its paths.
+ *
+ * @param[in,out] files - The file list.
+ */
+void file_list_free(FileList *files);
+
+
+#endif /**< CRAWL_UTILITY_H */
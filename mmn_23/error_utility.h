@@ -29,6 +29,141 @@
  */
 #define MEMORY_ALLOCATION_ERR "Memory allocation failed"
 
+/**
+ * @brief Error message for an unrecognized command-line option.
+ */
+#define UNKNOWN_OPTION_ERR "Unknown option."
+
+/**
+ * @brief Error message for a command-line option given without its value.
+ */
+#define MISSING_OPTION_VALUE_ERR "Missing value for option."
+
+/**
+ * @brief Error message for a command-line option with an invalid value.
+ */
+#define INVALID_OPTION_VALUE_ERR "Invalid value for option."
+
+/**
+ * @brief Error message for the approximate mode given without a number of words.
+ */
+#define APPROX_WITHOUT_TOP_ERR "The --approx option requires --top."
+
+/**
+ * @brief Error message for the approximate mode given together with the daemon mode.
+ */
+#define APPROX_WITH_SERVE_ERR "The --approx option cannot be used with --serve."
+
+/**
+ * @brief Error message for a server socket that cannot be created.
+ */
+#define SOCKET_ERR "Could not create the server socket."
+
+/**
+ * @brief Error message for a server whose worker threads cannot be started.
+ */
+#define WORKERS_ERR "Could not start the server's worker threads."
+
+/**
+ * @brief Error message for an unrecognized server request.
+ */
+#define UNKNOWN_COMMAND_ERR "Unknown command."
+
+/**
+ * @brief Error message for a server request longer than MAX_LINE_LENGTH.
+ */
+#define REQUEST_TOO_LONG_ERR "Request too long."
+
+/**
+ * @brief Error message for a regular expression that fails to compile.
+ */
+#define INVALID_REGEX_ERR "Invalid regular expression."
+
+/**
+ * @brief Error message for n-gram mode combined with a mode that only handles single words.
+ */
+#define NGRAMS_CONFLICT_ERR "The --ngrams option cannot be used with --approx or --serve."
+
+/**
+ * @brief Error message for parallel indexing combined with a mode that reads the file sequentially.
+ */
+#define THREADS_CONFLICT_ERR "The --threads option cannot be used with --grep, --regex, --approx, --serve or --ngrams."
+
+/**
+ * @brief Error message for a compressed input file that could not be decompressed.
+ */
+#define DECOMPRESS_ERR "Could not decompress file."
+
+/**
+ * @brief Error message for a memory budget combined with a mode that keeps the whole index in memory.
+ */
+#define MAX_MEMORY_CONFLICT_ERR "The --max-memory option cannot be used with --serve, --positions, --context, --threads or --ngrams."
+
+/**
+ * @brief Error message for a temporary file the index could not be spilled to.
+ */
+#define SPILL_ERR "Could not spill the index to a temporary file within the memory budget."
+
+/**
+ * @brief Error message for a snapshot combined with a mode that does not build the exact index.
+ */
+#define SAVE_SNAPSHOT_CONFLICT_ERR "The --save-snapshot option cannot be used with --grep, --regex, --approx, --ngrams, --max-memory, --positions, --context, --top or --counts."
+
+/**
+ * @brief Error message for a snapshot to restore without a server, or with a file to index.
+ */
+#define LOAD_SNAPSHOT_CONFLICT_ERR "The --load-snapshot option requires --serve, and cannot be used with a file or --save-snapshot."
+
+/**
+ * @brief Error message for a snapshot that could not be written.
+ */
+#define SAVE_SNAPSHOT_ERR "Could not write the snapshot."
+
+/**
+ * @brief Error message for a snapshot that could not be restored.
+ */
+#define LOAD_SNAPSHOT_ERR "Could not load the snapshot, it is missing, truncated, damaged or from another version."
+
+/**
+ * @brief Error response for a search on a server restored from a snapshot, which has no trigram index.
+ */
+#define NO_TRIGRAMS_ERR "Searches are not available on an index restored from a snapshot."
+
+/**
+ * @brief Error message for a directory that could not be read.
+ */
+#define OPEN_DIR_ERR "Could not open directory."
+
+/**
+ * @brief Error message for a profiler whose timer or signal handler could not be set.
+ */
+#define PROFILE_START_ERR "Could not start the profiler."
+
+/**
+ * @brief Error message for a profile that could not be written.
+ */
+#define PROFILE_WRITE_ERR "Could not write the profile."
+
+/**
+ * @brief Error message for a crawl combined with a mode that reads a single file.
+ */
+#define RECURSIVE_CONFLICT_ERR "The -r option cannot be used with a file, --grep, --regex, --approx, --ngrams, --serve, --max-memory, --positions, --context, --show-lines or --save-snapshot."
+
+/**
+ * @brief Error message for printing the lines of the words in a mode that does not print the index.
+ */
+#define SHOW_LINES_CONFLICT_ERR "The --show-lines option cannot be used with --grep, --regex, --approx, --ngrams, --serve, --max-memory, --positions, --context, --top, --counts or --save-snapshot."
+
+/**
+ * @brief Error message for printing the counts of the lines in a mode that does not print the lines.
+ */
+#define LINE_COUNTS_CONFLICT_ERR "The --line-counts option cannot be used with --grep, --regex, --approx, --ngrams, --serve, --positions, --context, --top, --counts or --save-snapshot."
+
+/**
+ * @brief Error message for a filter of the crawled files without a crawl.
+ */
+#define CRAWL_FILTER_ERR "The --include and --max-file-size options require -r."
+
 /**
  * @brief Handles errors by printing a formatted error message to the error log stream.
  *
@@ -0,0 +1,439 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frequency_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/* Checks whether (count_a, word_a) ranks strictly above (count_b, word_b) */
+static bool ranks_above(unsigned long count_a, const char *word_a, unsigned long count_b, const char *word_b) {
+
+    if (count_a != count_b) {
+        return count_a > count_b ? TRUE : FALSE;
+    }
+    return strcmp(word_a, word_b) < 0 ? TRUE : FALSE;
+}
+
+/* Compares two word entries by rank, the most frequent first */
+static int compare_entries_by_rank(const void *a, const void *b) {
+
+    const WordEntry *entry_a = *(WordEntry *const *) a;
+    const WordEntry *entry_b = *(WordEntry *const *) b;
+
+    if (ranks_above((unsigned long) entry_a->count, entry_a->word, (unsigned long) entry_b->count, entry_b->word)) {
+        return -1;
+    }
+    return 1;
+}
+
+/* Restores the min-heap order of word entries downward from a position */
+static void entry_sift_down(WordEntry **heap, int size, int position) {
+
+    WordEntry *entry = heap[position];
+    int child;
+
+    while ((child = 2 * position + 1) < size) {
+        if (child + 1 < size &&
+            ranks_above((unsigned long) heap[child]->count, heap[child]->word,
+                        (unsigned long) heap[child + 1]->count, heap[child + 1]->word)) {
+            child++;
+        }
+        if (!ranks_above((unsigned long) entry->count, entry->word, (unsigned long) heap[child]->count, heap[child]->word)) {
+            break;
+        }
+        heap[position] = heap[child];
+        position = child;
+    }
+    heap[position] = entry;
+}
+
+/* Restores the min-heap order of word entries upward from a position */
+static void entry_sift_up(WordEntry **heap, int position) {
+
+    WordEntry *entry = heap[position];
+    int parent;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (!ranks_above((unsigned long) heap[parent]->count, heap[parent]->word, (unsigned long) entry->count, entry->word)) {
+            break;
+        }
+        heap[position] = heap[parent];
+        position = parent;
+    }
+    heap[position] = entry;
+}
+
+/* Prints the number of occurrences of each word */
+void print_word_counts(const WordIndex *index, CollateOrder order) {
+
+    WordEntry **entries = collect_sorted_word_entries(index, order);
+    int i;
+
+    FOR_RANGE(i, index->count) {
+        printf("%s - appears %d times%s", entries[i]->word, entries[i]->count, NEW_LINE);
+    }
+    free(entries);
+}
+
+/* Prints the K most frequent words of the index */
+void print_top_words(FILE *out, const WordIndex *index, int k) {
+
+    WordEntry **heap;
+    WordEntry *entry;
+    int heap_size = 0;
+    int i;
+
+    if (k > index->count) {
+        k = index->count;
+    }
+    if (k <= 0) {
+        return;
+    }
+
+    heap = (WordEntry **) validated_memory_allocation(sizeof(WordEntry *) * (size_t) k);
+
+    /* Keep the K best entries seen so far, with the weakest of them at the root */
+    FOR_RANGE(i, index->count) {
+        entry = &index->entries[i];
+
+        if (heap_size < k) {
+            heap[heap_size] = entry;
+            entry_sift_up(heap, heap_size++);
+        }
+        else if (ranks_above((unsigned long) entry->count, entry->word, (unsigned long) heap[0]->count, heap[0]->word)) {
+            heap[0] = entry;
+            entry_sift_down(heap, heap_size, 0);
+        }
+    }
+
+    /* Only the selected entries are sorted */
+    qsort(heap, (size_t) heap_size, sizeof(WordEntry *), compare_entries_by_rank);
+
+    FOR_RANGE(i, heap_size) {
+        fprintf(out, "%s - appears %d times%s", heap[i]->word, heap[i]->count, NEW_LINE);
+    }
+    free(heap);
+}
+
+/* Initializes an empty selection of the K most frequent words */
+void top_words_init(TopWords *top, int k) {
+
+    top->heap = NULL;
+    top->size = 0;
+    top->capacity = 0;
+    top->k = k;
+}
+
+/* Offers a word and its number of occurrences to the selection */
+void top_words_add(TopWords *top, const char *word, int count) {
+
+    WordEntry *entry;
+
+    if (top->size < top->k) {
+        /* The heap grows with the words kept, k may be far more than the number of words */
+        if (top->size == top->capacity) {
+            top->capacity = top->capacity == 0 ? 64 : 2 * top->capacity;
+            if (top->capacity > top->k) {
+                top->capacity = top->k;
+            }
+            top->heap = (WordEntry **) validated_memory_reallocation(top->heap, sizeof(WordEntry *) * (size_t) top->capacity);
+        }
+        entry = (WordEntry *) validated_memory_allocation(sizeof(WordEntry));
+        entry->word = duplicate_string(word);
+        entry->count = count;
+        top->heap[top->size] = entry;
+        entry_sift_up(top->heap, top->size++);
+    }
+    else if (top->size > 0 &&
+             ranks_above((unsigned long) count, word, (unsigned long) top->heap[0]->count, top->heap[0]->word)) {
+        /* The weakest kept word is replaced, and its record reused */
+        entry = top->heap[0];
+        free((char *) entry->word);
+        entry->word = duplicate_string(word);
+        entry->count = count;
+        entry_sift_down(top->heap, top->size, 0);
+    }
+}
+
+/* Prints the kept words, the most frequent first */
+void top_words_print(FILE *out, TopWords *top) {
+
+    int i;
+
+    if (top->size == 0) {
+        return;
+    }
+    qsort(top->heap, (size_t) top->size, sizeof(WordEntry *), compare_entries_by_rank);
+
+    FOR_RANGE(i, top->size) {
+        fprintf(out, "%s - appears %d times%s", top->heap[i]->word, top->heap[i]->count, NEW_LINE);
+    }
+}
+
+/* Frees the memory allocated for the selection and its words */
+void top_words_free(TopWords *top) {
+
+    int i;
+
+    FOR_RANGE(i, top->size) {
+        free((char *) top->heap[i]->word);
+        free(top->heap[i]);
+    }
+    free(top->heap);
+    top->heap = NULL;
+    top->size = 0;
+    top->capacity = 0;
+}
+
+/* Finds the slot of a tracked word, or the empty slot where it should be inserted */
+static int find_slot(const ApproxTopK *approx, const char *word) {
+
+    unsigned int mask = (unsigned int) approx->num_slots - 1;
+    unsigned int i = hash(word) & mask;
+
+    while (approx->slots[i] != NULL && strcmp(approx->slots[i]->word, word) != 0) {
+        i = (i + 1) & mask;
+    }
+    return (int) i;
+}
+
+/* Removes a word from the slot table, shifting back the entries that follow it */
+static void remove_slot(ApproxTopK *approx, int slot) {
+
+    unsigned int mask = (unsigned int) approx->num_slots - 1;
+    unsigned int hole = (unsigned int) slot;
+    unsigned int i = hole;
+    unsigned int home;
+
+    approx->slots[hole] = NULL;
+
+    while (approx->slots[i = (i + 1) & mask] != NULL) {
+        home = hash(approx->slots[i]->word) & mask;
+
+        /* Move the entry into the hole if its home bucket is not between the hole and the entry */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            approx->slots[hole] = approx->slots[i];
+            approx->slots[i] = NULL;
+            hole = i;
+        }
+    }
+}
+
+/* Restores the min-heap order of tracked words downward from a position */
+static void tracked_sift_down(ApproxTopK *approx, int position) {
+
+    TrackedWord **heap = approx->heap;
+    TrackedWord *tracked = heap[position];
+    int child;
+
+    while ((child = 2 * position + 1) < approx->heap_size) {
+        if (child + 1 < approx->heap_size &&
+            ranks_above(heap[child]->count, heap[child]->word, heap[child + 1]->count, heap[child + 1]->word)) {
+            child++;
+        }
+        if (!ranks_above(tracked->count, tracked->word, heap[child]->count, heap[child]->word)) {
+            break;
+        }
+        heap[position] = heap[child];
+        heap[position]->heap_position = position;
+        position = child;
+    }
+    heap[position] = tracked;
+    tracked->heap_position = position;
+}
+
+/* Restores the min-heap order of tracked words upward from a position */
+static void tracked_sift_up(ApproxTopK *approx, int position) {
+
+    TrackedWord **heap = approx->heap;
+    TrackedWord *tracked = heap[position];
+    int parent;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (!ranks_above(heap[parent]->count, heap[parent]->word, tracked->count, tracked->word)) {
+            break;
+        }
+        heap[position] = heap[parent];
+        heap[position]->heap_position = position;
+        position = parent;
+    }
+    heap[position] = tracked;
+    tracked->heap_position = position;
+}
+
+/* Doubles the number of slots of the slot table, and inserts the tracked words again */
+static void grow_slots(ApproxTopK *approx) {
+
+    int i;
+
+    free(approx->slots);
+    approx->num_slots *= 2;
+    approx->slots = (TrackedWord **) validated_memory_allocation(sizeof(TrackedWord *) * (size_t) approx->num_slots);
+    FOR_RANGE(i, approx->num_slots) {
+        approx->slots[i] = NULL;
+    }
+    FOR_RANGE(i, approx->heap_size) {
+        approx->slots[find_slot(approx, approx->heap[i]->word)] = approx->heap[i];
+    }
+}
+
+/* Initializes the approximate top-K state */
+void approx_init(ApproxTopK *approx, int k) {
+
+    int i;
+
+    approx->k = k;
+    approx->heap_size = 0;
+
+    approx->sketch = (unsigned long *) validated_memory_allocation(sizeof(unsigned long) * SKETCH_DEPTH * SKETCH_WIDTH);
+    memset(approx->sketch, 0, sizeof(unsigned long) * SKETCH_DEPTH * SKETCH_WIDTH);
+
+    /* The heap and the slot table grow with the words tracked, k may be far more than the number of words */
+    approx->heap = NULL;
+    approx->capacity = 0;
+    approx->num_slots = 4 * APPROX_INITIAL_CAPACITY;
+    approx->slots = (TrackedWord **) validated_memory_allocation(sizeof(TrackedWord *) * (size_t) approx->num_slots);
+    FOR_RANGE(i, approx->num_slots) {
+        approx->slots[i] = NULL;
+    }
+}
+
+/* Counts a word in the sketch and returns its new estimate */
+static unsigned long sketch_add(ApproxTopK *approx, const char *word) {
+
+    unsigned long *counters[SKETCH_DEPTH];
+    unsigned int h1 = hash(word);
+    unsigned int h2 = secondary_hash(word) | 1U;
+    unsigned long estimate = 0;
+    int row;
+
+    /* Derive the row hashes from two independent hashes */
+    FOR_RANGE(row, SKETCH_DEPTH) {
+        counters[row] = &approx->sketch[row * SKETCH_WIDTH + ((h1 + (unsigned int) row * h2) & (SKETCH_WIDTH - 1))];
+        if (row == 0 || *counters[row] < estimate) {
+            estimate = *counters[row];
+        }
+    }
+
+    /* Conservative update: only the counters holding the minimum can be exact */
+    estimate++;
+    FOR_RANGE(row, SKETCH_DEPTH) {
+        if (*counters[row] < estimate) {
+            *counters[row] = estimate;
+        }
+    }
+    return estimate;
+}
+
+/* Counts an occurrence of a word in the approximate top-K state */
+void approx_add_word(ApproxTopK *approx, const char *word) {
+
+    unsigned long estimate = sketch_add(approx, word);
+    TrackedWord *tracked;
+    int slot;
+
+    if (approx->k <= 0) {
+        return;
+    }
+
+    slot = find_slot(approx, word);
+
+    /* The word is already tracked, raise its estimate */
+    if (approx->slots[slot] != NULL) {
+        tracked = approx->slots[slot];
+        tracked->count = estimate;
+        tracked_sift_down(approx, tracked->heap_position);
+        return;
+    }
+
+    if (approx->heap_size < approx->k) {
+        /* The heap is not full yet, track the word in a new record */
+        if (approx->heap_size == approx->capacity) {
+            approx->capacity = approx->capacity == 0 ? APPROX_INITIAL_CAPACITY : 2 * approx->capacity;
+            if (approx->capacity > approx->k) {
+                approx->capacity = approx->k;
+            }
+            approx->heap = (TrackedWord **) validated_memory_reallocation(approx->heap, sizeof(TrackedWord *) *
+                                                                                        (size_t) approx->capacity);
+        }
+
+        /* Keep the slot table at most one quarter full */
+        if (4 * (approx->heap_size + 1) > approx->num_slots) {
+            grow_slots(approx);
+            slot = find_slot(approx, word);
+        }
+
+        tracked = (TrackedWord *) validated_memory_allocation(sizeof(TrackedWord));
+        tracked->heap_position = approx->heap_size;
+        approx->heap[approx->heap_size++] = tracked;
+    }
+    else if (ranks_above(estimate, word, approx->heap[0]->count, approx->heap[0]->word)) {
+        /* Evict the weakest tracked word */
+        tracked = approx->heap[0];
+        remove_slot(approx, find_slot(approx, tracked->word));
+        free(tracked->word);
+        slot = find_slot(approx, word);
+    }
+    else {
+        return;
+    }
+
+    tracked->word = duplicate_string(word);
+    tracked->count = estimate;
+    approx->slots[slot] = tracked;
+
+    if (tracked->heap_position == 0 && approx->heap_size == approx->k) {
+        tracked_sift_down(approx, 0);
+    }
+    else {
+        tracked_sift_up(approx, tracked->heap_position);
+    }
+}
+
+/* Compares two tracked words by rank, the most frequent first */
+static int compare_tracked_by_rank(const void *a, const void *b) {
+
+    const TrackedWord *tracked_a = *(TrackedWord *const *) a;
+    const TrackedWord *tracked_b = *(TrackedWord *const *) b;
+
+    return ranks_above(tracked_a->count, tracked_a->word, tracked_b->count, tracked_b->word) ? -1 : 1;
+}
+
+/* Prints the tracked words, from the most frequent to the least frequent */
+void approx_print(const ApproxTopK *approx) {
+
+    TrackedWord **sorted;
+    int i;
+
+    if (approx->heap_size == 0) {
+        return;
+    }
+
+    sorted = (TrackedWord **) validated_memory_allocation(sizeof(TrackedWord *) * (size_t) approx->heap_size);
+    memcpy(sorted, approx->heap, sizeof(TrackedWord *) * (size_t) approx->heap_size);
+    qsort(sorted, (size_t) approx->heap_size, sizeof(TrackedWord *), compare_tracked_by_rank);
+
+    FOR_RANGE(i, approx->heap_size) {
+        printf("%s - appears about %lu times%s", sorted[i]->word, sorted[i]->count, NEW_LINE);
+    }
+    free(sorted);
+}
+
+/* Frees the memory allocated for the approximate top-K state */
+void approx_free(ApproxTopK *approx) {
+
+    int i;
+
+    FOR_RANGE(i, approx->heap_size) {
+        free(approx->heap[i]->word);
+        free(approx->heap[i]);
+    }
+    free(approx->sketch);
+    free(approx->heap);
+    free(approx->slots);
+}
@@ -0,0 +1,167 @@
+/**
+ * @file frequency_utility.h
+ * @brief Header file containing word frequency statistics and top-K selection.
+ *
+ * This header file defines functions for printing the number of occurrences of each word,
+ * selecting the K most frequent words of the index, or of a stream of counted words, with a
+ * bounded heap, and an approximate
+ * top-K mode that counts the words in a Count-Min sketch instead of the exact index.
+ */
+
+#ifndef FREQUENCY_UTILITY_H
+#define FREQUENCY_UTILITY_H
+
+#include "globals.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Number of records the heap of the approximate top-K mode starts with, the slot table four times as many.
+ */
+#define APPROX_INITIAL_CAPACITY 64
+
+/**
+ * @brief Structure to represent a word tracked by the approximate top-K heap.
+ */
+typedef struct {
+    char *word;          /**< The tracked word. */
+    unsigned long count; /**< The estimated number of occurrences of the word. */
+    int heap_position;   /**< The position of the record in the heap. */
+} TrackedWord;
+
+/**
+ * @brief Structure to represent the K most frequent words of a stream of counted words.
+ *
+ * It selects the top words when they do not come from an index in memory, such as when the
+ * runs of a spilled index are merged. The kept words are copied, as the words of the stream
+ * are only valid until the next one is added.
+ */
+typedef struct {
+    WordEntry **heap; /**< Min-heap of the kept words, ordered by rank, each with its own copy of the word. */
+    int size;         /**< The number of words in the heap. */
+    int capacity;     /**< The number of words allocated in the heap. */
+    int k;            /**< The maximum number of words in the heap. */
+} TopWords;
+
+/**
+ * @brief Structure to represent the state of the approximate top-K mode.
+ *
+ * The words are counted in a Count-Min sketch of SKETCH_DEPTH rows of SKETCH_WIDTH counters.
+ * The K words with the highest estimates are kept in a min-heap, and a small hash table maps
+ * each tracked word to its record so that a word already in the heap is updated in place.
+ * The heap and the table grow with the words tracked, so a K larger than the number of
+ * distinct words costs no more than the words themselves.
+ */
+typedef struct {
+    unsigned long *sketch; /**< The counters of the sketch, row after row. */
+    TrackedWord **heap;    /**< Min-heap of the records of the tracked words, ordered by estimate. */
+    int capacity;          /**< The number of records allocated in the heap. */
+    TrackedWord **slots;   /**< Hash table from words to their records (linear probing). */
+    int num_slots;         /**< The number of slots in the hash table (a power of two). */
+    int heap_size;         /**< The number of words in the heap. */
+    int k;                 /**< The maximum number of words in the heap. */
+} ApproxTopK;
+
+/**
+ * @brief Prints the number of occurrences of each word in the index, in an order of the words.
+ *
+ * @param[in] index - The word index.
+ * @param[in] order - The sort order (see collate_utility.h).
+ *
+ * @complexity
+ * Time Complexity: O(n), where n is the number of distinct words (see collate_sort).
+ */
+void print_word_counts(const WordIndex *index, CollateOrder order);
+
+/**
+ * @brief Prints the K most frequent words of the index.
+ *
+ * The words are selected with a min-heap bounded to K entries, so only the selected words
+ * are sorted. Words with the same number of occurrences are ordered lexicographically.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] index - The word index.
+ * @param[in] k - The number of words to print.
+ *
+ * @complexity
+ * Time Complexity: O(n * log k), where n is the number of distinct words.
+ */
+void print_top_words(FILE *out, const WordIndex *index, int k);
+
+/**
+ * @brief Initializes an empty selection of the K most frequent words.
+ *
+ * @param[out] top - The selection to initialize.
+ * @param[in] k - The number of words to keep.
+ */
+void top_words_init(TopWords *top, int k);
+
+/**
+ * @brief Offers a word and its number of occurrences to the selection.
+ *
+ * Every word must be offered once, with its total number of occurrences.
+ *
+ * @param[in,out] top - The selection.
+ * @param[in] word - The word. It is copied if it is kept.
+ * @param[in] count - The number of occurrences of the word.
+ *
+ * @complexity
+ * Time Complexity: O(log k).
+ */
+void top_words_add(TopWords *top, const char *word, int count);
+
+/**
+ * @brief Prints the kept words, from the most frequent to the least frequent.
+ *
+ * The words are printed as print_top_words prints them.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in,out] top - The selection. Its heap is sorted.
+ */
+void top_words_print(FILE *out, TopWords *top);
+
+/**
+ * @brief Frees the memory allocated for the selection and its words.
+ *
+ * @param[in,out] top - The selection.
+ */
+void top_words_free(TopWords *top);
+
+/**
+ * @brief Initializes the approximate top-K state.
+ *
+ * @param[out] approx - The state to initialize.
+ * @param[in] k - The number of words to track.
+ */
+void approx_init(ApproxTopK *approx, int k);
+
+/**
+ * @brief Counts an occurrence of a word in the approximate top-K state.
+ *
+ * The word is counted in the sketch with a conservative update (only the minimal counters
+ * are incremented), and the heap is updated if the new estimate ranks among the top K.
+ *
+ * @param[in,out] approx - The approximate top-K state.
+ * @param[in] word - The word to count.
+ *
+ * @complexity
+ * Time Complexity: O(SKETCH_DEPTH + log k) on average.
+ */
+void approx_add_word(ApproxTopK *approx, const char *word);
+
+/**
+ * @brief Prints the tracked words, from the most frequent to the least frequent.
+ *
+ * @param[in] approx - The approximate top-K state.
+ */
+void approx_print(const ApproxTopK *approx);
+
+/**
+ * @brief Frees the memory allocated for the approximate top-K state.
+ *
+ * @param[in,out] approx - The approximate top-K state.
+ */
+void approx_free(ApproxTopK *approx);
+
+
+#endif /**< FREQUENCY_UTILITY_H */
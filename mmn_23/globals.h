@@ -4,34 +4,16 @@
  *
  * This header file defines global structures and enumerations used
  * throughout the program, including structures for linked list nodes
- * and word entries in the index, as well as an enumeration for boolean
- * values.
+ * and word entries in the index, an enumeration for boolean values,
+ * and the command-line options of the program.
  */
 
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
-/**
- * @brief Structure to represent a node in a linked list.
- *
- * This structure represents a node in a linked list used for storing
- * line numbers associated with a word in the index.
- */
-typedef struct ListNode {
-    int line_number;       /**< The line number associated with the word. */
-    struct ListNode *next; /**< Pointer to the next node in the linked list. */
-} ListNode;
+#include "constants.h"
 
-/**
- * @brief Structure to represent a word entry in the index.
- *
- * This structure represents an entry in the index, containing a word
- * and a linked list of line numbers where the word appears.
- */
-typedef struct {
-    char *word;      /**< Pointer to the word stored in the index entry. */
-    ListNode *lines; /**< Pointer to the linked list of line numbers. */
-} WordEntry;
+#include <stddef.h>
 
 /**
  * @enum bool
@@ -60,5 +42,155 @@ typedef enum {
     TRUE = 1   /**< Represents the boolean value TRUE (1). */
 } bool;
 
+/**
+ * @brief The orders the words of the index are sorted in (--sort, see collate_utility.h).
+ */
+typedef enum {
+    COLLATE_BYTES,   /**< The byte order of the words, as strcmp compares them. */
+    COLLATE_NOCASE,  /**< The byte order with ASCII letters compared without case. */
+    COLLATE_NATURAL  /**< The byte order with numbers compared by value. */
+} CollateOrder;
+
+/**
+ * @brief Structure to represent a node in a linked list.
+ *
+ * This structure represents a node in a linked list used for storing
+ * line numbers associated with a word in the index. A line appears once
+ * in the list of a word, with the number of occurrences of the word on it.
+ */
+typedef struct ListNode {
+    int line_number;       /**< The line number associated with the word. */
+    int count;             /**< The number of occurrences of the word on the line. */
+    struct ListNode *next; /**< Pointer to the next node in the linked list. */
+} ListNode;
+
+/**
+ * @brief Structure to represent a block of linked list nodes.
+ *
+ * The nodes of the line lists are carved out of blocks owned by the index,
+ * instead of being allocated one by one, and the blocks are freed together.
+ */
+typedef struct NodeBlock {
+    struct NodeBlock *next;          /**< Pointer to the previously allocated block. */
+    ListNode nodes[NODE_BLOCK_SIZE]; /**< The nodes of the block. */
+} NodeBlock;
+
+/**
+ * @brief Structure to represent a pool of linked list nodes, allocated in blocks.
+ */
+typedef struct {
+    NodeBlock *blocks;  /**< The most recent block, NULL if none. */
+    int used;           /**< The number of nodes used in the most recent block. */
+    size_t num_blocks;  /**< The number of blocks of the pool. */
+} NodePool;
+
+/**
+ * @brief Structure to represent the line numbers of a word as compressed postings.
+ *
+ * The distinct line numbers are stored as a byte stream of postings (see encode_posting),
+ * each the delta from the previous line number (from 0 for the first) and the number of
+ * occurrences on the line when there are several, so most lines take a single byte instead
+ * of a linked list node.
+ */
+typedef struct LinePostings {
+    unsigned char *data; /**< The encoded postings. */
+    size_t length;       /**< The number of bytes used. */
+    size_t capacity;     /**< The number of bytes allocated. */
+    int last_line;       /**< The last line number, the base of the next delta. */
+    int last_count;      /**< The number of occurrences on the last line. */
+    size_t last_offset;  /**< The offset of the posting of the last line, rewritten as its count grows. */
+} LinePostings;
+
+/**
+ * @brief Structure to represent a word entry in the index.
+ *
+ * This structure represents an entry in the index, containing a word,
+ * a linked list of line numbers where the word appears, the number
+ * of times the word occurs in the file, and optionally the exact
+ * position of every occurrence. The entry of the word with ID i is
+ * the i-th entry of the index. Once the postings of the index are
+ * compressed, the line numbers are kept in compressed postings instead
+ * of the linked list.
+ */
+typedef struct {
+    const char *word;    /**< The word, owned by the symbol table of the index. */
+    ListNode *lines;     /**< Pointer to the linked list of line numbers. */
+    ListNode *last_line; /**< Pointer to the last node of the list, for appending in order. */
+    int count;           /**< The number of occurrences of the word. */
+    struct PositionPostings *positions; /**< The encoded positions of the occurrences, NULL unless recorded. */
+    LinePostings *postings; /**< The line numbers as compressed postings, NULL while they are in the list. */
+} WordEntry;
+
+/**
+ * @brief Structure to represent a symbol table.
+ *
+ * The symbol table interns every distinct word once and gives it a dense 32-bit ID,
+ * starting at 0. The words are stored in an array indexed by ID. An open-addressing
+ * table (linear probing) of IDs, at most half full, maps the words to their IDs. The
+ * hash of every word is kept, so growing the table never hashes a word again.
+ */
+typedef struct SymbolTable {
+    char **words;           /**< The word of each ID. */
+    unsigned int *hashes;   /**< The hash of the word of each ID. */
+    unsigned int *slots;    /**< The table of IDs plus one, 0 for an empty slot, NULL once frozen. */
+    unsigned int num_slots; /**< The number of slots (a power of two). */
+    unsigned int count;     /**< The number of interned words. */
+    unsigned int capacity;  /**< The number of IDs allocated in the words and hashes arrays. */
+    size_t bytes;           /**< The number of bytes allocated for the table and the words. */
+} SymbolTable;
+
+/**
+ * @brief Structure to represent the word index.
+ *
+ * The words are interned in a symbol table, and the entry of every word is stored at
+ * its ID in a dense array, so every later stage works on IDs and the strings are only
+ * read for output. Once frozen, the words are renumbered in the order of a minimal
+ * perfect hash, which then replaces the table of the symbol table for lookups.
+ */
+typedef struct {
+    SymbolTable symbols;       /**< The words of the index and their IDs. */
+    WordEntry *entries;        /**< The entry of each word, indexed by ID. */
+    int count;                 /**< The number of distinct words in the index. */
+    int capacity;              /**< The number of entries allocated. */
+    NodePool nodes;            /**< The nodes of the line lists. */
+    bool compressed;           /**< TRUE once the line numbers are kept in compressed postings. */
+    size_t postings_bytes;     /**< The number of bytes allocated for compressed postings. */
+    struct BloomFilter *bloom; /**< Filter answering for absent words without a probe, NULL if not built. */
+    struct PerfectHash *mph;   /**< Minimal perfect hash of the frozen vocabulary, NULL while the index grows. */
+} WordIndex;
+
+/**
+ * @brief Structure to represent the command-line options of the program.
+ *
+ * This structure holds the parsed command-line options. Options that were
+ * not given on the command line are NULL.
+ */
+typedef struct {
+    const char *file_name; /**< The name of the file to index. */
+    const char *substring; /**< Substring to search for with the trigram index (--grep). */
+    const char *regex;     /**< Regular expression to search for with the trigram index (--regex). */
+    int top;               /**< Number of most frequent words to print (--top), 0 if not requested. */
+    bool counts;           /**< TRUE to print the number of occurrences of each word (--counts). */
+    bool approximate;      /**< TRUE to count with a Count-Min sketch instead of the exact index (--approx). */
+    const char *socket_path; /**< Unix domain socket to serve lookups on (--serve), NULL to print and exit. */
+    int workers;           /**< Number of worker threads of the server (--workers). */
+    double bloom_fpr;      /**< False-positive rate of the Bloom filter of the served index (--bloom-fpr). */
+    bool positions;        /**< TRUE to record and print the position of every occurrence (--positions). */
+    int context;           /**< Bytes of context to print around every occurrence (--context), 0 if not requested. */
+    int tokenize_flags;    /**< The TOKENIZE_* flags of the tokenizer (--words, --fold-case). */
+    int ngrams;            /**< Number of words of the n-grams to index (--ngrams), 0 to index single words. */
+    int threads;           /**< Number of threads indexing the file (--threads), 1 to index it sequentially. */
+    unsigned long max_memory; /**< Memory budget of the index in bytes (--max-memory), 0 for no budget. */
+    const char *save_snapshot; /**< File to save a snapshot of the index to (--save-snapshot). */
+    const char *load_snapshot; /**< Snapshot to serve instead of indexing a file (--load-snapshot). */
+    CollateOrder sort_order; /**< The order the words are printed in (--sort). */
+    const char *directory; /**< The directory whose tree is indexed instead of a file (-r). */
+    const char *include;   /**< Glob the names of the crawled files must match (--include). */
+    unsigned long max_file_size; /**< Largest size of the crawled files in bytes (--max-file-size), 0 for no limit. */
+    bool show_lines;       /**< TRUE to print the lines of every word under it (--show-lines). */
+    bool line_counts;      /**< TRUE to print the number of occurrences on every line (--line-counts). */
+    const char *profile;   /**< File the sampled stacks are written to (--profile), NULL not to profile. */
+} IndexOptions;
+
 
 #endif /**< GLOBALS_H */
@@ -1,6 +1,10 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "hash_utility.h"
+#include "bloom_utility.h"
+#include "mph_utility.h"
+#include "symbol_utility.h"
 #include "utility.h"
 #include "constants.h"
 
@@ -18,56 +22,252 @@ unsigned int hash(const char *str) {
         hash = ((hash << 5) + hash) + c;
     }
 
-    /* Take the hash value modulo the size of the hash table */
-    return hash % HASH_SIZE;
+    return hash;
 }
 
-/* Adds a word to the index along with its line number */
-void addWordToIndex(WordEntry *index, const char *word, int line_number) {
+/* Computes a second, independent hash value for a string (FNV-1a) */
+unsigned int secondary_hash(const char *str) {
 
-    ListNode *new_node;
-    bool word_exist;
-    /* Compute the hash value for the word */
-    unsigned int hash_value = hash(word);
+    unsigned int hash = 2166136261U;
 
-    /* Check if the word is already in the index */
-    ListNode *curr = index[hash_value].lines;
+    while (*str) {
+        hash ^= (unsigned char) *str++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
 
-    while (curr != NULL) {
+/* Mixes the bits of a hash value (murmur3 finalizer) */
+unsigned int mix_hash(unsigned int h) {
 
-        word_exist = word_compare(index, word, hash_value);
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    return h;
+}
 
-        if (word_exist) {
+/* Initializes an empty word index */
+void index_init(WordIndex *index) {
 
-            /* Add the line number to the existing word entry */
-            new_node = (ListNode *) validated_memory_allocation(sizeof(ListNode));
+    symbol_init(&index->symbols);
+    index->count = 0;
+    index->capacity = HASH_SIZE / 2;
+    index->entries = (WordEntry *) validated_memory_allocation(sizeof(WordEntry) * (size_t) index->capacity);
+    node_pool_init(&index->nodes);
+    index->compressed = FALSE;
+    index->postings_bytes = 0;
+    index->bloom = NULL;
+    index->mph = NULL;
+}
 
-            new_node->line_number = line_number;
-            new_node->next = curr->next;
-            curr->next = new_node;
-            return;
-        }
-        curr = curr->next;
+/* Builds the Bloom filter of the words of the index */
+void index_build_bloom(WordIndex *index, double false_positive_rate) {
+
+    int i;
+
+    if (index->bloom != NULL) {
+        bloom_free(index->bloom);
+        free(index->bloom);
+    }
+
+    index->bloom = (BloomFilter *) validated_memory_allocation(sizeof(BloomFilter));
+    bloom_init(index->bloom, index->count, false_positive_rate);
+
+    FOR_RANGE(i, index->count) {
+        bloom_add(index->bloom, index->entries[i].word);
+    }
+}
+
+/* Freezes the index into a minimal perfect hash over its final vocabulary */
+void index_freeze(WordIndex *index) {
+
+    WordEntry *entries;
+    unsigned int *new_ids;
+    int i;
+
+    if (index->mph != NULL) {
+        return;
+    }
+
+    index->mph = (PerfectHash *) validated_memory_allocation(sizeof(PerfectHash));
+    mph_build(index->mph, index->symbols.words, index->count);
+
+    /* Renumber the words in the order of the hash, the dense array has no empty buckets */
+    new_ids = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (size_t) (index->count + 1));
+    entries = (WordEntry *) validated_memory_allocation(sizeof(WordEntry) * (size_t) (index->count + 1));
+    FOR_RANGE(i, index->count) {
+        new_ids[i] = (unsigned int) mph_lookup(index->mph, index->entries[i].word);
+        entries[new_ids[i]] = index->entries[i];
+    }
+    symbol_freeze(&index->symbols, new_ids);
+
+    free(index->entries);
+    index->entries = entries;
+    index->capacity = index->count + 1;
+    free(new_ids);
+}
+
+/* Finds the entry of a word in the index */
+WordEntry *findWordEntry(const WordIndex *index, const char *word) {
+
+    unsigned int id;
+    int slot;
+
+    /* A word the filter rejects is definitely absent, so skip the table probe */
+    if (index->bloom != NULL && !bloom_may_contain(index->bloom, word)) {
+        return NULL;
+    }
+
+    /* A frozen index has a single candidate slot, holding the word or another one */
+    if (index->mph != NULL) {
+        slot = mph_lookup(index->mph, word);
+        return (slot >= 0 && word_compare(&index->entries[slot], word)) ? &index->entries[slot] : NULL;
+    }
+
+    id = symbol_find(&index->symbols, word);
+
+    return id != SYMBOL_NOT_FOUND ? &index->entries[id] : NULL;
+}
+
+/* Finds the entry of a word, adding an entry without occurrences for a new word */
+WordEntry *index_intern_word(WordIndex *index, const char *word) {
+
+    unsigned int id = symbol_intern(&index->symbols, word);
+    WordEntry *entry;
+
+    if (id < (unsigned int) index->count) {
+        return &index->entries[id];
+    }
+
+    /* A new word gets the entry at its ID */
+    if (index->count == index->capacity) {
+        index->capacity *= 2;
+        index->entries = (WordEntry *) validated_memory_reallocation(index->entries,
+                                                                     sizeof(WordEntry) * (size_t) index->capacity);
     }
+    entry = &index->entries[index->count++];
+    entry->word = symbol_word(&index->symbols, id);
+    entry->lines = NULL;
+    entry->last_line = NULL;
+    entry->count = 0;
+    entry->positions = NULL;
+    entry->postings = NULL;
+
+    return entry;
+}
 
-    /* Word not found in the index, add it */
-    index[hash_value].word = strdup(word);
-    new_node = (ListNode *) validated_memory_allocation(sizeof(ListNode));
+/* Appends an occurrence of a word to the list of lines of its entry */
+void entry_add_line(WordEntry *entry, NodePool *nodes, int line_number) {
+
+    ListNode *new_node;
+
+    /* Another occurrence on the same line only counts in its node */
+    if (entry->last_line != NULL && entry->last_line->line_number == line_number) {
+        entry->last_line->count++;
+        entry->count++;
+        return;
+    }
 
+    new_node = node_pool_allocate(nodes);
     new_node->line_number = line_number;
+    new_node->count = 1;
     new_node->next = NULL;
-    index[hash_value].lines = new_node;
+
+    if (entry->last_line == NULL) {
+        entry->lines = new_node;
+    }
+    else {
+        entry->last_line->next = new_node;
+    }
+    entry->last_line = new_node;
+    entry->count++;
+}
+
+/* Appends occurrences on a line to the compressed postings of an entry, without counting them */
+static void postings_append(WordIndex *index, WordEntry *entry, int line_number, int count) {
+
+    LinePostings *postings = entry->postings;
+    unsigned long delta;
+    int previous;
+
+    if (postings == NULL) {
+        postings = (LinePostings *) validated_memory_allocation(sizeof(LinePostings));
+        postings->capacity = POSTINGS_INITIAL_CAPACITY;
+        postings->data = (unsigned char *) validated_memory_allocation(postings->capacity);
+        postings->length = 0;
+        postings->last_line = 0;
+        postings->last_count = 0;
+        postings->last_offset = 0;
+        entry->postings = postings;
+        index->postings_bytes += sizeof(LinePostings) + postings->capacity;
+    }
+
+    /* A posting takes at most MAX_POSTING_BYTES bytes */
+    if (postings->length + MAX_POSTING_BYTES > postings->capacity) {
+        index->postings_bytes += postings->capacity;
+        postings->capacity *= 2;
+        postings->data = (unsigned char *) validated_memory_reallocation(postings->data, postings->capacity);
+    }
+
+    /* More occurrences on the last line rewrite its posting, the last bytes of the postings */
+    if (postings->last_count > 0 && postings->last_line == line_number) {
+        decode_posting(postings->data + postings->last_offset, postings->data + postings->length, &delta, &previous);
+        postings->last_count += count;
+    }
+    else {
+        delta = (unsigned long) (line_number - postings->last_line);
+        postings->last_offset = postings->length;
+        postings->last_line = line_number;
+        postings->last_count = count;
+    }
+    postings->length = postings->last_offset + encode_posting(delta, postings->last_count,
+                                                              postings->data + postings->last_offset);
+}
+
+/* Adds a word to the index along with its line number */
+WordEntry *addWordToIndex(WordIndex *index, const char *word, int line_number) {
+
+    WordEntry *entry = index_intern_word(index, word);
+
+    if (index->compressed) {
+        postings_append(index, entry, line_number, 1);
+        entry->count++;
+    }
+    else {
+        entry_add_line(entry, &index->nodes, line_number);
+    }
+
+    return entry;
 }
 
-/* Checks if a word exists in an array of words */
-bool isWordInArray(char **array, int size, const char *word) {
+/* Moves the line lists of the index into compressed postings */
+void index_compress_postings(WordIndex *index) {
 
+    ListNode *curr;
     int i;
 
-    FOR_RANGE(i, size) {
-        if (strcmp(array[i], word) == 0) {
-            return TRUE; /**< Word found in the array */
+    if (index->compressed) {
+        return;
+    }
+
+    FOR_RANGE(i, index->count) {
+        for (curr = index->entries[i].lines; curr != NULL; curr = curr->next) {
+            postings_append(index, &index->entries[i], curr->line_number, curr->count);
         }
+        index->entries[i].lines = NULL;
+        index->entries[i].last_line = NULL;
     }
-    return FALSE; /**< Word not found in the array */
+
+    /* Every node has been copied, so the blocks are released at once */
+    node_pool_free(&index->nodes);
+    index->compressed = TRUE;
+}
+
+/* Computes the number of bytes allocated for the word index */
+size_t index_memory_usage(const WordIndex *index) {
+
+    return index->symbols.bytes + sizeof(WordEntry) * (size_t) index->capacity +
+           sizeof(NodeBlock) * index->nodes.num_blocks + index->postings_bytes;
 }
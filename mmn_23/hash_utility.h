@@ -3,8 +3,10 @@
  * @brief Header file containing utility functions for hashing and indexing words.
  *
  * This header file defines utility functions for computing hash values of strings,
- * adding words to an index along with line numbers, and checking the existence
- * of words in an array.
+ * initializing the word index, looking up words, adding words to the index
+ * along with line numbers, building the Bloom filter in front of the index,
+ * freezing the index into a minimal perfect hash once it is complete, and
+ * compressing its line lists when it has to fit in a memory budget.
  */
 
 #ifndef HASH_UTILITY_H
@@ -17,7 +19,7 @@
  * @brief Computes a hash value for a given string.
  *
  * This function computes a hash value for a given string using a simple
- * hash algorithm. The computed hash value is used to determine the index
+ * hash algorithm. The computed hash value is used to determine the bucket
  * in a hash table for storing the string or its associated data.
  *
  * @param str The input string for which the hash value is computed.
@@ -32,11 +34,9 @@
  *       It uses the following formula:
  *       hash = ((hash << 5) + hash) + c, where 'hash' is the current
  *       hash value and 'c' is the ASCII value of the current character.
- *       The final hash value is then taken modulo the size of the hash table.
  *
- * @note The choice of the hash table size (HASH_SIZE) impacts the
- *       distribution of hash values across the table. It's recommended
- *       to choose a prime number for HASH_SIZE to minimize collisions.
+ * @note The value is not reduced to the size of a table. Callers mask it
+ *       with the table size, which is always a power of two.
  *
  * @warning This function assumes that the input string is a null-terminated
  *          C string. It does not perform any bounds checking, so it's the
@@ -45,46 +45,166 @@
  */
 unsigned int hash(const char *str);
 
+/**
+ * @brief Computes a second hash value for a given string, independent of hash().
+ *
+ * The value is computed with the FNV-1a algorithm. It is combined with hash()
+ * wherever several hash functions of the same word are needed, such as in the
+ * Count-Min sketch and the Bloom filter.
+ *
+ * @param str The input string. This parameter must be a null-terminated C string.
+ * @return The computed hash value as an unsigned integer.
+ */
+unsigned int secondary_hash(const char *str);
+
+/**
+ * @brief Mixes the bits of a hash value (the murmur3 finalizer).
+ *
+ * Every bit of the input affects every bit of the output. It is applied where the
+ * low bits of hash() are too weak to be used directly, such as in the Bloom filter
+ * and the levels of the minimal perfect hash.
+ *
+ * @param h The hash value to mix.
+ * @return The mixed hash value.
+ */
+unsigned int mix_hash(unsigned int h);
+
+/**
+ * @brief Initializes an empty word index.
+ *
+ * @param[out] index - The word index to initialize, with an empty symbol table.
+ */
+void index_init(WordIndex *index);
+
+/**
+ * @brief Builds a Bloom filter of the words of the index.
+ *
+ * Once built, findWordEntry answers for words the filter rejects without probing the table.
+ * The filter must be rebuilt if words are added to the index afterwards.
+ *
+ * @param[in,out] index - The word index.
+ * @param[in] false_positive_rate - The target false-positive rate of the filter, between 0 and 1.
+ *
+ * @complexity
+ * Time Complexity: O(n), where n is the number of words in the index.
+ */
+void index_build_bloom(WordIndex *index, double false_positive_rate);
+
+/**
+ * @brief Freezes the index into a minimal perfect hash over its final vocabulary.
+ *
+ * The words are renumbered in the order of a minimal perfect hash of the words (see
+ * mph_utility.h), so the entry of a word is at the slot the hash gives it. A lookup then
+ * costs one hash evaluation and a single probe, and the table of the symbol table is
+ * released. The Bloom filter, if built, is kept. Words must not be added to a frozen index.
+ *
+ * @param[in,out] index - The complete word index.
+ *
+ * @complexity
+ * Time Complexity: O(n) expected, where n is the number of words in the index.
+ */
+void index_freeze(WordIndex *index);
+
+/**
+ * @brief Finds the entry of a word in the index.
+ *
+ * If the index has a Bloom filter, a word the filter rejects is reported as absent
+ * without probing the table. If the index is frozen, the word is looked up through
+ * the minimal perfect hash and compared with the single entry in its slot.
+ *
+ * @param[in] index - The word index.
+ * @param[in] word - The word to look up.
+ *
+ * @return A pointer to the entry of the word, or NULL if the word is not in the index.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ */
+WordEntry *findWordEntry(const WordIndex *index, const char *word);
+
+/**
+ * @brief Finds the entry of a word, adding an entry without occurrences if the word is new.
+ *
+ * The word is interned in the symbol table of the index, and a new word gets the next ID
+ * and the entry at that ID. The index must not be frozen.
+ *
+ * @param[in,out] index - The word index.
+ * @param[in] word - The word.
+ *
+ * @return A pointer to the entry of the word, valid until the next word is added.
+ *
+ * @complexity
+ * Time Complexity: O(1) amortized.
+ */
+WordEntry *index_intern_word(WordIndex *index, const char *word);
+
+/**
+ * @brief Appends an occurrence of a word to the list of lines of its entry.
+ *
+ * The occurrences are added in the order of their lines, so another occurrence on the last line
+ * of the list is counted in its node, found in constant time, instead of taking a node of its own.
+ *
+ * @param[in,out] entry - The entry of the word. Its occurrence count is incremented.
+ * @param[in,out] nodes - The pool the node of a new line is taken from.
+ * @param[in] line_number - The line number of the occurrence, not before the last line of the list.
+ *
+ * @complexity
+ * Time Complexity: O(1).
+ */
+void entry_add_line(WordEntry *entry, NodePool *nodes, int line_number);
+
 /**
  * @brief Adds a word to the index along with its line number.
  *
- * This function adds a word to the index along with its line number. If the word already exists in the index,
- * the line number is appended to the existing word entry. If the word does not exist in the index, a new word entry
- * is created, and the line number is added to it.
+ * This function adds a word to the index along with its line number. The word is interned in
+ * the symbol table of the index, which hashes it once. A new word gets the next ID and the entry
+ * at that ID. The line number is appended to the entry, and the occurrence count is incremented.
+ * The index must not be frozen.
  *
- * @param[in,out] index - Pointer to the array of word entries representing the index.
+ * @param[in,out] index - Pointer to the word index.
  * @param[in] word - The word to add to the index.
  * @param[in] line_number - The line number where the word appears.
  *
+ * @return A pointer to the entry of the word, valid until the next word is added.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ * - The word is hashed once and looked up in the table of the symbol table, at most half full.
+ * - The entries are a dense array indexed by ID, grown by doubling, so adding a word is amortized O(1).
+ * - The line number is appended at the tail of the word's list in constant time, with a node
+ *   taken from the current block of nodes of the index.
+ */
+WordEntry *addWordToIndex(WordIndex *index, const char *word, int line_number);
+
+/**
+ * @brief Moves the line lists of the index into compressed postings.
+ *
+ * The lines of every word are encoded as postings of their deltas and counts (see LinePostings),
+ * and the blocks of list nodes are freed. The words added afterwards are appended to the
+ * compressed postings directly. The order of the line numbers of every word is kept.
+ *
+ * @param[in,out] index - The word index. Positions must not be recorded.
+ *
  * @complexity
- * Time Complexity: O(1) on average for adding a word to an existing entry, O(n) in the worst case for traversing the linked list.
- * - The function computes the hash value of the word, which has constant time complexity.
- * - It then checks if the word already exists in the index by traversing the linked list of word entries.
- * - If the word exists, the function adds the line number to the existing word entry in constant time.
- * - If the word does not exist, a new word entry is created, and the line number is added to it in constant time.
- * - In the worst case, if there are collisions resulting in a long linked list, the time complexity for adding a word is O(n), where n is the number of words in the index.
+ * Time Complexity: O(n), where n is the number of occurrences in the index.
  */
-void addWordToIndex(WordEntry *index, const char *word, int line_number);
+void index_compress_postings(WordIndex *index);
 
 /**
- * @brief Checks if a word exists in an array of words.
+ * @brief Computes the number of bytes allocated for the word index.
  *
- * This function checks if a word exists in an array of words.
+ * The symbol table, the entries, the blocks of list nodes and the compressed postings are
+ * accounted for as they are allocated, so the result is exact up to the allocator overhead.
+ * The positions, the Bloom filter and the minimal perfect hash are not accounted for.
  *
- * @param[in] array - Pointer to the array of words.
- * @param[in] size - The size of the array.
- * @param[in] word - The word to search for in the array.
+ * @param[in] index - The word index.
  *
- * @return Boolean value indicating whether the word is present in the array.
- * - Returns TRUE if the word is found in the array.
- * - Returns FALSE if the word is not found in the array.
+ * @return The number of bytes allocated for the index.
  *
  * @complexity
- * Time Complexity: O(n), where n is the size of the array.
- * - The function iterates over each element of the array and performs string comparison,
- *   resulting in linear time complexity proportional to the size of the array.
+ * Time Complexity: O(1).
  */
-bool isWordInArray(char **array, int size, const char *word);
+size_t index_memory_usage(const WordIndex *index);
 
 
 #endif /**< HASH_UTILITY_H */
@@ -1,3 +1,4 @@
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -6,81 +7,656 @@
 #include "error_utility.h"
 #include "constants.h"
 #include "hash_utility.h"
+#include "trigram_utility.h"
+#include "frequency_utility.h"
+#include "server.h"
+#include "position_utility.h"
+#include "tokenizer_utility.h"
+#include "symbol_utility.h"
+#include "ngram_utility.h"
+#include "parallel_utility.h"
+#include "compress_utility.h"
+#include "spill_utility.h"
+#include "snapshot_utility.h"
+#include "collate_utility.h"
+#include "crawl_utility.h"
+#include "line_table_utility.h"
+#include "profile_utility.h"
 
 
 int main(int argc, char *argv[]) {
 
-    FILE *file;
-    WordEntry index[HASH_SIZE];
-    int i;
+    IndexOptions options;
+    int status;
 
-    /* Check if the correct arguments number is provided */
-    if (argc != VALID_ARG_COUNT) {
-        error_handling(INCORRECT_ARG_ERR, argv[0]);
+    /* Parse the command-line arguments */
+    if (!parse_arguments(argc, argv, &options)) {
         return EXIT_FAILURE;
     }
 
-    /* Open the file */
-    file = fopen(argv[1], "r");
-    if (file == NULL) {
-        error_handling(OPEN_FILE_ERR, argv[1]);
+    /* Sample the stacks of the whole run, written once it ends */
+    if (options.profile != NULL && !profile_start()) {
+        error_handling(PROFILE_START_ERR, options.profile);
         return EXIT_FAILURE;
     }
 
-    /* Initialize the hash table */
-    FOR_RANGE(i, HASH_SIZE) {
-        index[i].word = NULL;
-        index[i].lines = NULL;
+    status = program_run(&options);
+
+    if (options.profile != NULL && !profile_stop(options.profile)) {
+        error_handling(PROFILE_WRITE_ERR, options.profile);
+        return EXIT_FAILURE;
+    }
+
+    return status;
+}
+
+int program_run(const IndexOptions *options) {
+
+    InputStream input;
+    WordIndex index;
+    IndexSnapshot snapshot;
+    bool crawled, served;
+
+    /* Serve a snapshot saved by an earlier run, without indexing the file again */
+    if (options->load_snapshot != NULL) {
+        if (!snapshot_load(&snapshot, options->load_snapshot)) {
+            error_handling(LOAD_SNAPSHOT_ERR, options->load_snapshot);
+            return EXIT_FAILURE;
+        }
+        served = server_run(options, &snapshot, NULL);
+        snapshot_free(&snapshot);
+        return served ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Index the files of a directory tree instead of a single file */
+    if (options->directory != NULL) {
+        index_init(&index);
+        crawled = program_process_directory(&index, options);
+        free_hash(&index);
+        return crawled ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    /* Open the file, decompressing it as it is read if it is compressed */
+    if (!input_open(&input, options->file_name)) {
+        error_handling(OPEN_FILE_ERR, options->file_name);
+        return EXIT_FAILURE;
     }
 
-    program_process(file, index);
+    /* Initialize the hash table */
+    index_init(&index);
 
-    free_hash(index);
+    /* A file the threads cannot read, or a server that cannot start, fails the run as a truncated file does */
+    if (!program_process(&input, &index, options)) {
+        free_hash(&index);
+        input_close(&input);
+        return EXIT_FAILURE;
+    }
 
-    /* Close the file */
-    fclose(file);
+    free_hash(&index);
+
+    /* Close the file, a truncated or corrupt compressed file is only detected at its end */
+    if (!input_close(&input)) {
+        error_handling(DECOMPRESS_ERR, options->file_name);
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
 
-void program_process(FILE *file, WordEntry *index) {
+/* Parses a number of bytes, or of KiB, MiB or GiB with a suffix */
+static bool parse_size(const char *text, unsigned long *size) {
+
+    char *end_ptr;
+    unsigned long value = strtoul(text, &end_ptr, 10);
+    int shift = (*end_ptr == 'K' || *end_ptr == 'k') ? 10 : (*end_ptr == 'M' || *end_ptr == 'm') ? 20 :
+                (*end_ptr == 'G' || *end_ptr == 'g') ? 30 : 0;
+
+    if (shift > 0) {
+        end_ptr++;
+    }
+    if (end_ptr == text || *end_ptr != '\0' || text[0] == '-' || value > (ULONG_MAX >> shift)) {
+        return FALSE;
+    }
+    *size = value << shift;
+    return TRUE;
+}
+
+/* Counts the bytes input_gets read into a buffer filled with newlines beforehand */
+static size_t read_length(const char *line, size_t length, size_t size) {
+
+    const char *newline;
+
+    /* Without a null byte in the line, it ends at a newline, at the end of the buffer or at the end of the file */
+    if ((length > 0 && line[length - 1] == '\n') || length == size - 1) {
+        return length;
+    }
+
+    /* The line holds no newline but its last byte, so the first one is either that byte or the fill after the
+       terminating null byte, which the fill after a newline is not */
+    newline = (const char *) memchr(line, '\n', size);
+    if (newline == NULL) {
+        return size - 1;
+    }
+    if ((size_t) (newline - line) < size - 1 && newline[1] == '\0') {
+        return (size_t) (newline - line) + 1;
+    }
+    return (size_t) (newline - line) - 1;
+}
+
+bool parse_arguments(int argc, char *argv[], IndexOptions *options) {
+
+    char *end_ptr;
+    long value;
+    unsigned long size;
+    double rate;
+    int i;
+
+    options->file_name = NULL;
+    options->substring = NULL;
+    options->regex = NULL;
+    options->top = 0;
+    options->counts = FALSE;
+    options->approximate = FALSE;
+    options->socket_path = NULL;
+    options->workers = DEFAULT_WORKERS;
+    options->bloom_fpr = DEFAULT_BLOOM_FPR;
+    options->positions = FALSE;
+    options->context = 0;
+    options->tokenize_flags = 0;
+    options->ngrams = 0;
+    options->threads = 1;
+    options->max_memory = 0;
+    options->save_snapshot = NULL;
+    options->load_snapshot = NULL;
+    options->sort_order = COLLATE_BYTES;
+    options->directory = NULL;
+    options->include = NULL;
+    options->max_file_size = 0;
+    options->show_lines = FALSE;
+    options->line_counts = FALSE;
+    options->profile = NULL;
+
+    for(i = 1 ; i < argc ; i++) {
+
+        if (strcmp(argv[i], GREP_OPTION) == 0 || strcmp(argv[i], REGEX_OPTION) == 0 ||
+            strcmp(argv[i], TOP_OPTION) == 0 || strcmp(argv[i], SERVE_OPTION) == 0 ||
+            strcmp(argv[i], WORKERS_OPTION) == 0 || strcmp(argv[i], BLOOM_FPR_OPTION) == 0 ||
+            strcmp(argv[i], CONTEXT_OPTION) == 0 || strcmp(argv[i], NGRAMS_OPTION) == 0 ||
+            strcmp(argv[i], THREADS_OPTION) == 0 || strcmp(argv[i], MAX_MEMORY_OPTION) == 0 ||
+            strcmp(argv[i], SAVE_SNAPSHOT_OPTION) == 0 || strcmp(argv[i], LOAD_SNAPSHOT_OPTION) == 0 ||
+            strcmp(argv[i], SORT_OPTION) == 0 || strcmp(argv[i], RECURSIVE_OPTION) == 0 ||
+            strcmp(argv[i], INCLUDE_OPTION) == 0 || strcmp(argv[i], MAX_FILE_SIZE_OPTION) == 0 ||
+            strcmp(argv[i], PROFILE_OPTION) == 0) {
+
+            /* The option must be followed by its value */
+            if (i + 1 >= argc) {
+                error_handling(MISSING_OPTION_VALUE_ERR, argv[i]);
+                return FALSE;
+            }
+
+            if (strcmp(argv[i], GREP_OPTION) == 0) {
+                options->substring = argv[i + 1];
+            }
+            else if (strcmp(argv[i], REGEX_OPTION) == 0) {
+                options->regex = argv[i + 1];
+            }
+            else if (strcmp(argv[i], SERVE_OPTION) == 0) {
+                options->socket_path = argv[i + 1];
+            }
+            else if (strcmp(argv[i], SAVE_SNAPSHOT_OPTION) == 0) {
+                options->save_snapshot = argv[i + 1];
+            }
+            else if (strcmp(argv[i], LOAD_SNAPSHOT_OPTION) == 0) {
+                options->load_snapshot = argv[i + 1];
+            }
+            else if (strcmp(argv[i], RECURSIVE_OPTION) == 0) {
+                options->directory = argv[i + 1];
+            }
+            else if (strcmp(argv[i], INCLUDE_OPTION) == 0) {
+                options->include = argv[i + 1];
+            }
+            else if (strcmp(argv[i], PROFILE_OPTION) == 0) {
+                options->profile = argv[i + 1];
+            }
+            else if (strcmp(argv[i], SORT_OPTION) == 0) {
+                if (!collate_parse(argv[i + 1], &options->sort_order)) {
+                    error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                    return FALSE;
+                }
+            }
+            else if (strcmp(argv[i], BLOOM_FPR_OPTION) == 0) {
+                rate = strtod(argv[i + 1], &end_ptr);
+                if (end_ptr == argv[i + 1] || *end_ptr != '\0' || rate <= 0 || rate >= 1) {
+                    error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                    return FALSE;
+                }
+                options->bloom_fpr = rate;
+            }
+            else if (strcmp(argv[i], MAX_MEMORY_OPTION) == 0) {
+                if (!parse_size(argv[i + 1], &size) || size < MIN_MAX_MEMORY) {
+                    error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                    return FALSE;
+                }
+                options->max_memory = size;
+            }
+            else if (strcmp(argv[i], MAX_FILE_SIZE_OPTION) == 0) {
+                if (!parse_size(argv[i + 1], &size) || size == 0) {
+                    error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                    return FALSE;
+                }
+                options->max_file_size = size;
+            }
+            else {
+                value = strtol(argv[i + 1], &end_ptr, 10);
+                if (end_ptr == argv[i + 1] || *end_ptr != '\0' || value <= 0 || value > INT_MAX) {
+                    error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                    return FALSE;
+                }
+                if (strcmp(argv[i], TOP_OPTION) == 0) {
+                    options->top = (int) value;
+                }
+                else if (strcmp(argv[i], CONTEXT_OPTION) == 0) {
+                    options->context = (int) value;
+                }
+                else if (strcmp(argv[i], NGRAMS_OPTION) == 0) {
+                    if (value < 2 || value > NGRAM_MAX_N) {
+                        error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                        return FALSE;
+                    }
+                    options->ngrams = (int) value;
+                }
+                else if (strcmp(argv[i], THREADS_OPTION) == 0) {
+                    if (value > MAX_THREADS) {
+                        error_handling(INVALID_OPTION_VALUE_ERR, argv[i]);
+                        return FALSE;
+                    }
+                    options->threads = (int) value;
+                }
+                else {
+                    options->workers = (int) value;
+                }
+            }
+            i++;
+        }
+        else if (strcmp(argv[i], COUNTS_OPTION) == 0) {
+            options->counts = TRUE;
+        }
+        else if (strcmp(argv[i], APPROX_OPTION) == 0) {
+            options->approximate = TRUE;
+        }
+        else if (strcmp(argv[i], POSITIONS_OPTION) == 0) {
+            options->positions = TRUE;
+        }
+        else if (strcmp(argv[i], SHOW_LINES_OPTION) == 0) {
+            options->show_lines = TRUE;
+        }
+        else if (strcmp(argv[i], LINE_COUNTS_OPTION) == 0) {
+            options->line_counts = TRUE;
+        }
+        else if (strcmp(argv[i], WORDS_OPTION) == 0) {
+            options->tokenize_flags |= TOKENIZE_WORDS;
+        }
+        else if (strcmp(argv[i], FOLD_CASE_OPTION) == 0) {
+            options->tokenize_flags |= TOKENIZE_FOLD_CASE;
+        }
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            error_handling(UNKNOWN_OPTION_ERR, argv[i]);
+            return FALSE;
+        }
+        else {
+            options->file_name = argv[i];
+        }
+    }
+
+    /* The counts are printed with the lines of the printed index */
+    if (options->line_counts && (options->substring != NULL || options->regex != NULL || options->approximate ||
+                                 options->ngrams > 0 || options->socket_path != NULL || options->positions ||
+                                 options->context > 0 || options->top > 0 || options->counts ||
+                                 options->save_snapshot != NULL)) {
+        error_handling(LINE_COUNTS_CONFLICT_ERR, LINE_COUNTS_OPTION);
+        return FALSE;
+    }
+
+    /* A restored snapshot is served as it was indexed, from no file */
+    if (options->load_snapshot != NULL) {
+        if (options->socket_path == NULL || options->file_name != NULL || options->directory != NULL ||
+            options->save_snapshot != NULL) {
+            error_handling(LOAD_SNAPSHOT_CONFLICT_ERR, LOAD_SNAPSHOT_OPTION);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /* A crawl indexes the files of a tree as one input, and prints their words or the frequencies */
+    if (options->directory != NULL) {
+        if (options->file_name != NULL || options->substring != NULL || options->regex != NULL ||
+            options->approximate || options->ngrams > 0 || options->socket_path != NULL || options->max_memory > 0 ||
+            options->positions || options->context > 0 || options->show_lines || options->save_snapshot != NULL) {
+            error_handling(RECURSIVE_CONFLICT_ERR, RECURSIVE_OPTION);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    /* Only the crawled files are filtered */
+    if (options->include != NULL || options->max_file_size > 0) {
+        error_handling(CRAWL_FILTER_ERR, options->include != NULL ? INCLUDE_OPTION : MAX_FILE_SIZE_OPTION);
+        return FALSE;
+    }
+
+    /* Check that a file name was provided */
+    if (options->file_name == NULL) {
+        error_handling(INCORRECT_ARG_ERR, argv[0]);
+        return FALSE;
+    }
+
+    /* The sketch only estimates counts, it cannot list every word */
+    if (options->approximate && options->top == 0) {
+        error_handling(APPROX_WITHOUT_TOP_ERR, APPROX_OPTION);
+        return FALSE;
+    }
+
+    /* The server answers from the exact index */
+    if (options->approximate && options->socket_path != NULL) {
+        error_handling(APPROX_WITH_SERVE_ERR, APPROX_OPTION);
+        return FALSE;
+    }
+
+    /* The n-gram index replaces the word index, which the sketch and the server need */
+    if (options->ngrams > 0 && (options->approximate || options->socket_path != NULL)) {
+        error_handling(NGRAMS_CONFLICT_ERR, NGRAMS_OPTION);
+        return FALSE;
+    }
+
+    /* Only the word index is built in parallel, the other indexes are built in the sequential pass */
+    if (options->threads > 1 && (options->substring != NULL || options->regex != NULL || options->approximate ||
+                                 options->socket_path != NULL || options->ngrams > 0)) {
+        error_handling(THREADS_CONFLICT_ERR, THREADS_OPTION);
+        return FALSE;
+    }
+
+    /* Only the line lists can be compressed and spilled, the other modes need the whole index in memory */
+    if (options->max_memory > 0 && (options->socket_path != NULL || options->positions || options->context > 0 ||
+                                    options->threads > 1 || options->ngrams > 0)) {
+        error_handling(MAX_MEMORY_CONFLICT_ERR, MAX_MEMORY_OPTION);
+        return FALSE;
+    }
+
+    /* The snapshot holds the exact word index, and saving it replaces the printed output */
+    if (options->save_snapshot != NULL && (options->substring != NULL || options->regex != NULL ||
+                                           options->approximate || options->ngrams > 0 || options->max_memory > 0 ||
+                                           options->positions || options->context > 0 || options->top > 0 ||
+                                           options->counts)) {
+        error_handling(SAVE_SNAPSHOT_CONFLICT_ERR, SAVE_SNAPSHOT_OPTION);
+        return FALSE;
+    }
+
+    /* The lines are printed under the words of the printed index */
+    if (options->show_lines && (options->substring != NULL || options->regex != NULL || options->approximate ||
+                                options->ngrams > 0 || options->socket_path != NULL || options->max_memory > 0 ||
+                                options->positions || options->context > 0 || options->top > 0 || options->counts ||
+                                options->save_snapshot != NULL)) {
+        error_handling(SHOW_LINES_CONFLICT_ERR, SHOW_LINES_OPTION);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+bool program_process(InputStream *input, WordIndex *index, const IndexOptions *options) {
 
     char line[MAX_LINE_LENGTH];
-    char *sorted_words[HASH_SIZE]; /**< Array to store pointers to words for sorting */
-    int num_words = 0;
+    Tokenizer tokenizer;
+    WordEntry **sorted_entries;
+    WordEntry *entry;
+    TrigramIndex trigrams;
+    ApproxTopK approx;
+    SymbolTable symbols;
+    NgramIndex ngrams;
+    MappedFile mapped;
+    SpillRuns runs;
+    IndexSnapshot snapshot;
+    LineTable lines;
+    Position position;
+    bool search = (options->substring != NULL || options->regex != NULL) ? TRUE : FALSE;
+    bool serve = (options->socket_path != NULL) ? TRUE : FALSE;
+    bool record_positions = (options->positions || options->context > 0) ? TRUE : FALSE;
+    bool served = TRUE;
+    bool within_budget = TRUE;
+    unsigned long line_offset = 0;
+    unsigned long file_offset = 0;
+    size_t line_length;
     int line_count = 0;
     int i;
 
+    /* The server answers searches too, so it needs the trigram index */
+    if (search || serve) {
+        trigram_init(&trigrams);
+    }
+    if (options->approximate) {
+        approx_init(&approx, options->top);
+    }
+    if (options->ngrams > 0) {
+        symbol_init(&symbols);
+        ngram_init(&ngrams, options->ngrams);
+    }
+    spill_init(&runs, options->sort_order);
+    line_table_init(&lines);
+
+    /* Index the file on several threads instead, into the same index a sequential pass builds */
+    if (options->threads > 1 && !parallel_index_file(index, &lines, options)) {
+        error_handling(input->compression != COMPRESSION_NONE ? DECOMPRESS_ERR : OPEN_FILE_ERR, options->file_name);
+        spill_free(&runs);
+        line_table_free(&lines);
+        return FALSE;
+    }
+
+    /* The bytes of a line after a null byte are only counted in a buffer filled with newlines */
+    if (options->show_lines) {
+        memset(line, '\n', sizeof(line));
+    }
+
     /* Read the file line by line */
-    while (fgets(line, sizeof(line), file)) {
+    while (within_budget && options->threads == 1 && input_gets(input, line, sizeof(line))) {
         line_count++;
+        line_length = strlen(line);
+
+        /* Record where the line starts, so it is printed without reading the file again */
+        if (options->show_lines) {
+            line_table_add(&lines, file_offset);
+            file_offset += (unsigned long) read_length(line, line_length, sizeof(line));
+        }
+
+        /* Index the trigrams of the raw line before tokenizing it */
+        if (search || serve) {
+            trigram_add_text(&trigrams, line);
+        }
 
         /* Tokenize the line into words */
-        char *token = strtok(line, SPACES);
-        while (token != NULL) {
-            /* Add the word to the index */
-            addWordToIndex(index, token, line_count);
+        tokenizer_init(&tokenizer, line, line_length, options->tokenize_flags);
+        while (tokenizer_next(&tokenizer)) {
+            if (options->ngrams > 0) {
+                /* Index the n-grams of word IDs instead of the words */
+                ngram_add_word(&ngrams, symbol_intern(&symbols, tokenizer.token), line_count);
+            }
+            else if (options->approximate) {
+                /* Count the word in the sketch instead of the index */
+                approx_add_word(&approx, tokenizer.token);
+            }
+            else {
+                /* Add the word to the index */
+                entry = addWordToIndex(index, tokenizer.token, line_count);
 
-            /* Add the word to the array for sorting if it's not already present */
-            if (!isWordInArray(sorted_words, num_words, token)) {
-                sorted_words[num_words] = strdup(token);
-                (num_words)++;
+                /* The offset of the word in the line gives its column and its offset in the file */
+                if (record_positions) {
+                    position.line = line_count;
+                    position.column = (int) tokenizer.offset + 1;
+                    position.offset = line_offset + (unsigned long) tokenizer.offset;
+                    position_add(entry, &position);
+                }
             }
+        }
+        line_offset += (unsigned long) line_length;
+        if (options->show_lines) {
+            memset(line, '\n', sizeof(line));
+        }
 
-            token = strtok(NULL, SPACES);
+        /* Compress the index, or spill it to a temporary file, as it approaches the budget */
+        if (options->max_memory > 0 && !spill_enforce_budget(index, &runs, options->max_memory)) {
+            error_handling(SPILL_ERR, options->file_name);
+            within_budget = FALSE;
         }
     }
 
-    /* Sort the array of words lexicographically */
-    qsort(sorted_words, num_words, sizeof(char *), compare_strings);
+    /* The index cannot be kept within the budget, so no partial output is printed */
+    if (!within_budget) {
+        if (search) {
+            trigram_free(&trigrams);
+        }
+        if (options->approximate) {
+            approx_free(&approx);
+        }
+        spill_free(&runs);
+        line_table_free(&lines);
+        return FALSE;
+    }
+
+    if (serve || options->save_snapshot != NULL) {
+        /* The served index never changes, freeze it into a minimal perfect hash */
+        index_freeze(index);
+
+        /* Lay it out as a snapshot, with most absent words rejected by the filter */
+        index_build_bloom(index, options->bloom_fpr);
+        snapshot_build(&snapshot, index, options->tokenize_flags);
+
+        /* The snapshot holds all the server reads, the index is released before serving */
+        free_hash(index);
+        index_init(index);
+
+        if (options->save_snapshot != NULL && !snapshot_save(&snapshot, options->save_snapshot)) {
+            error_handling(SAVE_SNAPSHOT_ERR, options->save_snapshot);
+        }
+        if (serve) {
+            served = server_run(options, &snapshot, &trigrams);
+            trigram_free(&trigrams);
+        }
+        snapshot_free(&snapshot);
+    }
+    else if (search) {
+        /* Print the lines matching the search instead of the index, verified against the mapped file */
+        if (map_input(options->file_name, &mapped, 1)) {
+            if (options->substring != NULL) {
+                trigram_search_substring(&trigrams, &mapped, options->substring, stdout);
+            }
+            if (options->regex != NULL) {
+                trigram_search_regex(&trigrams, &mapped, options->regex, stdout);
+            }
+            unmap_file(&mapped);
+        }
+        else {
+            error_handling(OPEN_FILE_ERR, options->file_name);
+        }
+        trigram_free(&trigrams);
+    }
+    else if (options->ngrams > 0) {
+        if (options->top > 0) {
+            ngram_print_top(stdout, &ngrams, &symbols, options->top);
+        }
+        else {
+            ngram_print(stdout, &ngrams, &symbols, options->sort_order);
+        }
+        ngram_free(&ngrams);
+        symbol_free(&symbols);
+    }
+    else if (options->approximate) {
+        approx_print(&approx);
+    }
+    else if (runs.count > 0) {
+        /* Merge the spilled runs with the part of the index left in memory */
+        spill_print(stdout, &runs, index, options);
+    }
+    else if (options->top > 0) {
+        print_top_words(stdout, index, options->top);
+    }
+    else if (options->counts) {
+        print_word_counts(index, options->sort_order);
+    }
+    else {
+        /* Sort the words of the index in the requested order */
+        sorted_entries = collect_sorted_word_entries(index, options->sort_order);
+
+        if (options->context > 0 || options->show_lines) {
+            /* Print the snippets or the lines straight from the mapped file, at the recorded offsets */
+            if (map_input(options->file_name, &mapped, options->threads)) {
+                FOR_RANGE(i, index->count) {
+                    if (options->show_lines) {
+                        print_word_entry(stdout, sorted_entries[i], options->line_counts);
+                        print_word_lines(stdout, sorted_entries[i], &lines, &mapped);
+                    }
+                    else {
+                        print_word_contexts(stdout, sorted_entries[i], &mapped, options->context);
+                    }
+                }
+                unmap_file(&mapped);
+            }
+            else {
+                error_handling(OPEN_FILE_ERR, options->file_name);
+            }
+        }
+        else {
+            /* Print the sorted index */
+            FOR_RANGE(i, index->count) {
+                if (options->positions) {
+                    print_word_positions(stdout, sorted_entries[i]);
+                }
+                else {
+                    print_word_entry(stdout, sorted_entries[i], options->line_counts);
+                }
+            }
+        }
+        free(sorted_entries);
+    }
 
-    /* Print the sorted index */
-    FOR_RANGE(i, num_words) {
-        print_word_entry(index, sorted_words[i]);
+    if (options->approximate) {
+        approx_free(&approx);
     }
+    spill_free(&runs);
+    line_table_free(&lines);
+    return served;
 }
 
+bool program_process_directory(WordIndex *index, const IndexOptions *options) {
 
+    FileList files;
+    WordEntry **sorted_entries;
+    int i;
 
+    if (!crawl_directory(&files, options->directory, options->include, options->max_file_size, options->threads)) {
+        error_handling(OPEN_DIR_ERR, options->directory);
+        return FALSE;
+    }
 
+    /* The files are indexed as one input, each run of files on a thread of its own */
+    if (!parallel_index_files(index, options, &files)) {
+        file_list_free(&files);
+        return FALSE;
+    }
 
+    if (options->top > 0) {
+        print_top_words(stdout, index, options->top);
+    }
+    else if (options->counts) {
+        print_word_counts(index, options->sort_order);
+    }
+    else {
+        /* Print the sorted index, every line as its file and its line in the file */
+        sorted_entries = collect_sorted_word_entries(index, options->sort_order);
+        FOR_RANGE(i, index->count) {
+            print_word_files(stdout, sorted_entries[i], &files, options->line_counts);
+        }
+        free(sorted_entries);
+    }
+
+    file_list_free(&files);
+    return TRUE;
+}
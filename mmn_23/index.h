@@ -2,35 +2,104 @@
  * @file index.h
  * @brief Header file containing functions for processing files and building an index.
  *
- * This header file declares a function for processing a file, building an index,
- * and printing the sorted index.
+ * This header file declares functions for parsing the command-line options,
+ * processing a file, building an index, and printing the sorted index or the
+ * results of a search.
  */
 
 #ifndef INDEX_H
 #define INDEX_H
 
 #include "globals.h"
+#include "compress_utility.h"
 
 #include <stdio.h>
 
+/**
+ * @brief Parses the command-line arguments into the program options.
+ *
+ * The last argument that is not an option or an option value is taken as the name of the file to index.
+ *
+ * @param[in] argc - The number of command-line arguments.
+ * @param[in] argv - The command-line arguments.
+ * @param[out] options - The parsed options.
+ *
+ * @return TRUE if the arguments are valid, FALSE otherwise (an error message is printed).
+ */
+bool parse_arguments(int argc, char *argv[], IndexOptions *options);
+
+/**
+ * @brief Runs the program with its parsed options.
+ *
+ * Serves a restored snapshot (--load-snapshot), indexes a directory tree (-r), or opens the file and
+ * processes it. With --profile, main samples the stacks of the whole run (see profile_utility.h).
+ *
+ * @param[in] options - The command-line options.
+ *
+ * @return EXIT_SUCCESS if the run succeeded, EXIT_FAILURE otherwise (an error message is printed).
+ */
+int program_run(const IndexOptions *options);
+
 /**
  * @brief Processes the program by reading a file, building an index, and printing the sorted index.
  *
- * This function processes the program by reading a file line by line, tokenizing each line into words,
- * adding each word to the index with its corresponding line number, and adding unique words to an array for sorting.
- * After reading the entire file, the function sorts the array of words lexicographically and prints the occurrences
- * of each word in the index.
+ * This function processes the program by reading a file line by line, tokenizing each line into words
+ * with the UTF-8 tokenizer (see tokenizer_utility.h),
+ * and adding each word to the index with its corresponding line number.
+ * After reading the entire file, the function sorts the words of the index (lexicographically, or in the order of
+ * --sort, see collate_utility.h) and prints the occurrences
+ * of each word in the index, or prints the statistics requested by the options.
+ *
+ * @param[in,out] input - The file to be processed, decompressed as it is read if it is compressed.
+ * @param[in,out] index - Pointer to the word index.
+ * @param[in] options - The command-line options. If a search option is given, a trigram index is built
+ *                      in the same pass and the matching lines are printed instead of the sorted index.
+ *                      With --top or --counts the word frequencies are printed instead, and with --approx
+ *                      the words are counted in a Count-Min sketch and the index is not built.
+ *                      With --positions or --context the position of every occurrence is recorded, and the
+ *                      positions or the snippets around the occurrences are printed. With --show-lines
+ *                      the offset of every line is recorded in a line table (see line_table_utility.h),
+ *                      and the lines of every word are printed under it. With --line-counts every line is
+ *                      printed with the number of occurrences of the word on it. With --ngrams the
+ *                      n-grams of consecutive words are indexed and printed instead of the words.
+ *                      With --threads the word index is built on several threads (see parallel_utility.h)
+ *                      and the file is not read through the file pointer.
+ *                      With --max-memory the index is compressed, and then spilled to temporary files,
+ *                      as it approaches the budget (see spill_utility.h), and the runs are merged when printed.
+ *                      With --serve or --save-snapshot the index is frozen and laid out as a snapshot
+ *                      (see snapshot_utility.h), which is served, saved to a file, or both.
+ *
+ * @return TRUE if the file was indexed, FALSE if the threads of --threads could not read or decompress it
+ *         (an error message is printed, and nothing else is), or if the server of --serve could not start.
+ *
+ * @complexity
+ * Time Complexity: O(n * m + w * log w), where n is the number of lines in the file, m is the average number of words
+ * per line, and w is the number of distinct words.
+ * - Each word is added to the hash index in constant average time, so reading the file is linear in its number of words.
+ * - Printing the sorted index sorts the w distinct words once, resulting in O(w * log w).
+ * - With --top K only K words are selected and sorted, resulting in O(w * log K).
+ */
+bool program_process(InputStream *input, WordIndex *index, const IndexOptions *options);
+
+/**
+ * @brief Processes the program by crawling a directory tree, indexing its files, and printing the sorted index.
+ *
+ * The tree of options->directory is crawled (see crawl_utility.h), and its regular files that match
+ * --include and --max-file-size are indexed as one input, in the order of their paths, on --threads threads
+ * (see parallel_utility.h). Every occurrence is printed as the path of its file and its line in the file.
+ * With --top or --counts the word frequencies across the files are printed instead.
+ *
+ * @param[in,out] index - Pointer to the empty word index.
+ * @param[in] options - The command-line options.
  *
- * @param[in] file - Pointer to the file to be processed.
- * @param[in,out] index - Pointer to the array of word entries representing the index.
+ * @return TRUE if the tree was crawled and indexed, FALSE if the directory or one of its files cannot be read
+ *         (an error message is printed, and the index is not printed).
  *
  * @complexity
- * Time Complexity: O(n * m * log m), where n is the number of lines in the file, and m is the average number of words per line.
- * - The function reads each line of the file and tokenizes it into words, resulting in linear time complexity proportional to the number of lines (n) and the average number of words per line (m).
- * - For each word, the function adds it to the index and checks if it's already present in the array for sorting, resulting in logarithmic time complexity for sorting the array of words (m * log m).
- * - Overall, the time complexity is dominated by sorting the array of words, resulting in O(n * m * log m) time complexity.
+ * Time Complexity: O(e / t + n / t + w * log w), where e is the number of entries of the tree, n the size of
+ * the files, t the number of threads and w the number of distinct words.
  */
-void program_process(FILE *file, WordEntry *index);
+bool program_process_directory(WordIndex *index, const IndexOptions *options);
 
 
 #endif /**< INDEX_H */
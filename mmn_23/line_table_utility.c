@@ -0,0 +1,88 @@
+#include <stdlib.h>
+
+#include "line_table_utility.h"
+#include "constants.h"
+
+
+/* Initializes an empty line table */
+void line_table_init(LineTable *table) {
+
+    table->blocks = NULL;
+    table->offsets = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
+
+/* Adds the next line to a line table */
+void line_table_add(LineTable *table, unsigned long offset) {
+
+    int block = table->count / LINE_TABLE_STRIDE;
+
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity == 0 ? 16 * LINE_TABLE_STRIDE : 2 * table->capacity;
+        table->offsets = (unsigned short *) validated_memory_reallocation(table->offsets,
+                                                                          sizeof(unsigned short) * table->capacity);
+        table->blocks = (unsigned long *) validated_memory_reallocation(table->blocks, sizeof(unsigned long) *
+                                                                        (table->capacity / LINE_TABLE_STRIDE));
+    }
+
+    /* The first line of a block starts it, the others are stored from it */
+    if (table->count % LINE_TABLE_STRIDE == 0) {
+        table->blocks[block] = offset;
+    }
+    table->offsets[table->count] = (unsigned short) (offset - table->blocks[block]);
+    table->count++;
+}
+
+/* Returns the offset of a line */
+unsigned long line_table_offset(const LineTable *table, int line_number) {
+
+    int line = line_number - 1;
+
+    return table->blocks[line / LINE_TABLE_STRIDE] + table->offsets[line];
+}
+
+/* Adds the lines of a table after the lines of another, shifted by an offset */
+void line_table_append(LineTable *table, const LineTable *source, unsigned long offset_base) {
+
+    int i;
+
+    FOR_RANGE(i, source->count) {
+        line_table_add(table, offset_base + line_table_offset(source, i + 1));
+    }
+}
+
+/* Prints the distinct lines a word appears in */
+void print_word_lines(FILE *out, const WordEntry *entry, const LineTable *table, const MappedFile *mapped) {
+
+    ListNode *curr;
+    unsigned long start, end;
+
+    for (curr = entry->lines ; curr != NULL ; curr = curr->next) {
+        if (curr->line_number > table->count) {
+            continue;
+        }
+
+        /* A line ends where the next one starts, or at the end of the file */
+        start = line_table_offset(table, curr->line_number);
+        end = curr->line_number < table->count ? line_table_offset(table, curr->line_number + 1) : mapped->size;
+        if (end > mapped->size) {
+            end = mapped->size;
+        }
+        if (start >= end) {
+            continue;
+        }
+        if (mapped->data[end - 1] == '\n') {
+            end--;
+        }
+        fprintf(out, "  %d: %.*s%s", curr->line_number, (int) (end - start), mapped->data + start, NEW_LINE);
+    }
+}
+
+/* Frees the memory allocated for a line table */
+void line_table_free(LineTable *table) {
+
+    free(table->blocks);
+    free(table->offsets);
+    line_table_init(table);
+}
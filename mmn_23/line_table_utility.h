@@ -0,0 +1,109 @@
+/**
+ * @file line_table_utility.h
+ * @brief Header file containing the table of the offsets of the lines of the indexed file.
+ *
+ * This header file defines the line table recorded with --show-lines, in the same pass that
+ * numbers the lines. The table gives the offset of any line in constant time, so the lines of
+ * a word are printed from the mapped file without reading it again from its start.
+ *
+ * The offsets are stored in two levels, as the rank directory of the minimal perfect hash:
+ * the offset of every LINE_TABLE_STRIDE-th line in full, and the offset of every line from the
+ * first line of its block in an unsigned short. A line is read as fgets reads it into a buffer
+ * of MAX_LINE_LENGTH bytes, so a block spans at most LINE_TABLE_STRIDE * (MAX_LINE_LENGTH - 1)
+ * bytes and the relative offsets fit. The table takes about 2 bytes per line.
+ *
+ * The offsets are the offsets of the lines in the file, counting the bytes after a null byte in a
+ * line, which the offsets of the positions do not (see position_utility.h).
+ */
+
+#ifndef LINE_TABLE_UTILITY_H
+#define LINE_TABLE_UTILITY_H
+
+#include "globals.h"
+#include "utility.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Number of lines of a block of the line table, whose first offset is stored in full.
+ */
+#define LINE_TABLE_STRIDE 64
+
+/**
+ * @brief Structure to represent the offsets of the lines of a file.
+ */
+typedef struct {
+    unsigned long *blocks;   /**< The offset of the first line of every block. */
+    unsigned short *offsets; /**< The offset of every line from the first line of its block. */
+    int count;               /**< The number of lines. */
+    int capacity;            /**< The number of lines allocated. */
+} LineTable;
+
+/**
+ * @brief Initializes an empty line table.
+ *
+ * @param[out] table - The line table.
+ */
+void line_table_init(LineTable *table);
+
+/**
+ * @brief Adds the next line to a line table.
+ *
+ * @param[in,out] table - The line table.
+ * @param[in] offset - The offset of the line, not before the offset of the previous line and
+ *                     less than MAX_LINE_LENGTH bytes after it.
+ *
+ * @complexity
+ * Time Complexity: O(1) amortized.
+ */
+void line_table_add(LineTable *table, unsigned long offset);
+
+/**
+ * @brief Returns the offset of a line.
+ *
+ * @param[in] table - The line table.
+ * @param[in] line_number - The number of the line, from 1 to the number of lines.
+ *
+ * @return The offset of the line.
+ *
+ * @complexity
+ * Time Complexity: O(1).
+ */
+unsigned long line_table_offset(const LineTable *table, int line_number);
+
+/**
+ * @brief Adds the lines of a table after the lines of another, shifted by an offset.
+ *
+ * @param[in,out] table - The line table the lines are added to.
+ * @param[in] source - The line table whose lines are added.
+ * @param[in] offset_base - The offset added to the offsets of the lines of the source.
+ *
+ * @complexity
+ * Time Complexity: O(l), where l is the number of lines of the source.
+ */
+void line_table_append(LineTable *table, const LineTable *source, unsigned long offset_base);
+
+/**
+ * @brief Prints the distinct lines a word appears in, one per line as "number: line".
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] entry - The entry of the word.
+ * @param[in] table - The line table of the file.
+ * @param[in] mapped - The mapped file. Lines past its end (the file changed since it was indexed)
+ *                     are not printed.
+ *
+ * @complexity
+ * Time Complexity: O(l + b), where l is the number of lines of the word and b the number of
+ * bytes of the lines.
+ */
+void print_word_lines(FILE *out, const WordEntry *entry, const LineTable *table, const MappedFile *mapped);
+
+/**
+ * @brief Frees the memory allocated for a line table.
+ *
+ * @param[in,out] table - The line table.
+ */
+void line_table_free(LineTable *table);
+
+
+#endif /**< LINE_TABLE_UTILITY_H */
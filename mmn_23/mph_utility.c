@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mph_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+
+
+/* Computes the bit of a key in a level, relative to the start of the level */
+static unsigned long level_bit(unsigned int h1, unsigned int h2, int level, unsigned long level_bits) {
+
+    return (unsigned long) mix_hash(h1 + (unsigned int) level * h2) % level_bits;
+}
+
+/* Checks whether a bit of an array is set */
+static bool test_bit(const unsigned int *bits, unsigned long bit) {
+
+    return (bits[bit >> 5] & (1U << (bit & 31))) ? TRUE : FALSE;
+}
+
+/* Counts the set bits before a bit, using the rank directory */
+static int rank_bit(const PerfectHash *mph, unsigned long bit) {
+
+    unsigned long word = bit >> 5;
+    unsigned long i;
+    int rank = (int) mph->ranks[word / MPH_RANK_BLOCK];
+
+    for (i = word - word % MPH_RANK_BLOCK ; i < word ; i++) {
+        rank += __builtin_popcount(mph->bits[i]);
+    }
+    return rank + __builtin_popcount(mph->bits[word] & ((1U << (bit & 31)) - 1U));
+}
+
+/* Builds the rank directory of the bit arrays */
+static void build_ranks(PerfectHash *mph) {
+
+    unsigned long num_words = mph->level_offset[mph->num_levels] >> 5;
+    unsigned long i;
+    unsigned int rank = 0;
+
+    mph->ranks = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (num_words / MPH_RANK_BLOCK + 1));
+
+    FOR_RANGE(i, num_words) {
+        if (i % MPH_RANK_BLOCK == 0) {
+            mph->ranks[i / MPH_RANK_BLOCK] = rank;
+        }
+        rank += (unsigned int) __builtin_popcount(mph->bits[i]);
+    }
+    if (num_words % MPH_RANK_BLOCK == 0) {
+        mph->ranks[num_words / MPH_RANK_BLOCK] = rank;
+    }
+}
+
+/* Builds a minimal perfect hash function over a set of distinct keys */
+void mph_build(PerfectHash *mph, char **keys, int num_keys) {
+
+    unsigned int *h1 = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (size_t) (num_keys + 1));
+    unsigned int *h2 = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (size_t) (num_keys + 1));
+    int *remaining = (int *) validated_memory_allocation(sizeof(int) * (size_t) (num_keys + 1));
+    unsigned int *collisions = NULL;
+    unsigned int *level;
+    unsigned long level_bits, level_words, bit;
+    int num_remaining = num_keys;
+    int num_kept, i;
+
+    mph->num_keys = num_keys;
+    mph->num_levels = 0;
+    mph->bits = (unsigned int *) validated_memory_allocation(sizeof(unsigned int));
+    mph->level_offset = (unsigned long *) validated_memory_allocation(sizeof(unsigned long) * (MPH_MAX_LEVELS + 1));
+    mph->level_offset[0] = 0;
+    mph->fallback = NULL;
+    mph->num_fallback = 0;
+
+    FOR_RANGE(i, num_keys) {
+        h1[i] = hash(keys[i]);
+        h2[i] = secondary_hash(keys[i]) | 1U;
+        remaining[i] = i;
+    }
+
+    while (num_remaining > 0 && mph->num_levels < MPH_MAX_LEVELS) {
+
+        /* Size the level for the keys not placed yet, in whole words */
+        level_bits = (unsigned long) (MPH_GAMMA * num_remaining);
+        if (level_bits < MPH_MIN_LEVEL_BITS) {
+            level_bits = MPH_MIN_LEVEL_BITS;
+        }
+        level_bits = (level_bits + 31) & ~31UL;
+        level_words = level_bits >> 5;
+
+        mph->bits = (unsigned int *) validated_memory_reallocation(mph->bits,
+                sizeof(unsigned int) * ((mph->level_offset[mph->num_levels] >> 5) + level_words));
+        level = mph->bits + (mph->level_offset[mph->num_levels] >> 5);
+        memset(level, 0, sizeof(unsigned int) * level_words);
+
+        collisions = (unsigned int *) validated_memory_reallocation(collisions, sizeof(unsigned int) * level_words);
+        memset(collisions, 0, sizeof(unsigned int) * level_words);
+
+        /* Mark the bits hit once, and separately the bits hit more than once */
+        FOR_RANGE(i, num_remaining) {
+            bit = level_bit(h1[remaining[i]], h2[remaining[i]], mph->num_levels, level_bits);
+            if (test_bit(level, bit)) {
+                collisions[bit >> 5] |= 1U << (bit & 31);
+            }
+            else {
+                level[bit >> 5] |= 1U << (bit & 31);
+            }
+        }
+
+        /* Only the bits hit by a single key are kept */
+        FOR_RANGE(bit, level_words) {
+            level[bit] &= ~collisions[bit];
+        }
+
+        /* The keys whose bit was cleared move on to the next level */
+        num_kept = 0;
+        FOR_RANGE(i, num_remaining) {
+            if (!test_bit(level, level_bit(h1[remaining[i]], h2[remaining[i]], mph->num_levels, level_bits))) {
+                remaining[num_kept++] = remaining[i];
+            }
+        }
+        num_remaining = num_kept;
+
+        mph->level_offset[mph->num_levels + 1] = mph->level_offset[mph->num_levels] + level_bits;
+        mph->num_levels++;
+    }
+
+    build_ranks(mph);
+
+    /* Keys with identical hash values can never be separated, list them in the last slots */
+    if (num_remaining > 0) {
+        mph->fallback = (char **) validated_memory_allocation(sizeof(char *) * (size_t) num_remaining);
+        FOR_RANGE(i, num_remaining) {
+            mph->fallback[i] = duplicate_string(keys[remaining[i]]);
+        }
+        mph->num_fallback = num_remaining;
+    }
+
+    free(collisions);
+    free(remaining);
+    free(h1);
+    free(h2);
+}
+
+/* Looks up the slot of a key */
+int mph_lookup(const PerfectHash *mph, const char *key) {
+
+    unsigned int h1 = hash(key);
+    unsigned int h2 = secondary_hash(key) | 1U;
+    unsigned long bit;
+    int level;
+    int i;
+
+    FOR_RANGE(level, mph->num_levels) {
+        bit = mph->level_offset[level] +
+              level_bit(h1, h2, level, mph->level_offset[level + 1] - mph->level_offset[level]);
+
+        /* The first level where the bit of the key is set is the one that placed it */
+        if (test_bit(mph->bits, bit)) {
+            return rank_bit(mph, bit);
+        }
+    }
+
+    FOR_RANGE(i, mph->num_fallback) {
+        if (strcmp(mph->fallback[i], key) == 0) {
+            return mph->num_keys - mph->num_fallback + i;
+        }
+    }
+    return -1;
+}
+
+/* Computes the memory used by the hash function, in bits per key */
+double mph_bits_per_key(const PerfectHash *mph) {
+
+    unsigned long total_bits = mph->level_offset[mph->num_levels];
+
+    if (mph->num_keys == 0) {
+        return 0;
+    }
+    total_bits += ((total_bits >> 5) / MPH_RANK_BLOCK + 1) * 32;
+    total_bits += (unsigned long) (mph->num_levels + 1) * 8 * sizeof(unsigned long);
+
+    return (double) total_bits / mph->num_keys;
+}
+
+/* Frees the memory allocated for the hash function */
+void mph_free(PerfectHash *mph) {
+
+    int i;
+
+    FOR_RANGE(i, mph->num_fallback) {
+        free(mph->fallback[i]);
+    }
+    free(mph->fallback);
+    free(mph->bits);
+    free(mph->ranks);
+    free(mph->level_offset);
+    mph->bits = NULL;
+    mph->ranks = NULL;
+    mph->level_offset = NULL;
+    mph->fallback = NULL;
+    mph->num_fallback = 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file mph_utility.h
+ * @brief Header file containing the minimal perfect hash of a frozen vocabulary.
+ *
+ * This header file defines a minimal perfect hash function in the style of BBHash.
+ * The keys are hashed into a bit array at each level. A bit hit by exactly one key is
+ * kept, and the keys that collided are passed on to the next, smaller level. The index
+ * of a key is the number of kept bits before its bit (its rank) across all levels, so
+ * the n keys map to exactly the slots 0..n-1 with no wasted buckets.
+ *
+ * With a level size of GAMMA bits per remaining key, the bit arrays total about
+ * e * GAMMA bits per key, plus the rank directory.
+ */
+
+#ifndef MPH_UTILITY_H
+#define MPH_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Number of bits per remaining key in each level of the hash.
+ *
+ * Larger values use more memory but resolve the keys in fewer levels, so lookups
+ * probe fewer bit arrays. A value of 1 gives about 3 bits per key.
+ */
+#define MPH_GAMMA 1.0
+
+/**
+ * @brief Minimum number of bits in a level, so that the last few keys separate quickly.
+ */
+#define MPH_MIN_LEVEL_BITS 64
+
+/**
+ * @brief Number of 32-bit words covered by each entry of the rank directory.
+ */
+#define MPH_RANK_BLOCK 16
+
+/**
+ * @brief Maximum number of levels.
+ *
+ * About a third of the remaining keys is placed at every level, so this is only reached
+ * by keys whose two hash values are both identical. Such keys are kept in a short list.
+ */
+#define MPH_MAX_LEVELS 64
+
+/**
+ * @brief Structure to represent a minimal perfect hash function.
+ */
+typedef struct PerfectHash {
+    unsigned int *bits;          /**< The bit arrays of all the levels, one after another. */
+    unsigned int *ranks;         /**< The number of set bits before each block of MPH_RANK_BLOCK words. */
+    unsigned long *level_offset; /**< The bit offset of each level, with the total size as a last entry. */
+    int num_levels;              /**< The number of levels. */
+    int num_keys;                /**< The number of keys. */
+    char **fallback;             /**< Copies of the keys no level could separate, in the last slots. */
+    int num_fallback;            /**< The number of keys in the fallback list. */
+} PerfectHash;
+
+/**
+ * @brief Builds a minimal perfect hash function over a set of distinct keys.
+ *
+ * @param[out] mph - The hash function to build.
+ * @param[in] keys - The distinct keys.
+ * @param[in] num_keys - The number of keys.
+ *
+ * @complexity
+ * Time Complexity: O(n) expected, where n is the number of keys (the levels shrink geometrically).
+ */
+void mph_build(PerfectHash *mph, char **keys, int num_keys);
+
+/**
+ * @brief Looks up the slot of a key.
+ *
+ * Every key of the set maps to a distinct slot in 0..n-1. A key outside the set maps
+ * to an arbitrary slot or to -1, so the caller must compare the key stored in the slot.
+ *
+ * @param[in] mph - The hash function.
+ * @param[in] key - The key to look up.
+ *
+ * @return The slot of the key, or -1 if the key is definitely not in the set.
+ *
+ * @complexity
+ * Time Complexity: O(1) expected (the expected number of levels probed is a small constant).
+ */
+int mph_lookup(const PerfectHash *mph, const char *key);
+
+/**
+ * @brief Computes the memory used by the hash function, in bits per key.
+ *
+ * @param[in] mph - The hash function.
+ *
+ * @return The number of bits of the bit arrays and the rank directory, divided by the number of keys.
+ */
+double mph_bits_per_key(const PerfectHash *mph);
+
+/**
+ * @brief Frees the memory allocated for the hash function.
+ *
+ * @param[in,out] mph - The hash function to free.
+ */
+void mph_free(PerfectHash *mph);
+
+
+#endif /**< MPH_UTILITY_H */
@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ngram_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/* Computes the hash of the key of an n-gram */
+static unsigned int ngram_hash(const unsigned int *ids, int n) {
+
+    unsigned int h = 0x9E3779B9U;
+    int i;
+
+    FOR_RANGE(i, n) {
+        h = mix_hash(h + ids[i]);
+    }
+    return h;
+}
+
+/* Allocates the empty buckets of a shard */
+static void allocate_shard(NgramShard *shard, unsigned long size) {
+
+    shard->size = size;
+    shard->entries = (NgramEntry *) validated_memory_allocation(sizeof(NgramEntry) * size);
+    memset(shard->entries, 0, sizeof(NgramEntry) * size);
+}
+
+/* Finds the bucket of a key in a shard, or the empty bucket where it should be inserted */
+static NgramEntry *find_bucket(const NgramShard *shard, const unsigned int *ids, int n, unsigned int h) {
+
+    unsigned long mask = shard->size - 1;
+    unsigned long i = h & mask;
+
+    while (shard->entries[i].count != 0 && memcmp(shard->entries[i].ids, ids, sizeof(unsigned int) * (size_t) n) != 0) {
+        i = (i + 1) & mask;
+    }
+    return &shard->entries[i];
+}
+
+/* Doubles the size of a shard and rehashes its n-grams */
+static void grow_shard(NgramShard *shard, int n) {
+
+    NgramEntry *old_entries = shard->entries;
+    unsigned long old_size = shard->size;
+    unsigned long i;
+
+    allocate_shard(shard, old_size * 2);
+    FOR_RANGE(i, old_size) {
+        if (old_entries[i].count != 0) {
+            *find_bucket(shard, old_entries[i].ids, n, ngram_hash(old_entries[i].ids, n)) = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+/* Counts an occurrence of an n-gram on a line */
+static void add_ngram(NgramIndex *ngrams, const unsigned int *ids, int line_number) {
+
+    unsigned int h = ngram_hash(ids, ngrams->n);
+    NgramShard *shard = &ngrams->shards[h >> (32 - NGRAM_SHARD_BITS)];
+    NgramEntry *entry;
+
+    /* Keep the load factor of the shard below one half */
+    if ((shard->count + 1) * 2 > shard->size) {
+        grow_shard(shard, ngrams->n);
+    }
+
+    entry = find_bucket(shard, ids, ngrams->n, h);
+    if (entry->count == 0) {
+        memcpy(entry->ids, ids, sizeof(unsigned int) * (size_t) ngrams->n);
+        shard->count++;
+        ngrams->count++;
+    }
+    entry->count++;
+
+    /* Every line is recorded once, as the delta from the previous line */
+    if (entry->last_line == line_number) {
+        return;
+    }
+    if (entry->postings_length + MAX_VARINT_BYTES > entry->postings_capacity) {
+        entry->postings_capacity = entry->postings_capacity == 0 ? 2 * MAX_VARINT_BYTES : 2 * entry->postings_capacity;
+        entry->postings = (unsigned char *) validated_memory_reallocation(entry->postings, entry->postings_capacity);
+    }
+    entry->postings_length += (unsigned int) encode_varint((unsigned long) (line_number - entry->last_line),
+                                                           entry->postings + entry->postings_length);
+    entry->last_line = line_number;
+}
+
+/* Initializes an empty n-gram index */
+void ngram_init(NgramIndex *ngrams, int n) {
+
+    int i;
+
+    ngrams->n = n;
+    ngrams->window_length = 0;
+    ngrams->window_line = 0;
+    ngrams->count = 0;
+
+    FOR_RANGE(i, NGRAM_SHARDS) {
+        allocate_shard(&ngrams->shards[i], NGRAM_INITIAL_SHARD_SIZE);
+        ngrams->shards[i].count = 0;
+    }
+}
+
+/* Adds the next word of the file to the n-gram index */
+void ngram_add_word(NgramIndex *ngrams, unsigned int id, int line_number) {
+
+    /* N-grams do not span lines */
+    if (line_number != ngrams->window_line) {
+        ngrams->window_length = 0;
+        ngrams->window_line = line_number;
+    }
+
+    /* Slide the window of the last n words */
+    if (ngrams->window_length == ngrams->n) {
+        memmove(ngrams->window, ngrams->window + 1, sizeof(unsigned int) * (size_t) (ngrams->n - 1));
+        ngrams->window_length--;
+    }
+    ngrams->window[ngrams->window_length++] = id;
+
+    if (ngrams->window_length == ngrams->n) {
+        add_ngram(ngrams, ngrams->window, line_number);
+    }
+}
+
+/* Collects the n-grams of all the shards into an array */
+static const NgramEntry **collect_ngrams(const NgramIndex *ngrams) {
+
+    const NgramEntry **entries = (const NgramEntry **) validated_memory_allocation(sizeof(NgramEntry *) * (ngrams->count + 1));
+    unsigned long num_entries = 0;
+    unsigned long j;
+    int i;
+
+    FOR_RANGE(i, NGRAM_SHARDS) {
+        FOR_RANGE(j, ngrams->shards[i].size) {
+            if (ngrams->shards[i].entries[j].count != 0) {
+                entries[num_entries++] = &ngrams->shards[i].entries[j];
+            }
+        }
+    }
+    return entries;
+}
+
+/* Prints the words of an n-gram */
+static void print_ngram_words(FILE *out, const NgramEntry *entry, int n, const SymbolTable *symbols) {
+
+    int i;
+
+    FOR_RANGE(i, n) {
+        fprintf(out, i == 0 ? "%s" : " %s", symbol_word(symbols, entry->ids[i]));
+    }
+}
+
+/* Prints every n-gram with its lines, in an order of the words */
+void ngram_print(FILE *out, const NgramIndex *ngrams, const SymbolTable *symbols, CollateOrder order) {
+
+    const NgramEntry **entries = collect_ngrams(ngrams);
+    const NgramEntry **sorted = (const NgramEntry **) validated_memory_allocation(sizeof(NgramEntry *) * (ngrams->count + 1));
+    const NgramEntry **swap;
+    unsigned int *ranks = symbol_ranks(symbols, order);
+    unsigned long *offsets = (unsigned long *) validated_memory_allocation(sizeof(unsigned long) * (symbols->count + 1));
+    const unsigned char *next, *end;
+    unsigned long i, delta;
+    unsigned int rank;
+    int word, line;
+
+    /* Stable counting sort by the rank of each word, from the last word to the first */
+    for (word = ngrams->n - 1 ; word >= 0 ; word--) {
+        memset(offsets, 0, sizeof(unsigned long) * (symbols->count + 1));
+        FOR_RANGE(i, ngrams->count) {
+            offsets[ranks[entries[i]->ids[word]] + 1]++;
+        }
+        FOR_RANGE(rank, symbols->count) {
+            offsets[rank + 1] += offsets[rank];
+        }
+        FOR_RANGE(i, ngrams->count) {
+            sorted[offsets[ranks[entries[i]->ids[word]]]++] = entries[i];
+        }
+        swap = entries;
+        entries = sorted;
+        sorted = swap;
+    }
+
+    FOR_RANGE(i, ngrams->count) {
+        print_ngram_words(out, entries[i], ngrams->n, symbols);
+        fprintf(out, " - appears in line");
+
+        line = 0;
+        next = entries[i]->postings;
+        end = next + entries[i]->postings_length;
+        while (next < end) {
+            next += decode_varint(next, end, &delta);
+            line += (int) delta;
+            fprintf(out, " %d", line);
+        }
+        fprintf(out, NEW_LINE);
+    }
+
+    free(entries);
+    free(sorted);
+    free(ranks);
+    free(offsets);
+}
+
+/* Checks whether an n-gram ranks strictly above another, by count and then by the ranks of its words */
+static bool ngram_ranks_above(const NgramEntry *a, const NgramEntry *b, int n, const unsigned int *ranks) {
+
+    int i;
+
+    if (a->count != b->count) {
+        return a->count > b->count ? TRUE : FALSE;
+    }
+    FOR_RANGE(i, n) {
+        if (a->ids[i] != b->ids[i]) {
+            return ranks[a->ids[i]] < ranks[b->ids[i]] ? TRUE : FALSE;
+        }
+    }
+    return FALSE;
+}
+
+/* Restores the min-heap order of n-grams downward from a position */
+static void ngram_sift_down(const NgramEntry **heap, int size, int position, int n, const unsigned int *ranks) {
+
+    const NgramEntry *entry = heap[position];
+    int child;
+
+    while ((child = 2 * position + 1) < size) {
+        if (child + 1 < size && ngram_ranks_above(heap[child], heap[child + 1], n, ranks)) {
+            child++;
+        }
+        if (!ngram_ranks_above(entry, heap[child], n, ranks)) {
+            break;
+        }
+        heap[position] = heap[child];
+        position = child;
+    }
+    heap[position] = entry;
+}
+
+/* Restores the min-heap order of n-grams upward from a position */
+static void ngram_sift_up(const NgramEntry **heap, int position, int n, const unsigned int *ranks) {
+
+    const NgramEntry *entry = heap[position];
+    int parent;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (!ngram_ranks_above(heap[parent], entry, n, ranks)) {
+            break;
+        }
+        heap[position] = heap[parent];
+        position = parent;
+    }
+    heap[position] = entry;
+}
+
+/* Prints the K most frequent n-grams with their number of occurrences */
+void ngram_print_top(FILE *out, const NgramIndex *ngrams, const SymbolTable *symbols, int k) {
+
+    const NgramEntry **heap;
+    const NgramEntry *entry;
+    unsigned int *ranks;
+    unsigned long j;
+    int heap_size = 0;
+    int i, last;
+
+    if ((unsigned long) k > ngrams->count) {
+        k = (int) ngrams->count;
+    }
+    if (k <= 0) {
+        return;
+    }
+
+    ranks = symbol_ranks(symbols, COLLATE_BYTES);
+    heap = (const NgramEntry **) validated_memory_allocation(sizeof(NgramEntry *) * (size_t) k);
+
+    /* Keep the K best n-grams seen so far, with the weakest of them at the root */
+    FOR_RANGE(i, NGRAM_SHARDS) {
+        FOR_RANGE(j, ngrams->shards[i].size) {
+            entry = &ngrams->shards[i].entries[j];
+
+            if (entry->count == 0) {
+                continue;
+            }
+            if (heap_size < k) {
+                heap[heap_size] = entry;
+                ngram_sift_up(heap, heap_size++, ngrams->n, ranks);
+            }
+            else if (ngram_ranks_above(entry, heap[0], ngrams->n, ranks)) {
+                heap[0] = entry;
+                ngram_sift_down(heap, heap_size, 0, ngrams->n, ranks);
+            }
+        }
+    }
+
+    /* Pop the weakest n-gram to the end of the array until the heap is empty, best first */
+    for (last = heap_size - 1 ; last > 0 ; last--) {
+        entry = heap[0];
+        heap[0] = heap[last];
+        heap[last] = entry;
+        ngram_sift_down(heap, last, 0, ngrams->n, ranks);
+    }
+
+    FOR_RANGE(i, heap_size) {
+        print_ngram_words(out, heap[i], ngrams->n, symbols);
+        fprintf(out, " - appears %u times%s", heap[i]->count, NEW_LINE);
+    }
+
+    free(heap);
+    free(ranks);
+}
+
+/* Frees the memory allocated for the n-gram index */
+void ngram_free(NgramIndex *ngrams) {
+
+    unsigned long j;
+    int i;
+
+    FOR_RANGE(i, NGRAM_SHARDS) {
+        FOR_RANGE(j, ngrams->shards[i].size) {
+            free(ngrams->shards[i].entries[j].postings);
+        }
+        free(ngrams->shards[i].entries);
+        ngrams->shards[i].entries = NULL;
+        ngrams->shards[i].size = 0;
+        ngrams->shards[i].count = 0;
+    }
+    ngrams->count = 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file ngram_utility.h
+ * @brief Header file containing the word n-gram index.
+ *
+ * This header file defines an index of the n-grams of consecutive words on a line (pairs
+ * or triples), with the lines on which each n-gram appears and its number of occurrences.
+ * The words are interned in a symbol table first, so the key of an n-gram is a tuple of
+ * NGRAM_MAX_N integer IDs and not a concatenated string.
+ *
+ * The table is split into NGRAM_SHARDS shards, chosen by the high bits of the hash of the
+ * key. Every shard is an open-addressing table that grows on its own, so no single table
+ * or rehash ever spans the whole index.
+ */
+
+#ifndef NGRAM_UTILITY_H
+#define NGRAM_UTILITY_H
+
+#include "globals.h"
+#include "symbol_utility.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Maximum number of words of an n-gram.
+ */
+#define NGRAM_MAX_N 3
+
+/**
+ * @brief Number of bits of the hash of a key that select its shard.
+ */
+#define NGRAM_SHARD_BITS 6
+
+/**
+ * @brief Number of shards of the n-gram table.
+ */
+#define NGRAM_SHARDS (1 << NGRAM_SHARD_BITS)
+
+/**
+ * @brief Initial number of buckets of a shard (a power of two).
+ */
+#define NGRAM_INITIAL_SHARD_SIZE 64
+
+/**
+ * @brief Structure to represent an n-gram and its postings.
+ *
+ * The postings are the line numbers of the n-gram, every line once, stored as
+ * variable-length deltas.
+ */
+typedef struct {
+    unsigned int ids[NGRAM_MAX_N];  /**< The IDs of the words, unused IDs are 0. */
+    unsigned int count;             /**< The number of occurrences, 0 for an empty bucket. */
+    int last_line;                  /**< The last line in the postings. */
+    unsigned int postings_length;   /**< The number of bytes of postings used. */
+    unsigned int postings_capacity; /**< The number of bytes of postings allocated. */
+    unsigned char *postings;        /**< The encoded line numbers. */
+} NgramEntry;
+
+/**
+ * @brief Structure to represent a shard of the n-gram table.
+ */
+typedef struct {
+    NgramEntry *entries; /**< The buckets of the shard. */
+    unsigned long size;  /**< The number of buckets (a power of two). */
+    unsigned long count; /**< The number of n-grams in the shard. */
+} NgramShard;
+
+/**
+ * @brief Structure to represent the n-gram index.
+ */
+typedef struct {
+    NgramShard shards[NGRAM_SHARDS];    /**< The shards of the table. */
+    int n;                              /**< The number of words of an n-gram. */
+    unsigned int window[NGRAM_MAX_N];   /**< The IDs of the last words of the current line. */
+    int window_length;                  /**< The number of words in the window. */
+    int window_line;                    /**< The line of the words in the window. */
+    unsigned long count;                /**< The number of distinct n-grams. */
+} NgramIndex;
+
+/**
+ * @brief Initializes an empty n-gram index.
+ *
+ * @param[out] ngrams - The n-gram index to initialize.
+ * @param[in] n - The number of words of an n-gram, between 2 and NGRAM_MAX_N.
+ */
+void ngram_init(NgramIndex *ngrams, int n);
+
+/**
+ * @brief Adds the next word of the file to the n-gram index.
+ *
+ * Once n words of the same line have been added, every word completes an n-gram with
+ * the words before it. N-grams never span two lines.
+ *
+ * @param[in,out] ngrams - The n-gram index.
+ * @param[in] id - The ID of the word.
+ * @param[in] line_number - The line number of the word.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ */
+void ngram_add_word(NgramIndex *ngrams, unsigned int id, int line_number);
+
+/**
+ * @brief Prints every n-gram with its lines, in an order of the words.
+ *
+ * The n-grams are ordered by radix sort on the ranks of their word IDs, one pass per
+ * word, so no string is compared.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] ngrams - The n-gram index.
+ * @param[in] symbols - The symbol table of the word IDs.
+ * @param[in] order - The sort order of the words (see collate_utility.h).
+ *
+ * @complexity
+ * Time Complexity: O(n * (g + w)), where g is the number of n-grams and w the number of words.
+ */
+void ngram_print(FILE *out, const NgramIndex *ngrams, const SymbolTable *symbols, CollateOrder order);
+
+/**
+ * @brief Prints the K most frequent n-grams with their number of occurrences.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] ngrams - The n-gram index.
+ * @param[in] symbols - The symbol table of the word IDs.
+ * @param[in] k - The number of n-grams to print.
+ *
+ * @complexity
+ * Time Complexity: O(g * log k), where g is the number of n-grams.
+ */
+void ngram_print_top(FILE *out, const NgramIndex *ngrams, const SymbolTable *symbols, int k);
+
+/**
+ * @brief Frees the memory allocated for the n-gram index.
+ *
+ * @param[in,out] ngrams - The n-gram index to free.
+ */
+void ngram_free(NgramIndex *ngrams);
+
+
+#endif /**< NGRAM_UTILITY_H */
@@ -0,0 +1,548 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parallel_utility.h"
+#include "hash_utility.h"
+#include "symbol_utility.h"
+#include "position_utility.h"
+#include "tokenizer_utility.h"
+#include "compress_utility.h"
+#include "error_utility.h"
+#include "line_table_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Structure to represent the postings of a chunk of the file, built by a single thread.
+ *
+ * The entries are in the order of the first occurrence of their words in the chunk. Their
+ * words are the copies held by the shared dictionary, and their lines and positions are
+ * counted from the start of the chunk until the chunk is merged.
+ */
+typedef struct {
+    SharedDictionary *dictionary; /**< The dictionary shared by the threads. */
+    const IndexOptions *options;  /**< The command-line options. */
+    const char *start;            /**< The first byte of the chunk. */
+    const char *end;              /**< The end of the chunk. */
+    FileList *files;              /**< The files crawled by -r, NULL for a chunk of a single file. */
+    size_t first_file;            /**< The first file of the chunk, in the file list. */
+    size_t end_file;              /**< The end of the files of the chunk, in the file list. */
+    WordEntry *entries;           /**< The entries of the words of the chunk. */
+    unsigned int *ids;            /**< The shared ID of the word of each entry. */
+    unsigned int *hashes;         /**< The hash of the word of each entry. */
+    unsigned int *slots;          /**< Table of the entries plus one, 0 for an empty slot. */
+    unsigned int num_slots;       /**< The number of slots (a power of two). */
+    unsigned int count;           /**< The number of entries. */
+    unsigned int capacity;        /**< The number of entries allocated. */
+    NodePool nodes;               /**< The nodes of the line lists of the chunk. */
+    int line_count;               /**< The number of lines of the chunk. */
+    unsigned long length;         /**< The number of bytes of the lines of the chunk, as read by fgets. */
+    int line_base;                /**< The number of lines before the chunk, known once all chunks are indexed. */
+    LineTable lines;              /**< The offsets of the lines of the chunk, with --show-lines. */
+    bool failed;                  /**< Whether a file of the chunk could not be read. */
+} ChunkIndex;
+
+/* Initializes an empty shared dictionary */
+void shared_dictionary_init(SharedDictionary *dictionary) {
+
+    int i;
+
+    FOR_RANGE(i, DICTIONARY_STRIPES) {
+        pthread_mutex_init(&dictionary->stripes[i].lock, NULL);
+        symbol_init(&dictionary->stripes[i].symbols);
+    }
+}
+
+/* Interns a word in the shared dictionary */
+unsigned int shared_dictionary_intern(SharedDictionary *dictionary, const char *word, unsigned int word_hash,
+                                      const char **interned) {
+
+    /* The low bits of the hash pick the slot in the stripe, the high bits pick the stripe */
+    unsigned int stripe = word_hash >> (32 - DICTIONARY_STRIPE_BITS);
+    DictionaryStripe *owner = &dictionary->stripes[stripe];
+    unsigned int id;
+
+    pthread_mutex_lock(&owner->lock);
+    id = symbol_intern(&owner->symbols, word);
+    *interned = symbol_word(&owner->symbols, id);
+    pthread_mutex_unlock(&owner->lock);
+
+    return (id << DICTIONARY_STRIPE_BITS) | stripe;
+}
+
+/* Computes a bound on the IDs of the words of the shared dictionary */
+unsigned int shared_dictionary_id_bound(const SharedDictionary *dictionary) {
+
+    unsigned int largest = 0;
+    int i;
+
+    FOR_RANGE(i, DICTIONARY_STRIPES) {
+        if (dictionary->stripes[i].symbols.count > largest) {
+            largest = dictionary->stripes[i].symbols.count;
+        }
+    }
+    return largest << DICTIONARY_STRIPE_BITS;
+}
+
+/* Frees the memory allocated for the shared dictionary */
+void shared_dictionary_free(SharedDictionary *dictionary) {
+
+    int i;
+
+    FOR_RANGE(i, DICTIONARY_STRIPES) {
+        symbol_free(&dictionary->stripes[i].symbols);
+        pthread_mutex_destroy(&dictionary->stripes[i].lock);
+    }
+}
+
+/* Finds the slot of a word in the table of a chunk, or the empty slot where its entry should be stored */
+static unsigned int find_chunk_slot(const ChunkIndex *chunk, const char *word, unsigned int word_hash) {
+
+    unsigned int mask = chunk->num_slots - 1;
+    unsigned int i = word_hash & mask;
+    unsigned int e;
+
+    while (chunk->slots[i] != 0) {
+        e = chunk->slots[i] - 1;
+        if (chunk->hashes[e] == word_hash && strcmp(chunk->entries[e].word, word) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Doubles the number of slots of the table of a chunk */
+static void grow_chunk_slots(ChunkIndex *chunk) {
+
+    unsigned int mask;
+    unsigned int e, i;
+
+    free(chunk->slots);
+    chunk->num_slots *= 2;
+    chunk->slots = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * chunk->num_slots);
+    memset(chunk->slots, 0, sizeof(unsigned int) * chunk->num_slots);
+
+    mask = chunk->num_slots - 1;
+    FOR_RANGE(e, chunk->count) {
+        i = chunk->hashes[e] & mask;
+        while (chunk->slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        chunk->slots[i] = e + 1;
+    }
+}
+
+/* Finds the entry of a word in a chunk, interning the word in the shared dictionary on its first occurrence */
+static WordEntry *chunk_entry(ChunkIndex *chunk, const char *word) {
+
+    unsigned int word_hash = mix_hash(hash(word));
+    unsigned int slot = find_chunk_slot(chunk, word, word_hash);
+    WordEntry *entry;
+
+    if (chunk->slots[slot] != 0) {
+        return &chunk->entries[chunk->slots[slot] - 1];
+    }
+
+    if (chunk->count == chunk->capacity) {
+        chunk->capacity *= 2;
+        chunk->entries = (WordEntry *) validated_memory_reallocation(chunk->entries, sizeof(WordEntry) * chunk->capacity);
+        chunk->ids = (unsigned int *) validated_memory_reallocation(chunk->ids, sizeof(unsigned int) * chunk->capacity);
+        chunk->hashes = (unsigned int *) validated_memory_reallocation(chunk->hashes,
+                                                                       sizeof(unsigned int) * chunk->capacity);
+    }
+
+    entry = &chunk->entries[chunk->count];
+    chunk->ids[chunk->count] = shared_dictionary_intern(chunk->dictionary, word, word_hash, &entry->word);
+    chunk->hashes[chunk->count] = word_hash;
+    entry->lines = NULL;
+    entry->last_line = NULL;
+    entry->count = 0;
+    entry->positions = NULL;
+    entry->postings = NULL;
+    chunk->slots[slot] = ++chunk->count;
+
+    /* Keep the load factor below one half */
+    if (chunk->count * 2 > chunk->num_slots) {
+        grow_chunk_slots(chunk);
+    }
+    return entry;
+}
+
+/* Tokenizes and indexes lines of bytes after the lines already in a chunk */
+static void index_lines(ChunkIndex *chunk, const char *start, const char *end) {
+
+    bool record_positions = (chunk->options->positions || chunk->options->context > 0) ? TRUE : FALSE;
+    Tokenizer tokenizer;
+    Position position;
+    WordEntry *entry;
+    const char *line = start;
+    const char *newline, *null_byte, *next;
+    size_t line_length;
+
+    while (line < end) {
+
+        /* Read the line as fgets would: up to a newline, at most MAX_LINE_LENGTH - 1 bytes */
+        next = end - line > MAX_LINE_LENGTH - 1 ? line + MAX_LINE_LENGTH - 1 : end;
+        newline = (const char *) memchr(line, '\n', (size_t) (next - line));
+        if (newline != NULL) {
+            next = newline + 1;
+        }
+
+        /* The line ends at its first null byte, as strlen would find it in the buffer */
+        null_byte = (const char *) memchr(line, '\0', (size_t) (next - line));
+        line_length = (size_t) ((null_byte != NULL ? null_byte : next) - line);
+        chunk->line_count++;
+        if (chunk->options->show_lines) {
+            line_table_add(&chunk->lines, (unsigned long) (line - start));
+        }
+
+        tokenizer_init(&tokenizer, line, line_length, chunk->options->tokenize_flags);
+        while (tokenizer_next(&tokenizer)) {
+            entry = chunk_entry(chunk, tokenizer.token);
+            entry_add_line(entry, &chunk->nodes, chunk->line_count);
+
+            if (record_positions) {
+                position.line = chunk->line_count;
+                position.column = (int) tokenizer.offset + 1;
+                position.offset = chunk->length + (unsigned long) tokenizer.offset;
+                position_add(entry, &position);
+            }
+        }
+        chunk->length += (unsigned long) line_length;
+        line = next;
+    }
+}
+
+/* Tokenizes and indexes the lines of a chunk, the work of one thread */
+static void *index_chunk(void *arg) {
+
+    ChunkIndex *chunk = (ChunkIndex *) arg;
+
+    index_lines(chunk, chunk->start, chunk->end);
+    return NULL;
+}
+
+/* Reads a whole file into a buffer that grows as needed, returns the number of bytes or -1 */
+static long read_whole_file(const char *file_name, char **buffer, size_t *capacity) {
+
+    int fd = open(file_name, O_RDONLY);
+    size_t length = 0;
+    ssize_t bytes;
+
+    if (fd < 0) {
+        return -1;
+    }
+    while (TRUE) {
+        if (length == *capacity) {
+            *capacity = *capacity == 0 ? CRAWL_MAP_SIZE : 2 * *capacity;
+            *buffer = (char *) validated_memory_reallocation(*buffer, *capacity);
+        }
+        bytes = read(fd, *buffer + length, *capacity - length);
+        if (bytes <= 0) {
+            break;
+        }
+        length += (size_t) bytes;
+    }
+    close(fd);
+    return bytes < 0 ? -1 : (long) length;
+}
+
+/* Tokenizes and indexes the files of a chunk one after another, the work of one thread */
+static void *index_file_chunk(void *arg) {
+
+    ChunkIndex *chunk = (ChunkIndex *) arg;
+    const char *path;
+    char *buffer = NULL;
+    size_t capacity = 0;
+    MappedFile mapped;
+    long length;
+    int line_count;
+    size_t i;
+
+    for (i = chunk->first_file ; i < chunk->end_file ; i++) {
+        path = chunk->files->paths[i];
+
+        /* The number of lines of the file is kept in its slot until the lines before every file are known */
+        line_count = chunk->line_count;
+        chunk->files->first_lines[i] = 0;
+
+        /* A small file is read into the buffer of the thread, unless it turns out to be compressed */
+        if (chunk->files->sizes[i] < CRAWL_MAP_SIZE) {
+            length = read_whole_file(path, &buffer, &capacity);
+            if (length < 0) {
+                error_handling(OPEN_FILE_ERR, path);
+                chunk->failed = TRUE;
+                continue;
+            }
+            if (detect_compression((const unsigned char *) buffer, (size_t) length) == COMPRESSION_NONE) {
+                index_lines(chunk, buffer, buffer + length);
+                chunk->files->first_lines[i] = chunk->line_count - line_count;
+                continue;
+            }
+        }
+
+        if (!map_input(path, &mapped, 1)) {
+            error_handling(OPEN_FILE_ERR, path);
+            chunk->failed = TRUE;
+            continue;
+        }
+        index_lines(chunk, mapped.data, mapped.data + mapped.size);
+        chunk->files->first_lines[i] = chunk->line_count - line_count;
+        unmap_file(&mapped);
+    }
+    free(buffer);
+    return NULL;
+}
+
+/* Shifts the line numbers of a chunk by the lines before it, the work of one thread */
+static void *rebase_chunk(void *arg) {
+
+    ChunkIndex *chunk = (ChunkIndex *) arg;
+    NodeBlock *block;
+    int used = chunk->nodes.used;
+    int i;
+
+    /* Every node of the pool is in a line list of the chunk, so the blocks are walked instead of the lists */
+    for (block = chunk->nodes.blocks; block != NULL; block = block->next) {
+        FOR_RANGE(i, used) {
+            block->nodes[i].line_number += chunk->line_base;
+        }
+        used = NODE_BLOCK_SIZE;
+    }
+    return NULL;
+}
+
+/* Runs a function on every task, each on its own thread, and waits for all of them */
+void run_on_threads(void *tasks, size_t task_size, int num_tasks, void *(*work)(void *)) {
+
+    pthread_t *threads = (pthread_t *) validated_memory_allocation(sizeof(pthread_t) * (size_t) num_tasks);
+    bool *started = (bool *) validated_memory_allocation(sizeof(bool) * (size_t) num_tasks);
+    char *task = (char *) tasks;
+    int i;
+
+    FOR_RANGE(i, num_tasks) {
+        started[i] = (pthread_create(&threads[i], NULL, work, task + (size_t) i * task_size) == 0) ? TRUE : FALSE;
+
+        /* Without another thread, the task is run on this one */
+        if (!started[i]) {
+            work(task + (size_t) i * task_size);
+        }
+    }
+    FOR_RANGE(i, num_tasks) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    free(started);
+    free(threads);
+}
+
+/* Moves the postings of a chunk into the word index, after those of the previous chunks */
+static void merge_chunk(WordIndex *index, ChunkIndex *chunk, unsigned int *merged_ids, unsigned long offset_base) {
+
+    WordEntry *source, *entry;
+    unsigned int i;
+
+    FOR_RANGE(i, chunk->count) {
+        source = &chunk->entries[i];
+
+        /* A word seen in a previous chunk has its entry already, a new word gets the next ID */
+        if (merged_ids[chunk->ids[i]] == 0) {
+            entry = index_intern_word(index, source->word);
+            merged_ids[chunk->ids[i]] = (unsigned int) (entry - index->entries) + 1;
+        }
+        else {
+            entry = &index->entries[merged_ids[chunk->ids[i]] - 1];
+        }
+
+        /* The lines of the chunk follow the lines of the previous chunks */
+        if (entry->last_line == NULL) {
+            entry->lines = source->lines;
+        }
+        else {
+            entry->last_line->next = source->lines;
+        }
+        entry->last_line = source->last_line;
+        entry->count += source->count;
+
+        if (source->positions != NULL) {
+            position_append(entry, source, chunk->line_base, offset_base);
+            position_free(source);
+        }
+    }
+
+    /* The nodes of the spliced lists now belong to the index */
+    node_pool_append(&index->nodes, &chunk->nodes);
+}
+
+/* Initializes the empty postings of a chunk */
+static void chunk_init(ChunkIndex *chunk, SharedDictionary *dictionary, const IndexOptions *options) {
+
+    chunk->dictionary = dictionary;
+    chunk->options = options;
+    chunk->start = NULL;
+    chunk->end = NULL;
+    chunk->files = NULL;
+    chunk->first_file = 0;
+    chunk->end_file = 0;
+    chunk->capacity = HASH_SIZE / 2;
+    chunk->count = 0;
+    chunk->entries = (WordEntry *) validated_memory_allocation(sizeof(WordEntry) * chunk->capacity);
+    chunk->ids = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * chunk->capacity);
+    chunk->hashes = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * chunk->capacity);
+    chunk->num_slots = HASH_SIZE;
+    chunk->slots = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * chunk->num_slots);
+    memset(chunk->slots, 0, sizeof(unsigned int) * chunk->num_slots);
+    node_pool_init(&chunk->nodes);
+    chunk->line_count = 0;
+    chunk->length = 0;
+    chunk->line_base = 0;
+    line_table_init(&chunk->lines);
+    chunk->failed = FALSE;
+}
+
+/* Indexes the chunks on their threads, and merges them and their line tables in their order */
+static void index_chunks(WordIndex *index, LineTable *lines, ChunkIndex *chunks, int num_chunks,
+                         SharedDictionary *dictionary, void *(*work)(void *)) {
+
+    unsigned int *merged_ids;
+    unsigned long offset_base = 0;
+    int line_base = 0;
+    int i;
+
+    run_on_threads(chunks, sizeof(ChunkIndex), num_chunks, work);
+
+    /* The line numbers of a chunk follow those of the chunks before it */
+    FOR_RANGE(i, num_chunks) {
+        chunks[i].line_base = line_base;
+        line_base += chunks[i].line_count;
+    }
+    run_on_threads(chunks, sizeof(ChunkIndex), num_chunks, rebase_chunk);
+
+    /* Merge the chunks in the order of the input, so the words get the IDs of a sequential run */
+    merged_ids = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) *
+                                                              (shared_dictionary_id_bound(dictionary) + 1));
+    memset(merged_ids, 0, sizeof(unsigned int) * (shared_dictionary_id_bound(dictionary) + 1));
+
+    FOR_RANGE(i, num_chunks) {
+        merge_chunk(index, &chunks[i], merged_ids, offset_base);
+        if (lines != NULL) {
+            line_table_append(lines, &chunks[i].lines, (unsigned long) (chunks[i].start - chunks[0].start));
+        }
+        offset_base += chunks[i].length;
+        line_table_free(&chunks[i].lines);
+
+        free(chunks[i].entries);
+        free(chunks[i].ids);
+        free(chunks[i].hashes);
+        free(chunks[i].slots);
+    }
+    free(merged_ids);
+}
+
+/* Indexes a file on several threads into an empty word index */
+bool parallel_index_file(WordIndex *index, LineTable *lines, const IndexOptions *options) {
+
+    SharedDictionary *dictionary;
+    ChunkIndex *chunks;
+    MappedFile mapped;
+    const char *boundary;
+    const char *newline;
+    int i;
+
+    if (!map_input(options->file_name, &mapped, options->threads)) {
+        return FALSE;
+    }
+    if (mapped.size == 0) {
+        return TRUE;
+    }
+
+    dictionary = (SharedDictionary *) validated_memory_allocation(sizeof(SharedDictionary));
+    shared_dictionary_init(dictionary);
+
+    /* Split the file into chunks of about the same size, each ending after a newline */
+    chunks = (ChunkIndex *) validated_memory_allocation(sizeof(ChunkIndex) * (size_t) options->threads);
+    boundary = mapped.data;
+    FOR_RANGE(i, options->threads) {
+        chunk_init(&chunks[i], dictionary, options);
+        chunks[i].start = boundary;
+
+        boundary = mapped.data + (size_t) ((double) mapped.size * (i + 1) / options->threads);
+        if (boundary < chunks[i].start) {
+            boundary = chunks[i].start;
+        }
+        if (i == options->threads - 1) {
+            boundary = mapped.data + mapped.size;
+        }
+        else if (boundary > mapped.data && boundary < mapped.data + mapped.size && boundary[-1] != '\n') {
+            newline = (const char *) memchr(boundary, '\n', (size_t) (mapped.data + mapped.size - boundary));
+            boundary = newline != NULL ? newline + 1 : mapped.data + mapped.size;
+        }
+        chunks[i].end = boundary;
+    }
+
+    index_chunks(index, lines, chunks, options->threads, dictionary, index_chunk);
+
+    free(chunks);
+    shared_dictionary_free(dictionary);
+    free(dictionary);
+    unmap_file(&mapped);
+    return TRUE;
+}
+
+/* Indexes the files of a crawl on several threads into an empty word index */
+bool parallel_index_files(WordIndex *index, const IndexOptions *options, FileList *files) {
+
+    SharedDictionary *dictionary;
+    ChunkIndex *chunks;
+    unsigned long total = 0, taken = 0;
+    size_t next = 0, i;
+    int line_base = 0, line_count;
+    bool indexed = TRUE;
+    int t;
+
+    dictionary = (SharedDictionary *) validated_memory_allocation(sizeof(SharedDictionary));
+    shared_dictionary_init(dictionary);
+
+    /* Split the list into runs of files of about the same number of bytes, in the order of the list */
+    FOR_RANGE(i, files->count) {
+        total += files->sizes[i];
+    }
+    chunks = (ChunkIndex *) validated_memory_allocation(sizeof(ChunkIndex) * (size_t) options->threads);
+    FOR_RANGE(t, options->threads) {
+        chunk_init(&chunks[t], dictionary, options);
+        chunks[t].files = files;
+        chunks[t].first_file = next;
+        while (next < files->count &&
+               (t == options->threads - 1 || taken < (unsigned long) ((double) total * (t + 1) / options->threads))) {
+            taken += files->sizes[next++];
+        }
+        chunks[t].end_file = next;
+    }
+
+    index_chunks(index, NULL, chunks, options->threads, dictionary, index_file_chunk);
+    FOR_RANGE(t, options->threads) {
+        if (chunks[t].failed) {
+            indexed = FALSE;
+        }
+    }
+
+    /* The number of lines of every file becomes the number of lines before it */
+    FOR_RANGE(i, files->count) {
+        line_count = files->first_lines[i];
+        files->first_lines[i] = line_base;
+        line_base += line_count;
+    }
+    files->first_lines[files->count] = line_base;
+
+    free(chunks);
+    shared_dictionary_free(dictionary);
+    free(dictionary);
+    return indexed;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file parallel_utility.h
+ * @brief Header file containing the parallel indexer and its shared dictionary.
+ *
+ * This header file defines the indexing of a file on several threads. The mapped file is
+ * split into one chunk per thread at line boundaries, and every thread tokenizes its chunk
+ * into postings of its own: the entries of the words of the chunk, with line lists taken
+ * from a node pool of the thread. No lock is taken while a word is added to the postings.
+ *
+ * The words themselves are interned once for all the threads in a shared dictionary, so
+ * the threads do not each hold a copy of the vocabulary. The dictionary is a concurrent
+ * hash map from words to IDs, split into DICTIONARY_STRIPES stripes chosen by the high bits
+ * of the hash of a word. Every stripe is a symbol table behind its own mutex, so threads only
+ * contend when they intern new words of the same stripe at the same time. A thread consults
+ * the dictionary once per distinct word of its chunk, and keeps the interned word in a table
+ * of its own for the later occurrences.
+ *
+ * Once all the chunks are indexed, the postings are merged into the word index in the order
+ * of the chunks. The lines and byte offsets of every chunk are shifted by those before it,
+ * the line lists are spliced and the positions appended, and the words get their IDs in the
+ * order of their first occurrence in the file. The merged index is therefore identical to the
+ * index built by reading the file on a single thread, and so is everything printed from it.
+ *
+ * The files of a directory crawled by -r are indexed the same way, as if they were one file:
+ * every chunk is a run of files of the sorted list, indexed one after another by its thread.
+ */
+
+#ifndef PARALLEL_UTILITY_H
+#define PARALLEL_UTILITY_H
+
+#include "globals.h"
+#include "crawl_utility.h"
+#include "line_table_utility.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+/**
+ * @brief Number of bits of the hash of a word that select its stripe of the shared dictionary.
+ */
+#define DICTIONARY_STRIPE_BITS 6
+
+/**
+ * @brief Number of stripes of the shared dictionary.
+ */
+#define DICTIONARY_STRIPES (1 << DICTIONARY_STRIPE_BITS)
+
+/**
+ * @brief Structure to represent a stripe of the shared dictionary.
+ */
+typedef struct {
+    pthread_mutex_t lock; /**< Protects the symbol table of the stripe. */
+    SymbolTable symbols;  /**< The words of the stripe and their IDs in the stripe. */
+} DictionaryStripe;
+
+/**
+ * @brief Structure to represent the dictionary of words shared by the indexing threads.
+ *
+ * The ID of a word is its ID in its stripe, followed by the DICTIONARY_STRIPE_BITS bits of
+ * the stripe. The IDs are therefore unique across the stripes, and below the bound returned
+ * by shared_dictionary_id_bound.
+ */
+typedef struct {
+    DictionaryStripe stripes[DICTIONARY_STRIPES]; /**< The stripes of the dictionary. */
+} SharedDictionary;
+
+/**
+ * @brief Initializes an empty shared dictionary.
+ *
+ * @param[out] dictionary - The dictionary to initialize.
+ */
+void shared_dictionary_init(SharedDictionary *dictionary);
+
+/**
+ * @brief Interns a word in the shared dictionary. It may be called by several threads at once.
+ *
+ * @param[in,out] dictionary - The dictionary.
+ * @param[in] word - The word to intern.
+ * @param[in] word_hash - The hash of the word, mix_hash(hash(word)).
+ * @param[out] interned - The copy of the word held by the dictionary, valid until it is freed.
+ *
+ * @return The ID of the word.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average, plus the wait for the lock of the stripe of the word.
+ */
+unsigned int shared_dictionary_intern(SharedDictionary *dictionary, const char *word, unsigned int word_hash,
+                                      const char **interned);
+
+/**
+ * @brief Computes a bound on the IDs of the words of the shared dictionary.
+ *
+ * @param[in] dictionary - The dictionary. No thread may intern words concurrently.
+ *
+ * @return A number greater than every ID given so far.
+ */
+unsigned int shared_dictionary_id_bound(const SharedDictionary *dictionary);
+
+/**
+ * @brief Frees the memory allocated for the shared dictionary and its words.
+ *
+ * @param[in,out] dictionary - The dictionary.
+ */
+void shared_dictionary_free(SharedDictionary *dictionary);
+
+/**
+ * @brief Runs a function on every task of an array, each on its own thread, and waits for all of them.
+ *
+ * A task whose thread cannot be created is run on the calling thread instead.
+ *
+ * @param[in,out] tasks - The array of tasks.
+ * @param[in] task_size - The size of a task in bytes.
+ * @param[in] num_tasks - The number of tasks.
+ * @param[in] work - The function run on every task, given a pointer to the task.
+ */
+void run_on_threads(void *tasks, size_t task_size, int num_tasks, void *(*work)(void *));
+
+/**
+ * @brief Indexes a file on several threads into an empty word index.
+ *
+ * The file is mapped and split into options->threads chunks at line boundaries. Lines are
+ * read as fgets would read them into a buffer of MAX_LINE_LENGTH bytes, so the line numbers,
+ * and the positions if options->positions or options->context ask for them, are the same as
+ * when the file is read sequentially.
+ *
+ * @param[in,out] index - The empty word index.
+ * @param[in,out] lines - The empty line table the offsets of the lines are added to, with
+ *                        options->show_lines.
+ * @param[in] options - The command-line options: the file, the number of threads, the tokenizer
+ *                      flags, and whether positions and line offsets are recorded.
+ *
+ * @return TRUE if the file was indexed, FALSE if it could not be mapped.
+ *
+ * @complexity
+ * Time Complexity: O(n / t + t * w), where n is the size of the file, t the number of threads and
+ * w the number of distinct words.
+ * - Every thread tokenizes and indexes its chunk of about n / t bytes.
+ * - The merge visits the entries of every chunk and the blocks of line list nodes, not the occurrences.
+ *   Only the first position of a word in a chunk is encoded again.
+ */
+bool parallel_index_file(WordIndex *index, LineTable *lines, const IndexOptions *options);
+
+/**
+ * @brief Indexes the files of a crawl on several threads into an empty word index.
+ *
+ * The list is split into options->threads runs of files of about the same number of bytes.
+ * The lines of the files are numbered one after another in the order of the list, every file
+ * starting on a line of its own, and the number of lines before every file is recorded in the
+ * list. A file that cannot be read is reported and indexed as empty, and the other files are
+ * still indexed.
+ *
+ * @param[in,out] index - The empty word index.
+ * @param[in] options - The command-line options: the number of threads and the tokenizer flags.
+ * @param[in,out] files - The files to index, in the order of their lines.
+ *
+ * @return TRUE if every file was indexed, FALSE if a file could not be read.
+ *
+ * @complexity
+ * Time Complexity: O(n / t + t * w), where n is the size of the files, t the number of threads and
+ * w the number of distinct words, as for a single file.
+ */
+bool parallel_index_files(WordIndex *index, const IndexOptions *options, FileList *files);
+
+
+#endif /**< PARALLEL_UTILITY_H */
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "position_utility.h"
+#include "constants.h"
+
+
+/* Records the position of an occurrence of a word */
+void position_add(WordEntry *entry, const Position *position) {
+
+    PositionPostings *postings = entry->positions;
+
+    if (postings == NULL) {
+        postings = (PositionPostings *) validated_memory_allocation(sizeof(PositionPostings));
+        postings->data = NULL;
+        postings->length = 0;
+        postings->capacity = 0;
+        postings->last_line = 0;
+        postings->last_offset = 0;
+        entry->positions = postings;
+    }
+
+    /* Make room for the three values of the occurrence */
+    if (postings->length + 3 * MAX_VARINT_BYTES > postings->capacity) {
+        postings->capacity = postings->capacity == 0 ? 4 * MAX_VARINT_BYTES : 2 * postings->capacity;
+        postings->data = (unsigned char *) validated_memory_reallocation(postings->data, postings->capacity);
+    }
+
+    /* Lines and offsets never decrease along the file, so only the deltas are stored */
+    postings->length += encode_varint((unsigned long) (position->line - postings->last_line), postings->data + postings->length);
+    postings->length += encode_varint((unsigned long) position->column, postings->data + postings->length);
+    postings->length += encode_varint(position->offset - postings->last_offset, postings->data + postings->length);
+
+    postings->last_line = position->line;
+    postings->last_offset = position->offset;
+}
+
+/* Appends the positions of a word recorded over a later part of the file */
+void position_append(WordEntry *entry, const WordEntry *source, int line_base, unsigned long offset_base) {
+
+    PositionPostings *postings;
+    PositionCursor cursor;
+    Position position;
+    size_t rest;
+
+    position_cursor_init(&cursor, source);
+    if (!position_next(&cursor, &position)) {
+        return;
+    }
+
+    /* Only the first occurrence is encoded against the start of the part */
+    position.line += line_base;
+    position.offset += offset_base;
+    position_add(entry, &position);
+
+    postings = entry->positions;
+    rest = (size_t) (cursor.end - cursor.next);
+    if (postings->length + rest > postings->capacity) {
+        postings->capacity = 2 * postings->capacity > postings->length + rest ? 2 * postings->capacity : postings->length + rest;
+        postings->data = (unsigned char *) validated_memory_reallocation(postings->data, postings->capacity);
+    }
+    memcpy(postings->data + postings->length, cursor.next, rest);
+    postings->length += rest;
+
+    postings->last_line = source->positions->last_line + line_base;
+    postings->last_offset = source->positions->last_offset + offset_base;
+}
+
+/* Initializes a cursor over the positions of a word */
+void position_cursor_init(PositionCursor *cursor, const WordEntry *entry) {
+
+    cursor->next = NULL;
+    cursor->end = NULL;
+    cursor->line = 0;
+    cursor->offset = 0;
+
+    if (entry->positions != NULL) {
+        cursor->next = entry->positions->data;
+        cursor->end = entry->positions->data + entry->positions->length;
+    }
+}
+
+/* Reads the next variable-length integer of the positions, returns FALSE if it is truncated */
+static bool read_value(PositionCursor *cursor, unsigned long *value) {
+
+    size_t length = decode_varint(cursor->next, cursor->end, value);
+
+    cursor->next += length;
+    return length > 0 ? TRUE : FALSE;
+}
+
+/* Decodes the next position of a word */
+bool position_next(PositionCursor *cursor, Position *position) {
+
+    unsigned long line_delta, column, offset_delta;
+
+    if (cursor->next == cursor->end ||
+        !read_value(cursor, &line_delta) || !read_value(cursor, &column) || !read_value(cursor, &offset_delta)) {
+        return FALSE;
+    }
+
+    cursor->line += (int) line_delta;
+    cursor->offset += offset_delta;
+
+    position->line = cursor->line;
+    position->column = (int) column;
+    position->offset = cursor->offset;
+    return TRUE;
+}
+
+/* Prints the positions of a word */
+void print_word_positions(FILE *out, const WordEntry *entry) {
+
+    PositionCursor cursor;
+    Position position;
+
+    fprintf(out, "%s - appears at", entry->word);
+
+    position_cursor_init(&cursor, entry);
+    while (position_next(&cursor, &position)) {
+        fprintf(out, " %d:%d@%lu", position.line, position.column, position.offset);
+    }
+    fprintf(out, "%s", NEW_LINE);
+}
+
+/* Prints every occurrence of a word with the text around it */
+void print_word_contexts(FILE *out, const WordEntry *entry, const MappedFile *mapped, int context) {
+
+    PositionCursor cursor;
+    Position position;
+    size_t word_length = strlen(entry->word);
+    size_t line_start, start, end, limit;
+
+    position_cursor_init(&cursor, entry);
+    while (position_next(&cursor, &position)) {
+
+        /* The file changed since it was indexed */
+        if (position.offset + word_length > mapped->size) {
+            break;
+        }
+
+        /* The column locates the start of the line without scanning back for it */
+        line_start = (size_t) position.offset - (size_t) (position.column - 1);
+        start = (size_t) position.offset;
+        start = start - line_start > (size_t) context ? start - (size_t) context : line_start;
+
+        end = (size_t) position.offset + word_length;
+        limit = mapped->size - end > (size_t) context ? end + (size_t) context : mapped->size;
+        while (end < limit && mapped->data[end] != '\n') {
+            end++;
+        }
+
+        /* Keep multibyte characters whole at both ends of the snippet */
+        while (start < (size_t) position.offset && ((unsigned char) mapped->data[start] & 0xC0) == 0x80) {
+            start++;
+        }
+        while (end < mapped->size && end > (size_t) position.offset + word_length &&
+               ((unsigned char) mapped->data[end] & 0xC0) == 0x80) {
+            end--;
+        }
+
+        fprintf(out, "%s - %d:%d: %.*s%s", entry->word, position.line, position.column,
+                (int) (end - start), mapped->data + start, NEW_LINE);
+    }
+}
+
+/* Frees the positions of a word */
+void position_free(WordEntry *entry) {
+
+    if (entry->positions != NULL) {
+        free(entry->positions->data);
+        free(entry->positions);
+        entry->positions = NULL;
+    }
+}
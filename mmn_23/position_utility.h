@@ -0,0 +1,135 @@
+/**
+ * @file position_utility.h
+ * @brief Header file containing the position postings of the words of the index.
+ *
+ * This header file defines the optional position postings of a word: the line, the column
+ * and the byte offset of every occurrence. The positions are stored as a byte stream of
+ * variable-length integers, with the line and the byte offset delta-encoded against the
+ * previous occurrence, so most occurrences take three to five bytes.
+ *
+ * The byte offsets let the context of an occurrence be read straight from a mapping of
+ * the indexed file, without scanning the line for the word again.
+ */
+
+#ifndef POSITION_UTILITY_H
+#define POSITION_UTILITY_H
+
+#include "globals.h"
+#include "utility.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Structure to represent the encoded positions of a word.
+ */
+typedef struct PositionPostings {
+    unsigned char *data;       /**< The encoded positions (line delta, column, offset delta per occurrence). */
+    size_t length;             /**< The number of bytes used. */
+    size_t capacity;           /**< The number of bytes allocated. */
+    int last_line;             /**< The line of the last occurrence, the base of the next line delta. */
+    unsigned long last_offset; /**< The byte offset of the last occurrence, the base of the next offset delta. */
+} PositionPostings;
+
+/**
+ * @brief Structure to represent the position of an occurrence of a word.
+ */
+typedef struct {
+    int line;             /**< The line number, starting at 1. */
+    int column;           /**< The byte column in the line, starting at 1. */
+    unsigned long offset; /**< The byte offset in the file, starting at 0. */
+} Position;
+
+/**
+ * @brief Structure to represent a cursor decoding the positions of a word in order.
+ */
+typedef struct {
+    const unsigned char *next; /**< The next encoded byte. */
+    const unsigned char *end;  /**< The end of the encoded positions. */
+    int line;                  /**< The line of the last decoded occurrence. */
+    unsigned long offset;      /**< The byte offset of the last decoded occurrence. */
+} PositionCursor;
+
+/**
+ * @brief Records the position of an occurrence of a word.
+ *
+ * The occurrences must be recorded in the order of the file.
+ *
+ * @param[in,out] entry - The entry of the word. Its postings are allocated on the first occurrence.
+ * @param[in] position - The position of the occurrence.
+ *
+ * @complexity
+ * Time Complexity: O(1) amortized.
+ */
+void position_add(WordEntry *entry, const Position *position);
+
+/**
+ * @brief Appends the positions of a word recorded over a later part of the file.
+ *
+ * The positions of the source were recorded from the start of that part, so their lines and
+ * byte offsets are shifted by the lines and bytes before it. Only the first occurrence is encoded
+ * again, the deltas of the others are copied unchanged.
+ *
+ * @param[in,out] entry - The entry of the word. Its positions must all precede those of the source.
+ * @param[in] source - The entry holding the positions to append.
+ * @param[in] line_base - The number of lines before the part of the source.
+ * @param[in] offset_base - The number of bytes before the part of the source.
+ *
+ * @complexity
+ * Time Complexity: O(k), where k is the number of bytes of the positions of the source.
+ */
+void position_append(WordEntry *entry, const WordEntry *source, int line_base, unsigned long offset_base);
+
+/**
+ * @brief Initializes a cursor over the positions of a word.
+ *
+ * @param[out] cursor - The cursor to initialize.
+ * @param[in] entry - The entry of the word. An entry without positions yields none.
+ */
+void position_cursor_init(PositionCursor *cursor, const WordEntry *entry);
+
+/**
+ * @brief Decodes the next position of a word.
+ *
+ * @param[in,out] cursor - The cursor.
+ * @param[out] position - The decoded position.
+ *
+ * @return TRUE if a position was decoded, FALSE at the end of the positions.
+ */
+bool position_next(PositionCursor *cursor, Position *position);
+
+/**
+ * @brief Prints the positions of a word, as "word - appears at line:column@offset ...".
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] entry - The entry of the word.
+ *
+ * @complexity
+ * Time Complexity: O(k), where k is the number of occurrences of the word.
+ */
+void print_word_positions(FILE *out, const WordEntry *entry);
+
+/**
+ * @brief Prints every occurrence of a word with the text around it, one occurrence per line.
+ *
+ * The snippet is taken from the mapped file at the byte offset of the occurrence. It extends
+ * up to context bytes on each side of the word, without crossing the ends of the line.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] entry - The entry of the word.
+ * @param[in] mapped - The mapping of the indexed file.
+ * @param[in] context - The number of bytes of context on each side of the word.
+ *
+ * @complexity
+ * Time Complexity: O(k * c), where k is the number of occurrences and c the context size.
+ */
+void print_word_contexts(FILE *out, const WordEntry *entry, const MappedFile *mapped, int context);
+
+/**
+ * @brief Frees the positions of a word.
+ *
+ * @param[in,out] entry - The entry of the word.
+ */
+void position_free(WordEntry *entry);
+
+
+#endif /**< POSITION_UTILITY_H */
@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * @file postings_bench.c
+ * @brief Benchmark of the intersection kernels of postings_utility.h against the line list walk.
+ *
+ * For pairs of lists of several lengths, the lines common to two words are computed by walking
+ * their linked lists of line numbers side by side, as the index stores them, and by every
+ * kernel on sorted arrays of the same lines. The list nodes of the two words are taken from one
+ * node pool in the order of their lines, as indexing interleaves them. The time of collecting
+ * the arrays from the lists is reported separately, for a query that does not keep them.
+ *
+ * Usage: postings_bench [scale], where scale divides the list lengths (1 by default).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "postings_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Number of lines the benchmark lists are drawn from.
+ */
+#define BENCH_UNIVERSE (1U << 24)
+
+/**
+ * @brief Number of input lines processed per measurement, over repetitions.
+ */
+#define BENCH_WORK 40000000UL
+
+/**
+ * @brief Structure to represent a pair of lists of the benchmark.
+ */
+typedef struct {
+    size_t short_length; /**< The number of lines of the shorter list. */
+    size_t long_length;  /**< The number of lines of the longer list. */
+} BenchCase;
+
+/**
+ * @brief The pairs of lists, from equal lengths to a ratio of 1000.
+ */
+static const BenchCase bench_cases[] = {
+    {1000000, 1000000}, {250000, 1000000}, {50000, 1000000}, {10000, 1000000}, {1000, 1000000}, {1000, 1000}
+};
+
+/**
+ * @brief State of the pseudo-random generator (xorshift), fixed so runs are comparable.
+ */
+static unsigned long random_state = 88172645463325252UL;
+
+/* Returns the next pseudo-random number */
+static unsigned long next_random(void) {
+
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/* Compares two line numbers */
+static int compare_lines(const void *a, const void *b) {
+
+    unsigned int line_a = *(const unsigned int *) a;
+    unsigned int line_b = *(const unsigned int *) b;
+
+    return (line_a > line_b) - (line_a < line_b);
+}
+
+/* Sorts lines and removes the duplicates, returns the number of distinct lines */
+static size_t sort_distinct(unsigned int *lines, size_t length) {
+
+    size_t i, k = 0;
+
+    qsort(lines, length, sizeof(unsigned int), compare_lines);
+    FOR_RANGE(i, length) {
+        if (k == 0 || lines[k - 1] != lines[i]) {
+            lines[k++] = lines[i];
+        }
+    }
+    return k;
+}
+
+/* Returns the current time in seconds */
+static double now_seconds(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/* Builds the line lists of two words, with their nodes interleaved in one pool in line order */
+static void build_lists(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                        NodePool *pool, WordEntry *entry_a, WordEntry *entry_b) {
+
+    size_t i = 0, j = 0;
+
+    memset(entry_a, 0, sizeof(WordEntry));
+    memset(entry_b, 0, sizeof(WordEntry));
+    while (i < a_length || j < b_length) {
+        if (j == b_length || (i < a_length && a[i] <= b[j])) {
+            entry_add_line(entry_a, pool, (int) a[i++]);
+        }
+        else {
+            entry_add_line(entry_b, pool, (int) b[j++]);
+        }
+    }
+}
+
+/* Intersects the line lists of two words by walking them side by side */
+static size_t intersect_lists(const ListNode *a, const ListNode *b, unsigned int *out) {
+
+    size_t k = 0;
+
+    while (a != NULL && b != NULL) {
+        if (a->line_number < b->line_number) {
+            a = a->next;
+        }
+        else if (b->line_number < a->line_number) {
+            b = b->next;
+        }
+        else {
+            out[k++] = (unsigned int) a->line_number;
+            a = a->next;
+            b = b->next;
+        }
+    }
+    return k;
+}
+
+/* Runs one pair of lists and prints the time of every method */
+static void run_case(const BenchCase *bench_case, int scale) {
+
+    size_t short_length = bench_case->short_length / (size_t) scale;
+    size_t long_length = bench_case->long_length / (size_t) scale;
+    unsigned int *a = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (short_length + 1));
+    unsigned int *b = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (long_length + 1));
+    unsigned int *expected = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (short_length + 1));
+    unsigned int *out = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (short_length + 1));
+    unsigned int *lines_a = NULL, *lines_b = NULL;
+    size_t capacity_a = 0, capacity_b = 0;
+    size_t i, expected_length = 0, length = 0;
+    unsigned long repetitions, r;
+    WordEntry entry_a, entry_b;
+    NodePool pool;
+    double start, list_time, elapsed;
+    int kernel;
+
+    /* The longer list is random, half of the shorter one is taken from it so the lists share lines */
+    FOR_RANGE(i, long_length) {
+        b[i] = (unsigned int) (next_random() % BENCH_UNIVERSE);
+    }
+    long_length = sort_distinct(b, long_length);
+    FOR_RANGE(i, short_length) {
+        a[i] = (i % 2 == 0) ? b[next_random() % long_length] : (unsigned int) (next_random() % BENCH_UNIVERSE);
+    }
+    short_length = sort_distinct(a, short_length);
+
+    node_pool_init(&pool);
+    build_lists(a, short_length, b, long_length, &pool, &entry_a, &entry_b);
+    repetitions = BENCH_WORK / (short_length + long_length) + 1;
+
+    printf("%8lu x %-8lu", (unsigned long) short_length, (unsigned long) long_length);
+
+    /* The line list walk is the baseline */
+    start = now_seconds();
+    for (r = 0; r < repetitions; r++) {
+        expected_length = intersect_lists(entry_a.lines, entry_b.lines, expected);
+    }
+    list_time = (now_seconds() - start) / (double) repetitions;
+    printf(" %9.1f", list_time * 1e6);
+
+    /* Collecting the arrays from the lists, once per query if they are not kept */
+    start = now_seconds();
+    for (r = 0; r < repetitions; r++) {
+        length = postings_collect_lines(&entry_a, &lines_a, &capacity_a);
+        length += postings_collect_lines(&entry_b, &lines_b, &capacity_b);
+    }
+    elapsed = (now_seconds() - start) / (double) repetitions;
+    printf(" %9.1f", elapsed * 1e6);
+    if (length != short_length + long_length) {
+        printf(" collect mismatch");
+    }
+
+    FOR_RANGE(kernel, POSTINGS_KERNELS) {
+        if (!postings_kernel_supported((PostingsKernel) kernel)) {
+            printf(" %15s", "-");
+            continue;
+        }
+        start = now_seconds();
+        for (r = 0; r < repetitions; r++) {
+            length = postings_intersect(a, short_length, b, long_length, out, (PostingsKernel) kernel);
+        }
+        elapsed = (now_seconds() - start) / (double) repetitions;
+
+        /* Every kernel must find exactly the lines the list walk finds */
+        if (length != expected_length || memcmp(out, expected, sizeof(unsigned int) * length) != 0) {
+            printf(" %15s", "MISMATCH");
+            continue;
+        }
+        printf(" %7.1f (%5.1fx)", elapsed * 1e6, list_time / elapsed);
+    }
+    printf("%s", NEW_LINE);
+
+    node_pool_free(&pool);
+    free(lines_a);
+    free(lines_b);
+    free(a);
+    free(b);
+    free(expected);
+    free(out);
+}
+
+int main(int argc, char *argv[]) {
+
+    int scale = argc > 1 ? atoi(argv[1]) : 1;
+    size_t i;
+    int kernel;
+
+    if (scale <= 0) {
+        scale = 1;
+    }
+
+    printf("Intersection of two line lists, microseconds per intersection (speedup over the list walk)%s", NEW_LINE);
+    printf("%-19s %9s %9s", "lines", "list", "collect");
+    FOR_RANGE(kernel, POSTINGS_KERNELS) {
+        printf(" %15s", postings_kernel_name((PostingsKernel) kernel));
+    }
+    printf("%s", NEW_LINE);
+
+    FOR_RANGE(i, sizeof(bench_cases) / sizeof(bench_cases[0])) {
+        run_case(&bench_cases[i], scale);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,380 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "postings_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+/**
+ * @brief Defined when the SIMD kernels are compiled in, on x86-64 with GCC or Clang.
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POSTINGS_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief Names of the kernels, in the order of PostingsKernel.
+ */
+static const char *const kernel_names[POSTINGS_KERNELS] = {"auto", "scalar", "galloping", "sse", "avx2"};
+
+/**
+ * @brief Whether each kernel can run on this CPU, set once by detect_kernels.
+ */
+static bool kernel_supported[POSTINGS_KERNELS];
+
+/**
+ * @brief Guards the single run of detect_kernels.
+ */
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+#ifdef POSTINGS_SIMD
+/**
+ * @brief Byte shuffles moving the 32-bit lanes selected by a 4-bit mask to the front of a vector.
+ */
+static unsigned char sse_shuffles[16][16];
+
+/**
+ * @brief Lane permutations moving the 32-bit lanes selected by an 8-bit mask to the front of a vector.
+ */
+static unsigned int avx2_permutes[256][8];
+#endif
+
+/* Detects the kernels the CPU supports and builds the compaction tables of the SIMD kernels */
+static void detect_kernels(void) {
+
+#ifdef POSTINGS_SIMD
+    int mask, lane, used, byte;
+
+    /* Every table entry lists the selected lanes first, the other lanes are not kept */
+    FOR_RANGE(mask, 16) {
+        used = 0;
+        memset(sse_shuffles[mask], 0x80, sizeof(sse_shuffles[mask]));
+        FOR_RANGE(lane, 4) {
+            if (mask & (1 << lane)) {
+                FOR_RANGE(byte, 4) {
+                    sse_shuffles[mask][4 * used + byte] = (unsigned char) (4 * lane + byte);
+                }
+                used++;
+            }
+        }
+    }
+    FOR_RANGE(mask, 256) {
+        used = 0;
+        memset(avx2_permutes[mask], 0, sizeof(avx2_permutes[mask]));
+        FOR_RANGE(lane, 8) {
+            if (mask & (1 << lane)) {
+                avx2_permutes[mask][used++] = (unsigned int) lane;
+            }
+        }
+    }
+
+    __builtin_cpu_init();
+    kernel_supported[POSTINGS_SSE] = __builtin_cpu_supports("ssse3") ? TRUE : FALSE;
+    kernel_supported[POSTINGS_AVX2] = __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+#endif
+
+    kernel_supported[POSTINGS_AUTO] = TRUE;
+    kernel_supported[POSTINGS_SCALAR] = TRUE;
+    kernel_supported[POSTINGS_GALLOPING] = TRUE;
+}
+
+/* Checks whether a kernel can run on this CPU */
+bool postings_kernel_supported(PostingsKernel kernel) {
+
+    pthread_once(&kernels_once, detect_kernels);
+    return (kernel >= 0 && kernel < POSTINGS_KERNELS) ? kernel_supported[kernel] : FALSE;
+}
+
+/* Returns the name of a kernel */
+const char *postings_kernel_name(PostingsKernel kernel) {
+
+    return (kernel >= 0 && kernel < POSTINGS_KERNELS) ? kernel_names[kernel] : "unknown";
+}
+
+/* Intersects two sorted arrays with a scalar merge */
+static size_t intersect_scalar(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                               unsigned int *out) {
+
+    size_t i = 0, j = 0, k = 0;
+
+    while (i < a_length && j < b_length) {
+        if (a[i] < b[j]) {
+            i++;
+        }
+        else if (b[j] < a[i]) {
+            j++;
+        }
+        else {
+            out[k++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    return k;
+}
+
+/* Finds the first position from a start whose line is not below a value, by galloping then bisecting */
+static size_t gallop(const unsigned int *lines, size_t length, size_t start, unsigned int value) {
+
+    size_t step = 1;
+    size_t low = start, high;
+
+    /* Double the step until the value is passed, it is then in the last step */
+    while (start + step < length && lines[start + step] < value) {
+        low = start + step;
+        step *= 2;
+    }
+    high = start + step < length ? start + step : length;
+    if (low < high && lines[low] >= value) {
+        return low;
+    }
+
+    /* lines[low] < value <= lines[high], or high is the end */
+    while (high - low > 1) {
+        if (lines[low + (high - low) / 2] < value) {
+            low += (high - low) / 2;
+        }
+        else {
+            high = low + (high - low) / 2;
+        }
+    }
+    return high;
+}
+
+/* Intersects two sorted arrays by galloping through the longer one */
+static size_t intersect_galloping(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                                  unsigned int *out) {
+
+    const unsigned int *swap;
+    size_t i, j = 0, k = 0;
+
+    if (a_length > b_length) {
+        swap = a;
+        a = b;
+        b = swap;
+        i = a_length;
+        a_length = b_length;
+        b_length = i;
+    }
+
+    for (i = 0; i < a_length && j < b_length; i++) {
+        j = gallop(b, b_length, j, a[i]);
+        if (j < b_length && b[j] == a[i]) {
+            out[k++] = a[i];
+            j++;
+        }
+    }
+    return k;
+}
+
+#ifdef POSTINGS_SIMD
+/* Intersects two sorted arrays in blocks of 4 lines with SSE */
+__attribute__((target("ssse3")))
+static size_t intersect_sse(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                            unsigned int *out) {
+
+    __m128i block_a, block_b, equal;
+    size_t i = 0, j = 0, k = 0;
+    unsigned int last_a, last_b;
+    int mask;
+
+    while (i + 4 <= a_length && j + 4 <= b_length) {
+        block_a = _mm_loadu_si128((const __m128i *) (a + i));
+        block_b = _mm_loadu_si128((const __m128i *) (b + j));
+
+        /* Compare every line of the block of a with every rotation of the block of b */
+        equal = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(block_a, block_b),
+                         _mm_cmpeq_epi32(block_a, _mm_shuffle_epi32(block_b, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(block_a, _mm_shuffle_epi32(block_b, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(block_a, _mm_shuffle_epi32(block_b, _MM_SHUFFLE(2, 1, 0, 3)))));
+        mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+
+        /* The common lines are moved to the front, the whole block is stored and only they are kept */
+        _mm_storeu_si128((__m128i *) (out + k),
+                         _mm_shuffle_epi8(block_a, _mm_loadu_si128((const __m128i *) sse_shuffles[mask])));
+        k += (size_t) __builtin_popcount((unsigned int) mask);
+
+        /* The block with the smaller last line cannot match any later block of the other array */
+        last_a = a[i + 3];
+        last_b = b[j + 3];
+        if (last_a <= last_b) {
+            i += 4;
+        }
+        if (last_b <= last_a) {
+            j += 4;
+        }
+    }
+    return k + intersect_scalar(a + i, a_length - i, b + j, b_length - j, out + k);
+}
+
+/* Intersects two sorted arrays in blocks of 8 lines with AVX2 */
+__attribute__((target("avx2")))
+static size_t intersect_avx2(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                             unsigned int *out) {
+
+    __m256i block_a, block_b, equal;
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    size_t i = 0, j = 0, k = 0;
+    unsigned int last_a, last_b;
+    int mask, r;
+
+    while (i + 8 <= a_length && j + 8 <= b_length) {
+        block_a = _mm256_loadu_si256((const __m256i *) (a + i));
+        block_b = _mm256_loadu_si256((const __m256i *) (b + j));
+
+        /* Compare every line of the block of a with every rotation of the block of b */
+        equal = _mm256_cmpeq_epi32(block_a, block_b);
+        for (r = 1; r < 8; r++) {
+            block_b = _mm256_permutevar8x32_epi32(block_b, rotate);
+            equal = _mm256_or_si256(equal, _mm256_cmpeq_epi32(block_a, block_b));
+        }
+        mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+
+        /* The common lines are moved to the front, the whole block is stored and only they are kept */
+        _mm256_storeu_si256((__m256i *) (out + k),
+                            _mm256_permutevar8x32_epi32(block_a,
+                                                        _mm256_loadu_si256((const __m256i *) avx2_permutes[mask])));
+        k += (size_t) __builtin_popcount((unsigned int) mask);
+
+        /* The block with the smaller last line cannot match any later block of the other array */
+        last_a = a[i + 7];
+        last_b = b[j + 7];
+        if (last_a <= last_b) {
+            i += 8;
+        }
+        if (last_b <= last_a) {
+            j += 8;
+        }
+    }
+    return k + intersect_scalar(a + i, a_length - i, b + j, b_length - j, out + k);
+}
+#endif
+
+/* Intersects two sorted arrays of distinct line numbers */
+size_t postings_intersect(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                          unsigned int *out, PostingsKernel kernel) {
+
+    size_t shorter = a_length < b_length ? a_length : b_length;
+    size_t longer = a_length < b_length ? b_length : a_length;
+
+    if (kernel == POSTINGS_AUTO) {
+        /* Gallop over far longer arrays, merge with the widest SIMD kernel otherwise */
+        if (longer / POSTINGS_GALLOP_RATIO >= shorter) {
+            kernel = POSTINGS_GALLOPING;
+        }
+        else {
+            kernel = postings_kernel_supported(POSTINGS_AVX2) ? POSTINGS_AVX2 :
+                     postings_kernel_supported(POSTINGS_SSE) ? POSTINGS_SSE : POSTINGS_SCALAR;
+        }
+    }
+    else if (!postings_kernel_supported(kernel)) {
+        kernel = POSTINGS_SCALAR;
+    }
+
+    switch (kernel) {
+        case POSTINGS_GALLOPING:
+            return intersect_galloping(a, a_length, b, b_length, out);
+#ifdef POSTINGS_SIMD
+        case POSTINGS_SSE:
+            return intersect_sse(a, a_length, b, b_length, out);
+        case POSTINGS_AVX2:
+            return intersect_avx2(a, a_length, b, b_length, out);
+#endif
+        default:
+            return intersect_scalar(a, a_length, b, b_length, out);
+    }
+}
+
+/* Merges two sorted arrays of distinct line numbers into their union */
+size_t postings_union(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                      unsigned int *out) {
+
+    size_t i = 0, j = 0, k = 0;
+
+    while (i < a_length && j < b_length) {
+        if (a[i] < b[j]) {
+            out[k++] = a[i++];
+        }
+        else if (b[j] < a[i]) {
+            out[k++] = b[j++];
+        }
+        else {
+            out[k++] = a[i++];
+            j++;
+        }
+    }
+    while (i < a_length) {
+        out[k++] = a[i++];
+    }
+    while (j < b_length) {
+        out[k++] = b[j++];
+    }
+    return k;
+}
+
+/* Removes the lines of a sorted array from another one */
+size_t postings_difference(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                           unsigned int *out) {
+
+    bool galloping = (b_length / POSTINGS_GALLOP_RATIO >= a_length) ? TRUE : FALSE;
+    size_t i, j = 0, k = 0;
+
+    FOR_RANGE(i, a_length) {
+        if (galloping) {
+            j = gallop(b, b_length, j, a[i]);
+        }
+        else {
+            while (j < b_length && b[j] < a[i]) {
+                j++;
+            }
+        }
+        if (j == b_length || b[j] != a[i]) {
+            out[k++] = a[i];
+        }
+    }
+    return k;
+}
+
+/* Appends a line to a sorted array unless it is its last line */
+static size_t append_line(unsigned int **lines, size_t *capacity, size_t length, unsigned int line) {
+
+    if (length > 0 && (*lines)[length - 1] == line) {
+        return length;
+    }
+    if (length == *capacity) {
+        *capacity = *capacity == 0 ? 64 : 2 * *capacity;
+        *lines = (unsigned int *) validated_memory_reallocation(*lines, sizeof(unsigned int) * *capacity);
+    }
+    (*lines)[length] = line;
+    return length + 1;
+}
+
+/* Collects the distinct lines of a word into a sorted array */
+size_t postings_collect_lines(const WordEntry *entry, unsigned int **lines, size_t *capacity) {
+
+    const ListNode *curr;
+    const unsigned char *data, *end;
+    unsigned long delta;
+    size_t used, length = 0;
+    unsigned int line = 0;
+    int count;
+
+    for (curr = entry->lines; curr != NULL; curr = curr->next) {
+        length = append_line(lines, capacity, length, (unsigned int) curr->line_number);
+    }
+
+    if (entry->postings != NULL) {
+        data = entry->postings->data;
+        end = data + entry->postings->length;
+        while ((used = decode_posting(data, end, &delta, &count)) > 0) {
+            line += (unsigned int) delta;
+            length = append_line(lines, capacity, length, line);
+            data += used;
+        }
+    }
+    return length;
+}
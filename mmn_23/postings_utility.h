@@ -0,0 +1,143 @@
+/**
+ * @file postings_utility.h
+ * @brief Header file containing the set operations on sorted arrays of line numbers.
+ *
+ * This header file defines the kernels that answer queries of several words: the intersection,
+ * the union and the difference of the lines of words, as sorted arrays of distinct 32-bit line
+ * numbers. The line list of a word is collected into such an array once (for every word of the
+ * served index, in its snapshot), and the kernels then work on contiguous memory instead of
+ * following list nodes scattered across the node blocks.
+ *
+ * The intersection has several kernels:
+ * - A scalar merge of the two arrays, linear in their total length.
+ * - A galloping search of every line of the shorter array in the longer one, which skips most
+ *   of the longer array when the lengths are far apart.
+ * - SSE and AVX2 block merges, which compare a block of 4 (or 8) lines of each array against
+ *   all the rotations of the other block at once, and compact the common lines with a shuffle.
+ *
+ * The SIMD kernels are compiled for their instruction sets regardless of the compiler flags,
+ * and chosen at run time by the features of the CPU. The automatic kernel gallops when the
+ * longer array is at least POSTINGS_GALLOP_RATIO times longer than the shorter one, and uses
+ * the widest SIMD kernel the CPU supports otherwise.
+ */
+
+#ifndef POSTINGS_UTILITY_H
+#define POSTINGS_UTILITY_H
+
+#include "globals.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Ratio of the lengths of two arrays from which the automatic intersection gallops.
+ */
+#define POSTINGS_GALLOP_RATIO 32
+
+/**
+ * @brief The kernels of the intersection of sorted arrays.
+ */
+typedef enum {
+    POSTINGS_AUTO,      /**< Chosen by the ratio of the lengths and the features of the CPU. */
+    POSTINGS_SCALAR,    /**< Scalar merge. */
+    POSTINGS_GALLOPING, /**< Galloping search of the shorter array in the longer one. */
+    POSTINGS_SSE,       /**< Blocks of 4 lines, with SSSE3 shuffles. */
+    POSTINGS_AVX2,      /**< Blocks of 8 lines, with AVX2 permutes. */
+    POSTINGS_KERNELS    /**< The number of kernels. */
+} PostingsKernel;
+
+/**
+ * @brief Checks whether a kernel can run on this CPU.
+ *
+ * @param[in] kernel - The kernel.
+ *
+ * @return TRUE if the kernel is compiled in and the CPU has its instruction set, FALSE otherwise.
+ */
+bool postings_kernel_supported(PostingsKernel kernel);
+
+/**
+ * @brief Returns the name of a kernel, as printed by the benchmark.
+ *
+ * @param[in] kernel - The kernel.
+ *
+ * @return The name of the kernel.
+ */
+const char *postings_kernel_name(PostingsKernel kernel);
+
+/**
+ * @brief Intersects two sorted arrays of distinct line numbers.
+ *
+ * @param[in] a - The first array.
+ * @param[in] a_length - The length of the first array.
+ * @param[in] b - The second array.
+ * @param[in] b_length - The length of the second array.
+ * @param[out] out - The lines in both arrays, sorted. It must have room for the length of the
+ *                   shorter array, and must not be one of the arrays.
+ * @param[in] kernel - The kernel. A kernel the CPU does not support falls back to the scalar merge.
+ *
+ * @return The number of lines in both arrays.
+ *
+ * @complexity
+ * Time Complexity: O(n + m) for the merges, O(n * log(m / n)) for the galloping search of the
+ * n lines of the shorter array in the m lines of the longer one.
+ */
+size_t postings_intersect(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                          unsigned int *out, PostingsKernel kernel);
+
+/**
+ * @brief Merges two sorted arrays of distinct line numbers into their union.
+ *
+ * @param[in] a - The first array.
+ * @param[in] a_length - The length of the first array.
+ * @param[in] b - The second array.
+ * @param[in] b_length - The length of the second array.
+ * @param[out] out - The lines in either array, sorted. It must have room for a_length + b_length
+ *                   lines, and must not be one of the arrays.
+ *
+ * @return The number of lines in either array.
+ *
+ * @complexity
+ * Time Complexity: O(n + m).
+ */
+size_t postings_union(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                      unsigned int *out);
+
+/**
+ * @brief Removes the lines of a sorted array from another one.
+ *
+ * The lines of a are looked up by galloping in b when b is at least POSTINGS_GALLOP_RATIO times
+ * longer, and the arrays are merged otherwise.
+ *
+ * @param[in] a - The array to remove the lines from.
+ * @param[in] a_length - The length of the array a.
+ * @param[in] b - The lines to remove.
+ * @param[in] b_length - The length of the array b.
+ * @param[out] out - The lines of a that are not in b, sorted. It must have room for a_length lines,
+ *                   and may be the array a.
+ *
+ * @return The number of lines of a that are not in b.
+ *
+ * @complexity
+ * Time Complexity: O(n + m), or O(n * log(m / n)) when galloping.
+ */
+size_t postings_difference(const unsigned int *a, size_t a_length, const unsigned int *b, size_t b_length,
+                           unsigned int *out);
+
+/**
+ * @brief Collects the distinct lines of a word into a sorted array.
+ *
+ * The lines are read from the line list of the entry and then from its compressed postings,
+ * and a line where the word occurs several times is collected once.
+ *
+ * @param[in] entry - The entry of the word.
+ * @param[in,out] lines - The array, grown as needed. It may be NULL, and must be freed by the caller.
+ * @param[in,out] capacity - The number of lines allocated in the array.
+ *
+ * @return The number of distinct lines of the word.
+ *
+ * @complexity
+ * Time Complexity: O(k), where k is the number of occurrences of the word.
+ */
+size_t postings_collect_lines(const WordEntry *entry, unsigned int **lines, size_t *capacity);
+
+
+#endif /**< POSTINGS_UTILITY_H */
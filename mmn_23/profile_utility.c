@@ -0,0 +1,363 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <execinfo.h>
+#include <link.h>
+#include <elf.h>
+
+#include "profile_utility.h"
+#include "error_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Number of frames of the handler at the top of every stack, before the interrupted frame.
+ *
+ * The handler itself and the trampoline the kernel returns through.
+ */
+#define PROFILE_SKIP_FRAMES 2
+
+/**
+ * @brief A function of the symbol table of the executable.
+ */
+typedef struct {
+    unsigned long address; /**< The address of the function, relative to the load address. */
+    unsigned long size;    /**< The size of the function in bytes, 0 if unknown. */
+    const char *name;      /**< The name of the function, in the mapped executable. */
+} ProfileSymbol;
+
+/**
+ * @brief A loaded object of the process: the executable or a shared library.
+ */
+typedef struct {
+    unsigned long start; /**< The lowest address of its loaded segments. */
+    unsigned long end;   /**< The end of its loaded segments. */
+    unsigned long base;  /**< The load address its symbol addresses are relative to. */
+    const char *name;    /**< Its path, empty for the executable. */
+} ProfileObject;
+
+/**
+ * @brief The symbols and the objects the sampled addresses are resolved with.
+ */
+typedef struct {
+    MappedFile image;        /**< The mapped executable, holding the names of the symbols. */
+    ProfileSymbol *symbols;  /**< The functions of the executable, sorted by address. */
+    size_t num_symbols;      /**< The number of functions. */
+    ProfileObject *objects;  /**< The loaded objects, the executable first. */
+    size_t num_objects;      /**< The number of objects. */
+    size_t objects_capacity; /**< The number of objects allocated. */
+} ProfileResolver;
+
+/**
+ * @brief The state shared by the signal handler and the profiler.
+ *
+ * A sample is its number of frames followed by the frames, from the interrupted one to the root.
+ * The number is written last, so a sample being written when the profiler stops reads as the end.
+ */
+static struct {
+    unsigned long *frames;          /**< The sample buffer of PROFILE_BUFFER_FRAMES frames, zeroed. */
+    volatile unsigned long used;    /**< The number of frames reserved, past the buffer once it is full. */
+    volatile unsigned long dropped; /**< The number of samples that did not fit. */
+    volatile sig_atomic_t active;   /**< Nonzero while the samples are recorded. */
+    struct sigaction previous;      /**< The action of SIGPROF before the profiler. */
+} profiler;
+
+/* Records the stack of the interrupted thread, only with async-signal-safe operations */
+static void profile_handler(int signal_number) {
+
+    void *stack[PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES];
+    unsigned long slot;
+    int saved_errno = errno;
+    int depth, i;
+
+    (void) signal_number;
+
+    if (profiler.active) {
+        depth = backtrace(stack, PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES) - PROFILE_SKIP_FRAMES;
+        if (depth > 0) {
+            slot = __sync_fetch_and_add(&profiler.used, (unsigned long) depth + 1);
+            if (slot + (unsigned long) depth + 1 <= PROFILE_BUFFER_FRAMES) {
+                FOR_RANGE(i, depth) {
+                    profiler.frames[slot + 1 + i] = (unsigned long) stack[PROFILE_SKIP_FRAMES + i];
+                }
+                __sync_synchronize();
+                profiler.frames[slot] = (unsigned long) depth;
+            }
+            else {
+                __sync_fetch_and_add(&profiler.dropped, 1);
+            }
+        }
+    }
+    errno = saved_errno;
+}
+
+/* Starts sampling the stacks of the process */
+bool profile_start(void) {
+
+    struct sigaction action;
+    struct itimerval timer;
+    void *stack[1];
+
+    profiler.frames = (unsigned long *) calloc(PROFILE_BUFFER_FRAMES, sizeof(unsigned long));
+    if (profiler.frames == NULL) {
+        return FALSE;
+    }
+    profiler.used = 0;
+    profiler.dropped = 0;
+
+    /* The first backtrace loads the unwinder, which allocates, so it is not left to the handler */
+    backtrace(stack, 1);
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &profiler.previous) < 0) {
+        free(profiler.frames);
+        return FALSE;
+    }
+
+    profiler.active = 1;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / PROFILE_FREQUENCY;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL) < 0) {
+        profiler.active = 0;
+        sigaction(SIGPROF, &profiler.previous, NULL);
+        free(profiler.frames);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Compares two symbols by address for use in qsort */
+static int compare_symbols(const void *a, const void *b) {
+
+    const ProfileSymbol *symbol_a = (const ProfileSymbol *) a;
+    const ProfileSymbol *symbol_b = (const ProfileSymbol *) b;
+
+    return symbol_a->address < symbol_b->address ? -1 : symbol_a->address > symbol_b->address;
+}
+
+/* Compares two collapsed stacks for use in qsort */
+static int compare_stacks(const void *a, const void *b) {
+
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/* Reads the functions of the symbol table of the executable, or of its dynamic one if it is stripped */
+static void resolver_load_symbols(ProfileResolver *resolver) {
+
+    const ElfW(Ehdr) *header;
+    const ElfW(Shdr) *sections, *table = NULL, *strings;
+    const ElfW(Sym) *symbol;
+    size_t i, count;
+
+    resolver->symbols = NULL;
+    resolver->num_symbols = 0;
+    if (!map_file("/proc/self/exe", &resolver->image)) {
+        resolver->image.data = NULL;
+        resolver->image.size = 0;
+        return;
+    }
+
+    header = (const ElfW(Ehdr) *) resolver->image.data;
+    if (resolver->image.size < sizeof(ElfW(Ehdr)) || memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 ||
+        header->e_shoff + (size_t) header->e_shnum * sizeof(ElfW(Shdr)) > resolver->image.size) {
+        return;
+    }
+    sections = (const ElfW(Shdr) *) (resolver->image.data + header->e_shoff);
+
+    FOR_RANGE(i, header->e_shnum) {
+        if (sections[i].sh_type == SHT_SYMTAB || (sections[i].sh_type == SHT_DYNSYM && table == NULL)) {
+            table = &sections[i];
+        }
+    }
+    if (table == NULL || table->sh_link >= header->e_shnum ||
+        table->sh_offset + table->sh_size > resolver->image.size) {
+        return;
+    }
+    strings = &sections[table->sh_link];
+
+    count = table->sh_size / sizeof(ElfW(Sym));
+    resolver->symbols = (ProfileSymbol *) validated_memory_allocation(sizeof(ProfileSymbol) * (count + 1));
+    symbol = (const ElfW(Sym) *) (resolver->image.data + table->sh_offset);
+    FOR_RANGE(i, count) {
+        if (ELF64_ST_TYPE(symbol[i].st_info) != STT_FUNC || symbol[i].st_value == 0 ||
+            symbol[i].st_name >= strings->sh_size) {
+            continue;
+        }
+        resolver->symbols[resolver->num_symbols].address = (unsigned long) symbol[i].st_value;
+        resolver->symbols[resolver->num_symbols].size = (unsigned long) symbol[i].st_size;
+        resolver->symbols[resolver->num_symbols].name = resolver->image.data + strings->sh_offset + symbol[i].st_name;
+        resolver->num_symbols++;
+    }
+    qsort(resolver->symbols, resolver->num_symbols, sizeof(ProfileSymbol), compare_symbols);
+}
+
+/* Records the range of a loaded object, the callback of dl_iterate_phdr */
+static int resolver_add_object(struct dl_phdr_info *info, size_t size, void *data) {
+
+    ProfileResolver *resolver = (ProfileResolver *) data;
+    ProfileObject object;
+    unsigned long start, end;
+    int i;
+
+    (void) size;
+
+    object.start = (unsigned long) -1;
+    object.end = 0;
+    object.base = (unsigned long) info->dlpi_addr;
+    object.name = info->dlpi_name != NULL ? info->dlpi_name : "";
+    FOR_RANGE(i, info->dlpi_phnum) {
+        if (info->dlpi_phdr[i].p_type == PT_LOAD) {
+            start = object.base + (unsigned long) info->dlpi_phdr[i].p_vaddr;
+            end = start + (unsigned long) info->dlpi_phdr[i].p_memsz;
+            object.start = start < object.start ? start : object.start;
+            object.end = end > object.end ? end : object.end;
+        }
+    }
+
+    if (resolver->num_objects == resolver->objects_capacity) {
+        resolver->objects_capacity = resolver->objects_capacity == 0 ? 16 : 2 * resolver->objects_capacity;
+        resolver->objects = (ProfileObject *) validated_memory_reallocation(resolver->objects,
+                                                                            sizeof(ProfileObject) *
+                                                                            resolver->objects_capacity);
+    }
+    resolver->objects[resolver->num_objects++] = object;
+    return 0;
+}
+
+/* Resolves an address to its function in the executable, or to the library it is in */
+static const char *resolver_name(const ProfileResolver *resolver, unsigned long address, char *buffer,
+                                 size_t buffer_size) {
+
+    const ProfileObject *object = NULL;
+    const char *slash;
+    unsigned long relative;
+    size_t i, low = 0, high = resolver->num_symbols;
+
+    FOR_RANGE(i, resolver->num_objects) {
+        if (address >= resolver->objects[i].start && address < resolver->objects[i].end) {
+            object = &resolver->objects[i];
+            break;
+        }
+    }
+    if (object == NULL) {
+        return "[unknown]";
+    }
+
+    /* The executable is the first object, its functions are searched by their relative address */
+    if (object == &resolver->objects[0]) {
+        relative = address - object->base;
+        while (high - low > 0) {
+            i = low + (high - low) / 2;
+            if (resolver->symbols[i].address <= relative) {
+                low = i + 1;
+            }
+            else {
+                high = i;
+            }
+        }
+        if (low > 0 && (resolver->symbols[low - 1].size == 0 ||
+                        relative < resolver->symbols[low - 1].address + resolver->symbols[low - 1].size)) {
+            return resolver->symbols[low - 1].name;
+        }
+        return "[unknown]";
+    }
+
+    slash = strrchr(object->name, '/');
+    sprintf(buffer, "[%.*s]", (int) (buffer_size - 3), slash != NULL ? slash + 1 : object->name);
+    return buffer;
+}
+
+/* Stops sampling and writes the samples as collapsed stacks */
+bool profile_stop(const char *file_name) {
+
+    struct itimerval timer;
+    ProfileResolver resolver;
+    FILE *out;
+    char **stacks = NULL, *stack;
+    const char *name;
+    char library[64];
+    unsigned long used, slot, depth, address, samples = 0;
+    size_t length, last, capacity, stacks_capacity = 0, i, j;
+    int frame;
+
+    /* The samples being recorded when the timer stops are not read */
+    profiler.active = 0;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &profiler.previous, NULL);
+
+    resolver_load_symbols(&resolver);
+    resolver.objects = NULL;
+    resolver.num_objects = 0;
+    resolver.objects_capacity = 0;
+    dl_iterate_phdr(resolver_add_object, &resolver);
+
+    used = profiler.used < PROFILE_BUFFER_FRAMES ? profiler.used : PROFILE_BUFFER_FRAMES;
+    for (slot = 0 ; slot < used && (depth = profiler.frames[slot]) > 0 ; slot += depth + 1) {
+        capacity = 256;
+        stack = (char *) validated_memory_allocation(capacity);
+        length = 0;
+        last = 0;
+
+        /* The stack is printed from its root, every return address moved back into its call */
+        for (frame = (int) depth - 1 ; frame >= 0 ; frame--) {
+            address = profiler.frames[slot + 1 + frame] - (frame > 0 ? 1 : 0);
+            name = resolver_name(&resolver, address, library, sizeof(library));
+
+            /* The frames of a library have no names, consecutive ones are one frame */
+            if (name == library && length > 0 && strcmp(stack + last, name) == 0) {
+                continue;
+            }
+            if (length + strlen(name) + 2 > capacity) {
+                while (length + strlen(name) + 2 > capacity) {
+                    capacity *= 2;
+                }
+                stack = (char *) validated_memory_reallocation(stack, capacity);
+            }
+            last = length > 0 ? length + 1 : 0;
+            length += (size_t) sprintf(stack + length, "%s%s", length > 0 ? ";" : "", name);
+        }
+
+        if (samples == stacks_capacity) {
+            stacks_capacity = stacks_capacity == 0 ? 1024 : 2 * stacks_capacity;
+            stacks = (char **) validated_memory_reallocation(stacks, sizeof(char *) * stacks_capacity);
+        }
+        stacks[samples++] = stack;
+    }
+    free(profiler.frames);
+    free(resolver.symbols);
+    free(resolver.objects);
+    unmap_file(&resolver.image);
+
+    /* The equal stacks are adjacent once sorted, and are written once with their count */
+    qsort(stacks, samples, sizeof(char *), compare_stacks);
+    out = fopen(file_name, "w");
+    if (out != NULL) {
+        for (i = 0 ; i < samples ; i = j) {
+            for (j = i + 1 ; j < samples && strcmp(stacks[i], stacks[j]) == 0 ; j++) {
+            }
+            fprintf(out, "%s %lu%s", stacks[i], (unsigned long) (j - i), NEW_LINE);
+        }
+    }
+    FOR_RANGE(i, samples) {
+        free(stacks[i]);
+    }
+    free(stacks);
+
+    if (out == NULL || fclose(out) != 0) {
+        return FALSE;
+    }
+    fprintf(ERROR_LOG_STREAM, "[Profile] %lu samples, %lu dropped, written to %s%s", samples, profiler.dropped,
+            file_name, NEW_LINE);
+    return TRUE;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file profile_utility.h
+ * @brief Header file containing the sampling profiler of --profile.
+ *
+ * This header file defines a statistical profiler built into the program, so a run of any size
+ * can be profiled on a host without outside tools. An ITIMER_PROF timer sends SIGPROF every
+ * 1 / PROFILE_FREQUENCY seconds of CPU time spent by the process, on any of its threads, and the
+ * handler records the stack of the interrupted thread with backtrace. The kernel accounts the
+ * CPU time on its scheduler ticks, so a kernel with a lower tick rate takes fewer samples.
+ * The handler only copies the return addresses into a buffer allocated before the timer starts,
+ * reserving their slots with an atomic add, so it neither allocates nor locks; the samples past
+ * the end of the buffer are counted and dropped.
+ *
+ * Once the run ends the addresses are resolved to the functions of the symbol table of the
+ * executable, read from /proc/self/exe, including its static functions. The addresses of the
+ * shared libraries are named after the library, consecutive frames of a library as one frame.
+ * The stacks are written as collapsed stacks, one line per distinct stack from its root to its
+ * leaf with the number of samples, the input of flame graph tools:
+ *
+ *     _start;[libc.so.6];main;program_run;program_process;addWordToIndex;entry_add_line 11
+ *
+ * The stacks are unwound from the unwind tables of the program, so --profile needs no special
+ * build. `make profile` builds the program with frame pointers and debug symbols for perf as
+ * well, and with gprof instrumentation given PROFILE_FLAGS=-pg. gprof samples with the same
+ * timer, so a run is profiled with --profile or with gprof, not both.
+ */
+
+#ifndef PROFILE_UTILITY_H
+#define PROFILE_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief Number of samples taken per second of CPU time.
+ *
+ * A prime, so the samples do not fall in step with periodic work of the program.
+ */
+#define PROFILE_FREQUENCY 997
+
+/**
+ * @brief Largest number of frames recorded for a stack, the frames nearest the root are dropped.
+ */
+#define PROFILE_MAX_DEPTH 64
+
+/**
+ * @brief Number of frames the sample buffer holds, about a minute of samples of deep stacks.
+ *
+ * The pages of the buffer are only touched as the samples fill it.
+ */
+#define PROFILE_BUFFER_FRAMES (1 << 21)
+
+/**
+ * @brief Starts sampling the stacks of the process.
+ *
+ * @return TRUE if the profiler was started, FALSE if the timer or the handler could not be set.
+ */
+bool profile_start(void);
+
+/**
+ * @brief Stops sampling and writes the samples as collapsed stacks.
+ *
+ * The number of samples taken and dropped is reported on the error stream.
+ *
+ * @param[in] file_name - The file to write the collapsed stacks to.
+ *
+ * @return TRUE if the profile was written, FALSE if the file could not be written.
+ *
+ * @complexity
+ * Time Complexity: O(s * d * log f + s * log s), where s is the number of samples, d their depth and f the
+ * number of functions of the executable.
+ */
+bool profile_stop(const char *file_name);
+
+
+#endif /**< PROFILE_UTILITY_H */
@@ -0,0 +1,771 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "snapshot_utility.h"
+#include "mph_utility.h"
+#include "tokenizer_utility.h"
+#include "postings_utility.h"
+#include "compress_utility.h"
+#include "utility.h"
+#include "error_utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Structure to represent a client connection.
+ *
+ * A connection is registered in epoll with EPOLLONESHOT, so at most one worker
+ * handles it at a time and its buffers need no locking.
+ */
+typedef struct Connection {
+    int fd;                   /**< The client socket. */
+    char *input;              /**< Bytes received that do not yet form a complete request. */
+    size_t input_length;      /**< The number of bytes in the input buffer. */
+    char *output;             /**< Response bytes not yet sent to the client. */
+    size_t output_length;     /**< The number of bytes in the output buffer. */
+    size_t output_sent;       /**< The number of bytes of the output buffer already sent. */
+    bool closing;             /**< TRUE once the connection should be closed after flushing. */
+    struct Connection *next;  /**< The next connection in the work queue. */
+    struct Connection *prev_open; /**< The previous connection in the list of open connections. */
+    struct Connection *next_open; /**< The next connection in the list of open connections. */
+} Connection;
+
+/**
+ * @brief Structure to represent the throughput and latency counters.
+ */
+typedef struct {
+    pthread_mutex_t lock;        /**< Protects the counters. */
+    unsigned long requests;      /**< The number of requests served. */
+    unsigned long errors;        /**< The number of requests answered with an error. */
+    unsigned long connections;   /**< The number of connections accepted. */
+    double total_latency;        /**< The sum of the request latencies, in seconds. */
+    double max_latency;          /**< The highest request latency, in seconds. */
+    struct timespec start;       /**< The time the server started. */
+} ServerStats;
+
+/**
+ * @brief Structure to represent the distinct lines of a word of a query, as a sorted array.
+ */
+typedef struct {
+    const unsigned int *lines; /**< The lines of the word, in the snapshot. */
+    size_t length;             /**< The number of lines. */
+    bool excluded;             /**< TRUE if the lines of the word are removed from the result (-word). */
+} QueryTerm;
+
+/**
+ * @brief Structure to represent the state of the server.
+ */
+typedef struct {
+    const IndexOptions *options;   /**< The command-line options. */
+    const IndexSnapshot *snapshot; /**< The snapshot of the word index being served. */
+    const TrigramIndex *trigrams;  /**< The trigram index being served, NULL if restored from a snapshot. */
+    MappedFile input;              /**< The indexed file, mapped once for the searches of all the workers. */
+    int epoll_fd;                  /**< The epoll instance of the event loop. */
+    pthread_mutex_t queue_lock;    /**< Protects the work queue and the list of open connections. */
+    pthread_cond_t queue_ready;    /**< Signaled when a connection is queued or the server stops. */
+    Connection *queue_head;        /**< The first connection waiting for a worker. */
+    Connection *queue_tail;        /**< The last connection waiting for a worker. */
+    Connection *open_connections;  /**< All the open connections, for cleanup on shutdown. */
+    bool stopping;                 /**< TRUE once the workers should exit. */
+    ServerStats stats;             /**< The throughput and latency counters. */
+} Server;
+
+/* Set by the signal handler to request a shutdown */
+static volatile sig_atomic_t shutdown_requested = 0;
+
+/* Requests a shutdown of the event loop */
+static void handle_shutdown_signal(int signal_number) {
+
+    (void) signal_number;
+    shutdown_requested = 1;
+}
+
+/* Returns the time elapsed between two instants, in seconds */
+static double elapsed_seconds(const struct timespec *from, const struct timespec *to) {
+
+    return (double) (to->tv_sec - from->tv_sec) + (double) (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/* Switches a socket to non-blocking mode */
+static bool set_non_blocking(int fd) {
+
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    return (flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0) ? TRUE : FALSE;
+}
+
+/* Re-arms a connection in epoll for the next event it waits for */
+static void rearm_connection(Server *server, Connection *conn) {
+
+    struct epoll_event event;
+
+    event.events = EPOLLONESHOT | EPOLLRDHUP;
+    event.events |= (conn->output_sent < conn->output_length) ? EPOLLOUT : EPOLLIN;
+    event.data.ptr = conn;
+
+    /* Re-arming under the queue lock orders this worker's writes to the connection before
+     * the next worker that pops it, which a thread sanitizer cannot see through epoll */
+    pthread_mutex_lock(&server->queue_lock);
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &event);
+    pthread_mutex_unlock(&server->queue_lock);
+}
+
+/* Closes a connection and frees its buffers */
+static void close_connection(Server *server, Connection *conn) {
+
+    pthread_mutex_lock(&server->queue_lock);
+    if (conn->prev_open != NULL) {
+        conn->prev_open->next_open = conn->next_open;
+    }
+    else {
+        server->open_connections = conn->next_open;
+    }
+    if (conn->next_open != NULL) {
+        conn->next_open->prev_open = conn->prev_open;
+    }
+    pthread_mutex_unlock(&server->queue_lock);
+
+    close(conn->fd);
+    free(conn->input);
+    free(conn->output);
+    free(conn);
+}
+
+/* Queues a connection for the workers */
+static void queue_push(Server *server, Connection *conn) {
+
+    pthread_mutex_lock(&server->queue_lock);
+    conn->next = NULL;
+    if (server->queue_tail != NULL) {
+        server->queue_tail->next = conn;
+    }
+    else {
+        server->queue_head = conn;
+    }
+    server->queue_tail = conn;
+    pthread_cond_signal(&server->queue_ready);
+    pthread_mutex_unlock(&server->queue_lock);
+}
+
+/* Takes the next queued connection, or returns NULL when the server stops */
+static Connection *queue_pop(Server *server) {
+
+    Connection *conn;
+
+    pthread_mutex_lock(&server->queue_lock);
+    while (server->queue_head == NULL && !server->stopping) {
+        pthread_cond_wait(&server->queue_ready, &server->queue_lock);
+    }
+
+    conn = server->queue_head;
+    if (conn != NULL) {
+        server->queue_head = conn->next;
+        if (server->queue_head == NULL) {
+            server->queue_tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&server->queue_lock);
+    return conn;
+}
+
+/* Appends bytes to the output buffer of a connection */
+static void append_output(Connection *conn, const char *data, size_t length) {
+
+    conn->output = (char *) validated_memory_reallocation(conn->output, conn->output_length + length + 1);
+    memcpy(conn->output + conn->output_length, data, length);
+    conn->output_length += length;
+}
+
+/* Prints the counters of the server */
+static void print_stats(FILE *out, Server *server) {
+
+    struct timespec now;
+    double uptime;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uptime = elapsed_seconds(&server->stats.start, &now);
+
+    pthread_mutex_lock(&server->stats.lock);
+    fprintf(out, "requests %lu%s", server->stats.requests, NEW_LINE);
+    fprintf(out, "errors %lu%s", server->stats.errors, NEW_LINE);
+    fprintf(out, "connections %lu%s", server->stats.connections, NEW_LINE);
+    fprintf(out, "uptime_seconds %.3f%s", uptime, NEW_LINE);
+    fprintf(out, "throughput_rps %.1f%s", uptime > 0 ? (double) server->stats.requests / uptime : 0.0, NEW_LINE);
+    fprintf(out, "latency_avg_us %.1f%s", server->stats.requests > 0 ?
+            server->stats.total_latency * 1e6 / (double) server->stats.requests : 0.0, NEW_LINE);
+    fprintf(out, "latency_max_us %.1f%s", server->stats.max_latency * 1e6, NEW_LINE);
+    pthread_mutex_unlock(&server->stats.lock);
+
+    /* The snapshot is immutable while serving, no lock is needed */
+    fprintf(out, "words %d%s", server->snapshot->count, NEW_LINE);
+    fprintf(out, "mph_bits_per_key %.2f%s", mph_bits_per_key(&server->snapshot->mph), NEW_LINE);
+}
+
+/* Compares two query terms by their number of lines */
+static int compare_terms_by_length(const void *a, const void *b) {
+
+    const QueryTerm *term_a = (const QueryTerm *) a;
+    const QueryTerm *term_b = (const QueryTerm *) b;
+
+    return (term_a->length > term_b->length) - (term_a->length < term_b->length);
+}
+
+/* Prints the lines containing all the words of a query (ALL), or any of them (ANY) */
+static void answer_lines_query(Server *server, char *argument, bool all, FILE *out) {
+
+    char *query = duplicate_string(argument);
+    QueryTerm *terms = NULL;
+    const IndexSnapshot *snapshot = server->snapshot;
+    Tokenizer tokenizer;
+    unsigned int *result = NULL, *next = NULL, *swap;
+    size_t result_length = 0, total = 0, length, j;
+    int num_terms = 0, capacity = 0, id, i;
+    bool missing = FALSE;
+    char *word;
+
+    /* Collect the lines of every word, looked up the way the file was tokenized */
+    while (*argument) {
+        word = argument;
+        while (*argument && *argument != ' ') {
+            argument++;
+        }
+        if (*argument) {
+            *argument++ = '\0';
+        }
+
+        if (num_terms == capacity) {
+            capacity = capacity == 0 ? 8 : 2 * capacity;
+            terms = (QueryTerm *) validated_memory_reallocation(terms, sizeof(QueryTerm) * (size_t) capacity);
+        }
+        terms[num_terms].lines = NULL;
+        terms[num_terms].length = 0;
+        terms[num_terms].excluded = (all && word[0] == '-' && word[1] != '\0') ? TRUE : FALSE;
+        if (terms[num_terms].excluded) {
+            word++;
+        }
+
+        tokenizer_init(&tokenizer, word, strlen(word), snapshot->tokenize_flags);
+        id = tokenizer_next(&tokenizer) ? snapshot_find(snapshot, tokenizer.token) : -1;
+        if (id >= 0) {
+            terms[num_terms].lines = snapshot->lines + snapshot->line_offsets[id];
+            terms[num_terms].length = (size_t) (snapshot->line_offsets[id + 1] - snapshot->line_offsets[id]);
+        }
+        else if (!terms[num_terms].excluded) {
+            missing = TRUE;
+        }
+        total += terms[num_terms].length;
+        num_terms++;
+
+        while (*argument == ' ') {
+            argument++;
+        }
+    }
+
+    /* The result is built in one buffer from the other, and the buffers are then swapped */
+    result = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (total + 1));
+    next = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (total + 1));
+
+    if (all && !missing) {
+        /* Intersect the shortest lists first, so the result only shrinks from the smallest list */
+        qsort(terms, (size_t) num_terms, sizeof(QueryTerm), compare_terms_by_length);
+        result_length = (size_t) -1;
+        FOR_RANGE(i, num_terms) {
+            if (terms[i].excluded) {
+                continue;
+            }
+            if (result_length == (size_t) -1) {
+                memcpy(result, terms[i].lines, sizeof(unsigned int) * terms[i].length);
+                result_length = terms[i].length;
+                continue;
+            }
+            length = postings_intersect(result, result_length, terms[i].lines, terms[i].length, next, POSTINGS_AUTO);
+            swap = result;
+            result = next;
+            next = swap;
+            result_length = length;
+        }
+        if (result_length == (size_t) -1) {
+            result_length = 0;
+        }
+
+        /* Then remove the lines of the excluded words */
+        FOR_RANGE(i, num_terms) {
+            if (terms[i].excluded) {
+                result_length = postings_difference(result, result_length, terms[i].lines, terms[i].length, result);
+            }
+        }
+    }
+    else if (!all) {
+        FOR_RANGE(i, num_terms) {
+            length = postings_union(result, result_length, terms[i].lines, terms[i].length, next);
+            swap = result;
+            result = next;
+            next = swap;
+            result_length = length;
+        }
+    }
+
+    if (result_length == 0) {
+        fprintf(out, "%s - not found%s", query, NEW_LINE);
+    }
+    else {
+        fprintf(out, "%s - appears in line", query);
+        FOR_RANGE(j, result_length) {
+            fprintf(out, " %u", result[j]);
+        }
+        fprintf(out, NEW_LINE);
+    }
+
+    free(terms);
+    free(result);
+    free(next);
+    free(query);
+}
+
+/* Parses a request line and writes its response to a stream, returns FALSE on an error response */
+static bool answer_request(Server *server, Connection *conn, char *request, FILE *out) {
+
+    char *argument = request;
+    const IndexSnapshot *snapshot = server->snapshot;
+    Tokenizer tokenizer;
+    char *end_ptr;
+    long k;
+    int id;
+
+    /* Split the command from its argument */
+    while (*argument && *argument != ' ') {
+        argument++;
+    }
+    if (*argument) {
+        *argument++ = '\0';
+    }
+    while (*argument == ' ') {
+        argument++;
+    }
+
+    if (strcmp(request, "LOOKUP") == 0 || strcmp(request, "COUNT") == 0) {
+        /* Look the word up the way the file was tokenized, with the same splitting and folding */
+        tokenizer_init(&tokenizer, argument, strlen(argument), snapshot->tokenize_flags);
+        id = tokenizer_next(&tokenizer) ? snapshot_find(snapshot, tokenizer.token) : -1;
+        if (id < 0) {
+            fprintf(out, "%s - not found%s", argument, NEW_LINE);
+        }
+        else if (request[0] == 'L') {
+            snapshot_print_word(out, snapshot, id);
+        }
+        else {
+            fprintf(out, "%s - appears %d times%s", snapshot_word(snapshot, id), snapshot->counts[id], NEW_LINE);
+        }
+    }
+    else if (strcmp(request, "ALL") == 0 || strcmp(request, "ANY") == 0) {
+        if (*argument == '\0') {
+            fprintf(out, "ERR %s%s", MISSING_OPTION_VALUE_ERR, NEW_LINE);
+            return FALSE;
+        }
+        answer_lines_query(server, argument, request[1] == 'L' ? TRUE : FALSE, out);
+    }
+    else if (strcmp(request, "TOP") == 0) {
+        k = strtol(argument, &end_ptr, 10);
+        if (end_ptr == argument || *end_ptr != '\0' || k <= 0) {
+            fprintf(out, "ERR %s%s", INVALID_OPTION_VALUE_ERR, NEW_LINE);
+            return FALSE;
+        }
+        snapshot_print_top(out, snapshot, (int) (k > snapshot->count ? snapshot->count : k));
+    }
+    else if ((strcmp(request, "GREP") == 0 || strcmp(request, "REGEX") == 0) && server->trigrams == NULL) {
+        /* A server restored from a snapshot has no trigram index to search with */
+        fprintf(out, "ERR %s%s", NO_TRIGRAMS_ERR, NEW_LINE);
+        return FALSE;
+    }
+    else if (strcmp(request, "GREP") == 0) {
+        trigram_search_substring(server->trigrams, &server->input, argument, out);
+    }
+    else if (strcmp(request, "REGEX") == 0) {
+        if (!trigram_search_regex(server->trigrams, &server->input, argument, out)) {
+            fprintf(out, "ERR %s%s", INVALID_REGEX_ERR, NEW_LINE);
+            return FALSE;
+        }
+    }
+    else if (strcmp(request, "STATS") == 0) {
+        print_stats(out, server);
+    }
+    else if (strcmp(request, "QUIT") == 0) {
+        conn->closing = TRUE;
+    }
+    else {
+        fprintf(out, "ERR %s%s", UNKNOWN_COMMAND_ERR, NEW_LINE);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Handles one request line and appends its response to the connection */
+static void handle_request(Server *server, Connection *conn, char *request) {
+
+    struct timespec start, end;
+    char *response = NULL;
+    size_t response_length = 0;
+    FILE *out;
+    bool success;
+    double latency;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* Format the response in memory with the same printers as the command-line output */
+    out = open_memstream(&response, &response_length);
+    if (out == NULL) {
+        handle_memory_allocation_failure();
+    }
+    success = answer_request(server, conn, request, out);
+    fprintf(out, NEW_LINE); /**< An empty line ends every response */
+    fclose(out);
+
+    append_output(conn, response, response_length);
+    free(response);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    latency = elapsed_seconds(&start, &end);
+
+    pthread_mutex_lock(&server->stats.lock);
+    server->stats.requests++;
+    if (!success) {
+        server->stats.errors++;
+    }
+    server->stats.total_latency += latency;
+    if (latency > server->stats.max_latency) {
+        server->stats.max_latency = latency;
+    }
+    pthread_mutex_unlock(&server->stats.lock);
+}
+
+/* Sends as much of the pending output as the socket accepts, returns FALSE if the client is gone */
+static bool flush_output(Connection *conn) {
+
+    ssize_t sent;
+
+    while (conn->output_sent < conn->output_length) {
+        sent = write(conn->fd, conn->output + conn->output_sent, conn->output_length - conn->output_sent);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? TRUE : FALSE;
+        }
+        conn->output_sent += (size_t) sent;
+    }
+
+    /* Everything was sent, reuse the buffer from its start */
+    conn->output_length = 0;
+    conn->output_sent = 0;
+    return TRUE;
+}
+
+/* Answers the complete request lines of a connection and rejects a partial one that is too long */
+static void answer_requests(Server *server, Connection *conn) {
+
+    char *line_end;
+    char *line;
+    size_t consumed;
+
+    /* Answer every complete request line */
+    consumed = 0;
+    while (!conn->closing && consumed < conn->input_length &&
+           (line_end = (char *) memchr(conn->input + consumed, '\n', conn->input_length - consumed)) != NULL) {
+        line = conn->input + consumed;
+        consumed = (size_t) (line_end - conn->input) + 1;
+
+        *line_end = '\0';
+        if (line_end > line && line_end[-1] == '\r') {
+            line_end[-1] = '\0';
+        }
+        handle_request(server, conn, line);
+    }
+    memmove(conn->input, conn->input + consumed, conn->input_length - consumed);
+    conn->input_length -= consumed;
+
+    /* A request that does not fit in a line is rejected */
+    if (conn->input_length >= MAX_LINE_LENGTH) {
+        append_output(conn, "ERR " REQUEST_TOO_LONG_ERR NEW_LINE NEW_LINE,
+                      strlen("ERR " REQUEST_TOO_LONG_ERR NEW_LINE NEW_LINE));
+        conn->closing = TRUE;
+    }
+}
+
+/* Reads the available requests of a connection and answers them */
+static void handle_connection(Server *server, Connection *conn) {
+
+    char buffer[SERVER_READ_SIZE];
+    ssize_t received;
+    bool peer_closed = FALSE;
+
+    /* Finish sending the previous responses before reading new requests */
+    if (conn->output_sent < conn->output_length) {
+        if (!flush_output(conn) || (conn->closing && conn->output_length == 0)) {
+            close_connection(server, conn);
+            return;
+        }
+        if (conn->output_sent < conn->output_length) {
+            rearm_connection(server, conn);
+            return;
+        }
+    }
+
+    /* Drain the socket */
+    while (!conn->closing) {
+        received = read(conn->fd, buffer, sizeof(buffer));
+        if (received > 0) {
+            conn->input = (char *) validated_memory_reallocation(conn->input, conn->input_length + (size_t) received + 1);
+            memcpy(conn->input + conn->input_length, buffer, (size_t) received);
+            conn->input_length += (size_t) received;
+
+            /* Answer as the input arrives, so the buffer never holds more than one partial request */
+            answer_requests(server, conn);
+        }
+        else if (received == 0) {
+            peer_closed = TRUE;
+            break;
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                peer_closed = TRUE;
+            }
+            break;
+        }
+    }
+
+    /* A client that shut down its side may still read the pending responses */
+    if (peer_closed) {
+        conn->closing = TRUE;
+    }
+
+    if (!flush_output(conn) || (conn->closing && conn->output_length == 0)) {
+        close_connection(server, conn);
+        return;
+    }
+    rearm_connection(server, conn);
+}
+
+/* Worker thread: handles queued connections until the server stops */
+static void *worker_main(void *arg) {
+
+    Server *server = (Server *) arg;
+    Connection *conn;
+
+    while ((conn = queue_pop(server)) != NULL) {
+        handle_connection(server, conn);
+    }
+    return NULL;
+}
+
+/* Accepts all the pending connections and registers them in epoll */
+static void accept_connections(Server *server, int listen_fd) {
+
+    struct epoll_event event;
+    Connection *conn;
+    int fd;
+
+    while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+
+        if (!set_non_blocking(fd)) {
+            close(fd);
+            continue;
+        }
+
+        conn = (Connection *) validated_memory_allocation(sizeof(Connection));
+        memset(conn, 0, sizeof(Connection));
+        conn->fd = fd;
+        conn->closing = FALSE;
+
+        pthread_mutex_lock(&server->queue_lock);
+        conn->next_open = server->open_connections;
+        if (server->open_connections != NULL) {
+            server->open_connections->prev_open = conn;
+        }
+        server->open_connections = conn;
+        pthread_mutex_unlock(&server->queue_lock);
+
+        pthread_mutex_lock(&server->stats.lock);
+        server->stats.connections++;
+        pthread_mutex_unlock(&server->stats.lock);
+
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.ptr = conn;
+        if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close_connection(server, conn);
+        }
+    }
+}
+
+/* Creates the listening Unix domain socket */
+static int create_listen_socket(const char *path) {
+
+    struct sockaddr_un address;
+    int fd;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    /* Replace a socket file left by a previous run */
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+        listen(fd, SERVER_BACKLOG) < 0 || !set_non_blocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Installs the signal handlers of the server */
+static void install_signal_handlers(void) {
+
+    struct sigaction action;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_shutdown_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    /* A client that disconnects mid-response must not kill the server */
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+}
+
+/* Serves lookups on a snapshot of the index until a shutdown signal */
+bool server_run(const IndexOptions *options, const IndexSnapshot *snapshot, const TrigramIndex *trigrams) {
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    struct epoll_event event;
+    pthread_t *workers;
+    Server server;
+    bool serving;
+    int listen_fd;
+    int num_events;
+    int started;
+    int i;
+
+    /* The searches read the file from one mapping, instead of mapping (and decompressing) it per request */
+    memset(&server.input, 0, sizeof(server.input));
+    if (trigrams != NULL && !map_input(options->file_name, &server.input, 1)) {
+        error_handling(OPEN_FILE_ERR, options->file_name);
+        return FALSE;
+    }
+
+    listen_fd = create_listen_socket(options->socket_path);
+    if (listen_fd < 0) {
+        error_handling(SOCKET_ERR, options->socket_path);
+        unmap_file(&server.input);
+        return FALSE;
+    }
+
+    server.options = options;
+    server.snapshot = snapshot;
+    server.trigrams = trigrams;
+    server.queue_head = NULL;
+    server.queue_tail = NULL;
+    server.open_connections = NULL;
+    server.stopping = FALSE;
+    server.stats.requests = 0;
+    server.stats.errors = 0;
+    server.stats.connections = 0;
+    server.stats.total_latency = 0;
+    server.stats.max_latency = 0;
+    clock_gettime(CLOCK_MONOTONIC, &server.stats.start);
+    pthread_mutex_init(&server.stats.lock, NULL);
+    pthread_mutex_init(&server.queue_lock, NULL);
+    pthread_cond_init(&server.queue_ready, NULL);
+
+    server.epoll_fd = epoll_create1(0);
+    event.events = EPOLLIN;
+    event.data.ptr = NULL; /**< The listening socket is the only event without a connection */
+    if (server.epoll_fd < 0 || epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) < 0) {
+        error_handling(SOCKET_ERR, options->socket_path);
+        close(listen_fd);
+        unlink(options->socket_path);
+        unmap_file(&server.input);
+        return FALSE;
+    }
+
+    install_signal_handlers();
+
+    /* Start the worker pool, and stop the workers already started if one cannot be */
+    workers = (pthread_t *) validated_memory_allocation(sizeof(pthread_t) * (size_t) options->workers);
+    started = 0;
+    while (started < options->workers && pthread_create(&workers[started], NULL, worker_main, &server) == 0) {
+        started++;
+    }
+    serving = (started == options->workers) ? TRUE : FALSE;
+
+    if (serving) {
+        printf("Serving \"%s\" on %s with %d workers.%s", options->load_snapshot != NULL ? options->load_snapshot : options->file_name,
+               options->socket_path, options->workers, NEW_LINE);
+        fflush(stdout);
+    }
+    else {
+        error_handling(WORKERS_ERR, options->socket_path);
+    }
+
+    /* Event loop */
+    while (serving && !shutdown_requested) {
+        num_events = epoll_wait(server.epoll_fd, events, SERVER_MAX_EVENTS, SERVER_POLL_INTERVAL);
+
+        FOR_RANGE(i, num_events) {
+            if (events[i].data.ptr == NULL) {
+                accept_connections(&server, listen_fd);
+            }
+            else {
+                queue_push(&server, (Connection *) events[i].data.ptr);
+            }
+        }
+    }
+
+    /* Stop the workers and close the remaining connections */
+    pthread_mutex_lock(&server.queue_lock);
+    server.stopping = TRUE;
+    pthread_cond_broadcast(&server.queue_ready);
+    pthread_mutex_unlock(&server.queue_lock);
+
+    FOR_RANGE(i, started) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    while (server.open_connections != NULL) {
+        close_connection(&server, server.open_connections);
+    }
+
+    close(server.epoll_fd);
+    close(listen_fd);
+    unlink(options->socket_path);
+    unmap_file(&server.input);
+
+    pthread_mutex_destroy(&server.stats.lock);
+    pthread_mutex_destroy(&server.queue_lock);
+    pthread_cond_destroy(&server.queue_ready);
+    return serving;
+}
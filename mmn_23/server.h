@@ -0,0 +1,68 @@
+/**
+ * @file server.h
+ * @brief Header file containing the long-running index server.
+ *
+ * This header file declares the daemon mode of the program. The index is built once, or
+ * restored from a snapshot saved by an earlier run, and lookups are then served from its
+ * snapshot (see snapshot_utility.h) over a Unix domain socket with a simple line protocol.
+ * An epoll event loop accepts the clients and watches their sockets, and a pool of
+ * worker threads parses the requests and writes the responses.
+ *
+ * Protocol: every request is a single line, and every response is zero or more lines
+ * followed by an empty line.
+ * - LOOKUP word   - the line numbers of the word, as printed in the index.
+ * - COUNT word    - the number of occurrences of the word.
+ * - ALL words     - the lines containing every word, except those of the words written -word.
+ * - ANY words     - the lines containing any of the words.
+ * - TOP k         - the k most frequent words.
+ * - GREP text     - the lines containing the text (narrowed by the trigram index).
+ * - REGEX pattern - the lines matching the extended regular expression.
+ *   Both are unavailable when the index is restored from a snapshot, which has no trigram index.
+ * - STATS         - the throughput and latency counters of the server, and the size of the index.
+ * - QUIT          - closes the connection.
+ * Errors are reported as a line starting with "ERR".
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "globals.h"
+#include "trigram_utility.h"
+#include "snapshot_utility.h"
+
+/**
+ * @brief Maximum number of epoll events handled per wake-up of the event loop.
+ */
+#define SERVER_MAX_EVENTS 64
+
+/**
+ * @brief Backlog of pending connections on the listening socket.
+ */
+#define SERVER_BACKLOG 128
+
+/**
+ * @brief Size of the buffer used for reading from a client socket.
+ */
+#define SERVER_READ_SIZE 4096
+
+/**
+ * @brief Interval, in milliseconds, at which the event loop checks for a shutdown request.
+ */
+#define SERVER_POLL_INTERVAL 500
+
+/**
+ * @brief Serves lookups on a snapshot of the index until the process receives SIGINT or SIGTERM.
+ *
+ * The socket file is created at the given path (replacing a stale one) and removed on shutdown.
+ *
+ * @param[in] options - The command-line options (socket path, number of workers and file name).
+ * @param[in] snapshot - The snapshot of the word index, built or restored. It is only read while serving.
+ * @param[in] trigrams - The built trigram index, or NULL if the snapshot was restored. It is only
+ *                       read while serving.
+ *
+ * @return TRUE if the server shut down cleanly, FALSE if it could not start.
+ */
+bool server_run(const IndexOptions *options, const IndexSnapshot *snapshot, const TrigramIndex *trigrams);
+
+
+#endif /**< SERVER_H */
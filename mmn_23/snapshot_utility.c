@@ -0,0 +1,375 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snapshot_utility.h"
+#include "frequency_utility.h"
+#include "postings_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Value of the byte order field, read back differently on a machine of another byte order.
+ */
+#define SNAPSHOT_BYTE_ORDER 0x01020304U
+
+/**
+ * @brief Multiplier of the checksum of the sections (the multiplier of MurmurHash2).
+ */
+#define SNAPSHOT_CHECKSUM_MULTIPLIER 0x5BD1E995UL
+
+/* Rounds an offset up to the alignment of the sections */
+static unsigned long align_section(unsigned long offset) {
+
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~((unsigned long) SNAPSHOT_ALIGNMENT - 1);
+}
+
+/* Computes the checksum of the sections, a word at a time, the sections being aligned to whole words */
+static unsigned long snapshot_checksum(const char *base, unsigned long start, unsigned long end) {
+
+    const unsigned long *word = (const unsigned long *) (base + start);
+    const unsigned long *last = (const unsigned long *) (base + end);
+    unsigned long checksum = end - start;
+
+    for (; word < last; word++) {
+        checksum = (checksum ^ *word) * SNAPSHOT_CHECKSUM_MULTIPLIER;
+        checksum ^= checksum >> 29;
+    }
+    return checksum;
+}
+
+/* Appends the posting of a line to the postings, growing their buffer as needed */
+static void append_delta(unsigned char **deltas, size_t *length, size_t *capacity, int line, int count,
+                         int *last_line) {
+
+    if (*length + MAX_POSTING_BYTES > *capacity) {
+        while (*length + MAX_POSTING_BYTES > *capacity) {
+            *capacity = *capacity == 0 ? 4096 : 2 * *capacity;
+        }
+        *deltas = (unsigned char *) validated_memory_reallocation(*deltas, *capacity);
+    }
+    *length += encode_posting((unsigned long) (line - *last_line), count, *deltas + *length);
+    *last_line = line;
+}
+
+/* Appends the lines of a word as postings, from its line list then its compressed postings */
+static void append_word_deltas(const WordEntry *entry, unsigned char **deltas, size_t *length, size_t *capacity) {
+
+    const ListNode *curr;
+    const unsigned char *data, *end;
+    unsigned long delta;
+    size_t used;
+    int line = 0, last_line = 0;
+    int count;
+
+    for (curr = entry->lines; curr != NULL; curr = curr->next) {
+        append_delta(deltas, length, capacity, curr->line_number, curr->count, &last_line);
+    }
+
+    /* The postings restart their deltas from line 0, they are re-encoded after the list */
+    if (entry->postings != NULL) {
+        data = entry->postings->data;
+        end = data + entry->postings->length;
+        while ((used = decode_posting(data, end, &delta, &count)) > 0) {
+            line += (int) delta;
+            append_delta(deltas, length, capacity, line, count, &last_line);
+            data += used;
+        }
+    }
+}
+
+/* Points the fields of a snapshot into its buffer, returns FALSE if the buffer is not a valid snapshot */
+static bool snapshot_attach(IndexSnapshot *snapshot) {
+
+    const char *base = snapshot->mapped.data;
+    const SnapshotHeader *header = (const SnapshotHeader *) base;
+    unsigned long size[SNAPSHOT_SECTIONS];
+    unsigned long num_words;
+    int i, first_fallback;
+
+    /* The header must be one this program writes, on a machine like this one */
+    if (base == NULL || snapshot->mapped.size < sizeof(SnapshotHeader) ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header->version != SNAPSHOT_VERSION || header->byte_order != SNAPSHOT_BYTE_ORDER ||
+        header->long_size != sizeof(unsigned long) || header->sections[SNAPSHOT_SECTIONS] != snapshot->mapped.size ||
+        header->count < 0 || header->mph_num_levels < 0 || header->mph_num_levels > MPH_MAX_LEVELS ||
+        header->mph_num_fallback < 0 || header->mph_num_fallback > header->count) {
+        return FALSE;
+    }
+
+    /* The sections must follow the header in order, aligned, and be large enough for the counts */
+    FOR_RANGE(i, SNAPSHOT_SECTIONS) {
+        if (header->sections[i] < sizeof(SnapshotHeader) || header->sections[i] % SNAPSHOT_ALIGNMENT != 0 ||
+            header->sections[i] > header->sections[i + 1]) {
+            return FALSE;
+        }
+        size[i] = header->sections[i + 1] - header->sections[i];
+    }
+
+    /* A byte of the sections changed since the snapshot was written would be read as an offset or a word */
+    if (snapshot_checksum(base, header->sections[0], header->sections[SNAPSHOT_SECTIONS]) != header->checksum) {
+        return FALSE;
+    }
+    if (size[SNAPSHOT_WORD_OFFSETS] < sizeof(unsigned long) * ((unsigned long) header->count + 1) ||
+        size[SNAPSHOT_COUNTS] < sizeof(int) * (unsigned long) header->count ||
+        size[SNAPSHOT_DELTA_OFFSETS] < sizeof(unsigned long) * ((unsigned long) header->count + 1) ||
+        size[SNAPSHOT_LINE_OFFSETS] < sizeof(unsigned long) * ((unsigned long) header->count + 1) ||
+        size[SNAPSHOT_MPH_LEVELS] < sizeof(unsigned long) * ((unsigned long) header->mph_num_levels + 1) ||
+        size[SNAPSHOT_BLOOM] < header->bloom_num_blocks * BLOOM_BLOCK_BYTES || header->bloom_num_blocks == 0) {
+        return FALSE;
+    }
+
+    snapshot->count = header->count;
+    snapshot->tokenize_flags = header->tokenize_flags;
+    snapshot->word_offsets = (const unsigned long *) (base + header->sections[SNAPSHOT_WORD_OFFSETS]);
+    snapshot->words = base + header->sections[SNAPSHOT_WORDS];
+    snapshot->counts = (const int *) (base + header->sections[SNAPSHOT_COUNTS]);
+    snapshot->delta_offsets = (const unsigned long *) (base + header->sections[SNAPSHOT_DELTA_OFFSETS]);
+    snapshot->deltas = (const unsigned char *) (base + header->sections[SNAPSHOT_DELTAS]);
+    snapshot->line_offsets = (const unsigned long *) (base + header->sections[SNAPSHOT_LINE_OFFSETS]);
+    snapshot->lines = (const unsigned int *) (base + header->sections[SNAPSHOT_LINES]);
+
+    /* Only the ends of the offset arrays are checked, the rest is read as lookups need it */
+    if (snapshot->word_offsets[snapshot->count] > size[SNAPSHOT_WORDS] ||
+        snapshot->delta_offsets[snapshot->count] > size[SNAPSHOT_DELTAS] ||
+        snapshot->line_offsets[snapshot->count] > size[SNAPSHOT_LINES] / sizeof(unsigned int)) {
+        return FALSE;
+    }
+
+    /* The arrays of the hash and the filter are used in place, they are never freed as their own */
+    snapshot->mph.bits = (unsigned int *) (base + header->sections[SNAPSHOT_MPH_BITS]);
+    snapshot->mph.ranks = (unsigned int *) (base + header->sections[SNAPSHOT_MPH_RANKS]);
+    snapshot->mph.level_offset = (unsigned long *) (base + header->sections[SNAPSHOT_MPH_LEVELS]);
+    snapshot->mph.num_levels = header->mph_num_levels;
+    snapshot->mph.num_keys = header->count;
+    num_words = snapshot->mph.level_offset[snapshot->mph.num_levels] >> 5;
+    if (size[SNAPSHOT_MPH_BITS] < sizeof(unsigned int) * num_words ||
+        size[SNAPSHOT_MPH_RANKS] < sizeof(unsigned int) * (num_words / MPH_RANK_BLOCK + 1)) {
+        return FALSE;
+    }
+
+    /* The keys of the fallback list are the words of the last IDs */
+    snapshot->mph.num_fallback = header->mph_num_fallback;
+    snapshot->mph.fallback = NULL;
+    if (snapshot->mph.num_fallback > 0) {
+        first_fallback = snapshot->count - snapshot->mph.num_fallback;
+        snapshot->mph.fallback = (char **) validated_memory_allocation(sizeof(char *) * (size_t) snapshot->mph.num_fallback);
+        FOR_RANGE(i, snapshot->mph.num_fallback) {
+            snapshot->mph.fallback[i] = (char *) snapshot_word(snapshot, first_fallback + i);
+        }
+    }
+
+    snapshot->bloom.bits = (unsigned int *) (base + header->sections[SNAPSHOT_BLOOM]);
+    snapshot->bloom.num_blocks = header->bloom_num_blocks;
+    snapshot->bloom.num_hashes = header->bloom_num_hashes;
+    return TRUE;
+}
+
+/* Builds the snapshot of a frozen index in memory */
+void snapshot_build(IndexSnapshot *snapshot, const WordIndex *index, int tokenize_flags) {
+
+    SnapshotHeader header;
+    unsigned long size[SNAPSHOT_SECTIONS];
+    unsigned long *offsets;
+    unsigned char *deltas = NULL;
+    unsigned int *lines = NULL, *word_lines = NULL;
+    size_t deltas_length = 0, deltas_capacity = 0, lines_length = 0, lines_capacity = 0, word_capacity = 0, length;
+    unsigned long *delta_offsets = (unsigned long *) validated_memory_allocation(sizeof(unsigned long) * (size_t) (index->count + 1));
+    unsigned long *line_offsets = (unsigned long *) validated_memory_allocation(sizeof(unsigned long) * (size_t) (index->count + 1));
+    unsigned long words_length = 0, offset, num_words;
+    char *base;
+    void *buffer;
+    int i;
+
+    /* Encode the lines of every word first, their sizes are only known once encoded */
+    FOR_RANGE(i, index->count) {
+        words_length += (unsigned long) strlen(index->entries[i].word) + 1;
+
+        delta_offsets[i] = (unsigned long) deltas_length;
+        append_word_deltas(&index->entries[i], &deltas, &deltas_length, &deltas_capacity);
+
+        line_offsets[i] = (unsigned long) lines_length;
+        length = postings_collect_lines(&index->entries[i], &word_lines, &word_capacity);
+        if (lines_length + length > lines_capacity) {
+            while (lines_length + length > lines_capacity) {
+                lines_capacity = lines_capacity == 0 ? 4096 : 2 * lines_capacity;
+            }
+            lines = (unsigned int *) validated_memory_reallocation(lines, sizeof(unsigned int) * lines_capacity);
+        }
+        memcpy(lines + lines_length, word_lines, sizeof(unsigned int) * length);
+        lines_length += length;
+    }
+    delta_offsets[index->count] = (unsigned long) deltas_length;
+    line_offsets[index->count] = (unsigned long) lines_length;
+    free(word_lines);
+
+    num_words = index->mph->level_offset[index->mph->num_levels] >> 5;
+    size[SNAPSHOT_WORD_OFFSETS] = sizeof(unsigned long) * ((unsigned long) index->count + 1);
+    size[SNAPSHOT_WORDS] = words_length;
+    size[SNAPSHOT_COUNTS] = sizeof(int) * (unsigned long) index->count;
+    size[SNAPSHOT_DELTA_OFFSETS] = sizeof(unsigned long) * ((unsigned long) index->count + 1);
+    size[SNAPSHOT_DELTAS] = (unsigned long) deltas_length;
+    size[SNAPSHOT_LINE_OFFSETS] = sizeof(unsigned long) * ((unsigned long) index->count + 1);
+    size[SNAPSHOT_LINES] = sizeof(unsigned int) * (unsigned long) lines_length;
+    size[SNAPSHOT_MPH_BITS] = sizeof(unsigned int) * num_words;
+    size[SNAPSHOT_MPH_RANKS] = sizeof(unsigned int) * (num_words / MPH_RANK_BLOCK + 1);
+    size[SNAPSHOT_MPH_LEVELS] = sizeof(unsigned long) * ((unsigned long) index->mph->num_levels + 1);
+    size[SNAPSHOT_BLOOM] = index->bloom->num_blocks * BLOOM_BLOCK_BYTES;
+
+    /* Lay the sections out one after another, each on its own cache line */
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.long_size = sizeof(unsigned long);
+    header.count = index->count;
+    header.tokenize_flags = tokenize_flags;
+    header.mph_num_levels = index->mph->num_levels;
+    header.mph_num_fallback = index->mph->num_fallback;
+    header.bloom_num_hashes = index->bloom->num_hashes;
+    header.bloom_num_blocks = index->bloom->num_blocks;
+    offset = align_section(sizeof(SnapshotHeader));
+    FOR_RANGE(i, SNAPSHOT_SECTIONS) {
+        header.sections[i] = offset;
+        offset = align_section(offset + size[i]);
+    }
+    header.sections[SNAPSHOT_SECTIONS] = offset;
+
+    if (posix_memalign(&buffer, SNAPSHOT_ALIGNMENT, offset) != 0) {
+        handle_memory_allocation_failure();
+    }
+    base = (char *) buffer;
+    memset(base, 0, offset);
+    memcpy(base, &header, sizeof(header));
+
+    /* Copy the words and their numbers of occurrences in the order of their IDs */
+    offsets = (unsigned long *) (base + header.sections[SNAPSHOT_WORD_OFFSETS]);
+    offset = 0;
+    FOR_RANGE(i, index->count) {
+        offsets[i] = offset;
+        strcpy(base + header.sections[SNAPSHOT_WORDS] + offset, index->entries[i].word);
+        offset += (unsigned long) strlen(index->entries[i].word) + 1;
+        ((int *) (base + header.sections[SNAPSHOT_COUNTS]))[i] = index->entries[i].count;
+    }
+    offsets[index->count] = offset;
+
+    memcpy(base + header.sections[SNAPSHOT_DELTA_OFFSETS], delta_offsets, size[SNAPSHOT_DELTA_OFFSETS]);
+    memcpy(base + header.sections[SNAPSHOT_LINE_OFFSETS], line_offsets, size[SNAPSHOT_LINE_OFFSETS]);
+    if (deltas_length > 0) {
+        memcpy(base + header.sections[SNAPSHOT_DELTAS], deltas, deltas_length);
+    }
+    if (lines_length > 0) {
+        memcpy(base + header.sections[SNAPSHOT_LINES], lines, size[SNAPSHOT_LINES]);
+    }
+    memcpy(base + header.sections[SNAPSHOT_MPH_BITS], index->mph->bits, size[SNAPSHOT_MPH_BITS]);
+    memcpy(base + header.sections[SNAPSHOT_MPH_RANKS], index->mph->ranks, size[SNAPSHOT_MPH_RANKS]);
+    memcpy(base + header.sections[SNAPSHOT_MPH_LEVELS], index->mph->level_offset, size[SNAPSHOT_MPH_LEVELS]);
+    memcpy(base + header.sections[SNAPSHOT_BLOOM], index->bloom->bits, size[SNAPSHOT_BLOOM]);
+    ((SnapshotHeader *) base)->checksum = snapshot_checksum(base, header.sections[0], header.sections[SNAPSHOT_SECTIONS]);
+
+    free(deltas);
+    free(lines);
+    free(delta_offsets);
+    free(line_offsets);
+
+    /* The buffer is then read exactly as a mapped file would be */
+    snapshot->mapped.data = base;
+    snapshot->mapped.size = (size_t) header.sections[SNAPSHOT_SECTIONS];
+    snapshot->mapped.owned = TRUE;
+    snapshot_attach(snapshot);
+}
+
+/* Writes a snapshot to a file, replacing it at once */
+bool snapshot_save(const IndexSnapshot *snapshot, const char *file_name) {
+
+    char *temporary = (char *) validated_memory_allocation(strlen(file_name) + sizeof(".tmp"));
+    bool success;
+    FILE *file;
+
+    strcpy(temporary, file_name);
+    strcat(temporary, ".tmp");
+
+    file = fopen(temporary, "wb");
+    if (file == NULL) {
+        free(temporary);
+        return FALSE;
+    }
+    success = (fwrite(snapshot->mapped.data, 1, snapshot->mapped.size, file) == snapshot->mapped.size) ? TRUE : FALSE;
+    if (fclose(file) != 0) {
+        success = FALSE;
+    }
+
+    if (!success || rename(temporary, file_name) != 0) {
+        remove(temporary);
+        success = FALSE;
+    }
+    free(temporary);
+    return success;
+}
+
+/* Restores a snapshot from a file, by mapping it */
+bool snapshot_load(IndexSnapshot *snapshot, const char *file_name) {
+
+    memset(snapshot, 0, sizeof(IndexSnapshot));
+    if (!map_file(file_name, &snapshot->mapped)) {
+        return FALSE;
+    }
+    if (!snapshot_attach(snapshot)) {
+        unmap_file(&snapshot->mapped);
+        snapshot->mapped.data = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Finds the ID of a word in a snapshot */
+int snapshot_find(const IndexSnapshot *snapshot, const char *word) {
+
+    int id;
+
+    if (!bloom_may_contain(&snapshot->bloom, word)) {
+        return -1;
+    }
+    id = mph_lookup(&snapshot->mph, word);
+    return (id >= 0 && strcmp(snapshot_word(snapshot, id), word) == 0) ? id : -1;
+}
+
+/* Returns the word with an ID */
+const char *snapshot_word(const IndexSnapshot *snapshot, int id) {
+
+    return snapshot->words + snapshot->word_offsets[id];
+}
+
+/* Prints the occurrences of a word */
+void snapshot_print_word(FILE *out, const IndexSnapshot *snapshot, int id) {
+
+    fprintf(out, "%s - appears in line", snapshot_word(snapshot, id));
+    print_line_deltas(out, snapshot->deltas + snapshot->delta_offsets[id],
+                      (size_t) (snapshot->delta_offsets[id + 1] - snapshot->delta_offsets[id]), FALSE);
+    fprintf(out, NEW_LINE);
+}
+
+/* Prints the K most frequent words of a snapshot */
+void snapshot_print_top(FILE *out, const IndexSnapshot *snapshot, int k) {
+
+    TopWords top;
+    int i;
+
+    top_words_init(&top, k);
+    FOR_RANGE(i, snapshot->count) {
+        top_words_add(&top, snapshot_word(snapshot, i), snapshot->counts[i]);
+    }
+    top_words_print(out, &top);
+    top_words_free(&top);
+}
+
+/* Frees the snapshot, unmapping its file or freeing its buffer */
+void snapshot_free(IndexSnapshot *snapshot) {
+
+    free(snapshot->mph.fallback);
+    unmap_file(&snapshot->mapped);
+    memset(snapshot, 0, sizeof(IndexSnapshot));
+}
@@ -0,0 +1,210 @@
+/**
+ * @file snapshot_utility.h
+ * @brief Header file containing the snapshot of the served index, and its restore.
+ *
+ * This header file defines the snapshot the server answers from: the frozen word index laid
+ * out as flat sections of one buffer, with no pointers inside. Every section starts at an
+ * offset recorded in the header, relative to the start of the snapshot and aligned to 64 bytes.
+ *
+ * - The words, one after another in the order of their IDs (the slots of the minimal perfect
+ *   hash), and the offset of every word.
+ * - The number of occurrences of every word.
+ * - The distinct lines of every word and the number of occurrences on them, as postings of
+ *   variable-length deltas (see LinePostings), and the offset of the postings of every word.
+ * - The distinct lines of every word as sorted arrays, for the ALL and ANY queries (see
+ *   postings_utility.h), and the offset of the array of every word.
+ * - The bit arrays, the rank directory and the level offsets of the minimal perfect hash.
+ * - The blocks of the Bloom filter.
+ *
+ * A snapshot is built in memory from the frozen index, and may be saved to a file. Restoring
+ * it maps the file and points the sections into the mapping, with nothing copied. The header
+ * records a checksum of the sections, which the restore reads once to compare, so a snapshot
+ * damaged since it was written is rejected instead of being served.
+ * The snapshot is specific to the machine that wrote it (byte order and integer sizes), which
+ * is checked when it is restored. The trigram index is not part of the snapshot.
+ */
+
+#ifndef SNAPSHOT_UTILITY_H
+#define SNAPSHOT_UTILITY_H
+
+#include "globals.h"
+#include "utility.h"
+#include "bloom_utility.h"
+#include "mph_utility.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Magic bytes at the start of a snapshot file.
+ */
+#define SNAPSHOT_MAGIC "IDXSNAP"
+
+/**
+ * @brief Version of the snapshot format, incremented whenever the layout changes.
+ */
+#define SNAPSHOT_VERSION 3
+
+/**
+ * @brief Alignment of the sections of a snapshot, in bytes (a cache line).
+ */
+#define SNAPSHOT_ALIGNMENT 64
+
+/**
+ * @brief The sections of a snapshot, in the order they are laid out.
+ */
+typedef enum {
+    SNAPSHOT_WORD_OFFSETS, /**< The offset of every word in the words section, and the end of the last one. */
+    SNAPSHOT_WORDS,        /**< The null-terminated words. */
+    SNAPSHOT_COUNTS,       /**< The number of occurrences of every word. */
+    SNAPSHOT_DELTA_OFFSETS, /**< The offset of the line deltas of every word, and the end of the last ones. */
+    SNAPSHOT_DELTAS,       /**< The lines of every word and their counts, as postings of variable-length deltas. */
+    SNAPSHOT_LINE_OFFSETS, /**< The index of the first distinct line of every word, and the total. */
+    SNAPSHOT_LINES,        /**< The distinct lines of every word, as sorted arrays. */
+    SNAPSHOT_MPH_BITS,     /**< The bit arrays of the minimal perfect hash. */
+    SNAPSHOT_MPH_RANKS,    /**< The rank directory of the minimal perfect hash. */
+    SNAPSHOT_MPH_LEVELS,   /**< The bit offset of every level of the minimal perfect hash. */
+    SNAPSHOT_BLOOM,        /**< The blocks of the Bloom filter. */
+    SNAPSHOT_SECTIONS      /**< The number of sections. */
+} SnapshotSection;
+
+/**
+ * @brief Structure to represent the header at the start of a snapshot.
+ */
+typedef struct {
+    char magic[8];                 /**< SNAPSHOT_MAGIC, null-terminated. */
+    unsigned int version;          /**< SNAPSHOT_VERSION. */
+    unsigned int byte_order;       /**< 0x01020304 as written, to detect another byte order. */
+    unsigned int long_size;        /**< sizeof(unsigned long) when written. */
+    int count;                     /**< The number of words. */
+    int tokenize_flags;            /**< The TOKENIZE_* flags the file was tokenized with. */
+    int mph_num_levels;            /**< The number of levels of the minimal perfect hash. */
+    int mph_num_fallback;          /**< The number of words in the fallback list of the hash, the last IDs. */
+    int bloom_num_hashes;          /**< The number of bits set per word in the Bloom filter. */
+    unsigned long bloom_num_blocks; /**< The number of blocks of the Bloom filter. */
+    unsigned long checksum;        /**< The checksum of the sections, from the first to the end of the snapshot. */
+    unsigned long sections[SNAPSHOT_SECTIONS + 1]; /**< The offset of every section, and the size of the snapshot. */
+} SnapshotHeader;
+
+/**
+ * @brief Structure to represent a snapshot, built in memory or restored from a file.
+ *
+ * The pointers of the structure point into the snapshot, which is only read.
+ */
+typedef struct {
+    MappedFile mapped;                  /**< The mapping of the file, or the buffer the snapshot was built in. */
+    int count;                          /**< The number of words. */
+    int tokenize_flags;                 /**< The TOKENIZE_* flags the file was tokenized with. */
+    const unsigned long *word_offsets;  /**< The offset of every word in the words. */
+    const char *words;                  /**< The null-terminated words. */
+    const int *counts;                  /**< The number of occurrences of every word. */
+    const unsigned long *delta_offsets; /**< The offset of the line deltas of every word. */
+    const unsigned char *deltas;        /**< The line deltas of all the words. */
+    const unsigned long *line_offsets;  /**< The index of the first distinct line of every word. */
+    const unsigned int *lines;          /**< The distinct lines of all the words. */
+    PerfectHash mph;                    /**< The minimal perfect hash, its arrays in the snapshot. */
+    BloomFilter bloom;                  /**< The Bloom filter, its blocks in the snapshot. */
+} IndexSnapshot;
+
+/**
+ * @brief Builds the snapshot of a frozen index in memory.
+ *
+ * @param[out] snapshot - The snapshot.
+ * @param[in] index - The word index, frozen with index_freeze and with a Bloom filter.
+ * @param[in] tokenize_flags - The TOKENIZE_* flags the file was tokenized with.
+ *
+ * @complexity
+ * Time Complexity: O(n + w), where n is the number of occurrences and w the number of words.
+ */
+void snapshot_build(IndexSnapshot *snapshot, const WordIndex *index, int tokenize_flags);
+
+/**
+ * @brief Writes a snapshot to a file.
+ *
+ * The snapshot is written to a temporary file next to the file, which then replaces it, so a
+ * snapshot being restored is never seen half written.
+ *
+ * @param[in] snapshot - The snapshot.
+ * @param[in] file_name - The name of the file.
+ *
+ * @return TRUE if the snapshot was written, FALSE otherwise.
+ */
+bool snapshot_save(const IndexSnapshot *snapshot, const char *file_name);
+
+/**
+ * @brief Restores a snapshot from a file, by mapping it.
+ *
+ * The header is checked: the magic bytes, the version, the byte order and integer sizes, and
+ * the offsets of the sections against the size of the file. The sections are then read once
+ * and compared with the checksum of the header, and used in place.
+ *
+ * @param[out] snapshot - The snapshot.
+ * @param[in] file_name - The name of the file.
+ *
+ * @return TRUE if the snapshot was restored, FALSE if the file could not be mapped or is not
+ *         a snapshot this program can read.
+ *
+ * @complexity
+ * Time Complexity: O(s), where s is the size of the snapshot, read once for the checksum,
+ * plus the words of the fallback list of the minimal perfect hash (almost always none).
+ */
+bool snapshot_load(IndexSnapshot *snapshot, const char *file_name);
+
+/**
+ * @brief Finds the ID of a word in a snapshot.
+ *
+ * A word the Bloom filter rejects is reported as absent without probing the hash. Otherwise
+ * the word is compared with the single word in its slot of the minimal perfect hash.
+ *
+ * @param[in] snapshot - The snapshot.
+ * @param[in] word - The word.
+ *
+ * @return The ID of the word, or -1 if the word is not in the snapshot.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ */
+int snapshot_find(const IndexSnapshot *snapshot, const char *word);
+
+/**
+ * @brief Returns the word with an ID.
+ *
+ * @param[in] snapshot - The snapshot.
+ * @param[in] id - The ID of the word.
+ *
+ * @return The word.
+ */
+const char *snapshot_word(const IndexSnapshot *snapshot, int id);
+
+/**
+ * @brief Prints the occurrences of a word, as print_word_entry prints them.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] snapshot - The snapshot.
+ * @param[in] id - The ID of the word.
+ *
+ * @complexity
+ * Time Complexity: O(k), where k is the number of occurrences of the word.
+ */
+void snapshot_print_word(FILE *out, const IndexSnapshot *snapshot, int id);
+
+/**
+ * @brief Prints the K most frequent words of a snapshot, as print_top_words prints them.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] snapshot - The snapshot.
+ * @param[in] k - The number of words to print.
+ *
+ * @complexity
+ * Time Complexity: O(w * log k), where w is the number of words.
+ */
+void snapshot_print_top(FILE *out, const IndexSnapshot *snapshot, int k);
+
+/**
+ * @brief Frees the snapshot, unmapping its file or freeing its buffer.
+ *
+ * @param[in,out] snapshot - The snapshot.
+ */
+void snapshot_free(IndexSnapshot *snapshot);
+
+
+#endif /**< SNAPSHOT_UTILITY_H */
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spill_utility.h"
+#include "hash_utility.h"
+#include "frequency_utility.h"
+#include "collate_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief Structure to represent a reader of the words of a run, or of the index in memory.
+ *
+ * A run stores, for every word in lexicographic order, the length of the word, the word, its
+ * number of occurrences, the length of its line postings and the postings (see LinePostings), all
+ * numbers as variable-length integers.
+ */
+typedef struct {
+    FILE *file;                  /**< The temporary file of the run, NULL for the index in memory. */
+    WordEntry **entries;         /**< The sorted entries of the index in memory, NULL for a run. */
+    int num_entries;             /**< The number of sorted entries. */
+    int next_entry;              /**< The next sorted entry to read. */
+    int run;                     /**< The number of the run, the index in memory comes last. */
+    const char *word;            /**< The current word. */
+    const char *key;             /**< The collation key of the current word. */
+    int count;                   /**< The number of occurrences of the current word. */
+    const unsigned char *deltas; /**< The line deltas of the current word. */
+    size_t length;               /**< The number of bytes of the line deltas. */
+    char *word_buffer;           /**< The buffer holding the current word of a run. */
+    size_t word_capacity;        /**< The size of the word buffer. */
+    unsigned char *buffer;       /**< The buffer holding the current line deltas, when they are encoded. */
+    size_t capacity;             /**< The size of the deltas buffer. */
+    CollateOrder order;          /**< The order of the words. */
+    char *key_buffer;            /**< The buffer holding the collation key of the current word. */
+    size_t key_capacity;         /**< The size of the key buffer. */
+} RunReader;
+
+/* Makes room for a number of bytes in a buffer */
+static void *reserve(void *buffer, size_t *capacity, size_t size) {
+
+    if (size <= *capacity) {
+        return buffer;
+    }
+    while (*capacity < size) {
+        *capacity = *capacity == 0 ? 64 : 2 * *capacity;
+    }
+    return validated_memory_reallocation(buffer, *capacity);
+}
+
+/* Writes a variable-length integer to a file */
+static void write_varint(FILE *file, unsigned long value) {
+
+    unsigned char bytes[MAX_VARINT_BYTES];
+
+    fwrite(bytes, 1, encode_varint(value, bytes), file);
+}
+
+/* Reads a variable-length integer from a file, returns FALSE at its end */
+static bool read_varint(FILE *file, unsigned long *value) {
+
+    int shift = 0;
+    int c;
+
+    *value = 0;
+    while ((c = getc(file)) != EOF && shift < 64) {
+        *value |= (unsigned long) (c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            return TRUE;
+        }
+        shift += 7;
+    }
+    return FALSE;
+}
+
+/* Starts reading the words of the index in memory, in the order of the runs */
+static void reader_init_index(RunReader *reader, const WordIndex *index, int run, CollateOrder order) {
+
+    memset(reader, 0, sizeof(RunReader));
+    reader->entries = collect_sorted_word_entries(index, order);
+    reader->num_entries = index->count;
+    reader->run = run;
+    reader->order = order;
+}
+
+/* Starts reading the words of a run from its start */
+static void reader_init_file(RunReader *reader, FILE *file, int run, CollateOrder order) {
+
+    memset(reader, 0, sizeof(RunReader));
+    reader->file = file;
+    reader->run = run;
+    reader->order = order;
+    rewind(file);
+}
+
+/* Reads the next word of the index in memory */
+static bool reader_next_entry(RunReader *reader) {
+
+    const WordEntry *entry;
+    const ListNode *curr;
+    int last_line = 0;
+
+    if (reader->next_entry == reader->num_entries) {
+        return FALSE;
+    }
+    entry = reader->entries[reader->next_entry++];
+    reader->word = entry->word;
+    reader->count = entry->count;
+
+    /* Compressed postings are already encoded, a line list is encoded as they are */
+    if (entry->lines == NULL && entry->postings != NULL) {
+        reader->deltas = entry->postings->data;
+        reader->length = entry->postings->length;
+        return TRUE;
+    }
+
+    reader->length = 0;
+    for (curr = entry->lines; curr != NULL; curr = curr->next) {
+        reader->buffer = (unsigned char *) reserve(reader->buffer, &reader->capacity, reader->length + MAX_POSTING_BYTES);
+        reader->length += encode_posting((unsigned long) (curr->line_number - last_line), curr->count,
+                                         reader->buffer + reader->length);
+        last_line = curr->line_number;
+    }
+    reader->deltas = reader->buffer;
+    return TRUE;
+}
+
+/* Reads the next word of a run */
+static bool reader_next_record(RunReader *reader) {
+
+    unsigned long length, count;
+
+    if (!read_varint(reader->file, &length)) {
+        return FALSE;
+    }
+    reader->word_buffer = (char *) reserve(reader->word_buffer, &reader->word_capacity, length + 1);
+    if (fread(reader->word_buffer, 1, length, reader->file) != length) {
+        return FALSE;
+    }
+    reader->word_buffer[length] = '\0';
+    reader->word = reader->word_buffer;
+
+    if (!read_varint(reader->file, &count) || !read_varint(reader->file, &length)) {
+        return FALSE;
+    }
+    reader->count = (int) count;
+    reader->buffer = (unsigned char *) reserve(reader->buffer, &reader->capacity, length);
+    if (fread(reader->buffer, 1, length, reader->file) != length) {
+        return FALSE;
+    }
+    reader->deltas = reader->buffer;
+    reader->length = length;
+    return TRUE;
+}
+
+/* Reads the next word of a reader, returns FALSE at its end */
+static bool reader_next(RunReader *reader) {
+
+    if (!(reader->file != NULL ? reader_next_record(reader) : reader_next_entry(reader))) {
+        return FALSE;
+    }
+
+    /* The key of the word is computed once, and compared at every step of the merge */
+    if (reader->order == COLLATE_BYTES) {
+        reader->key = reader->word;
+    }
+    else {
+        reader->key_buffer = (char *) reserve(reader->key_buffer, &reader->key_capacity,
+                                              COLLATE_KEY_EXPANSION * strlen(reader->word) + 1);
+        collate_key(reader->word, reader->order, reader->key_buffer);
+        reader->key = reader->key_buffer;
+    }
+    return TRUE;
+}
+
+/* Frees the buffers of a reader */
+static void reader_free(RunReader *reader) {
+
+    free(reader->entries);
+    free(reader->word_buffer);
+    free(reader->buffer);
+    free(reader->key_buffer);
+}
+
+/* Checks whether the current word of a reader comes before the current word of another one */
+static bool reader_before(const RunReader *a, const RunReader *b) {
+
+    int order = collate_compare(a->key, a->word, b->key, b->word);
+
+    /* The same word comes first from the earliest run, so its lines stay in order */
+    return (order < 0 || (order == 0 && a->run < b->run)) ? TRUE : FALSE;
+}
+
+/* Restores the min-heap order of readers downward from a position */
+static void reader_sift_down(RunReader **heap, int size, int position) {
+
+    RunReader *reader = heap[position];
+    int child;
+
+    while ((child = 2 * position + 1) < size) {
+        if (child + 1 < size && reader_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!reader_before(heap[child], reader)) {
+            break;
+        }
+        heap[position] = heap[child];
+        position = child;
+    }
+    heap[position] = reader;
+}
+
+/* Writes the index to a new run and empties it, returns FALSE if the run could not be written */
+static bool spill_index(WordIndex *index, SpillRuns *runs) {
+
+    RunReader reader;
+    FILE *file = tmpfile();
+
+    if (file == NULL) {
+        return FALSE;
+    }
+
+    reader_init_index(&reader, index, 0, runs->order);
+    while (reader_next(&reader)) {
+        write_varint(file, (unsigned long) strlen(reader.word));
+        fputs(reader.word, file);
+        write_varint(file, (unsigned long) reader.count);
+        write_varint(file, (unsigned long) reader.length);
+        fwrite(reader.deltas, 1, reader.length, file);
+    }
+    reader_free(&reader);
+
+    if (fflush(file) != 0 || ferror(file)) {
+        fclose(file);
+        return FALSE;
+    }
+
+    if (runs->count == runs->capacity) {
+        runs->capacity = runs->capacity == 0 ? 16 : 2 * runs->capacity;
+        runs->files = (FILE **) validated_memory_reallocation(runs->files, sizeof(FILE *) * (size_t) runs->capacity);
+    }
+    runs->files[runs->count++] = file;
+
+    /* The index goes on empty, already compressed as it has reached the budget before */
+    free_hash(index);
+    index_init(index);
+    index->compressed = TRUE;
+    return TRUE;
+}
+
+/* Initializes an empty set of runs */
+void spill_init(SpillRuns *runs, CollateOrder order) {
+
+    runs->files = NULL;
+    runs->count = 0;
+    runs->capacity = 0;
+    runs->order = order;
+}
+
+/* Keeps the index within a memory budget, compressing or spilling it if it is close to it */
+bool spill_enforce_budget(WordIndex *index, SpillRuns *runs, unsigned long max_memory) {
+
+    size_t usage = index_memory_usage(index);
+    if (!index->compressed && usage > max_memory / 100 * BUDGET_COMPRESS_PERCENT) {
+        index_compress_postings(index);
+        usage = index_memory_usage(index);
+    }
+
+    return (usage > max_memory / 100 * BUDGET_SPILL_PERCENT && index->count > 0) ? spill_index(index, runs) : TRUE;
+}
+
+/* Prints the index merged from its runs and the part of it left in memory */
+void spill_print(FILE *out, SpillRuns *runs, const WordIndex *index, const IndexOptions *options) {
+
+    RunReader *readers = (RunReader *) validated_memory_allocation(sizeof(RunReader) * (size_t) (runs->count + 1));
+    RunReader **heap = (RunReader **) validated_memory_allocation(sizeof(RunReader *) * (size_t) (runs->count + 1));
+    RunReader *reader;
+    TopWords top;
+    char *word = NULL;
+    size_t word_capacity = 0;
+    int heap_size = 0;
+    int count;
+    int i;
+
+    FOR_RANGE(i, runs->count) {
+        reader_init_file(&readers[i], runs->files[i], i, runs->order);
+    }
+    reader_init_index(&readers[runs->count], index, runs->count, runs->order);
+
+    FOR_RANGE(i, runs->count + 1) {
+        if (reader_next(&readers[i])) {
+            heap[heap_size++] = &readers[i];
+        }
+    }
+    for (i = heap_size / 2 - 1; i >= 0; i--) {
+        reader_sift_down(heap, heap_size, i);
+    }
+
+    if (options->top > 0) {
+        top_words_init(&top, options->top);
+    }
+
+    while (heap_size > 0) {
+        /* The word is copied, the buffer of its reader is overwritten when the reader advances */
+        word = (char *) reserve(word, &word_capacity, strlen(heap[0]->word) + 1);
+        strcpy(word, heap[0]->word);
+        count = 0;
+
+        if (options->top == 0 && !options->counts) {
+            fprintf(out, "%s - appears in line", word);
+        }
+
+        /* Take the word from every run that has it, the earliest run first */
+        do {
+            reader = heap[0];
+            count += reader->count;
+            if (options->top == 0 && !options->counts) {
+                print_line_deltas(out, reader->deltas, reader->length, options->line_counts);
+            }
+
+            if (!reader_next(reader)) {
+                heap[0] = heap[--heap_size];
+            }
+            if (heap_size > 0) {
+                reader_sift_down(heap, heap_size, 0);
+            }
+        } while (heap_size > 0 && strcmp(heap[0]->word, word) == 0);
+
+        if (options->top > 0) {
+            top_words_add(&top, word, count);
+        }
+        else if (options->counts) {
+            fprintf(out, "%s - appears %d times%s", word, count, NEW_LINE);
+        }
+        else {
+            fprintf(out, NEW_LINE);
+        }
+    }
+
+    if (options->top > 0) {
+        top_words_print(out, &top);
+        top_words_free(&top);
+    }
+
+    FOR_RANGE(i, runs->count + 1) {
+        reader_free(&readers[i]);
+    }
+    free(readers);
+    free(heap);
+    free(word);
+}
+
+/* Closes, and so deletes, the temporary files of the runs */
+void spill_free(SpillRuns *runs) {
+
+    int i;
+
+    FOR_RANGE(i, runs->count) {
+        fclose(runs->files[i]);
+    }
+    free(runs->files);
+    spill_init(runs, runs->order);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file spill_utility.h
+ * @brief Header file containing the memory budget of the index and its spilling to disk.
+ *
+ * This header file defines how the word index is kept within a memory budget (--max-memory).
+ * The memory of the index is accounted for as it is allocated (see index_memory_usage), and
+ * checked after every line. The index degrades in two steps as it approaches the budget:
+ *
+ * - Past BUDGET_COMPRESS_PERCENT of the budget, the line lists are compressed into postings
+ *   of variable-length deltas, which take about a byte per line instead of a list node.
+ * - Past BUDGET_SPILL_PERCENT of the budget, the index is written to a temporary file as a
+ *   run of its words in lexicographic order, and indexing continues in an empty index.
+ *
+ * When the output is printed, the runs and the index left in memory are merged word by word
+ * with a heap. The runs cover consecutive parts of the file, so the line numbers of a word are
+ * printed run after run, and the output is the same as when the whole index fits in memory.
+ */
+
+#ifndef SPILL_UTILITY_H
+#define SPILL_UTILITY_H
+
+#include "globals.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Percentage of the memory budget past which the line lists are compressed.
+ */
+#define BUDGET_COMPRESS_PERCENT 75
+
+/**
+ * @brief Percentage of the memory budget past which the index is spilled to a temporary file.
+ */
+#define BUDGET_SPILL_PERCENT 90
+
+/**
+ * @brief Structure to represent the runs the index was spilled to.
+ */
+typedef struct {
+    FILE **files;       /**< The temporary file of every run, in the order of the file. */
+    int count;          /**< The number of runs. */
+    int capacity;       /**< The number of runs allocated. */
+    CollateOrder order; /**< The order the words are sorted in, within the runs and when merged. */
+} SpillRuns;
+
+/**
+ * @brief Initializes an empty set of runs.
+ *
+ * @param[out] runs - The runs to initialize.
+ * @param[in] order - The order the words are printed in (see collate_utility.h).
+ */
+void spill_init(SpillRuns *runs, CollateOrder order);
+
+/**
+ * @brief Keeps the index within a memory budget, compressing or spilling it if it is close to it.
+ *
+ * @param[in,out] index - The word index. Positions must not be recorded.
+ * @param[in,out] runs - The runs the index is spilled to.
+ * @param[in] max_memory - The memory budget in bytes.
+ *
+ * @return FALSE if the index had to be spilled and the run could not be written, TRUE otherwise.
+ *
+ * @complexity
+ * Time Complexity: O(1) when the index is within the budget, O(n log n) for a spill of n words.
+ */
+bool spill_enforce_budget(WordIndex *index, SpillRuns *runs, unsigned long max_memory);
+
+/**
+ * @brief Prints the index merged from its runs and the part of it left in memory.
+ *
+ * The output is the one printed from the whole index in memory: the K most frequent words
+ * with options->top, the number of occurrences of every word with options->counts, and the
+ * lines of every word otherwise.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] runs - The runs of the index. They are read from the start.
+ * @param[in] index - The part of the index left in memory.
+ * @param[in] options - The command-line options.
+ *
+ * @complexity
+ * Time Complexity: O(n log r), where n is the size of the runs and r the number of runs.
+ */
+void spill_print(FILE *out, SpillRuns *runs, const WordIndex *index, const IndexOptions *options);
+
+/**
+ * @brief Closes, and so deletes, the temporary files of the runs.
+ *
+ * @param[in,out] runs - The runs.
+ */
+void spill_free(SpillRuns *runs);
+
+
+#endif /**< SPILL_UTILITY_H */
@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbol_utility.h"
+#include "collate_utility.h"
+#include "hash_utility.h"
+#include "utility.h"
+#include "constants.h"
+
+
+/* Finds the slot of a word, or the empty slot where its ID should be stored */
+static unsigned int find_slot(const SymbolTable *symbols, const char *word, unsigned int word_hash) {
+
+    unsigned int mask = symbols->num_slots - 1;
+    unsigned int i = word_hash & mask;
+    unsigned int id;
+
+    while (symbols->slots[i] != 0) {
+        id = symbols->slots[i] - 1;
+        if (symbols->hashes[id] == word_hash && strcmp(symbols->words[id], word) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/* Doubles the number of slots and stores every ID again, from its kept hash */
+static void grow_slots(SymbolTable *symbols) {
+
+    unsigned int mask;
+    unsigned int id, i;
+
+    free(symbols->slots);
+    symbols->bytes += sizeof(unsigned int) * symbols->num_slots;
+    symbols->num_slots *= 2;
+    symbols->slots = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * symbols->num_slots);
+    memset(symbols->slots, 0, sizeof(unsigned int) * symbols->num_slots);
+
+    mask = symbols->num_slots - 1;
+    FOR_RANGE(id, symbols->count) {
+        i = symbols->hashes[id] & mask;
+        while (symbols->slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        symbols->slots[i] = id + 1;
+    }
+}
+
+/* Initializes an empty symbol table */
+void symbol_init(SymbolTable *symbols) {
+
+    symbols->count = 0;
+    symbols->capacity = HASH_SIZE / 2;
+    symbols->words = (char **) validated_memory_allocation(sizeof(char *) * symbols->capacity);
+    symbols->hashes = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * symbols->capacity);
+    symbols->num_slots = HASH_SIZE;
+    symbols->slots = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * symbols->num_slots);
+    memset(symbols->slots, 0, sizeof(unsigned int) * symbols->num_slots);
+    symbols->bytes = (sizeof(char *) + sizeof(unsigned int)) * symbols->capacity + sizeof(unsigned int) * symbols->num_slots;
+}
+
+/* Interns a word, returning its ID */
+unsigned int symbol_intern(SymbolTable *symbols, const char *word) {
+
+    unsigned int word_hash = mix_hash(hash(word));
+    unsigned int slot = find_slot(symbols, word, word_hash);
+
+    if (symbols->slots[slot] != 0) {
+        return symbols->slots[slot] - 1;
+    }
+
+    /* A new word gets the next ID */
+    if (symbols->count == symbols->capacity) {
+        symbols->bytes += (sizeof(char *) + sizeof(unsigned int)) * symbols->capacity;
+        symbols->capacity *= 2;
+        symbols->words = (char **) validated_memory_reallocation(symbols->words, sizeof(char *) * symbols->capacity);
+        symbols->hashes = (unsigned int *) validated_memory_reallocation(symbols->hashes,
+                                                                         sizeof(unsigned int) * symbols->capacity);
+    }
+    symbols->words[symbols->count] = duplicate_string(word);
+    symbols->bytes += strlen(word) + 1;
+    symbols->hashes[symbols->count] = word_hash;
+    symbols->slots[slot] = ++symbols->count;
+
+    /* Keep the load factor below one half */
+    if (symbols->count * 2 > symbols->num_slots) {
+        grow_slots(symbols);
+    }
+    return symbols->count - 1;
+}
+
+/* Finds the ID of a word without interning it */
+unsigned int symbol_find(const SymbolTable *symbols, const char *word) {
+
+    unsigned int slot = find_slot(symbols, word, mix_hash(hash(word)));
+
+    return symbols->slots[slot] != 0 ? symbols->slots[slot] - 1 : SYMBOL_NOT_FOUND;
+}
+
+/* Looks up the word of an ID */
+const char *symbol_word(const SymbolTable *symbols, unsigned int id) {
+
+    return symbols->words[id];
+}
+
+/* Computes the IDs in an order of their words */
+unsigned int *symbol_sorted_ids(const SymbolTable *symbols, CollateOrder order) {
+
+    /* The IDs are the indexes of the words in the table */
+    return collate_sort(symbols->words, symbols->count, order);
+}
+
+/* Computes the rank of every ID in an order of the words */
+unsigned int *symbol_ranks(const SymbolTable *symbols, CollateOrder order) {
+
+    unsigned int *ids = symbol_sorted_ids(symbols, order);
+    unsigned int *ranks = (unsigned int *) validated_memory_allocation(sizeof(unsigned int) * (symbols->count + 1));
+    unsigned int i;
+
+    /* The ranks are the inverse permutation of the sorted IDs */
+    FOR_RANGE(i, symbols->count) {
+        ranks[ids[i]] = i;
+    }
+    free(ids);
+    return ranks;
+}
+
+/* Renumbers the words and releases the table mapping words to IDs */
+void symbol_freeze(SymbolTable *symbols, const unsigned int *new_ids) {
+
+    char **words = (char **) validated_memory_allocation(sizeof(char *) * (symbols->count + 1));
+    unsigned int id;
+
+    FOR_RANGE(id, symbols->count) {
+        words[new_ids[id]] = symbols->words[id];
+    }
+    free(symbols->words);
+    free(symbols->hashes);
+    free(symbols->slots);
+    symbols->bytes -= (sizeof(char *) + sizeof(unsigned int)) * symbols->capacity + sizeof(unsigned int) * symbols->num_slots;
+    symbols->bytes += sizeof(char *) * (symbols->count + 1);
+    symbols->words = words;
+    symbols->hashes = NULL;
+    symbols->slots = NULL;
+    symbols->num_slots = 0;
+    symbols->capacity = symbols->count + 1;
+}
+
+/* Frees the memory allocated for the symbol table and its words */
+void symbol_free(SymbolTable *symbols) {
+
+    unsigned int id;
+
+    FOR_RANGE(id, symbols->count) {
+        free(symbols->words[id]);
+    }
+    free(symbols->words);
+    free(symbols->hashes);
+    free(symbols->slots);
+    symbols->words = NULL;
+    symbols->hashes = NULL;
+    symbols->slots = NULL;
+    symbols->count = 0;
+    symbols->bytes = 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file symbol_utility.h
+ * @brief Header file containing the symbol table that interns words as dense integer IDs.
+ *
+ * This header file defines the operations of the symbol table (see globals.h), which
+ * stores every distinct word once and gives it the next free ID, starting at 0. The word
+ * index and the n-gram index hold small fixed-size IDs instead of strings, and the strings
+ * are only looked up when the results are printed.
+ */
+
+#ifndef SYMBOL_UTILITY_H
+#define SYMBOL_UTILITY_H
+
+#include "globals.h"
+
+/**
+ * @brief ID returned by symbol_find for a word that is not in the table.
+ */
+#define SYMBOL_NOT_FOUND 0xFFFFFFFFU
+
+/**
+ * @brief Initializes an empty symbol table.
+ *
+ * @param[out] symbols - The symbol table to initialize.
+ */
+void symbol_init(SymbolTable *symbols);
+
+/**
+ * @brief Interns a word, returning its ID.
+ *
+ * @param[in,out] symbols - The symbol table, not frozen.
+ * @param[in] word - The word to intern. It is copied on its first occurrence.
+ *
+ * @return The ID of the word, the same for every occurrence.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ */
+unsigned int symbol_intern(SymbolTable *symbols, const char *word);
+
+/**
+ * @brief Finds the ID of a word without interning it.
+ *
+ * @param[in] symbols - The symbol table, not frozen.
+ * @param[in] word - The word to look up.
+ *
+ * @return The ID of the word, or SYMBOL_NOT_FOUND if the word was never interned.
+ *
+ * @complexity
+ * Time Complexity: O(1) on average.
+ */
+unsigned int symbol_find(const SymbolTable *symbols, const char *word);
+
+/**
+ * @brief Looks up the word of an ID.
+ *
+ * @param[in] symbols - The symbol table.
+ * @param[in] id - An ID returned by symbol_intern.
+ *
+ * @return The word of the ID.
+ */
+const char *symbol_word(const SymbolTable *symbols, unsigned int id);
+
+/**
+ * @brief Computes the rank of every ID in an order of the words.
+ *
+ * The words are sorted once, and structures keyed by IDs are then ordered by comparing
+ * the ranks, which are integers, instead of the strings.
+ *
+ * @param[in] symbols - The symbol table.
+ * @param[in] order - The sort order (see collate_utility.h).
+ *
+ * @return A newly allocated array of count ranks, indexed by ID. The caller is responsible for freeing it.
+ *
+ * @complexity
+ * Time Complexity: O(w) for the radix sort of w words, see collate_sort.
+ */
+unsigned int *symbol_ranks(const SymbolTable *symbols, CollateOrder order);
+
+/**
+ * @brief Computes the IDs in an order of their words.
+ *
+ * Sorting the words of an index is then a permutation of the IDs, computed once.
+ *
+ * @param[in] symbols - The symbol table.
+ * @param[in] order - The sort order (see collate_utility.h).
+ *
+ * @return A newly allocated array of the count IDs, sorted by word. The caller is responsible for freeing it.
+ *
+ * @complexity
+ * Time Complexity: O(w) for the radix sort of w words, see collate_sort.
+ */
+unsigned int *symbol_sorted_ids(const SymbolTable *symbols, CollateOrder order);
+
+/**
+ * @brief Renumbers the words and releases the table mapping words to IDs.
+ *
+ * This is used when an index is frozen: the words take the order of a minimal perfect
+ * hash, which replaces the table for lookups. Afterwards the symbol table only maps IDs
+ * to words, and no word can be interned or found.
+ *
+ * @param[in,out] symbols - The symbol table.
+ * @param[in] new_ids - The new ID of every word, a permutation of the IDs.
+ */
+void symbol_freeze(SymbolTable *symbols, const unsigned int *new_ids);
+
+/**
+ * @brief Frees the memory allocated for the symbol table and its words.
+ *
+ * @param[in,out] symbols - The symbol table to free.
+ */
+void symbol_free(SymbolTable *symbols);
+
+
+#endif /**< SYMBOL_UTILITY_H */
@@ -0,0 +1,401 @@
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tokenizer_utility.h"
+
+
+/**
+ * @brief The character classes of the tokenizer.
+ */
+enum {
+    W = 0, /**< Part of a word: letters, digits, marks and the underscore. */
+    S = 1, /**< Whitespace, always a separator. */
+    P = 2, /**< Punctuation, symbols and control characters, a separator with TOKENIZE_WORDS. */
+    J = 3  /**< Apostrophes and quotes, kept between two word characters with TOKENIZE_WORDS. */
+};
+
+/**
+ * @brief The character class of every ASCII byte.
+ */
+static const unsigned char ascii_class[128] = {
+    P, P, P, P, P, P, P, P, P, S, S, S, S, S, P, P,
+    P, P, P, P, P, P, P, P, P, P, P, P, P, P, P, P,
+    S, P, J, P, P, P, P, J, P, P, P, P, P, P, P, P,
+    W, W, W, W, W, W, W, W, W, W, P, P, P, P, P, P,
+    P, W, W, W, W, W, W, W, W, W, W, W, W, W, W, W,
+    W, W, W, W, W, W, W, W, W, W, W, P, P, P, P, W,
+    P, W, W, W, W, W, W, W, W, W, W, W, W, W, W, W,
+    W, W, W, W, W, W, W, W, W, W, W, P, P, P, P, P
+};
+
+/**
+ * @brief A range of code points sharing a character class.
+ */
+typedef struct {
+    unsigned long first; /**< The first code point of the range. */
+    unsigned long last;  /**< The last code point of the range. */
+    unsigned char type;  /**< The character class of the range. */
+} ClassRange;
+
+/**
+ * @brief The non-ASCII code points that are not word characters, sorted.
+ *
+ * The whitespace follows the Unicode White_Space property, with the zero width space and
+ * the byte order mark added. The punctuation covers the punctuation and symbol blocks of
+ * the scripts in use, including the Hebrew maqaf, paseq and sof pasuq.
+ */
+static const ClassRange class_ranges[] = {
+    {0x0085, 0x0085, S}, {0x00A0, 0x00A0, S}, {0x00A1, 0x00A9, P}, {0x00AB, 0x00AC, P},
+    {0x00AE, 0x00B1, P}, {0x00B4, 0x00B4, P}, {0x00B6, 0x00B6, P}, {0x00B7, 0x00B7, J},
+    {0x00B8, 0x00B8, P}, {0x00BB, 0x00BB, P}, {0x00BF, 0x00BF, P}, {0x00D7, 0x00D7, P},
+    {0x00F7, 0x00F7, P}, {0x02C2, 0x02C5, P}, {0x02D2, 0x02DF, P}, {0x037E, 0x037E, P},
+    {0x0387, 0x0387, P}, {0x055A, 0x055F, P}, {0x0589, 0x058A, P}, {0x05BE, 0x05BE, P},
+    {0x05C0, 0x05C0, P}, {0x05C3, 0x05C3, P}, {0x05C6, 0x05C6, P}, {0x05F3, 0x05F4, J},
+    {0x0609, 0x060D, P}, {0x061B, 0x061B, P}, {0x061D, 0x061F, P}, {0x066A, 0x066D, P},
+    {0x06D4, 0x06D4, P}, {0x0964, 0x0965, P}, {0x0E4F, 0x0E4F, P}, {0x0E5A, 0x0E5B, P},
+    {0x10FB, 0x10FB, P}, {0x1680, 0x1680, S}, {0x2000, 0x200B, S}, {0x2010, 0x2018, P},
+    {0x2019, 0x2019, J}, {0x201A, 0x2027, P}, {0x2028, 0x2029, S}, {0x202F, 0x202F, S},
+    {0x2030, 0x205E, P}, {0x205F, 0x205F, S}, {0x207A, 0x207E, P}, {0x208A, 0x208E, P},
+    {0x20A0, 0x20C0, P}, {0x2116, 0x2116, P}, {0x2122, 0x2122, P}, {0x2190, 0x244A, P},
+    {0x2500, 0x2775, P}, {0x2794, 0x2BFF, P}, {0x2E00, 0x2E5D, P}, {0x3000, 0x3000, S},
+    {0x3001, 0x3003, P}, {0x3008, 0x301F, P}, {0x3030, 0x3030, P}, {0x303D, 0x303D, P},
+    {0x30FB, 0x30FB, P}, {0xFD3E, 0xFD3F, P}, {0xFE10, 0xFE19, P}, {0xFE30, 0xFE52, P},
+    {0xFE54, 0xFE66, P}, {0xFE68, 0xFE6B, P}, {0xFEFF, 0xFEFF, S}, {0xFF01, 0xFF0F, P},
+    {0xFF1A, 0xFF20, P}, {0xFF3B, 0xFF40, P}, {0xFF5B, 0xFF65, P}, {0xFFE0, 0xFFEE, P},
+    {0x1F000, 0x1FAFF, P}
+};
+
+/**
+ * @brief A range of code points folded by a constant offset.
+ *
+ * With a stride of 2 only the code points of the same parity as the first are folded,
+ * as in the blocks where upper and lower case letters alternate.
+ */
+typedef struct {
+    unsigned long first; /**< The first code point of the range. */
+    unsigned long last;  /**< The last code point of the range. */
+    long delta;          /**< The offset from a code point to its folded form. */
+    int stride;          /**< 1 if every code point is folded, 2 if every other one is. */
+} FoldRange;
+
+/**
+ * @brief The simple case folding of the non-ASCII letters with case, sorted.
+ *
+ * The table covers Latin, Greek, Cyrillic, Armenian, Georgian, Glagolitic, the fullwidth
+ * forms and Deseret. Hebrew and Arabic have no case and are left as they are.
+ */
+static const FoldRange fold_ranges[] = {
+    {0x00B5, 0x00B5, 775, 1}, {0x00C0, 0x00D6, 32, 1}, {0x00D8, 0x00DE, 32, 1},
+    {0x0100, 0x012E, 1, 2}, {0x0132, 0x0136, 1, 2}, {0x0139, 0x0147, 1, 2},
+    {0x014A, 0x0176, 1, 2}, {0x0178, 0x0178, -121, 1}, {0x0179, 0x017D, 1, 2},
+    {0x017F, 0x017F, -268, 1}, {0x0386, 0x0386, 38, 1}, {0x0388, 0x038A, 37, 1},
+    {0x038C, 0x038C, 64, 1}, {0x038E, 0x038F, 63, 1}, {0x0391, 0x03A1, 32, 1},
+    {0x03A3, 0x03AB, 32, 1}, {0x03C2, 0x03C2, 1, 1}, {0x03D8, 0x03EE, 1, 2},
+    {0x0400, 0x040F, 80, 1}, {0x0410, 0x042F, 32, 1}, {0x0460, 0x0480, 1, 2},
+    {0x048A, 0x04BE, 1, 2}, {0x04C0, 0x04C0, 15, 1}, {0x04C1, 0x04CD, 1, 2},
+    {0x04D0, 0x052E, 1, 2}, {0x0531, 0x0556, 48, 1}, {0x10A0, 0x10C5, 7264, 1},
+    {0x10C7, 0x10C7, 7264, 1}, {0x10CD, 0x10CD, 7264, 1}, {0x1E00, 0x1E94, 1, 2},
+    {0x1E9E, 0x1E9E, -7615, 1}, {0x1EA0, 0x1EFE, 1, 2}, {0x1F08, 0x1F0F, -8, 1},
+    {0x1F18, 0x1F1D, -8, 1}, {0x1F28, 0x1F2F, -8, 1}, {0x1F38, 0x1F3F, -8, 1},
+    {0x1F48, 0x1F4D, -8, 1}, {0x1F59, 0x1F5F, -8, 2}, {0x1F68, 0x1F6F, -8, 1},
+    {0x2126, 0x2126, -7517, 1}, {0x212A, 0x212A, -8383, 1}, {0x212B, 0x212B, -8262, 1},
+    {0x2160, 0x216F, 16, 1}, {0x24B6, 0x24CF, 26, 1}, {0x2C00, 0x2C2F, 48, 1},
+    {0xFF21, 0xFF3A, 32, 1}, {0x10400, 0x10427, 40, 1}
+};
+
+/**
+ * @brief Marks a byte that does not start a valid UTF-8 sequence.
+ */
+#define INVALID_CODE_POINT 0xFFFFFFFFUL
+
+/* Finds the class of a non-ASCII code point */
+static int code_point_class(unsigned long code_point) {
+
+    int low = 0;
+    int high = (int) (sizeof(class_ranges) / sizeof(class_ranges[0])) - 1;
+    int middle;
+
+    while (low <= high) {
+        middle = (low + high) / 2;
+        if (code_point < class_ranges[middle].first) {
+            high = middle - 1;
+        }
+        else if (code_point > class_ranges[middle].last) {
+            low = middle + 1;
+        }
+        else {
+            return class_ranges[middle].type;
+        }
+    }
+    return W;
+}
+
+/* Finds the simple case folding of a non-ASCII code point */
+static unsigned long fold_code_point(unsigned long code_point) {
+
+    int low = 0;
+    int high = (int) (sizeof(fold_ranges) / sizeof(fold_ranges[0])) - 1;
+    int middle;
+
+    while (low <= high) {
+        middle = (low + high) / 2;
+        if (code_point < fold_ranges[middle].first) {
+            high = middle - 1;
+        }
+        else if (code_point > fold_ranges[middle].last) {
+            low = middle + 1;
+        }
+        else {
+            if ((code_point - fold_ranges[middle].first) % (unsigned long) fold_ranges[middle].stride != 0) {
+                return code_point;
+            }
+            return (unsigned long) ((long) code_point + fold_ranges[middle].delta);
+        }
+    }
+    return code_point;
+}
+
+/* Decodes and validates the character at a position, returns its class */
+static int decode_char(const unsigned char *p, const unsigned char *end, unsigned long *code_point, int *length) {
+
+    unsigned char lead = *p;
+    unsigned long min;
+    int i;
+
+    if (lead < 0x80) {
+        *code_point = lead;
+        *length = 1;
+        return ascii_class[lead];
+    }
+
+    /* The lead byte gives the length of the sequence and the smallest code point it may encode */
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        *length = 2;
+        *code_point = lead & 0x1F;
+        min = 0x80;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF) {
+        *length = 3;
+        *code_point = lead & 0x0F;
+        min = 0x800;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4) {
+        *length = 4;
+        *code_point = lead & 0x07;
+        min = 0x10000;
+    }
+    else {
+        *length = 0;
+    }
+
+    if (*length > 0 && end - p >= *length) {
+        for (i = 1 ; i < *length && (p[i] & 0xC0) == 0x80 ; i++) {
+            *code_point = (*code_point << 6) | (p[i] & 0x3F);
+        }
+
+        /* Reject truncated sequences, overlong forms, surrogates and code points past U+10FFFF */
+        if (i == *length && *code_point >= min && *code_point <= 0x10FFFF &&
+            (*code_point < 0xD800 || *code_point > 0xDFFF)) {
+            return code_point_class(*code_point);
+        }
+    }
+
+    /* A stray byte is kept in the word as is */
+    *code_point = INVALID_CODE_POINT;
+    *length = 1;
+    return W;
+}
+
+/* Encodes a code point as UTF-8, returns the number of bytes written */
+static int encode_char(unsigned long code_point, char *out) {
+
+    if (code_point < 0x80) {
+        out[0] = (char) code_point;
+        return 1;
+    }
+    if (code_point < 0x800) {
+        out[0] = (char) (0xC0 | (code_point >> 6));
+        out[1] = (char) (0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    if (code_point < 0x10000) {
+        out[0] = (char) (0xE0 | (code_point >> 12));
+        out[1] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    out[0] = (char) (0xF0 | (code_point >> 18));
+    out[1] = (char) (0x80 | ((code_point >> 12) & 0x3F));
+    out[2] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+    out[3] = (char) (0x80 | (code_point & 0x3F));
+    return 4;
+}
+
+/* Checks whether an ASCII byte continues a word without any special handling */
+static bool is_simple_byte(unsigned char c, int flags) {
+
+    if (c >= 0x80) {
+        return FALSE;
+    }
+    if (flags & TOKENIZE_WORDS) {
+        return ascii_class[c] == W ? TRUE : FALSE;
+    }
+    return ascii_class[c] != S ? TRUE : FALSE;
+}
+
+/* Copies the run of simple ASCII bytes at the start of [p, limit), returns its length */
+static size_t copy_ascii_run(const unsigned char *p, const unsigned char *limit, char *out, int flags) {
+
+    const unsigned char *start = p;
+
+#ifdef __SSE2__
+    __m128i chunk, simple, upper;
+    int mask;
+
+    /* Sixteen bytes at a time, until a byte that is not plain ASCII word text */
+    while (limit - p >= 16) {
+        chunk = _mm_loadu_si128((const __m128i *) p);
+
+        /* Non-ASCII bytes are negative as signed bytes, so they fail every range test */
+        if (flags & TOKENIZE_WORDS) {
+            simple = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+                                           _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1))),
+                             _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('A' - 1)),
+                                           _mm_cmplt_epi8(chunk, _mm_set1_epi8('Z' + 1)))),
+                _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('a' - 1)),
+                                           _mm_cmplt_epi8(chunk, _mm_set1_epi8('z' + 1))),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_'))));
+        }
+        else {
+            simple = _mm_andnot_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                             _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('\t' - 1)),
+                                           _mm_cmplt_epi8(chunk, _mm_set1_epi8('\r' + 1)))),
+                _mm_cmpgt_epi8(chunk, _mm_setzero_si128()));
+        }
+        mask = ~_mm_movemask_epi8(simple) & 0xFFFF;
+
+        if (flags & TOKENIZE_FOLD_CASE) {
+            upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(chunk, _mm_set1_epi8('Z' + 1)));
+            chunk = _mm_add_epi8(chunk, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        }
+
+        /* The whole chunk is stored, but only the bytes before the first other byte are kept */
+        _mm_storeu_si128((__m128i *) out, chunk);
+        if (mask != 0) {
+            return (size_t) (p - start) + (size_t) __builtin_ctz((unsigned int) mask);
+        }
+        p += 16;
+        out += 16;
+    }
+#endif
+
+    /* The rest of the run, one byte at a time */
+    while (p < limit && is_simple_byte(*p, flags)) {
+        *out++ = (char) ((flags & TOKENIZE_FOLD_CASE) && *p >= 'A' && *p <= 'Z' ? *p + 0x20 : *p);
+        p++;
+    }
+    return (size_t) (p - start);
+}
+
+/* Checks whether a character class separates words under the tokenizer flags */
+static bool is_separator(int type, int flags) {
+
+    if (type == S) {
+        return TRUE;
+    }
+    return (flags & TOKENIZE_WORDS) && type != W ? TRUE : FALSE;
+}
+
+/* Initializes a tokenizer over a line */
+void tokenizer_init(Tokenizer *tokenizer, const char *text, size_t length, int flags) {
+
+    tokenizer->start = (const unsigned char *) text;
+    tokenizer->next = tokenizer->start;
+    tokenizer->end = tokenizer->start + length;
+    tokenizer->flags = flags;
+    tokenizer->token[0] = '\0';
+    tokenizer->length = 0;
+    tokenizer->offset = 0;
+}
+
+/* Moves to the next word of the line */
+bool tokenizer_next(Tokenizer *tokenizer) {
+
+    const unsigned char *p = tokenizer->next;
+    const unsigned char *end = tokenizer->end;
+    const unsigned char *limit;
+    char *out = tokenizer->token;
+    char *out_end = tokenizer->token + TOKEN_BUFFER_SIZE - 8;
+    unsigned long code_point, next_code_point;
+    int length, next_length;
+    int type;
+
+    /* Skip the separators before the word, ASCII ones without decoding */
+    while (p < end) {
+        if (*p < 0x80) {
+            if (!is_separator(ascii_class[*p], tokenizer->flags)) {
+                break;
+            }
+            p++;
+            continue;
+        }
+        type = decode_char(p, end, &code_point, &length);
+        if (!is_separator(type, tokenizer->flags)) {
+            break;
+        }
+        p += length;
+    }
+
+    if (p == end) {
+        tokenizer->next = p;
+        return FALSE;
+    }
+
+    tokenizer->offset = (size_t) (p - tokenizer->start);
+
+    while (p < end && out < out_end) {
+
+        /* Fast path: a run of plain ASCII */
+        limit = (size_t) (end - p) < (size_t) (out_end - out) ? end : p + (out_end - out);
+        length = (int) copy_ascii_run(p, limit, out, tokenizer->flags);
+        p += length;
+        out += length;
+
+        if (p == end || out >= out_end) {
+            break;
+        }
+
+        /* Slow path: a separator, a quote or a multibyte character */
+        type = decode_char(p, end, &code_point, &length);
+
+        if (type == J && (tokenizer->flags & TOKENIZE_WORDS)) {
+            /* A quote joins two word characters and ends the word otherwise */
+            if (p + length == end || decode_char(p + length, end, &next_code_point, &next_length) != W) {
+                break;
+            }
+        }
+        else if (is_separator(type, tokenizer->flags)) {
+            break;
+        }
+
+        if (code_point == INVALID_CODE_POINT) {
+            *out++ = (char) *p;
+        }
+        else {
+            out += encode_char((tokenizer->flags & TOKENIZE_FOLD_CASE) && code_point >= 0x80 ?
+                               fold_code_point(code_point) : code_point, out);
+        }
+        p += length;
+    }
+
+    *out = '\0';
+    tokenizer->length = (size_t) (out - tokenizer->token);
+    tokenizer->next = p;
+    return TRUE;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file tokenizer_utility.h
+ * @brief Header file containing the UTF-8 tokenizer of the indexer.
+ *
+ * This header file defines the tokenizer that splits a line into words. The input is
+ * decoded as UTF-8, with every multibyte sequence validated (overlong forms, surrogates
+ * and code points above U+10FFFF are rejected). A byte that does not start a valid
+ * sequence is kept in the word as is, so text in a legacy encoding is never lost.
+ *
+ * Words are separated by Unicode whitespace and, with TOKENIZE_WORDS, by Unicode
+ * punctuation and symbols as well. With TOKENIZE_FOLD_CASE the words are case-folded
+ * (simple case folding) through lookup tables.
+ *
+ * Runs of plain ASCII are recognized and copied 16 bytes at a time with SSE2, so mostly
+ * ASCII text is tokenized at close to the speed of strtok. The multibyte path is only
+ * taken at the bytes that need it.
+ */
+
+#ifndef TOKENIZER_UTILITY_H
+#define TOKENIZER_UTILITY_H
+
+#include "globals.h"
+#include "constants.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Tokenizer flag: split words at punctuation and symbols, not only at whitespace.
+ *
+ * Apostrophes, and the Hebrew geresh and gershayim (or the ASCII quotes used in their
+ * place), are kept inside a word, so "don't" and Hebrew acronyms stay whole.
+ */
+#define TOKENIZE_WORDS 1
+
+/**
+ * @brief Tokenizer flag: case-fold the words.
+ */
+#define TOKENIZE_FOLD_CASE 2
+
+/**
+ * @brief Size of the buffer holding the current word.
+ *
+ * Case folding can lengthen a word by half (a two-byte letter folding to a three-byte
+ * one), so the buffer holds twice a line. Longer words are split.
+ */
+#define TOKEN_BUFFER_SIZE (2 * MAX_LINE_LENGTH + 32)
+
+/**
+ * @brief Structure to represent the state of the tokenizer over a line.
+ */
+typedef struct {
+    const unsigned char *start; /**< The start of the line. */
+    const unsigned char *next;  /**< The next byte to scan. */
+    const unsigned char *end;   /**< The end of the line. */
+    int flags;                  /**< The TOKENIZE_* flags. */
+    char token[TOKEN_BUFFER_SIZE]; /**< The current word, null-terminated. */
+    size_t length;              /**< The length of the current word in bytes. */
+    size_t offset;              /**< The byte offset of the current word in the line. */
+} Tokenizer;
+
+/**
+ * @brief Initializes a tokenizer over a line.
+ *
+ * The line is only read. It must remain valid while the tokenizer is used.
+ *
+ * @param[out] tokenizer - The tokenizer to initialize.
+ * @param[in] text - The line to split into words.
+ * @param[in] length - The length of the line in bytes.
+ * @param[in] flags - The TOKENIZE_* flags.
+ */
+void tokenizer_init(Tokenizer *tokenizer, const char *text, size_t length, int flags);
+
+/**
+ * @brief Moves to the next word of the line.
+ *
+ * @param[in,out] tokenizer - The tokenizer. On success its token, length and offset describe the word.
+ *
+ * @return TRUE if a word was found, FALSE at the end of the line.
+ *
+ * @complexity
+ * Time Complexity: O(k), where k is the number of bytes scanned.
+ */
+bool tokenizer_next(Tokenizer *tokenizer);
+
+
+#endif /**< TOKENIZER_UTILITY_H */
@@ -0,0 +1,467 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <regex.h>
+
+#include "trigram_utility.h"
+#include "utility.h"
+#include "error_utility.h"
+#include "constants.h"
+
+
+/**
+ * @brief A set of candidate lines produced by a trigram query.
+ *
+ * When 'all' is TRUE the query could not be narrowed and every line is a candidate.
+ */
+typedef struct {
+    int *lines; /**< Sorted array of candidate line numbers. */
+    int count;  /**< The number of candidate lines. */
+    bool all;   /**< TRUE if every line of the file is a candidate. */
+} Candidates;
+
+/* Packs three bytes into a trigram key */
+static unsigned long trigram_key(const char *str) {
+
+    return ((unsigned long) (unsigned char) str[0] << 16) |
+           ((unsigned long) (unsigned char) str[1] << 8) |
+           (unsigned long) (unsigned char) str[2];
+}
+
+/* Maps a trigram key to a bucket of a table with 'size' buckets */
+static int trigram_bucket(unsigned long key, int size) {
+
+    unsigned long h = key ^ (key >> 12);
+
+    h = (h * 2654435761UL) & 0xFFFFFFFFUL;
+    return (int) ((h >> 7) & (unsigned long) (size - 1));
+}
+
+/* Finds the bucket of a key, or the empty bucket where it should be inserted */
+static TrigramEntry *trigram_find(const TrigramIndex *trigrams, unsigned long key) {
+
+    int i = trigram_bucket(key, trigrams->size);
+
+    while (trigrams->table[i].used && trigrams->table[i].key != key) {
+        i = (i + 1) & (trigrams->size - 1);
+    }
+    return &trigrams->table[i];
+}
+
+/* Allocates a zeroed table of buckets */
+static TrigramEntry *trigram_allocate_table(int size) {
+
+    TrigramEntry *table = (TrigramEntry *) validated_memory_allocation(sizeof(TrigramEntry) * (size_t) size);
+
+    memset(table, 0, sizeof(TrigramEntry) * (size_t) size);
+    return table;
+}
+
+/* Doubles the size of the table and rehashes all the trigrams */
+static void trigram_grow(TrigramIndex *trigrams) {
+
+    TrigramEntry *old_table = trigrams->table;
+    int old_size = trigrams->size;
+    int i;
+
+    trigrams->size *= 2;
+    trigrams->table = trigram_allocate_table(trigrams->size);
+
+    FOR_RANGE(i, old_size) {
+        if (old_table[i].used) {
+            *trigram_find(trigrams, old_table[i].key) = old_table[i];
+        }
+    }
+    free(old_table);
+}
+
+/* Initializes an empty trigram index */
+void trigram_init(TrigramIndex *trigrams) {
+
+    trigrams->size = TRIGRAM_INIT_SIZE;
+    trigrams->used = 0;
+    trigrams->line_count = 0;
+    trigrams->carry_length = 0;
+    trigrams->continued = FALSE;
+    trigrams->table = trigram_allocate_table(trigrams->size);
+}
+
+/* Adds a single trigram occurrence to the index */
+static void trigram_add(TrigramIndex *trigrams, unsigned long key, int line_number) {
+
+    TrigramEntry *entry;
+
+    /* Keep the load factor below one half */
+    if ((trigrams->used + 1) * 2 > trigrams->size) {
+        trigram_grow(trigrams);
+    }
+
+    entry = trigram_find(trigrams, key);
+
+    if (!entry->used) {
+        entry->used = TRUE;
+        entry->key = key;
+        entry->lines = NULL;
+        entry->count = 0;
+        entry->capacity = 0;
+        trigrams->used++;
+    }
+
+    /* Lines arrive in ascending order, so a repeated trigram can only repeat the last line */
+    if (entry->count > 0 && entry->lines[entry->count - 1] == line_number) {
+        return;
+    }
+
+    if (entry->count == entry->capacity) {
+        entry->capacity = entry->capacity ? entry->capacity * 2 : 4;
+        entry->lines = (int *) validated_memory_reallocation(entry->lines, sizeof(int) * (size_t) entry->capacity);
+    }
+    entry->lines[entry->count++] = line_number;
+}
+
+/* Adds the trigrams of a piece of a line to the index, and of the bytes carried from the piece before it */
+void trigram_add_text(TrigramIndex *trigrams, const char *text) {
+
+    size_t length = strcspn(text, NEW_LINE);
+    char joined[2 * (TRIGRAM_LENGTH - 1)];
+    size_t joined_length, i;
+
+    /* A piece that does not continue the previous one starts the next line of the file */
+    if (!trigrams->continued) {
+        trigrams->line_count++;
+        trigrams->carry_length = 0;
+    }
+
+    /* The trigrams across the boundary, of the bytes carried and the first bytes of the piece */
+    memcpy(joined, trigrams->carry, trigrams->carry_length);
+    joined_length = trigrams->carry_length;
+    for (i = 0 ; i < length && i < TRIGRAM_LENGTH - 1 ; i++) {
+        joined[joined_length++] = text[i];
+    }
+    for (i = 0 ; i + TRIGRAM_LENGTH <= joined_length ; i++) {
+        trigram_add(trigrams, trigram_key(joined + i), trigrams->line_count);
+    }
+
+    for (i = 0 ; i + TRIGRAM_LENGTH <= length ; i++) {
+        trigram_add(trigrams, trigram_key(text + i), trigrams->line_count);
+    }
+
+    /* The last bytes of the line so far are carried to the next piece */
+    if (length >= TRIGRAM_LENGTH - 1) {
+        memcpy(trigrams->carry, text + length - (TRIGRAM_LENGTH - 1), TRIGRAM_LENGTH - 1);
+        trigrams->carry_length = TRIGRAM_LENGTH - 1;
+    }
+    else {
+        i = joined_length > TRIGRAM_LENGTH - 1 ? joined_length - (TRIGRAM_LENGTH - 1) : 0;
+        memcpy(trigrams->carry, joined + i, joined_length - i);
+        trigrams->carry_length = joined_length - i;
+    }
+
+    /* Only a read that filled the buffer of input_gets stops before the end of its line */
+    trigrams->continued = (text[length] == '\0' && length == MAX_LINE_LENGTH - 1) ? TRUE : FALSE;
+}
+
+/* Compares two trigram entries by the length of their postings */
+static int compare_postings_length(const void *a, const void *b) {
+
+    return (*(const TrigramEntry **) a)->count - (*(const TrigramEntry **) b)->count;
+}
+
+/* Intersects a sorted candidate array with sorted postings, in place */
+static void intersect_candidates(Candidates *candidates, const int *lines, int count) {
+
+    int i = 0, j = 0, k = 0;
+
+    while (i < candidates->count && j < count) {
+        if (candidates->lines[i] < lines[j]) {
+            i++;
+        }
+        else if (candidates->lines[i] > lines[j]) {
+            j++;
+        }
+        else {
+            candidates->lines[k++] = candidates->lines[i];
+            i++;
+            j++;
+        }
+    }
+    candidates->count = k;
+}
+
+/* Narrows the candidates to the lines containing every trigram of a literal */
+static void narrow_by_literal(const TrigramIndex *trigrams, Candidates *candidates, const char *literal, size_t length) {
+
+    const TrigramEntry **entries;
+    const TrigramEntry *entry;
+    int num_entries = 0;
+    int i;
+    size_t j;
+
+    /* Literals shorter than a trigram carry no information */
+    if (length < TRIGRAM_LENGTH) {
+        return;
+    }
+
+    entries = (const TrigramEntry **) validated_memory_allocation(sizeof(TrigramEntry *) * length);
+
+    for(j = 0 ; j + TRIGRAM_LENGTH <= length ; j++) {
+        entry = trigram_find(trigrams, trigram_key(literal + j));
+
+        /* A missing trigram means no line can match */
+        if (!entry->used) {
+            candidates->all = FALSE;
+            candidates->count = 0;
+            free(entries);
+            return;
+        }
+        entries[num_entries++] = entry;
+    }
+
+    /* Intersect the shortest postings first to keep the working set small */
+    qsort(entries, (size_t) num_entries, sizeof(TrigramEntry *), compare_postings_length);
+
+    FOR_RANGE(i, num_entries) {
+        if (candidates->all) {
+            candidates->all = FALSE;
+            candidates->count = entries[i]->count;
+            candidates->lines = (int *) validated_memory_allocation(sizeof(int) * (size_t) (entries[i]->count + 1));
+            memcpy(candidates->lines, entries[i]->lines, sizeof(int) * (size_t) entries[i]->count);
+        }
+        else {
+            intersect_candidates(candidates, entries[i]->lines, entries[i]->count);
+        }
+        if (candidates->count == 0) {
+            break;
+        }
+    }
+    free(entries);
+}
+
+/* Checks whether a regular expression has an alternation outside of any group or bracket */
+static bool has_top_level_alternation(const char *pattern) {
+
+    int depth = 0;
+
+    for(; *pattern ; pattern++) {
+        if (*pattern == '\\' && pattern[1]) {
+            pattern++;
+        }
+        else if (*pattern == '[') {
+            pattern++;
+            if (*pattern == '^') pattern++;
+            if (*pattern == ']') pattern++;
+            while (*pattern && *pattern != ']') pattern++;
+            if (!*pattern) break;
+        }
+        else if (*pattern == '(') depth++;
+        else if (*pattern == ')') depth--;
+        else if (*pattern == '|' && depth == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+/* Narrows the candidates by every literal run that a match of the expression must contain */
+static void narrow_by_regex(const TrigramIndex *trigrams, Candidates *candidates, const char *pattern) {
+
+    size_t length = strlen(pattern);
+    char *run = (char *) validated_memory_allocation(length + 1);
+    size_t run_length = 0;
+    size_t i = 0;
+    int depth = 0;
+    char literal = '\0';
+    bool is_literal;
+
+    /* Either side of a top-level alternation may match, so no literal is required */
+    if (has_top_level_alternation(pattern)) {
+        free(run);
+        return;
+    }
+
+    while (i < length) {
+        is_literal = FALSE;
+
+        if (pattern[i] == '\\' && i + 1 < length) {
+            /* Escaped punctuation is a literal, escaped letters are classes or back-references */
+            is_literal = !isalnum((unsigned char) pattern[i + 1]) && depth == 0;
+            literal = pattern[i + 1];
+            i += 2;
+        }
+        else if (pattern[i] == '[') {
+            i++;
+            if (i < length && pattern[i] == '^') i++;
+            if (i < length && pattern[i] == ']') i++;
+            while (i < length && pattern[i] != ']') i++;
+            i++;
+        }
+        else if (pattern[i] == '{') {
+            while (i < length && pattern[i] != '}') i++;
+            i++;
+        }
+        else {
+            if (pattern[i] == '(') depth++;
+            else if (pattern[i] == ')') depth--;
+            else if (depth == 0 && !strchr(".^$*+?|", pattern[i])) {
+                is_literal = TRUE;
+                literal = pattern[i];
+            }
+            i++;
+        }
+
+        /* A literal followed by an optional quantifier is not required */
+        if (is_literal && i < length && strchr("*?{", pattern[i])) {
+            is_literal = FALSE;
+        }
+
+        if (is_literal) {
+            run[run_length++] = literal;
+
+            /* A literal repeated by '+' is required once, but nothing after it is adjacent */
+            if (i < length && pattern[i] == '+') {
+                narrow_by_literal(trigrams, candidates, run, run_length);
+                run_length = 0;
+            }
+        }
+        else {
+            narrow_by_literal(trigrams, candidates, run, run_length);
+            run_length = 0;
+        }
+    }
+    narrow_by_literal(trigrams, candidates, run, run_length);
+    free(run);
+}
+
+/* Checks whether a line of known length contains a substring */
+static bool line_contains(const char *line, size_t length, const char *substring, size_t sub_length) {
+
+    const char *end = line + length;
+    const char *p = line;
+
+    if (sub_length == 0) {
+        return TRUE;
+    }
+
+    while ((size_t) (end - p) >= sub_length) {
+        p = (const char *) memchr(p, substring[0], (size_t) (end - p) - sub_length + 1);
+        if (p == NULL) {
+            return FALSE;
+        }
+        if (memcmp(p, substring, sub_length) == 0) {
+            return TRUE;
+        }
+        p++;
+    }
+    return FALSE;
+}
+
+/* Verifies the candidate lines against the mapped file and prints the matches */
+static void verify_candidates(const MappedFile *mapped, const Candidates *candidates, int line_count,
+                              const char *substring, const regex_t *regex, FILE *out) {
+
+    const char *p = mapped->data;
+    const char *end = mapped->data + mapped->size;
+    const char *eol;
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+    size_t length;
+    int line_number = 1;
+    int target;
+    int i = 0;
+    bool match;
+
+    while (p != NULL && p < end) {
+
+        /* Pick the next candidate line */
+        if (candidates->all) {
+            if (line_number > line_count) break;
+            target = line_number;
+        }
+        else {
+            if (i >= candidates->count) break;
+            target = candidates->lines[i++];
+        }
+
+        /* Skip the lines before the candidate */
+        while (line_number < target && p != NULL) {
+            p = (const char *) memchr(p, '\n', (size_t) (end - p));
+            if (p != NULL) p++;
+            line_number++;
+        }
+        if (p == NULL || p >= end) {
+            break;
+        }
+
+        eol = (const char *) memchr(p, '\n', (size_t) (end - p));
+        length = (size_t) ((eol ? eol : end) - p);
+
+        if (regex != NULL) {
+            /* regexec expects a null-terminated string */
+            if (length + 1 > buffer_size) {
+                buffer_size = length + 1;
+                buffer = (char *) validated_memory_reallocation(buffer, buffer_size);
+            }
+            memcpy(buffer, p, length);
+            buffer[length] = '\0';
+            match = regexec(regex, buffer, 0, NULL, 0) == 0 ? TRUE : FALSE;
+        }
+        else {
+            match = line_contains(p, length, substring, strlen(substring));
+        }
+
+        if (match) {
+            fprintf(out, "%d: %.*s%s", line_number, (int) length, p, NEW_LINE);
+        }
+
+        p = eol ? eol + 1 : end;
+        line_number++;
+    }
+    free(buffer);
+}
+
+/* Searches the indexed file for lines containing a substring */
+void trigram_search_substring(const TrigramIndex *trigrams, const MappedFile *mapped, const char *substring, FILE *out) {
+
+    Candidates candidates = {NULL, 0, TRUE};
+
+    narrow_by_literal(trigrams, &candidates, substring, strlen(substring));
+    verify_candidates(mapped, &candidates, trigrams->line_count, substring, NULL, out);
+
+    free(candidates.lines);
+}
+
+/* Searches the indexed file for lines matching a regular expression */
+bool trigram_search_regex(const TrigramIndex *trigrams, const MappedFile *mapped, const char *pattern, FILE *out) {
+
+    Candidates candidates = {NULL, 0, TRUE};
+    regex_t regex;
+
+    if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB) != 0) {
+        error_handling(INVALID_REGEX_ERR, pattern);
+        return FALSE;
+    }
+
+    narrow_by_regex(trigrams, &candidates, pattern);
+    verify_candidates(mapped, &candidates, trigrams->line_count, NULL, &regex, out);
+
+    free(candidates.lines);
+    regfree(&regex);
+    return TRUE;
+}
+
+/* Frees the memory allocated for a trigram index */
+void trigram_free(TrigramIndex *trigrams) {
+
+    int i;
+
+    FOR_RANGE(i, trigrams->size) {
+        if (trigrams->table[i].used) {
+            free(trigrams->table[i].lines);
+        }
+    }
+    free(trigrams->table);
+    trigrams->table = NULL;
+    trigrams->size = 0;
+    trigrams->used = 0;
+}
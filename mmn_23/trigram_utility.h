@@ -0,0 +1,135 @@
+/**
+ * @file trigram_utility.h
+ * @brief Header file containing the trigram postings index used for substring and regex search.
+ *
+ * This header file defines the trigram index structures and functions for building the
+ * index while the input file is read, narrowing substring and regular expression queries
+ * to candidate lines, and verifying the candidates against the original file.
+ *
+ * A trigram is a run of three consecutive bytes of a line. Every line that contains a
+ * substring must also contain every trigram of that substring, so intersecting the postings
+ * of the query trigrams yields a small set of candidate lines. Only those lines are then
+ * read back from the file, mapped once by the caller, and checked against the actual query.
+ *
+ * The index is read-only once built, so searches may run concurrently.
+ */
+
+#ifndef TRIGRAM_UTILITY_H
+#define TRIGRAM_UTILITY_H
+
+#include "globals.h"
+#include "utility.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Initial number of buckets in the trigram table.
+ *
+ * The table doubles its size when it becomes more than half full, so this
+ * value only determines the starting footprint.
+ */
+#define TRIGRAM_INIT_SIZE 1024
+
+/**
+ * @brief Number of bytes in a trigram.
+ */
+#define TRIGRAM_LENGTH 3
+
+/**
+ * @brief Structure to represent the postings of a single trigram.
+ *
+ * The line numbers are kept in an array sorted in ascending order. Lines are appended
+ * in reading order, so sorting is free and repeated trigrams on the same line are
+ * collapsed by comparing against the last appended line.
+ */
+typedef struct {
+    unsigned long key; /**< The three bytes of the trigram packed into an integer. */
+    int *lines;        /**< Sorted array of the line numbers containing the trigram. */
+    int count;         /**< The number of line numbers in the array. */
+    int capacity;      /**< The allocated capacity of the array. */
+    bool used;         /**< TRUE if the bucket holds a trigram. */
+} TrigramEntry;
+
+/**
+ * @brief Structure to represent the trigram index.
+ *
+ * The index is an open-addressing hash table (linear probing) from trigram keys
+ * to their postings.
+ */
+typedef struct {
+    TrigramEntry *table; /**< The buckets of the hash table. */
+    int size;            /**< The number of buckets (always a power of two). */
+    int used;            /**< The number of occupied buckets. */
+    int line_count;      /**< The number of lines of the file added to the index. */
+    char carry[TRIGRAM_LENGTH - 1]; /**< The last bytes of the line being added, for the trigrams of its next piece. */
+    size_t carry_length; /**< The number of bytes carried. */
+    bool continued;      /**< TRUE if the last piece added did not end its line. */
+} TrigramIndex;
+
+/**
+ * @brief Initializes an empty trigram index.
+ *
+ * @param[out] trigrams - The trigram index to initialize.
+ */
+void trigram_init(TrigramIndex *trigrams);
+
+/**
+ * @brief Adds the trigrams of a piece of a line to the index.
+ *
+ * The pieces are the reads of input_gets, so a line longer than the read buffer arrives in
+ * several pieces. A piece that fills the MAX_LINE_LENGTH buffer without a newline is continued
+ * by the next one: the trigrams across the boundary are added too, and the lines are numbered
+ * by the newlines of the file, as the candidates are verified against it.
+ *
+ * This function must be called with the raw piece, before it is tokenized,
+ * since tokenizing modifies the line buffer.
+ *
+ * @param[in,out] trigrams - The trigram index.
+ * @param[in] text - The piece as read from the file (the trailing newline is ignored).
+ *
+ * @complexity
+ * Time Complexity: O(n) on average, where n is the length of the piece.
+ */
+void trigram_add_text(TrigramIndex *trigrams, const char *text);
+
+/**
+ * @brief Searches the indexed file for lines containing a substring.
+ *
+ * The candidate lines are found by intersecting the postings of the substring's trigrams,
+ * and each candidate is then verified against the file. Matching lines are printed
+ * with their line numbers.
+ *
+ * @param[in] trigrams - The trigram index built for the file.
+ * @param[in] mapped - The indexed file, mapped with map_input. It is only read, so searches
+ *                     may share it.
+ * @param[in] substring - The substring to search for.
+ * @param[out] out - The stream the matching lines are printed to.
+ */
+void trigram_search_substring(const TrigramIndex *trigrams, const MappedFile *mapped, const char *substring, FILE *out);
+
+/**
+ * @brief Searches the indexed file for lines matching a POSIX extended regular expression.
+ *
+ * The literal runs that every match must contain are extracted from the expression and
+ * used to narrow the search to candidate lines. If the expression has no such literal
+ * (for example, a top-level alternation), every line is a candidate.
+ *
+ * @param[in] trigrams - The trigram index built for the file.
+ * @param[in] mapped - The indexed file, mapped with map_input. It is only read, so searches
+ *                     may share it.
+ * @param[in] pattern - The regular expression to search for.
+ * @param[out] out - The stream the matching lines are printed to.
+ *
+ * @return TRUE if the search was performed, FALSE if the expression is invalid.
+ */
+bool trigram_search_regex(const TrigramIndex *trigrams, const MappedFile *mapped, const char *pattern, FILE *out);
+
+/**
+ * @brief Frees the memory allocated for a trigram index.
+ *
+ * @param[in,out] trigrams - The trigram index to free.
+ */
+void trigram_free(TrigramIndex *trigrams);
+
+
+#endif /**< TRIGRAM_UTILITY_H */
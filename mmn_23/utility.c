@@ -1,32 +1,70 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "utility.h"
 #include "constants.h"
 #include "error_utility.h"
 #include "hash_utility.h"
+#include "bloom_utility.h"
+#include "mph_utility.h"
+#include "position_utility.h"
+#include "symbol_utility.h"
 
 
-/* Compares a word with a word entry in an index using a hash value */
-bool word_compare(const WordEntry *index, const char *word, unsigned int hash_value) {
+/* Compares a word with a word entry in the index */
+bool word_compare(const WordEntry *entry, const char *word) {
 
-    return (strcmp(index[hash_value].word, word) == 0) ? TRUE : FALSE;
+    return (strcmp(entry->word, word) == 0) ? TRUE : FALSE;
 }
 
 /* Prints the occurrences of a word in the index */
-void print_word_entry(WordEntry *index, const char *word) {
+void print_word_entry(FILE *out, const WordEntry *entry, bool line_counts) {
 
-    unsigned int hash_value = hash(word);
-    ListNode *curr = index[hash_value].lines;
+    ListNode *curr = entry->lines;
 
-    printf("%s - appears in line", word);
+    fprintf(out, "%s - appears in line", entry->word);
     while (curr != NULL) {
-        printf(" %d", curr->line_number);
+        if (line_counts) {
+            fprintf(out, " %d:%d", curr->line_number, curr->count);
+        }
+        else {
+            fprintf(out, " %d", curr->line_number);
+        }
         curr = curr->next;
     }
-    printf(NEW_LINE);
+    if (entry->postings != NULL) {
+        print_line_deltas(out, entry->postings->data, entry->postings->length, line_counts);
+    }
+    fprintf(out, NEW_LINE);
+}
+
+/* Prints the line numbers encoded as postings */
+void print_line_deltas(FILE *out, const unsigned char *data, size_t length, bool line_counts) {
+
+    const unsigned char *end = data + length;
+    unsigned long delta;
+    size_t used;
+    int line_number = 0;
+    int count;
+
+    while ((used = decode_posting(data, end, &delta, &count)) > 0) {
+        line_number += (int) delta;
+        if (line_counts) {
+            fprintf(out, " %d:%d", line_number, count);
+        }
+        else {
+            fprintf(out, " %d", line_number);
+        }
+        data += used;
+    }
 }
 
 /* Compares two strings */
@@ -35,24 +73,119 @@ int compare_strings(const void *a, const void *b) {
     return strcmp(*(const char **) a, *(const char **) b);
 }
 
+/* Collects the entries of the index in an order of their words */
+WordEntry **collect_sorted_word_entries(const WordIndex *index, CollateOrder order) {
+
+    WordEntry **entries = (WordEntry **) validated_memory_allocation(sizeof(WordEntry *) * (size_t) (index->count + 1));
+    unsigned int *ids = symbol_sorted_ids(&index->symbols, order);
+    int i;
+
+    /* The words are sorted once, the entries follow the permutation of their IDs */
+    FOR_RANGE(i, index->count) {
+        entries[i] = &index->entries[ids[i]];
+    }
+    free(ids);
+    return entries;
+}
+
 /* Frees memory allocated for a hash */
-void free_hash(const WordEntry *index) {
+void free_hash(WordIndex *index) {
 
-    ListNode *curr;
     int i;
 
-    FOR_RANGE(i, HASH_SIZE) {
+    FOR_RANGE(i, index->count) {
+        position_free(&index->entries[i]);
+        if (index->entries[i].postings != NULL) {
+            free(index->entries[i].postings->data);
+            free(index->entries[i].postings);
+        }
+    }
+    index->postings_bytes = 0;
+    index->compressed = FALSE;
+
+    /* The line list nodes are freed with their blocks */
+    node_pool_free(&index->nodes);
+
+    if (index->bloom != NULL) {
+        bloom_free(index->bloom);
+        free(index->bloom);
+        index->bloom = NULL;
+    }
+
+    if (index->mph != NULL) {
+        mph_free(index->mph);
+        free(index->mph);
+        index->mph = NULL;
+    }
 
-        curr = index[i].lines;
+    symbol_free(&index->symbols);
 
-        while (curr != NULL) {
-            ListNode *temp = curr;
-            curr = curr->next;
-            free(temp);
+    free(index->entries);
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+/* Initializes an empty pool of linked list nodes */
+void node_pool_init(NodePool *pool) {
+
+    pool->blocks = NULL;
+    pool->used = 0;
+    pool->num_blocks = 0;
+}
+
+/* Takes a linked list node from a pool */
+ListNode *node_pool_allocate(NodePool *pool) {
+
+    NodeBlock *block;
+
+    if (pool->blocks == NULL || pool->used == NODE_BLOCK_SIZE) {
+        block = (NodeBlock *) validated_memory_allocation(sizeof(NodeBlock));
+        block->next = pool->blocks;
+        pool->blocks = block;
+        pool->used = 0;
+        pool->num_blocks++;
+    }
+    return &pool->blocks->nodes[pool->used++];
+}
+
+/* Moves the blocks of a pool into another pool */
+void node_pool_append(NodePool *pool, NodePool *source) {
+
+    NodeBlock *last;
+
+    if (source->blocks == NULL) {
+        return;
+    }
+
+    if (pool->blocks == NULL) {
+        *pool = *source;
+    }
+    else {
+        /* Keep the current block of the pool first, it is the only one with free nodes */
+        last = source->blocks;
+        while (last->next != NULL) {
+            last = last->next;
         }
+        last->next = pool->blocks->next;
+        pool->blocks->next = source->blocks;
+        pool->num_blocks += source->num_blocks;
+    }
+    node_pool_init(source);
+}
+
+/* Frees the blocks of a pool */
+void node_pool_free(NodePool *pool) {
 
-        free(index[i].word);
+    NodeBlock *block;
+
+    while (pool->blocks != NULL) {
+        block = pool->blocks;
+        pool->blocks = block->next;
+        free(block);
     }
+    pool->used = 0;
+    pool->num_blocks = 0;
 }
 
 /* Prints error message for memory allocation failures and exits */
@@ -71,4 +204,133 @@ void *validated_memory_allocation(size_t size) {
         handle_memory_allocation_failure();
     }
     return ptr;
-}
\ No newline at end of file
+}
+
+/* Reallocates memory with error checking */
+void *validated_memory_reallocation(void *ptr, size_t size) {
+
+    void *new_ptr = realloc(ptr, size);
+
+    if (new_ptr == NULL) {
+        handle_memory_allocation_failure();
+    }
+    return new_ptr;
+}
+
+/* Duplicates a string with error checking */
+char *duplicate_string(const char *str) {
+
+    size_t length = strlen(str) + 1;
+    char *copy = (char *) validated_memory_allocation(length);
+
+    memcpy(copy, str, length);
+    return copy;
+}
+
+/* Encodes an unsigned value as a variable-length integer */
+size_t encode_varint(unsigned long value, unsigned char *out) {
+
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        out[length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char) value;
+    return length;
+}
+
+/* Decodes a variable-length integer */
+size_t decode_varint(const unsigned char *in, const unsigned char *end, unsigned long *value) {
+
+    const unsigned char *start = in;
+    int shift = 0;
+
+    *value = 0;
+    while (in < end && shift < 64) {
+        *value |= (unsigned long) (*in & 0x7F) << shift;
+        if (!(*in++ & 0x80)) {
+            return (size_t) (in - start);
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+/* Encodes the posting of a line */
+size_t encode_posting(unsigned long delta, int count, unsigned char *out) {
+
+    size_t length = encode_varint((delta << 1) | (count > 1 ? 1 : 0), out);
+
+    if (count > 1) {
+        length += encode_varint((unsigned long) count, out + length);
+    }
+    return length;
+}
+
+/* Decodes the posting of a line */
+size_t decode_posting(const unsigned char *in, const unsigned char *end, unsigned long *delta, int *count) {
+
+    unsigned long value, repeated;
+    size_t used = decode_varint(in, end, &value), more;
+
+    if (used == 0) {
+        return 0;
+    }
+    *delta = value >> 1;
+    *count = 1;
+    if (value & 1) {
+        more = decode_varint(in + used, end, &repeated);
+        if (more == 0) {
+            return 0;
+        }
+        *count = (int) repeated;
+        used += more;
+    }
+    return used;
+}
+
+/* Maps a file into memory for reading */
+bool map_file(const char *file_name, MappedFile *mapped) {
+
+    struct stat st;
+    int fd = open(file_name, O_RDONLY);
+
+    if (fd < 0) {
+        return FALSE;
+    }
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return FALSE;
+    }
+
+    mapped->size = (size_t) st.st_size;
+    mapped->data = NULL;
+    mapped->owned = FALSE;
+
+    if (mapped->size > 0) {
+        void *data = mmap(NULL, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            close(fd);
+            return FALSE;
+        }
+        mapped->data = (const char *) data;
+    }
+    close(fd);
+    return TRUE;
+}
+
+/* Unmaps a file mapped by map_file */
+void unmap_file(MappedFile *mapped) {
+
+    if (mapped->data == NULL) {
+        return;
+    }
+    if (mapped->owned) {
+        free((void *) mapped->data);
+    }
+    else {
+        munmap((void *) mapped->data, mapped->size);
+    }
+}
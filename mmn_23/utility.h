@@ -12,6 +12,9 @@
 
 #include "globals.h"
 
+#include <stdio.h>
+#include <stddef.h>
+
 /**
  * @brief Macro for a simple for-loop iterating over a range of values.
  *
@@ -26,14 +29,33 @@
     for(index = 0; index < upperBound; index++)
 
 /**
- * @brief Compares a word with a word entry in an index using a hash value.
+ * @brief Maximum number of bytes of an unsigned long encoded by encode_varint.
+ */
+#define MAX_VARINT_BYTES 10
+
+/**
+ * @brief Maximum number of bytes of a line posting encoded by encode_posting.
+ */
+#define MAX_POSTING_BYTES (2 * MAX_VARINT_BYTES)
+
+/**
+ * @brief A read-only memory mapping of a file.
+ *
+ * The contents of a compressed file are decompressed into memory instead (see map_input).
+ */
+typedef struct {
+    const char *data; /**< The mapped bytes of the file (NULL for an empty file). */
+    size_t size;      /**< The size of the file in bytes. */
+    bool owned;       /**< TRUE if the bytes were allocated rather than mapped. */
+} MappedFile;
+
+/**
+ * @brief Compares a word with a word entry in the index.
  *
- * This function compares a word with the word entry at a specified index in an index array,
- * based on the provided hash value.
+ * This function compares a word with the word stored in an entry of the index.
  *
- * @param[in] index - The array of word entries.
+ * @param[in] entry - The word entry.
  * @param[in] word - The word to compare.
- * @param[in] hash_value - The hash value used to access the word entry in the index.
  *
  * @return Boolean value indicating whether the word matches the word entry.
  * - Returns TRUE if the word matches the word entry.
@@ -43,22 +65,38 @@
  * Time Complexity: O(1)
  * - The function performs a single comparison operation using strcmp, which has constant time complexity.
  */
-bool word_compare(const WordEntry *index, const char *word, unsigned int hash_value);
+bool word_compare(const WordEntry *entry, const char *word);
 
 /**
- * @brief Prints the occurrences of a word in the index.
+ * @brief Prints the lines of a word in the index.
  *
- * This function prints the line numbers where a word appears in the index.
+ * This function prints the line numbers where the word of an entry appears,
+ * from its line list and then from its compressed postings, every line once.
  *
- * @param[in] index - The array of word entries.
- * @param[in] word - The word to print occurrences for.
+ * @param[out] out - The stream to print to.
+ * @param[in] entry - The word entry to print occurrences for.
+ * @param[in] line_counts - TRUE to print every line as "line:count", with the number of
+ *                          occurrences of the word on it (--line-counts).
  *
  * @complexity
- * Time Complexity: O(k), where k is the number of occurrences of the word.
+ * Time Complexity: O(k), where k is the number of distinct lines of the word.
  * - The function traverses the linked list of line numbers for the word and prints each line number,
- *   resulting in linear time complexity proportional to the number of occurrences of the word.
+ *   resulting in linear time complexity proportional to the number of lines of the word.
+ */
+void print_word_entry(FILE *out, const WordEntry *entry, bool line_counts);
+
+/**
+ * @brief Prints line numbers encoded as postings, each preceded by a space.
+ *
+ * @param[out] out - The stream to print to.
+ * @param[in] data - The postings, the first delta from line 0 (see LinePostings).
+ * @param[in] length - The number of bytes of the postings.
+ * @param[in] line_counts - TRUE to print every line as "line:count".
+ *
+ * @complexity
+ * Time Complexity: O(length).
  */
-void print_word_entry(WordEntry *index, const char *word) ;
+void print_line_deltas(FILE *out, const unsigned char *data, size_t length, bool line_counts);
 
 /**
  * @brief Compares two strings for use in qsort.
@@ -81,19 +119,76 @@ void print_word_entry(WordEntry *index, const char *word) ;
  */
 int compare_strings(const void *a, const void *b);
 
+/**
+ * @brief Collects the entries of the index into an array, in an order of their words.
+ *
+ * The IDs of the words are sorted once by the symbol table, and the entries are taken in
+ * that order, so the entries themselves are never compared.
+ *
+ * @param[in] index - The word index.
+ * @param[in] order - The sort order (see collate_utility.h).
+ *
+ * @return A newly allocated array of index->count pointers to the word entries.
+ *         The caller is responsible for freeing the array.
+ *
+ * @complexity
+ * Time Complexity: O(w), where w is the number of words in the index (see collate_sort).
+ */
+WordEntry **collect_sorted_word_entries(const WordIndex *index, CollateOrder order);
+
 /**
  * @brief Frees memory allocated for a hash index.
  *
- * This function frees memory allocated for a hash index, including word entries and linked list nodes.
+ * This function frees memory allocated for a hash index, including word entries, linked list nodes, positions, the symbol table, the Bloom filter and the perfect hash.
+ *
+ * @param[in,out] index - The word index.
+ *
+ * @complexity
+ * Time Complexity: O(n + b), where n is the number of words and b is the number of blocks of linked list nodes.
+ * - The function iterates over each entry in the index, freeing its positions, and frees the
+ *   linked list nodes a block at a time, without walking the lists.
+ */
+void free_hash(WordIndex *index);
+
+/**
+ * @brief Initializes an empty pool of linked list nodes.
+ *
+ * @param[out] pool - The pool to initialize.
+ */
+void node_pool_init(NodePool *pool);
+
+/**
+ * @brief Takes a linked list node from a pool, allocating a new block when the current one is full.
+ *
+ * @param[in,out] pool - The pool.
  *
- * @param[in] index - The array of word entries representing the hash index.
+ * @return A pointer to the node, valid until the pool is freed.
  *
  * @complexity
- * Time Complexity: O(n + m), where n is the number of word entries and m is the total number of linked list nodes.
- * - The function iterates over each word entry in the index, freeing the associated word and linked list nodes,
- *   resulting in linear time complexity proportional to the number of word entries and the total number of linked list nodes.
+ * Time Complexity: O(1).
+ */
+ListNode *node_pool_allocate(NodePool *pool);
+
+/**
+ * @brief Moves the blocks of a pool into another pool, so they are freed with it.
+ *
+ * The nodes keep their addresses, so lists built from the source pool stay valid.
+ * Nodes are still taken from the current block of the destination pool.
+ *
+ * @param[in,out] pool - The destination pool.
+ * @param[in,out] source - The pool whose blocks are moved. It is left empty.
+ *
+ * @complexity
+ * Time Complexity: O(b), where b is the number of blocks of the source pool.
+ */
+void node_pool_append(NodePool *pool, NodePool *source);
+
+/**
+ * @brief Frees the blocks of a pool, and with them every node taken from it.
+ *
+ * @param[in,out] pool - The pool. It is left empty.
  */
-void free_hash(const WordEntry *index);
+void node_pool_free(NodePool *pool);
 
 /**
  * @brief Prints the error message for memory allocation failures and exits.
@@ -133,4 +228,104 @@ void handle_memory_allocation_failure(void);
  */
 void *validated_memory_allocation(size_t size);
 
+/**
+ * @brief Reallocates memory with error checking.
+ *
+ * This function resizes a memory block using realloc and checks if the reallocation was successful.
+ * In case of failure, it invokes the handle_memory_allocation_failure function to print an error message
+ * and exit the program with a failure code.
+ *
+ * @param ptr The memory block to resize, or NULL to allocate a new block.
+ * @param size The new size of the memory block.
+ * @return A pointer to the resized memory block.
+ *
+ * @note Usage Example:
+ * \code
+ * array = (int *)validated_memory_reallocation(array, sizeof(int) * 20);
+ * \endcode
+ */
+void *validated_memory_reallocation(void *ptr, size_t size);
+
+/**
+ * @brief Duplicates a string with error checking.
+ *
+ * This function allocates a copy of a null-terminated string using validated_memory_allocation.
+ * It replaces strdup, which is not part of the C90 standard library.
+ *
+ * @param str The string to duplicate.
+ * @return A pointer to the newly allocated copy of the string.
+ *
+ * @note Memory Management:
+ * The caller is responsible for freeing the returned string using the free function.
+ */
+char *duplicate_string(const char *str);
+
+/**
+ * @brief Encodes an unsigned value as a variable-length integer.
+ *
+ * The value is written 7 bits per byte, low bits first, with the high bit of every
+ * byte but the last set. Small values, such as the deltas of sorted postings, take
+ * a single byte.
+ *
+ * @param value The value to encode.
+ * @param out The buffer to write to, with room for MAX_VARINT_BYTES bytes.
+ * @return The number of bytes written.
+ */
+size_t encode_varint(unsigned long value, unsigned char *out);
+
+/**
+ * @brief Decodes a variable-length integer written by encode_varint.
+ *
+ * @param in The first byte of the encoded value.
+ * @param end The end of the buffer.
+ * @param value The decoded value.
+ * @return The number of bytes read, or 0 if the encoding is truncated.
+ */
+size_t decode_varint(const unsigned char *in, const unsigned char *end, unsigned long *value);
+
+/**
+ * @brief Encodes the posting of a line: its delta from the previous line and the number of occurrences on it.
+ *
+ * The delta is shifted left by one bit, the low bit set when the line holds several occurrences,
+ * and encoded by encode_varint. Only then the number of occurrences follows, so a line with a
+ * single occurrence takes as many bytes as its delta alone.
+ *
+ * @param delta The delta of the line from the previous line.
+ * @param count The number of occurrences on the line, at least 1.
+ * @param out The buffer to write to, with room for MAX_POSTING_BYTES bytes.
+ * @return The number of bytes written.
+ */
+size_t encode_posting(unsigned long delta, int count, unsigned char *out);
+
+/**
+ * @brief Decodes the posting of a line written by encode_posting.
+ *
+ * @param in The first byte of the posting.
+ * @param end The end of the buffer.
+ * @param delta The delta of the line from the previous line.
+ * @param count The number of occurrences on the line.
+ * @return The number of bytes read, or 0 if the posting is truncated.
+ */
+size_t decode_posting(const unsigned char *in, const unsigned char *end, unsigned long *delta, int *count);
+
+/**
+ * @brief Maps a file into memory for reading.
+ *
+ * The indexed file is mapped instead of being read again, so lines and snippets are
+ * taken from it in place without copying.
+ *
+ * @param[in] file_name - The name of the file.
+ * @param[out] mapped - The mapping of the file.
+ *
+ * @return TRUE if the file was mapped, FALSE if it could not be opened or mapped.
+ */
+bool map_file(const char *file_name, MappedFile *mapped);
+
+/**
+ * @brief Unmaps a file mapped by map_file, or frees the contents decompressed by map_input.
+ *
+ * @param[in,out] mapped - The mapping of the file.
+ */
+void unmap_file(MappedFile *mapped);
+
 #endif /**< UTILITY_H */